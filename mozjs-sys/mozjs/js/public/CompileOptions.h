@@ -103,6 +103,22 @@ enum class AsmJSOption : uint8_t {
    */                                                                          \
   _(ConcurrentLargeFirst)                                                      \
                                                                                \
+  /*                                                                           \
+   * Syntax-parse the script, then delazify every function before returning    \
+   * the stencil. The functions of the top-level script are distributed over   \
+   * the helper threads and the compiling thread, largest first.               \
+   */                                                                          \
+  _(ParallelFullParse)                                                         \
+                                                                               \
+  /*                                                                           \
+   * Delazify the functions listed by the execution profile registered for the \
+   * source text with JS::SetDelazificationProfile, in the order in which they \
+   * were first called when the profile was recorded. Without a matching       \
+   * profile, this behaves as ConcurrentDepthFirst. The order of first calls   \
+   * is recorded, to be retrieved with JS::GetDelazificationProfile.           \
+   */                                                                          \
+  _(ConcurrentProfileGuided)                                                   \
+                                                                               \
   /*                                                                           \
    * Parse everything eagerly, from the first parse.                           \
    *                                                                           \
@@ -132,7 +148,8 @@ class JS_PUBLIC_API __attribute__((__packed__)) PrefableCompileOptions {
         explicitResourceManagement_(
             JS::Prefs::experimental_explicit_resource_management()),
 #endif
-        throwOnAsmJSValidationFailure_(false) {
+        throwOnAsmJSValidationFailure_(false),
+        bytecodePeephole_(false) {
   }
 
   bool importAttributes() const { return importAttributes_; }
@@ -181,6 +198,13 @@ class JS_PUBLIC_API __attribute__((__packed__)) PrefableCompileOptions {
     return *this;
   }
 
+  // Enable/disable the peephole optimization of the emitted bytecode.
+  bool bytecodePeephole() const { return bytecodePeephole_; }
+  PrefableCompileOptions& setBytecodePeephole(bool flag) {
+    bytecodePeephole_ = flag;
+    return *this;
+  }
+
 #if defined(DEBUG) || defined(JS_JITSPEW)
   template <typename Printer>
   void dumpWith(Printer& print) const {
@@ -188,6 +212,7 @@ class JS_PUBLIC_API __attribute__((__packed__)) PrefableCompileOptions {
     PrintFields_(importAttributes_);
     PrintFields_(sourcePragmas_);
     PrintFields_(throwOnAsmJSValidationFailure_);
+    PrintFields_(bytecodePeephole_);
 #  ifdef ENABLE_EXPLICIT_RESOURCE_MANAGEMENT
     PrintFields_(explicitResourceManagement_);
 #  endif
@@ -229,6 +254,9 @@ class JS_PUBLIC_API __attribute__((__packed__)) PrefableCompileOptions {
   // ==== asm.js options. ====
   bool throwOnAsmJSValidationFailure_ : 1;
 
+  // ==== Bytecode options. ====
+  bool bytecodePeephole_ : 1;
+
   AsmJSOption asmJSOption_ = AsmJSOption::DisabledByAsmJSPref;
 };
 
@@ -376,13 +404,25 @@ class JS_PUBLIC_API __attribute__((__packed__)) TransitiveCompileOptions {
   bool consumeDelazificationCache() const {
     return eagerDelazificationIsOneOf<
         DelazificationOption::ConcurrentDepthFirst,
-        DelazificationOption::ConcurrentLargeFirst>();
+        DelazificationOption::ConcurrentLargeFirst,
+        DelazificationOption::ParallelFullParse,
+        DelazificationOption::ConcurrentProfileGuided>();
   }
   bool populateDelazificationCache() const {
     return eagerDelazificationIsOneOf<
         DelazificationOption::CheckConcurrentWithOnDemand,
         DelazificationOption::ConcurrentDepthFirst,
-        DelazificationOption::ConcurrentLargeFirst>();
+        DelazificationOption::ConcurrentLargeFirst,
+        DelazificationOption::ParallelFullParse,
+        DelazificationOption::ConcurrentProfileGuided>();
+  }
+  bool parallelFullParse() const {
+    return eagerDelazificationIsOneOf<
+        DelazificationOption::ParallelFullParse>();
+  }
+  bool profileGuidedDelazification() const {
+    return eagerDelazificationIsOneOf<
+        DelazificationOption::ConcurrentProfileGuided>();
   }
   bool waitForDelazificationCache() const {
     return eagerDelazificationIsOneOf<
@@ -398,6 +438,7 @@ class JS_PUBLIC_API __attribute__((__packed__)) TransitiveCompileOptions {
 
   bool importAttributes() const { return prefableOptions_.importAttributes(); }
   bool sourcePragmas() const { return prefableOptions_.sourcePragmas(); }
+  bool bytecodePeephole() const { return prefableOptions_.bytecodePeephole(); }
 #ifdef ENABLE_EXPLICIT_RESOURCE_MANAGEMENT
   bool explicitResourceManagement() const {
     return prefableOptions_.explicitResourceManagement();
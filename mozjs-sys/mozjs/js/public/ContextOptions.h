@@ -111,6 +111,12 @@ class JS_PUBLIC_API ContextOptions {
     return *this;
   }
 
+  bool bytecodePeephole() const { return compileOptions_.bytecodePeephole(); }
+  ContextOptions& setBytecodePeephole(bool enabled) {
+    compileOptions_.setBytecodePeephole(enabled);
+    return *this;
+  }
+
   // Override to allow disabling the eval restriction security checks for
   // this context.
   bool disableEvalSecurityChecks() const { return disableEvalSecurityChecks_; }
@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef js_WasmBuiltins_h
+#define js_WasmBuiltins_h
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint8_t, uint32_t
+
+#include "jstypes.h"  // JS_PUBLIC_API
+
+#include "js/CallArgs.h"  // JSNative
+
+namespace JS {
+
+/**
+ * The types of the parameters and result of a WasmBuiltinNative, and the C
+ * types with which they are passed to its typed function.
+ */
+enum class WasmBuiltinType : uint8_t {
+  I32,        // int32_t
+  I64,        // int64_t
+  F32,        // float
+  F64,        // double
+  ExternRef,  // A pointer-sized opaque value, which is zero for null.
+};
+
+/**
+ * A native function of the embedding which WebAssembly modules can call
+ * directly, with the native ABI, rather than by converting their arguments to
+ * JS values and calling it as a JS function.
+ *
+ * |native| is the JSNative of the function objects which the embedding creates
+ * as usual, e.g. with JS_DefineFunctions, and provides to modules as imports.
+ * When a module imports such a function with exactly the signature described
+ * by |params| and |result|, its calls go to |typedFunc|, whose C signature
+ * corresponds to these types, e.g. `double (*)(int32_t, double)` for
+ * `(func (param i32 f64) (result f64))`. Calls from JS, and from modules
+ * which import the function with another signature, go to |native|, which
+ * must implement the same function.
+ *
+ * |typedFunc| is called without a JSContext, and must not call into the
+ * engine, allocate GC things or fail. An ExternRef is only valid for the
+ * duration of the call, and an ExternRef result must be zero or one of the
+ * arguments.
+ */
+struct WasmBuiltinNative {
+  JSNative native;
+  void* typedFunc;
+  const WasmBuiltinType* params;
+  uint32_t numParams;
+  bool hasResult;
+  WasmBuiltinType result;
+};
+
+/**
+ * Register WasmBuiltinNatives for all the runtimes of the process. This must
+ * be called after JS_Init, and before any WebAssembly module is compiled.
+ * Returns false if it is called too late, if a native has too many parameters
+ * to be called directly, or on OOM. On failure, none of the natives are
+ * registered.
+ *
+ * On builds using a simulator, the JSNatives are always called instead.
+ */
+extern JS_PUBLIC_API bool RegisterWasmBuiltinNatives(
+    const WasmBuiltinNative* natives, size_t numNatives);
+
+}  // namespace JS
+
+#endif /* js_WasmBuiltins_h */
@@ -8,10 +8,15 @@
 #define js_WasmModule_h
 
 #include "mozilla/RefPtr.h"  // RefPtr
+#include "mozilla/Vector.h"  // mozilla::Vector
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t
 
 #include "jstypes.h"  // JS_PUBLIC_API
 
-#include "js/RefCounted.h"  // AtomicRefCounted
+#include "js/AllocPolicy.h"  // js::SystemAllocPolicy
+#include "js/RefCounted.h"   // AtomicRefCounted
 #include "js/TypeDecls.h"   // HandleObject
 
 namespace JS {
@@ -41,6 +46,65 @@ extern JS_PUBLIC_API bool IsWasmModuleObject(HandleObject obj);
 
 extern JS_PUBLIC_API RefPtr<WasmModule> GetWasmModule(HandleObject obj);
 
+/**
+ * The indices of the functions of a WebAssembly module, compiled with lazy
+ * tiering, which got tiered up to optimized code, in increasing order. This is
+ * plain data which the embedding can persist, and register again with
+ * SetWasmTierUpProfile when the same module is compiled by a later execution,
+ * so that these functions are tiered up right away instead of once they get
+ * hot again.
+ */
+using WasmTierUpProfile =
+    mozilla::Vector<uint32_t, 0, js::SystemAllocPolicy>;
+
+/**
+ * Retrieve the functions of |module| tiered up so far. |moduleHash| is set to
+ * the hash of the module's code, which should be used as the key of the
+ * profile. If the module is not compiled with lazy tiering, |profile| is left
+ * empty. Returns false on out-of-memory.
+ */
+extern JS_PUBLIC_API bool GetWasmTierUpProfile(const WasmModule& module,
+                                               uint32_t* moduleHash,
+                                               WasmTierUpProfile& profile);
+
+/**
+ * Register a profile, to be used by modules compiled with lazy tiering whose
+ * code hashes to |moduleHash|. This replaces any profile previously registered
+ * for the same hash. Profiles are shared by all runtimes of the process.
+ * Returns false on out-of-memory.
+ */
+extern JS_PUBLIC_API bool SetWasmTierUpProfile(
+    uint32_t moduleHash, const WasmTierUpProfile& profile);
+
+/**
+ * Remove all profiles registered with SetWasmTierUpProfile.
+ */
+extern JS_PUBLIC_API void ClearWasmTierUpProfiles();
+
+/**
+ * Keep the address space reservations of up to |maxMemories| released
+ * WebAssembly memories, to be reused by new memories instead of being mapped
+ * again. This trades resident address space for the cost of mapping and
+ * unmapping memories, and helps embeddings which instantiate many short-lived
+ * instances. The pool is shared by all runtimes of the process, and is
+ * disabled by default. Reducing its size releases the excess reservations.
+ * Must be called after JS_Init.
+ *
+ * This has no effect on Windows.
+ */
+extern JS_PUBLIC_API void SetWasmMemoryPoolSize(size_t maxMemories);
+
+/**
+ * Keep up to |maxModules| compiled WebAssembly modules in a cache shared by all
+ * runtimes of the process, so that runtimes compiling the same bytecode with
+ * the same options get the same module, and share a single copy of its code
+ * and metadata. This helps embeddings running one runtime per worker, whose
+ * workers compile the same modules. The least recently used modules are
+ * evicted when the cache is full. The cache is disabled by default, and
+ * setting its capacity to 0 releases its modules. Must be called after JS_Init.
+ */
+extern JS_PUBLIC_API void SetWasmModuleCacheCapacity(size_t maxModules);
+
 }  // namespace JS
 
 #endif /* js_WasmModule_h */
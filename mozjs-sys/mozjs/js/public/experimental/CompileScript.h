@@ -10,13 +10,18 @@
 #ifndef js_experimental_CompileScript_h
 #define js_experimental_CompileScript_h
 
+#include "mozilla/RefPtr.h"  // RefPtr
+
 #include "jspubtd.h"
+#include "js/AllocPolicy.h"  // js::SystemAllocPolicy
 #include "js/ErrorReport.h"  // JSErrorReport
 #include "js/experimental/JSStencil.h"
 #include "js/GCAnnotations.h"
 #include "js/Modules.h"
 #include "js/Stack.h"
 #include "js/UniquePtr.h"
+#include "js/Utility.h"  // JS::UniqueChars
+#include "js/Vector.h"   // js::Vector
 
 namespace js {
 class FrontendContext;
@@ -121,6 +126,94 @@ extern JS_PUBLIC_API already_AddRefed<JS::Stencil> CompileModuleScriptToStencil(
     JS::FrontendContext* fc, const JS::ReadOnlyCompileOptions& options,
     JS::SourceText<char16_t>& srcBuf);
 
+// Provide the modules of a graph compiled by CompileModuleGraphToStencils.
+//
+// Modules are identified by a key chosen by the embedder, such as a URL. The
+// methods are called concurrently from the calling thread and from helper
+// threads, and must be thread-safe.
+class JS_PUBLIC_API ModuleGraphLoader {
+ public:
+  virtual ~ModuleGraphLoader() = default;
+
+  // Set |*key| to the key of the module imported with |specifier| by the
+  // module with the key |referrer|. Each key is loaded and compiled once.
+  // Leaving |*key| null skips the import.
+  virtual bool resolve(const char* referrer, const char* specifier,
+                       JS::UniqueChars* key) = 0;
+
+  // Initialize |srcBuf| with the source text of the module with the key |key|.
+  // Errors should be reported to |fc|.
+  virtual bool load(JS::FrontendContext* fc, const char* key,
+                    JS::SourceText<mozilla::Utf8Unit>& srcBuf) = 0;
+};
+
+// A module compiled by CompileModuleGraphToStencils.
+struct CompiledModule {
+  static constexpr size_t NoModule = size_t(-1);
+
+  JS::UniqueChars key;
+  RefPtr<JS::Stencil> stencil;
+
+  // For each module request of the stencil, in order, the index of the
+  // imported module in the graph. Requests with import attributes are not
+  // followed, nor the ones skipped by the loader, and are NoModule.
+  js::Vector<size_t, 0, js::SystemAllocPolicy> requestedModules;
+};
+
+// The modules are in topological order: each module comes after the modules it
+// imports, except within import cycles, and the entry module is the last one.
+// Instantiating them in this order finds the imported modules of each module
+// already instantiated.
+using CompiledModuleGraph =
+    js::Vector<CompiledModule, 0, js::SystemAllocPolicy>;
+
+// Compile the module with the key |entryKey| and all the modules it imports,
+// directly or not, to stencils. Imports are resolved and loaded as soon as
+// the module importing them is parsed, and the modules are compiled
+// concurrently by the calling thread and by helper threads.
+//
+// The filename of each module is set to its key. If any module fails to load
+// or to compile, the error is reported to |fc| and false is returned.
+extern JS_PUBLIC_API bool CompileModuleGraphToStencils(
+    JS::FrontendContext* fc, const JS::ReadOnlyCompileOptions& options,
+    const char* entryKey, ModuleGraphLoader& loader,
+    CompiledModuleGraph* graph);
+
+// Statistics of the process-wide table of parser atoms.
+struct SharedParserAtomsStats {
+  // Number of strings interned by compilations while the table was enabled,
+  // and how many of them had already been interned by another compilation.
+  uint64_t lookups = 0;
+  uint64_t duplicates = 0;
+
+  // Number of distinct strings in the table, and the memory they use.
+  uint64_t entries = 0;
+  uint64_t bytes = 0;
+
+  // Number of atoms which the instantiation of stencils found by their id,
+  // without hashing them and looking them up in the atoms table.
+  uint64_t instantiationHits = 0;
+};
+
+// Share the strings interned by the parser across all compilations of the
+// process, including the ones using a JS::FrontendContext on other threads.
+// Concurrent compilations then agree on an id for each identifier, which lets
+// the instantiation of their stencils reuse the atoms created for the same
+// identifiers by previous instantiations without hashing them again.
+//
+// This should be called after JS_Init, and stays enabled until JS_ShutDown or
+// DisableSharedParserAtoms. Returns false on out-of-memory.
+JS_PUBLIC_API bool EnableSharedParserAtoms();
+
+// Stop sharing the strings interned by later compilations. The strings which
+// are already shared are kept until JS_ShutDown, and are shared again if
+// EnableSharedParserAtoms is called again.
+JS_PUBLIC_API void DisableSharedParserAtoms();
+
+// Retrieve the statistics of the table enabled by EnableSharedParserAtoms. All
+// fields are zero if the table was never enabled.
+JS_PUBLIC_API void GetSharedParserAtomsStats(SharedParserAtomsStats* stats);
+
 extern JS_PUBLIC_API bool PrepareForInstantiate(
     JS::FrontendContext* fc, JS::Stencil& stencil,
     JS::InstantiationStorage& storage);
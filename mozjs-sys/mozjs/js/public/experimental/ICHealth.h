@@ -0,0 +1,101 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/*
+ * Inline cache (IC) health reporting.
+ *
+ * SpiderMonkey attaches specialized stubs to the ICs of a script as it runs.
+ * Sites that see many different shapes or types end up with several stubs,
+ * transition to a slower megamorphic or generic mode, or keep failing to
+ * attach any stub at all. These functions report the counters that the engine
+ * always maintains for each IC, so that embedders can find such sites in their
+ * own code.
+ *
+ * The counters are only updated on the slow path of an IC, and the report is
+ * computed when requested, so there is no need to enable anything beforehand.
+ * Scripts that have not run enough to get ICs are not included.
+ *
+ * The meaning of the data is tied to engine internals and may change, hence
+ * why these APIs are "experimental".
+ */
+
+#ifndef js_experimental_ICHealth_h
+#define js_experimental_ICHealth_h
+
+#include <stdint.h>  // uint32_t
+
+#include "jstypes.h"  // JS_PUBLIC_API
+
+#include "js/TypeDecls.h"
+
+namespace JS {
+
+/**
+ * Get a JSON string describing the ICs of |script|.
+ *
+ * The JSON string will encode an object of this form:
+ *
+ *   {
+ *     "file": filename for the script,
+ *     "line": line number of the script,
+ *     "column": column number of the script,
+ *
+ *     // OPTIONAL: only if this script is a function
+ *     "name": function name,
+ *
+ *     "entries":
+ *       [
+ *         // array elements of this form, one per IC in bytecode order
+ *         {
+ *           "offset": offset of the bytecode op within the script,
+ *           "op": name of the bytecode op,
+ *           "line": line number of the op,
+ *           "column": column number of the op,
+ *           "mode": "specialized", "megamorphic" or "generic",
+ *           "stubs": number of stubs currently attached,
+ *           "stubHits": number of times an attached stub was entered,
+ *           "fallbackHits": number of times the fallback path was taken,
+ *           "failures": number of failed attach attempts in the current mode,
+ *           "transitions": number of mode transitions (saturates at 31),
+ *
+ *           // OPTIONAL: only if the last attach attempt that produced a stub
+ *           // could not attach it
+ *           "attachFailure": "duplicateStub", "tooLarge" or "oom",
+ *         }
+ *       ]
+ *   }
+ *
+ * Hit counts are reset whenever a stub is attached to the IC. If the script
+ * has no ICs yet, "entries" is empty.
+ */
+extern JS_PUBLIC_API JSString* GetScriptICHealthReport(
+    JSContext* cx, Handle<JSScript*> script);
+
+/**
+ * Get a JSON string describing the unhealthy ICs of all scripts in the current
+ * zone: ICs that have more than one stub attached, have left the specialized
+ * mode, or have never been able to attach a stub, and which have been hit at
+ * least |minHits| times (counting both stub and fallback hits).
+ *
+ * The JSON string will encode an object of this form:
+ *
+ *   {
+ *     "scripts":
+ *       [
+ *         // array elements in the format of JS::GetScriptICHealthReport,
+ *         // restricted to the matching ICs. Scripts without matching ICs
+ *         // are omitted.
+ *       ]
+ *   }
+ *
+ * Self-hosted scripts are not included.
+ */
+extern JS_PUBLIC_API JSString* GetICHealthReport(JSContext* cx,
+                                                 uint32_t minHits);
+
+}  // namespace JS
+
+#endif  // js_experimental_ICHealth_h
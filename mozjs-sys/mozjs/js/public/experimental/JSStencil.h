@@ -20,9 +20,11 @@
 #include "mozilla/Vector.h"           // mozilla::Vector
 
 #include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t
 
 #include "jstypes.h"  // JS_PUBLIC_API
 
+#include "js/AllocPolicy.h"     // js::SystemAllocPolicy
 #include "js/CompileOptions.h"  // JS::ReadOnlyCompileOptions, JS::InstantiateOptions, JS::ReadOnlyDecodeOptions
 #include "js/SourceText.h"   // JS::SourceText
 #include "js/Transcoding.h"  // JS::TranscodeBuffer, JS::TranscodeRange
@@ -155,6 +157,39 @@ extern JS_PUBLIC_API already_AddRefed<Stencil> CompileGlobalScriptToStencil(
     JSContext* cx, const ReadOnlyCompileOptions& options,
     SourceText<char16_t>& srcBuf);
 
+// Statistics about the functions reused by
+// CompileGlobalScriptToStencilIncrementally.
+struct IncrementalCompilationStats {
+  // Number of functions copied from the previous stencil.
+  uint32_t reusedFunctions = 0;
+
+  // Number of functions in the new stencil, excluding the top-level script.
+  uint32_t totalFunctions = 0;
+};
+
+// Compile the edited source text of a global script which was previously
+// compiled into |previous|. The lazy functions defined directly in the global
+// scope of |previous| whose source text did not change are copied into the
+// new stencil instead of being parsed again, which reduces the time taken to
+// recompile a large script after a small edit.
+//
+// The result is the same as CompileGlobalScriptToStencil, and |previous| must
+// have been compiled with the same filename, line and column options. If
+// |stats| is non-null, it receives the number of functions reused.
+//
+// NOTE: On error, a null will be returned and an exception will be set on the
+//       JSContext.
+extern JS_PUBLIC_API already_AddRefed<Stencil>
+CompileGlobalScriptToStencilIncrementally(
+    JSContext* cx, const ReadOnlyCompileOptions& options,
+    SourceText<mozilla::Utf8Unit>& srcBuf, Stencil* previous,
+    IncrementalCompilationStats* stats = nullptr);
+extern JS_PUBLIC_API already_AddRefed<Stencil>
+CompileGlobalScriptToStencilIncrementally(
+    JSContext* cx, const ReadOnlyCompileOptions& options,
+    SourceText<char16_t>& srcBuf, Stencil* previous,
+    IncrementalCompilationStats* stats = nullptr);
+
 // Compile the source text into a JS::Stencil using "module" parse goal. The
 // ECMAScript spec defines special semantics so we use a seperate entry point
 // here for clarity. The result is still a JS::Stencil, but should use the
@@ -253,6 +288,43 @@ extern JS_PUBLIC_API void AbortCollectingDelazifications(
 extern JS_PUBLIC_API void AbortCollectingDelazifications(
     Handle<JSObject*> module);
 
+// ************************************************************************
+//   Delazification profile
+// ************************************************************************
+
+// The source range of a function, within the source text of its script.
+struct DelazificationProfileEntry {
+  uint32_t sourceStart;
+  uint32_t sourceEnd;
+};
+
+// The functions of a script which got called during an execution, in the
+// order of their first call. This is plain data which the embedder can
+// persist, and register again with SetDelazificationProfile when the same
+// source text is loaded by a later execution.
+using DelazificationProfile =
+    mozilla::Vector<DelazificationProfileEntry, 0, js::SystemAllocPolicy>;
+
+// Retrieve the order of first calls recorded for the source of the given
+// script, which must have been compiled with the ConcurrentProfileGuided
+// delazification mode. |sourceHash| is set to the hash of the source text,
+// which should be used as the key of the profile. If nothing got recorded,
+// |profile| is left empty.
+extern JS_PUBLIC_API bool GetDelazificationProfile(
+    JSContext* cx, Handle<JSScript*> script, uint32_t* sourceHash,
+    DelazificationProfile& profile);
+
+// Register a profile, to be used by scripts compiled with the
+// ConcurrentProfileGuided delazification mode whose source text hashes to
+// |sourceHash|. This replaces any profile previously registered for the same
+// hash. Profiles are shared by all runtimes of the process. Returns false on
+// out-of-memory.
+extern JS_PUBLIC_API bool SetDelazificationProfile(
+    uint32_t sourceHash, const DelazificationProfile& profile);
+
+// Remove all profiles registered with SetDelazificationProfile.
+extern JS_PUBLIC_API void ClearDelazificationProfiles();
+
 // ************************************************************************
 //   Cache
 // ************************************************************************
@@ -0,0 +1,33 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef js_friend_SourceCompression_h
+#define js_friend_SourceCompression_h
+
+#include <stdint.h>  // uint8_t
+
+#include "jstypes.h"       // JS_PUBLIC_API
+#include "js/TypeDecls.h"  // JSContext
+
+namespace js {
+
+// The source text of scripts is compressed off-thread once it has been kept
+// alive for a few GCs, and decompressed one chunk at a time whenever a lazy
+// function is parsed or its source is needed by Function.prototype.toString.
+//
+// Zlib gives the best compression ratio. LZ4 compresses slightly less but is
+// many times faster to compress and decompress, which reduces the main thread
+// time spent parsing lazy functions of compressed sources.
+enum class SourceCompressionCodec : uint8_t { Zlib, LZ4 };
+
+// Select the codec used for the source text compressed from now on. Sources
+// that are already compressed remain readable whatever the codec.
+extern JS_PUBLIC_API void SetSourceCompressionCodec(
+    JSContext* cx, SourceCompressionCodec codec);
+
+} /* namespace js */
+
+#endif  // js_friend_SourceCompression_h
@@ -72,9 +72,12 @@ class JS_PUBLIC_API JSObject;
  * However, unlike the legacy list, each glean metric must be manually added
  * to the switch statement in AccumulateTelemetryCallback().
  */
-#define FOR_EACH_JS_GLEAN_METRIC(_)    \
-  _(ION_COMPILE_TIME, TimeDuration_US) \
-  _(GC_GLEAN_SLOW_PHASE, Enumeration)  \
+#define FOR_EACH_JS_GLEAN_METRIC(_)               \
+  _(ION_COMPILE_TIME, TimeDuration_US)            \
+  _(ION_COMPILE_QUEUE_TIME, TimeDuration_US)      \
+  _(BASELINE_COMPILE_TIME, TimeDuration_US)       \
+  _(BASELINE_COMPILE_QUEUE_TIME, TimeDuration_US) \
+  _(GC_GLEAN_SLOW_PHASE, Enumeration)             \
   _(GC_GLEAN_SLOW_TASK, Enumeration)
 
 #define FOR_EACH_JS_METRIC(_)  \
@@ -18,8 +18,9 @@
 #include "frontend/EitherParser.h"
 #include "frontend/FrontendContext.h"  // AutoReportFrontendContext
 #include "frontend/ModuleSharedContext.h"
-#include "frontend/ParserAtom.h"     // ParserAtomsTable, TaggedParserAtomIndex
-#include "frontend/SharedContext.h"  // SharedContext, GlobalSharedContext
+#include "frontend/ParserAtom.h"  // ParserAtomsTable, TaggedParserAtomIndex
+#include "frontend/ReusableFunctions.h"  // ReusableFunctions
+#include "frontend/SharedContext.h"      // SharedContext, GlobalSharedContext
 #include "frontend/Stencil.h"        // ParserBindingIter
 #include "frontend/UsedNameTracker.h"  // UsedNameTracker, UsedNameMap
 #include "js/AllocPolicy.h"        // js::SystemAllocPolicy, ReportOutOfMemory
@@ -40,7 +41,7 @@
 #include "vm/EnvironmentObject.h"      // WithEnvironmentObject
 #include "vm/FunctionFlags.h"          // FunctionFlags
 #include "vm/GeneratorAndAsyncKind.h"  // js::GeneratorKind, js::FunctionAsyncKind
-#include "vm/HelperThreads.h"  // StartOffThreadDelazification, WaitForAllDelazifyTasks
+#include "vm/HelperThreads.h"  // StartOffThreadDelazification, DelazifyInParallel, WaitForAllDelazifyTasks
 #include "vm/JSContext.h"      // JSContext
 #include "vm/JSObject.h"       // SetIntegrityLevel, IntegrityLevel
 #include "vm/JSScript.h"       // ScriptSource, UncompressedSourceCache
@@ -256,7 +257,10 @@ static bool ConvertGlobalScriptStencilMaybeInstantiate(
     }
   }
 
-  if (input.options.populateDelazificationCache()) {
+  if (input.options.parallelFullParse()) {
+    // Delazify everything before returning, with the help of other threads.
+    DelazifyInParallel(maybeCx, fc, input.options, stencils.get());
+  } else if (input.options.populateDelazificationCache()) {
     // NOTE: Delazification can be triggered from off-thread compilation.
     StartOffThreadDelazification(maybeCx, input.options, stencils.get());
 
@@ -307,7 +311,8 @@ template <typename Unit>
     ExtraBindingInfoVector* maybeExtraBindings,
     CompilationStencil** initialStencilOut,
     InitialStencilAndDelazifications** stencilsOut,
-    CompilationGCOutput* gcOutput) {
+    CompilationGCOutput* gcOutput,
+    ReusableFunctions* reusableFunctions = nullptr) {
   if (input.options.selfHostingMode) {
     if (!input.initForSelfHostingGlobal(fc)) {
       return false;
@@ -329,6 +334,7 @@ template <typename Unit>
   if (!compiler.init(fc, scopeCache)) {
     return false;
   }
+  compiler.compilationState().reusableFunctions = reusableFunctions;
 
   SourceExtent extent = SourceExtent::makeGlobalExtent(
       srcBuf.length(), input.options.lineno,
@@ -415,6 +421,58 @@ already_AddRefed<JS::Stencil> JS::CompileGlobalScriptToStencil(
   return CompileGlobalScriptToStencilImpl(cx, options, srcBuf);
 }
 
+template <typename CharT>
+static already_AddRefed<JS::Stencil>
+CompileGlobalScriptToStencilIncrementallyImpl(
+    JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+    JS::SourceText<CharT>& srcBuf, JS::Stencil* previous,
+    JS::IncrementalCompilationStats* stats) {
+  MOZ_ASSERT(previous);
+
+  ScopeKind scopeKind =
+      options.nonSyntacticScope ? ScopeKind::NonSyntactic : ScopeKind::Global;
+
+  AutoReportFrontendContext fc(cx);
+
+  ReusableFunctions reusable(*previous->getInitial());
+  if (!reusable.init(cx, &fc, options, srcBuf.get(), srcBuf.length())) {
+    return nullptr;
+  }
+
+  NoScopeBindingCache scopeCache;
+  Rooted<CompilationInput> input(cx, CompilationInput(options));
+  RefPtr<InitialStencilAndDelazifications> stencils;
+  if (!CompileGlobalScriptToStencilAndMaybeInstantiate(
+          cx, &fc, cx->tempLifoAlloc(), input.get(), &scopeCache, srcBuf,
+          scopeKind, NoExtraBindings, NoInitialStencilOut,
+          getter_AddRefs(stencils), NoGCOutput, &reusable)) {
+    return nullptr;
+  }
+
+  if (stats) {
+    // The top-level script is always compiled again.
+    stats->reusedFunctions = reusable.reusedFunctions();
+    stats->totalFunctions = stencils->getInitial()->scriptData.size() - 1;
+  }
+  return stencils.forget();
+}
+
+already_AddRefed<JS::Stencil> JS::CompileGlobalScriptToStencilIncrementally(
+    JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+    JS::SourceText<mozilla::Utf8Unit>& srcBuf, JS::Stencil* previous,
+    JS::IncrementalCompilationStats* stats /* = nullptr */) {
+  return CompileGlobalScriptToStencilIncrementallyImpl(cx, options, srcBuf,
+                                                       previous, stats);
+}
+
+already_AddRefed<JS::Stencil> JS::CompileGlobalScriptToStencilIncrementally(
+    JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+    JS::SourceText<char16_t>& srcBuf, JS::Stencil* previous,
+    JS::IncrementalCompilationStats* stats /* = nullptr */) {
+  return CompileGlobalScriptToStencilIncrementallyImpl(cx, options, srcBuf,
+                                                       previous, stats);
+}
+
 template <typename CharT>
 static already_AddRefed<JS::Stencil> CompileGlobalScriptToStencilImpl(
     JS::FrontendContext* fc, const JS::ReadOnlyCompileOptions& options,
@@ -1530,6 +1588,10 @@ static bool DelazifyCanonicalScriptedFunctionImpl(JSContext* cx,
   RefPtr<InitialStencilAndDelazifications> stencils =
       lazy->sourceObject()->maybeGetStencils();
 
+  if (stencils && input.get().options.profileGuidedDelazification()) {
+    stencils->recordFirstCall(input.get().extent());
+  }
+
   if (stencils && input.get().options.consumeDelazificationCache()) {
     const CompilationStencil* cached =
         stencils->getDelazificationFor(input.get().extent());
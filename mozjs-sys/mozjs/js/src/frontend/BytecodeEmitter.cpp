@@ -2474,6 +2474,14 @@ bool BytecodeEmitter::emitScript(ParseNode* body) {
 
 js::UniquePtr<ImmutableScriptData>
 BytecodeEmitter::createImmutableScriptData() {
+  if (compilationState.input.options.bytecodePeephole()) {
+    uint32_t offset = mainOffset();
+    if (!bytecodeSection().optimizePeephole(fc, &offset)) {
+      return nullptr;
+    }
+    mainOffset_ = mozilla::Some(offset);
+  }
+
   uint32_t nslots;
   if (!getNslots(&nslots)) {
     return nullptr;
@@ -8,6 +8,8 @@
 
 #include "mozilla/Assertions.h"  // MOZ_ASSERT
 
+#include <algorithm>  // std::lower_bound
+
 #include "frontend/AbstractScopePtr.h"    // ScopeIndex
 #include "frontend/CompilationStencil.h"  // CompilationStencil
 #include "frontend/FrontendContext.h"     // FrontendContext
@@ -186,6 +188,195 @@ void BytecodeSection::updateDepth(JSOp op, BytecodeOffset target) {
   }
 }
 
+// Follow the chain of unconditional forward jumps starting at |target|, and
+// return the first instruction which isn't a JumpTarget immediately followed
+// by a Goto.
+static jsbytecode* ThreadJumpTarget(jsbytecode* target, jsbytecode* end) {
+  // Bound the number of hops, as a chain may end with a backward jump.
+  static constexpr size_t MaxHops = 8;
+
+  for (size_t i = 0; i < MaxHops; i++) {
+    if (JSOp(*target) != JSOp::JumpTarget) {
+      break;
+    }
+    jsbytecode* next = target + JSOpLength_JumpTarget;
+    if (next >= end || JSOp(*next) != JSOp::Goto) {
+      break;
+    }
+
+    // Backward jumps are loop backedges, and must remain the only jumps to
+    // their loop head.
+    jsbytecode* nextTarget = next + GET_JUMP_OFFSET(next);
+    if (nextTarget <= next) {
+      break;
+    }
+    target = nextTarget;
+  }
+
+  return target;
+}
+
+bool BytecodeSection::optimizePeephole(FrontendContext* fc,
+                                       uint32_t* mainOffset) {
+  jsbytecode* begin = code_.begin();
+  jsbytecode* end = code_.end();
+
+  // The frame's return value is undefined until a SetRval, so that without
+  // any SetRval, `Undefined; Return` is the same as RetRval.
+  bool hasSetRval = false;
+  for (jsbytecode* pc = begin; pc < end; pc += GetBytecodeLength(pc)) {
+    if (JSOp(*pc) == JSOp::SetRval) {
+      hasSetRval = true;
+      break;
+    }
+  }
+
+  // The offsets of the instructions turned into Nop, which are removed below.
+  Vector<uint32_t, 16> removed(fc);
+
+  for (jsbytecode* pc = begin; pc < end; pc += GetBytecodeLength(pc)) {
+    JSOp op = JSOp(*pc);
+
+    if (IsJumpOpcode(op)) {
+      int32_t offset = GET_JUMP_OFFSET(pc);
+      if (offset > 0) {
+        jsbytecode* target = ThreadJumpTarget(pc + offset, end);
+        SET_JUMP_OFFSET(pc, int32_t(target - pc));
+      }
+      continue;
+    }
+
+    // Every jump lands on a JumpTarget or a LoopHead instruction, so nothing
+    // can jump between the two instructions of the pairs below.
+    jsbytecode* next = pc + GetBytecodeLength(pc);
+    if (next >= end) {
+      break;
+    }
+    JSOp nextOp = JSOp(*next);
+
+    // Dup; Pop, and Swap; Swap, have no effect.
+    if ((op == JSOp::Dup && nextOp == JSOp::Pop) ||
+        (op == JSOp::Swap && nextOp == JSOp::Swap)) {
+      MOZ_ASSERT(GetBytecodeLength(next) == 1);
+      *pc = jsbytecode(JSOp::Nop);
+      *next = jsbytecode(JSOp::Nop);
+      if (!removed.append(pc - begin) || !removed.append(next - begin)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (op == JSOp::Undefined && nextOp == JSOp::Return && !hasSetRval) {
+      *pc = jsbytecode(JSOp::Nop);
+      *next = jsbytecode(JSOp::RetRval);
+      if (!removed.append(pc - begin)) {
+        return false;
+      }
+    }
+  }
+
+  if (removed.empty()) {
+    return true;
+  }
+
+  // Offsets move back by the number of removed bytes before them. The removed
+  // instructions are a single byte each, and are never jump targets.
+  auto newOffset = [&](uint32_t offset) {
+    size_t numRemoved =
+        std::lower_bound(removed.begin(), removed.end(), offset) -
+        removed.begin();
+    return offset - uint32_t(numRemoved);
+  };
+
+  // Relocate the jumps, while the instructions are at their old offsets.
+  for (jsbytecode* pc = begin; pc < end; pc += GetBytecodeLength(pc)) {
+    JSOp op = JSOp(*pc);
+    if (!IsJumpOpcode(op) && op != JSOp::TableSwitch) {
+      continue;
+    }
+    uint32_t offset = pc - begin;
+    uint32_t target = offset + GET_JUMP_OFFSET(pc);
+    SET_JUMP_OFFSET(pc,
+                    int32_t(newOffset(target)) - int32_t(newOffset(offset)));
+  }
+
+  // Remove the Nop instructions.
+  size_t length = 0;
+  const uint32_t* nextRemoved = removed.begin();
+  for (size_t offset = 0; offset < code_.length(); offset++) {
+    if (nextRemoved != removed.end() && *nextRemoved == offset) {
+      MOZ_ASSERT(JSOp(code_[offset]) == JSOp::Nop);
+      nextRemoved++;
+      continue;
+    }
+    code_[length++] = code_[offset];
+  }
+  code_.shrinkTo(length);
+
+  // Rewrite the source notes with their new deltas. Deltas only get smaller,
+  // so the notes never need more XDelta notes than they had.
+  SrcNotesVector notes(fc);
+  auto allocator = [&](unsigned size) -> SrcNote* {
+    if (!notes.growByUninitialized(size)) {
+      return nullptr;
+    }
+    return &notes[notes.length() - size];
+  };
+
+  uint32_t oldNoteOffset = 0;
+  uint32_t newNoteOffset = 0;
+  SrcNoteIterator iter(notes_.begin(), notes_.end());
+  while (!iter.atEnd()) {
+    const SrcNote* sn = *iter;
+    ++iter;
+    oldNoteOffset += sn->delta();
+    if (sn->type() == SrcNoteType::XDelta) {
+      continue;
+    }
+
+    uint32_t offset = newOffset(oldNoteOffset);
+    if (!SrcNoteWriter::writeNote(sn->type(), offset - newNoteOffset,
+                                  allocator)) {
+      return false;
+    }
+    newNoteOffset = offset;
+
+    // Copy the operands.
+    if (!notes.append(sn + 1, *iter)) {
+      return false;
+    }
+  }
+  if (!notes.append(*iter, notes_.end())) {
+    return false;
+  }
+  notes_ = std::move(notes);
+
+  for (TryNote& note : tryNoteList_.list) {
+    uint32_t start = newOffset(note.start);
+    note.length = newOffset(note.start + note.length) - start;
+    note.start = start;
+  }
+
+  // The scope of the vars of a function body ends at UINT32_MAX, see
+  // CGScopeNoteList::recordEndFunctionBodyVar.
+  for (ScopeNote& note : scopeNoteList_.list) {
+    uint32_t start = newOffset(note.start);
+    uint32_t noteEnd = note.start + note.length;
+    if (noteEnd != UINT32_MAX) {
+      noteEnd = newOffset(noteEnd);
+    }
+    note.length = noteEnd - start;
+    note.start = start;
+  }
+
+  for (uint32_t& offset : resumeOffsetList_.list) {
+    offset = newOffset(offset);
+  }
+
+  *mainOffset = newOffset(*mainOffset);
+  return true;
+}
+
 PerScriptData::PerScriptData(FrontendContext* fc,
                              frontend::CompilationState& compilationState)
     : gcThingList_(fc, compilationState),
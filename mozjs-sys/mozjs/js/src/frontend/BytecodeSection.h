@@ -218,6 +218,15 @@ class BytecodeSection {
 
   void updateDepth(JSOp op, BytecodeOffset target);
 
+  // ---- Peephole optimization ----
+
+  // Once the whole script has been emitted, rewrite some instruction sequences
+  // left by the single-pass emitter into cheaper ones, and remove the bytes
+  // they no longer use. Jumps, source notes, try notes, scope notes, resume
+  // offsets and |mainOffset| are moved along with the instructions.
+  [[nodiscard]] bool optimizePeephole(FrontendContext* fc,
+                                      uint32_t* mainOffset);
+
   // ---- Try notes ----
 
   CGTryNoteList& tryNoteList() { return tryNoteList_; };
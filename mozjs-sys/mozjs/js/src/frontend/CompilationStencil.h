@@ -36,6 +36,7 @@
 #include "frontend/TaggedParserAtomIndexHasher.h"  // TaggedParserAtomIndexHasher
 #include "frontend/UsedNameTracker.h"              // UsedNameTracker
 #include "js/AllocPolicy.h"    // SystemAllocPolicy, ReportOutOfMemory
+#include "js/experimental/JSStencil.h"  // JS::DelazificationProfile
 #include "js/GCVector.h"       // JS::GCVector
 #include "js/RefCounted.h"     // AtomicRefCounted
 #include "js/RootingAPI.h"     // JS::Handle
@@ -43,11 +44,13 @@
 #include "js/UniquePtr.h"      // js::UniquePtr
 #include "js/Vector.h"         // Vector
 #include "js/WasmModule.h"     // JS::WasmModule
+#include "threading/ExclusiveData.h"  // js::ExclusiveData
 #include "vm/FunctionFlags.h"  // FunctionFlags
 #include "vm/GlobalObject.h"   // GlobalObject
 #include "vm/JSContext.h"      // JSContext
 #include "vm/JSFunction.h"     // JSFunction
 #include "vm/JSScript.h"       // BaseScript, ScriptSource, SourceExtent
+#include "vm/MutexIDs.h"       // js::mutexid::DelazificationProfile
 #include "vm/Realm.h"          // JSContext::global
 #include "vm/Scope.h"          // Scope, ModuleScope
 #include "vm/ScopeKind.h"      // ScopeKind
@@ -78,6 +81,7 @@ struct PreallocatedCompilationGCOutput;
 class ScriptStencilIterable;
 struct InputName;
 class ScopeBindingCache;
+class ReusableFunctions;
 
 // When delazifying modules' inner functions, the actual global scope is used.
 // However, when doing a delazification the global scope is not available. We
@@ -632,6 +636,9 @@ struct CompilationAtomCache {
   void stealBuffer(AtomCacheVector& atoms);
   void releaseBuffer(AtomCacheVector& atoms);
 
+  // Take the buffer allocated by PreallocatedCompilationGCOutput.
+  void steal(PreallocatedCompilationGCOutput&& pre);
+
   void trace(JSTracer* trc);
 
   size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf) const {
@@ -1405,8 +1412,14 @@ struct InitialStencilAndDelazifications {
 
   mutable mozilla::Atomic<uintptr_t> refCount_{0};
 
+  // The functions delazified for an execution, in the order of their first
+  // call. Only recorded for the ConcurrentProfileGuided delazification mode.
+  // See JS::GetDelazificationProfile.
+  js::ExclusiveData<JS::DelazificationProfile> firstCalls_;
+
  public:
-  InitialStencilAndDelazifications() = default;
+  InitialStencilAndDelazifications()
+      : firstCalls_(js::mutexid::DelazificationProfile) {}
   ~InitialStencilAndDelazifications();
 
   void AddRef();
@@ -1468,6 +1481,14 @@ struct InitialStencilAndDelazifications {
 
   bool hasAsmJS() const;
 
+  // Record the first call of the function with the given extent. Failing to
+  // record a call only makes the profile less accurate, thus this function is
+  // infallible.
+  void recordFirstCall(const SourceExtent& extent);
+
+  // Copy the recorded first calls into |profile|, without duplicates.
+  [[nodiscard]] bool getFirstCalls(JS::DelazificationProfile& profile) const;
+
   // Instantiate the initial stencil and all delazifications populated so far.
   [[nodiscard]] static bool instantiateStencils(
       JSContext* cx, CompilationInput& input,
@@ -1659,6 +1680,10 @@ struct MOZ_RAII CompilationState : public ExtensibleCompilationStencil {
   // SharedDataContainer.prepareStorageFor *before* start emitting bytecode.
   size_t nonLazyFunctionCount = 0;
 
+  // When recompiling an edited global script, the lazy functions of the
+  // previous stencil which can be copied instead of being syntax parsed.
+  ReusableFunctions* reusableFunctions = nullptr;
+
   // End of fields.
 
   CompilationState(FrontendContext* fc, LifoAllocScope& parserAllocScope,
@@ -1866,6 +1891,13 @@ struct PreallocatedCompilationGCOutput {
   PreAllocateableGCArray<JSFunction*>::Preallocated functions;
   PreAllocateableGCArray<js::Scope*>::Preallocated scopes;
 
+  // The buffer of CompilationAtomCache, sized for the parser atoms.
+  CompilationAtomCache::AtomCacheVector atoms;
+
+  // The runtime data of each scope, or nullptr for scopes without data.
+  Vector<ScopeDataBuffer, 0, js::SystemAllocPolicy> scopeData;
+
+  friend struct CompilationAtomCache;
   friend struct CompilationGCOutput;
 
  public:
@@ -1884,10 +1916,13 @@ struct PreallocatedCompilationGCOutput {
     return true;
   }
 
-  size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf) const {
-    return functions.sizeOfExcludingThis(mallocSizeOf) +
-           scopes.sizeOfExcludingThis(mallocSizeOf);
-  }
+  // Allocate the memory which instantiation would otherwise allocate on the
+  // main thread, apart from GC things: the atom cache, and the runtime data
+  // of the scopes.
+  [[nodiscard]] bool allocateInstantiationData(
+      FrontendContext* fc, const CompilationStencil& stencil);
+
+  size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf) const;
 };
 
 // The output of GC allocation from stencil.
@@ -1912,6 +1947,11 @@ struct CompilationGCOutput {
   // The result ScriptSourceObject. This is unused in delazifying parses.
   ScriptSourceObject* sourceObject = nullptr;
 
+  // The runtime data of the scopes, allocated off-thread by
+  // PreallocatedCompilationGCOutput. Each buffer is moved to its scope when
+  // the scope is instantiated. Empty if the data was not preallocated.
+  Vector<ScopeDataBuffer, 0, js::SystemAllocPolicy> scopeData;
+
  private:
   // If we are only instantiating part of a stencil, we can reduce allocations
   // by setting a base index and allocating only the array elements we need.
@@ -1974,6 +2014,14 @@ struct CompilationGCOutput {
   void steal(PreallocatedCompilationGCOutput&& pre) {
     functions.steal(std::move(pre.functions));
     scopes.steal(std::move(pre.scopes));
+    scopeData = std::move(pre.scopeData);
+  }
+
+  ScopeDataBuffer* preallocatedScopeData(ScopeIndex index) {
+    if (scopeData.empty()) {
+      return nullptr;
+    }
+    return &scopeData[index - scopesBaseIndex];
   }
 
   // A variant of `ensureAllocated` that sets a base index for the function and
@@ -1995,7 +2043,8 @@ struct CompilationGCOutput {
   // Size of dynamic data. Note that GC data is counted by GC and not here.
   size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf) const {
     return functions.sizeOfExcludingThis(mallocSizeOf) +
-           scopes.sizeOfExcludingThis(mallocSizeOf);
+           scopes.sizeOfExcludingThis(mallocSizeOf) +
+           scopeData.sizeOfExcludingThis(mallocSizeOf);
   }
 
   void trace(JSTracer* trc);
@@ -42,6 +42,7 @@
 #include "frontend/ParseNodeVerify.h"
 #include "frontend/Parser-macros.h"  // MOZ_TRY_VAR_OR_RETURN
 #include "frontend/ParserAtom.h"  // TaggedParserAtomIndex, ParserAtomsTable, ParserAtom
+#include "frontend/ReusableFunctions.h"  // ReusableFunctions
 #include "frontend/ScriptIndex.h"  // ScriptIndex
 #include "frontend/TokenStream.h"  // IsKeyword, ReservedWordTokenKind, ReservedWordToCharZ, DeprecatedContent, *TokenStream*, CharBuffer, TokenKindToDesc
 #include "irregexp/RegExpAPI.h"
@@ -3151,6 +3152,60 @@ bool Parser<FullParseHandler, Unit>::advancePastSyntaxParsedFunction(
   return true;
 }
 
+template <typename Unit>
+bool Parser<FullParseHandler, Unit>::tryReuseInnerFunction(
+    FunctionNode* funNode, TaggedParserAtomIndex explicitName,
+    FunctionFlags flags, uint32_t toStringStart, FunctionSyntaxKind kind,
+    GeneratorKind generatorKind, FunctionAsyncKind asyncKind, bool tryAnnexB,
+    Directives inheritedDirectives, bool* reused) {
+  MOZ_ASSERT(!*reused);
+
+  // Only functions enclosed directly by the global scope are reused, as they
+  // cannot close over any binding of the script being compiled.
+  if (!pc_->sc()->isGlobalContext() || tryAnnexB ||
+      pc_->innermostScope() != &pc_->varScope()) {
+    return true;
+  }
+  auto isWith = [](ParseContext::Statement* stmt) {
+    return stmt->kind() == StatementKind::With;
+  };
+  if (pc_->findInnermostStatement(isWith)) {
+    return true;
+  }
+
+  ReusableFunctions& reusable = *this->compilationState_.reusableFunctions;
+  Maybe<ScriptIndex> previousIndex =
+      reusable.lookup(toStringStart, flags, inheritedDirectives.strict());
+  if (!previousIndex) {
+    return true;
+  }
+
+  FunctionBox* funbox =
+      newFunctionBox(funNode, explicitName, flags, toStringStart,
+                     inheritedDirectives, generatorKind, asyncKind);
+  if (!funbox) {
+    return false;
+  }
+  funbox->initWithEnclosingParseContext(pc_, kind);
+
+  if (!reusable.copyInto(fc_, this->compilationState_, funbox,
+                         *previousIndex)) {
+    return false;
+  }
+
+  PropagateTransitiveParseFlags(funbox, pc_->sc());
+
+  if (!tokenStream.advance(funbox->extent().sourceEnd)) {
+    return false;
+  }
+
+  // Update the end position of the parse node.
+  funNode->pn_pos.end = anyChars.currentToken().pos.end;
+
+  *reused = true;
+  return true;
+}
+
 template <typename Unit>
 bool Parser<FullParseHandler, Unit>::trySyntaxParseInnerFunction(
     FunctionNode** funNode, TaggedParserAtomIndex explicitName,
@@ -3175,6 +3230,20 @@ bool Parser<FullParseHandler, Unit>::trySyntaxParseInnerFunction(
       break;
     }
 
+    // When recompiling an edited script, copy the lazy function from the
+    // previous stencil if its source text did not change.
+    if (this->compilationState_.reusableFunctions) {
+      bool reused = false;
+      if (!tryReuseInnerFunction(*funNode, explicitName, flags, toStringStart,
+                                 kind, generatorKind, asyncKind, tryAnnexB,
+                                 inheritedDirectives, &reused)) {
+        return false;
+      }
+      if (reused) {
+        return true;
+      }
+    }
+
     UsedNameTracker::RewindToken token = usedNames_.getRewindToken();
     auto statePosition = this->compilationState_.getPosition();
 
@@ -1812,6 +1812,14 @@ class MOZ_STACK_CLASS Parser<FullParseHandler, Unit> final
   [[nodiscard]] bool advancePastSyntaxParsedFunction(
       SyntaxParser* syntaxParser);
 
+  bool tryReuseInnerFunction(FunctionNodeType funNode,
+                             TaggedParserAtomIndex explicitName,
+                             FunctionFlags flags, uint32_t toStringStart,
+                             FunctionSyntaxKind kind,
+                             GeneratorKind generatorKind,
+                             FunctionAsyncKind asyncKind, bool tryAnnexB,
+                             Directives inheritedDirectives, bool* reused);
+
   bool skipLazyInnerFunction(FunctionNodeType funNode, uint32_t toStringStart,
                              bool tryAnnexB);
 
@@ -13,6 +13,8 @@
 #include "jsnum.h"  // CharsToNumber
 
 #include "frontend/CompilationStencil.h"
+#include "frontend/SharedParserAtoms.h"  // SharedParserAtomsTable
+#include "gc/Zone.h"  // Zone, SharedParserAtomCache
 #include "js/GCAPI.h"            // JS::AutoSuppressGCAnalysis
 #include "js/Printer.h"          // Sprinter, QuoteString
 #include "util/Identifier.h"     // IsIdentifier
@@ -170,6 +172,23 @@ JSAtom* ParserAtom::instantiateAtom(JSContext* cx, FrontendContext* fc,
                                     CompilationAtomCache& atomCache) const {
   MOZ_ASSERT(isInstantiatedAsJSAtom());
 
+  // Atoms shared between compilations can be found by their id, if this zone
+  // instantiated them since the last GC.
+  SharedParserAtomCache* sharedCache = nullptr;
+  if (uint32_t id = sharedId()) {
+    sharedCache = cx->zone()->sharedParserAtomCache();
+    if (sharedCache) {
+      if (JSAtom* atom = sharedCache->lookup(id)) {
+        MOZ_ASSERT(atom->length() == length());
+        SharedParserAtomsTable::getEvenIfDisabled()->noteInstantiationHit();
+        if (!atomCache.setAtomAt(fc, index, atom)) {
+          return nullptr;
+        }
+        return atom;
+      }
+    }
+  }
+
   JSAtom* atom;
   if (hasLatin1Chars()) {
     atom =
@@ -181,6 +200,9 @@ JSAtom* ParserAtom::instantiateAtom(JSContext* cx, FrontendContext* fc,
   if (!atom) {
     return nullptr;
   }
+  if (sharedCache) {
+    sharedCache->add(sharedId(), atom);
+  }
   if (!atomCache.setAtomAt(fc, index, atom)) {
     return nullptr;
   }
@@ -351,6 +373,13 @@ TaggedParserAtomIndex ParserAtomsTable::addEntry(FrontendContext* fc,
     js::ReportOutOfMemory(fc);
     return TaggedParserAtomIndex::null();
   }
+
+  if (SharedParserAtomsTable* shared = SharedParserAtomsTable::get()) {
+    if (uint32_t id = shared->lookupOrAdd(entry)) {
+      entry->setSharedId(id);
+    }
+  }
+
   return taggedIndex;
 }
 
@@ -954,10 +983,19 @@ double ParserAtomsTable::toNumber(TaggedParserAtomIndex index) const {
 
 UniqueChars ParserAtomsTable::toNewUTF8CharsZ(
     FrontendContext* fc, TaggedParserAtomIndex index) const {
+  return toNewUTF8CharsZ(
+      fc, mozilla::Span<ParserAtom* const>(entries_.begin(), entries_.length()),
+      index);
+}
+
+/* static */
+UniqueChars ParserAtomsTable::toNewUTF8CharsZ(
+    FrontendContext* fc, mozilla::Span<ParserAtom* const> entries,
+    TaggedParserAtomIndex index) {
   auto* alloc = fc->getAllocator();
 
   if (index.isParserAtomIndex()) {
-    const auto* atom = getParserAtom(index.toParserAtomIndex());
+    const auto* atom = entries[index.toParserAtomIndex()];
     return UniqueChars(
         atom->hasLatin1Chars()
             ? JS::CharsToNewUTF8CharsZ(alloc, atom->latin1Range()).c_str()
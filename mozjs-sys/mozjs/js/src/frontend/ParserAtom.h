@@ -369,6 +369,10 @@ class alignas(alignof(uint32_t)) ParserAtom {
   static constexpr uint32_t UsedByStencilFlag = 1 << 1;
   static constexpr uint32_t AtomizeFlag = 1 << 2;
 
+  // The bits above the flags hold the process-wide id of the string, if any.
+  // See SharedParserAtomsTable.
+  static constexpr uint32_t SharedIdShift = 8;
+
  public:
   // Whether to atomize the ParserAtom during instantiation.
   //
@@ -462,6 +466,12 @@ class alignas(alignof(uint32_t)) ParserAtom {
 
   bool isUsedByStencil() const { return flags_ & UsedByStencilFlag; }
 
+  // The id given by SharedParserAtomsTable, or 0.
+  uint32_t sharedId() const { return flags_ >> SharedIdShift; }
+
+  // Ids are only meaningful within the process which assigned them.
+  void clearSharedId() { flags_ &= (uint32_t(1) << SharedIdShift) - 1; }
+
  private:
   bool isMarkedAtomize() const { return flags_ & AtomizeFlag; }
 
@@ -490,6 +500,12 @@ class alignas(alignof(uint32_t)) ParserAtom {
   }
   void markAtomize(Atomize atomize) { flags_ |= uint32_t(atomize); }
 
+  void setSharedId(uint32_t id) {
+    MOZ_ASSERT(!sharedId());
+    MOZ_ASSERT(id <= (UINT32_MAX >> SharedIdShift));
+    flags_ |= id << SharedIdShift;
+  }
+
   template <typename CharT>
   const CharT* chars() const {
     MOZ_ASSERT(sizeof(CharT) == (hasTwoByteChars() ? 2 : 1));
@@ -776,6 +792,10 @@ class ParserAtomsTable {
   double toNumber(TaggedParserAtomIndex index) const;
   UniqueChars toNewUTF8CharsZ(FrontendContext* fc,
                               TaggedParserAtomIndex index) const;
+  // Same as above, for the atoms of a stencil.
+  static UniqueChars toNewUTF8CharsZ(FrontendContext* fc,
+                                     mozilla::Span<ParserAtom* const> entries,
+                                     TaggedParserAtomIndex index);
   UniqueChars toPrintableString(TaggedParserAtomIndex index) const;
   UniqueChars toQuotedString(TaggedParserAtomIndex index) const;
   JSAtom* toJSAtom(JSContext* cx, FrontendContext* fc,
@@ -0,0 +1,342 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "frontend/ReusableFunctions.h"
+
+#include "mozilla/Utf8.h"  // mozilla::Utf8Unit
+
+#include <algorithm>  // std::min, std::mismatch
+
+#include "frontend/CompilationStencil.h"  // CompilationStencil, CompilationState
+#include "frontend/FrontendContext.h"  // FrontendContext
+#include "frontend/SharedContext.h"    // FunctionBox
+#include "frontend/TokenStream.h"      // CodeUnitValue
+#include "js/ColumnNumber.h"           // JS::LimitedColumnNumberOneOrigin
+#include "js/CompileOptions.h"         // JS::ReadOnlyCompileOptions
+#include "js/friend/StackLimits.h"     // AutoCheckRecursionLimit
+#include "js/Vector.h"                 // Vector
+#include "util/Unicode.h"              // unicode::LINE_SEPARATOR
+#include "vm/JSScript.h"               // ScriptSource
+#include "vm/Scope.h"                  // ScopeKind
+
+using namespace js;
+using namespace js::frontend;
+
+using mozilla::Maybe;
+using mozilla::Nothing;
+using mozilla::Some;
+using mozilla::Utf8Unit;
+
+static bool IsLineOrParagraphSeparatorAt(const char16_t* p,
+                                         const char16_t* end) {
+  return *p == unicode::LINE_SEPARATOR || *p == unicode::PARA_SEPARATOR;
+}
+
+static bool IsLineOrParagraphSeparatorAt(const Utf8Unit* p,
+                                         const Utf8Unit* end) {
+  // U+2028 and U+2029 are encoded as E2 80 A8 and E2 80 A9.
+  return end - p >= 3 && p[0].toUint8() == 0xE2 && p[1].toUint8() == 0x80 &&
+         (p[2].toUint8() & 0xFE) == 0xA8;
+}
+
+// Count the line terminators in [begin, end), where "\r\n" counts once.
+template <typename Unit>
+static int64_t CountLineTerminators(const Unit* begin, const Unit* end) {
+  int64_t count = 0;
+  for (const Unit* p = begin; p < end; p++) {
+    auto unit = CodeUnitValue(*p);
+    if (unit == '\n') {
+      count++;
+    } else if (unit == '\r') {
+      if (p + 1 == end || CodeUnitValue(p[1]) != '\n') {
+        count++;
+      }
+    } else if (IsLineOrParagraphSeparatorAt(p, end)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+template <typename Unit>
+bool ReusableFunctions::init(JSContext* cx, FrontendContext* fc,
+                             const JS::ReadOnlyCompileOptions& options,
+                             const Unit* units, size_t length) {
+  ScriptSource* source = previous_.source;
+  if (previous_.isModule() || !source->hasSourceText() ||
+      !source->hasSourceType<Unit>()) {
+    return true;
+  }
+
+  // Extents are only comparable if both scripts start at the same position.
+  const ScriptStencilExtra& topLevel =
+      previous_.scriptExtra[CompilationStencil::TopLevelIndex];
+  if (topLevel.extent.lineno != options.lineno ||
+      topLevel.extent.column !=
+          JS::LimitedColumnNumberOneOrigin::fromUnlimited(options.column)) {
+    return true;
+  }
+  previousStrict_ = topLevel.strict();
+
+  size_t previousLength = source->length();
+  UncompressedSourceCache::AutoHoldEntry holder;
+  ScriptSource::PinnedUnits<Unit> pinned(cx, source, holder, 0,
+                                         previousLength);
+  if (!pinned.get()) {
+    return false;
+  }
+  const Unit* previousUnits = pinned.get();
+  const Unit* previousEnd = previousUnits + previousLength;
+  const Unit* end = units + length;
+
+  // Find the unchanged prefix, and truncate it after its last "\n".
+  size_t prefix =
+      std::mismatch(previousUnits, previousEnd, units, end).first -
+      previousUnits;
+  while (prefix > 0 && CodeUnitValue(units[prefix - 1]) != '\n') {
+    prefix--;
+  }
+
+  // Find the unchanged suffix, not overlapping the prefix, and truncate it
+  // before its first line.
+  size_t maxSuffix = std::min(previousLength, length) - prefix;
+  size_t suffix = 0;
+  while (suffix < maxSuffix &&
+         previousEnd[-1 - ptrdiff_t(suffix)] == end[-1 - ptrdiff_t(suffix)]) {
+    suffix++;
+  }
+  while (suffix > 0 && CodeUnitValue(end[-ptrdiff_t(suffix)]) != '\n') {
+    suffix--;
+  }
+  if (suffix > 0) {
+    // Skip the "\n" which ends the last edited line.
+    suffix--;
+  }
+
+  previousSuffixStart_ = previousLength - suffix;
+  offsetDelta_ = int64_t(length) - int64_t(previousLength);
+  lineDelta_ =
+      CountLineTerminators(units + prefix, end - suffix) -
+      CountLineTerminators(previousUnits + prefix, previousEnd - suffix);
+
+  const ScriptStencil& topLevelData =
+      previous_.scriptData[CompilationStencil::TopLevelIndex];
+  for (TaggedScriptThingIndex thing : topLevelData.gcthings(previous_)) {
+    if (!thing.isFunction()) {
+      continue;
+    }
+
+    ScriptIndex index = thing.toFunction();
+    const ScriptStencil& data = previous_.scriptData[index];
+    if (data.hasSharedData() || data.isGhost() ||
+        !data.functionFlags.hasBaseScript() ||
+        !data.hasLazyFunctionEnclosingScopeIndex()) {
+      continue;
+    }
+
+    // Only functions which are directly enclosed by the global scope.
+    ScopeKind enclosingKind =
+        previous_.scopeData[data.lazyFunctionEnclosingScopeIndex()].kind();
+    if (enclosingKind != ScopeKind::Global &&
+        enclosingKind != ScopeKind::NonSyntactic) {
+      continue;
+    }
+
+    const SourceExtent& extent = previous_.scriptExtra[index].extent;
+    uint32_t toStringStart;
+    if (extent.toStringEnd <= prefix) {
+      toStringStart = extent.toStringStart;
+    } else if (extent.toStringStart >= previousSuffixStart_) {
+      toStringStart = uint32_t(int64_t(extent.toStringStart) + offsetDelta_);
+    } else {
+      continue;
+    }
+
+    if (!functions_.putNew(toStringStart, index)) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template bool ReusableFunctions::init(JSContext* cx, FrontendContext* fc,
+                                      const JS::ReadOnlyCompileOptions& options,
+                                      const Utf8Unit* units, size_t length);
+template bool ReusableFunctions::init(JSContext* cx, FrontendContext* fc,
+                                      const JS::ReadOnlyCompileOptions& options,
+                                      const char16_t* units, size_t length);
+
+Maybe<ScriptIndex> ReusableFunctions::lookup(uint32_t toStringStart,
+                                             FunctionFlags flags,
+                                             bool strict) const {
+  // The strictness of the global scope is inherited by the functions.
+  if (strict != previousStrict_) {
+    return Nothing();
+  }
+
+  auto p = functions_.lookup(toStringStart);
+  if (!p) {
+    return Nothing();
+  }
+
+  // Methods, accessors and class constructors depend on their enclosing
+  // object or class, which is always parsed again.
+  if (flags.kind() != FunctionFlags::NormalFunction &&
+      flags.kind() != FunctionFlags::Arrow) {
+    return Nothing();
+  }
+
+  // The same source text can be parsed as a different kind of function, if
+  // the edit changed its context.
+  FunctionFlags previousFlags = previous_.scriptData[p->value()].functionFlags;
+  if (previousFlags.kind() != flags.kind() ||
+      previousFlags.isLambda() != flags.isLambda()) {
+    return Nothing();
+  }
+
+  return Some(p->value());
+}
+
+SourceExtent ReusableFunctions::shiftedExtent(
+    const SourceExtent& extent) const {
+  if (extent.toStringStart < previousSuffixStart_) {
+    return extent;
+  }
+
+  SourceExtent shifted = extent;
+  shifted.sourceStart = uint32_t(int64_t(extent.sourceStart) + offsetDelta_);
+  shifted.sourceEnd = uint32_t(int64_t(extent.sourceEnd) + offsetDelta_);
+  shifted.toStringStart =
+      uint32_t(int64_t(extent.toStringStart) + offsetDelta_);
+  shifted.toStringEnd = uint32_t(int64_t(extent.toStringEnd) + offsetDelta_);
+  shifted.lineno = uint32_t(int64_t(extent.lineno) + lineDelta_);
+  return shifted;
+}
+
+bool ReusableFunctions::copyInto(FrontendContext* fc,
+                                 CompilationState& compilationState,
+                                 FunctionBox* funbox,
+                                 ScriptIndex previousIndex) {
+  ScriptStencilExtra extra = previous_.scriptExtra[previousIndex];
+  extra.extent = shiftedExtent(extra.extent);
+  MOZ_ASSERT(extra.extent.toStringStart == funbox->extent().toStringStart);
+
+  // Fill the FunctionBox as the syntax parser would have done.
+  funbox->initFromScriptStencilExtra(extra);
+  funbox->setArgCount(extra.nargs);
+  if (funbox->useMemberInitializers()) {
+    funbox->setMemberInitializers(extra.memberInitializers());
+  }
+
+  if (!copyGCThings(fc, compilationState, previousIndex, funbox->index())) {
+    return false;
+  }
+
+  funbox->copyFunctionFields(funbox->functionStencil());
+  ScriptStencilExtra& scriptExtra = funbox->functionExtraStencil();
+  funbox->copyFunctionExtraFields(scriptExtra);
+  funbox->copyScriptExtraFields(scriptExtra);
+
+  reusedFunctions_++;
+  return true;
+}
+
+bool ReusableFunctions::copyInnerFunction(FrontendContext* fc,
+                                          CompilationState& compilationState,
+                                          ScriptIndex previousIndex,
+                                          ScriptIndex* index) {
+  *index = ScriptIndex(compilationState.scriptData.length());
+  if (uint32_t(*index) >= TaggedScriptThingIndex::IndexLimit) {
+    ReportAllocationOverflow(fc);
+    return false;
+  }
+  if (!compilationState.appendScriptStencilAndData(fc)) {
+    return false;
+  }
+
+  const ScriptStencil& previousData = previous_.scriptData[previousIndex];
+  TaggedParserAtomIndex functionAtom;
+  if (previousData.functionAtom) {
+    functionAtom = compilationState.parserAtoms.internExternalParserAtomIndex(
+        fc, previous_, previousData.functionAtom);
+    if (!functionAtom) {
+      return false;
+    }
+    compilationState.parserAtoms.markUsedByStencil(functionAtom,
+                                                   ParserAtom::Atomize::Yes);
+  }
+
+  ScriptStencil& data = compilationState.scriptData[*index];
+  data.functionAtom = functionAtom;
+  data.functionFlags = previousData.functionFlags;
+
+  ScriptStencilExtra& extra = compilationState.scriptExtra[*index];
+  extra = previous_.scriptExtra[previousIndex];
+  extra.extent = shiftedExtent(extra.extent);
+
+  if (!copyGCThings(fc, compilationState, previousIndex, *index)) {
+    return false;
+  }
+
+  reusedFunctions_++;
+  return true;
+}
+
+bool ReusableFunctions::copyGCThings(FrontendContext* fc,
+                                     CompilationState& compilationState,
+                                     ScriptIndex previousIndex,
+                                     ScriptIndex index) {
+  AutoCheckRecursionLimit recursion(fc);
+  if (!recursion.check(fc)) {
+    return false;
+  }
+
+  auto previousThings =
+      previous_.scriptData[previousIndex].gcthings(previous_);
+  if (previousThings.empty()) {
+    return true;
+  }
+
+  // The gc-things of a lazy function are its inner functions, followed by
+  // the closed-over bindings of its scopes separated by null entries.
+  Vector<TaggedScriptThingIndex, 8, SystemAllocPolicy> things;
+  if (!things.reserve(previousThings.size())) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+
+  for (TaggedScriptThingIndex thing : previousThings) {
+    if (thing.isFunction()) {
+      ScriptIndex inner;
+      if (!copyInnerFunction(fc, compilationState, thing.toFunction(),
+                             &inner)) {
+        return false;
+      }
+      things.infallibleAppend(TaggedScriptThingIndex(inner));
+      continue;
+    }
+
+    if (thing.isNull()) {
+      things.infallibleAppend(TaggedScriptThingIndex());
+      continue;
+    }
+
+    MOZ_ASSERT(thing.isAtom());
+    TaggedParserAtomIndex atom =
+        compilationState.parserAtoms.internExternalParserAtomIndex(
+            fc, previous_, thing.toAtom());
+    if (!atom) {
+      return false;
+    }
+    compilationState.parserAtoms.markUsedByStencil(atom,
+                                                   ParserAtom::Atomize::Yes);
+    things.infallibleAppend(TaggedScriptThingIndex(atom));
+  }
+
+  return compilationState.appendGCThings(fc, index, things);
+}
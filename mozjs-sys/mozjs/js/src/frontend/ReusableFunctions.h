@@ -0,0 +1,115 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef frontend_ReusableFunctions_h
+#define frontend_ReusableFunctions_h
+
+#include "mozilla/Attributes.h"  // MOZ_STACK_CLASS
+#include "mozilla/Maybe.h"       // mozilla::Maybe
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t, int64_t
+
+#include "frontend/ScriptIndex.h"  // ScriptIndex
+#include "js/AllocPolicy.h"        // SystemAllocPolicy
+#include "js/HashTable.h"          // HashMap
+#include "js/TypeDecls.h"          // JSContext
+#include "vm/FunctionFlags.h"      // FunctionFlags
+#include "vm/SharedStencil.h"      // SourceExtent
+
+namespace JS {
+class JS_PUBLIC_API ReadOnlyCompileOptions;
+}
+
+namespace js {
+
+class FrontendContext;
+
+namespace frontend {
+
+struct CompilationStencil;
+struct CompilationState;
+class FunctionBox;
+
+// When a global script is compiled again after an edit of its source text,
+// the lazy functions of the previous initial stencil which are defined
+// directly in the global scope, and whose source text did not change, are
+// copied into the new stencil with all their inner functions, instead of being
+// syntax parsed again.
+//
+// The previous and the new source texts are split into an unchanged prefix,
+// the edited lines, and an unchanged suffix. Functions of the prefix keep
+// their extent, and functions of the suffix are shifted by the difference of
+// length and of line count of the edited lines. As the prefix ends and the
+// suffix starts at a line boundary, columns are unchanged.
+//
+// Functions defined in the global scope only refer to global names, which are
+// never closed over, so they can be skipped without tracking their free names
+// in the enclosing scopes.
+class MOZ_STACK_CLASS ReusableFunctions {
+  const CompilationStencil& previous_;
+
+  // Offset, within the previous source text, of the unchanged suffix.
+  uint32_t previousSuffixStart_ = 0;
+
+  // Shift to apply to the extent of functions located in the suffix.
+  int64_t offsetDelta_ = 0;
+  int64_t lineDelta_ = 0;
+
+  // Map the toStringStart of the reusable functions, as an offset within the
+  // new source text, to their index in the previous stencil.
+  using FunctionMap = HashMap<uint32_t, ScriptIndex, DefaultHasher<uint32_t>,
+                              SystemAllocPolicy>;
+  FunctionMap functions_;
+
+  // Whether the top-level script of the previous stencil was strict.
+  bool previousStrict_ = false;
+
+  // Number of functions, including inner functions, copied so far.
+  uint32_t reusedFunctions_ = 0;
+
+ public:
+  explicit ReusableFunctions(const CompilationStencil& previous)
+      : previous_(previous) {}
+
+  // Compare the source text of the previous stencil with the new source text,
+  // and register the functions which can be reused. If the previous stencil
+  // cannot be compared, nothing gets registered.
+  template <typename Unit>
+  [[nodiscard]] bool init(JSContext* cx, FrontendContext* fc,
+                          const JS::ReadOnlyCompileOptions& options,
+                          const Unit* units, size_t length);
+
+  // Return the index, in the previous stencil, of the function which can be
+  // reused for the function being parsed at |toStringStart| with |flags|.
+  mozilla::Maybe<ScriptIndex> lookup(uint32_t toStringStart,
+                                     FunctionFlags flags, bool strict) const;
+
+  // Copy the previous function at |previousIndex| and its inner functions into
+  // |compilationState|, as the lazy stencil of |funbox|.
+  [[nodiscard]] bool copyInto(FrontendContext* fc,
+                              CompilationState& compilationState,
+                              FunctionBox* funbox, ScriptIndex previousIndex);
+
+  uint32_t reusedFunctions() const { return reusedFunctions_; }
+
+ private:
+  SourceExtent shiftedExtent(const SourceExtent& extent) const;
+
+  [[nodiscard]] bool copyInnerFunction(FrontendContext* fc,
+                                       CompilationState& compilationState,
+                                       ScriptIndex previousIndex,
+                                       ScriptIndex* index);
+  [[nodiscard]] bool copyGCThings(FrontendContext* fc,
+                                  CompilationState& compilationState,
+                                  ScriptIndex previousIndex,
+                                  ScriptIndex index);
+};
+
+} /* namespace frontend */
+} /* namespace js */
+
+#endif /* frontend_ReusableFunctions_h */
@@ -0,0 +1,147 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "frontend/SharedParserAtoms.h"
+
+#include <algorithm>  // std::min
+#include <new>        // placement new
+#include <string.h>   // memcmp, memcpy
+
+#include "frontend/ParserAtom.h"  // ParserAtom
+#include "js/experimental/CompileScript.h"  // JS::SharedParserAtomsStats, JS::{Enable,Disable}SharedParserAtoms
+#include "js/Utility.h"  // js_pod_malloc, js_delete, js_free, js_new
+#include "threading/LockGuard.h"  // LockGuard
+#include "vm/MutexIDs.h"          // mutexid
+
+using namespace js;
+using namespace js::frontend;
+
+mozilla::Atomic<SharedParserAtomsTable*, mozilla::ReleaseAcquire>
+    SharedParserAtomsTable::singleton_;
+mozilla::Atomic<bool, mozilla::ReleaseAcquire>
+    SharedParserAtomsTable::enabled_;
+
+static size_t CharsSize(const ParserAtom* atom) {
+  return atom->length() *
+         (atom->hasTwoByteChars() ? sizeof(char16_t) : sizeof(Latin1Char));
+}
+
+static const void* CharsOf(const ParserAtom* atom) {
+  // The characters are stored immediately after the ParserAtom.
+  return atom + 1;
+}
+
+/* static */
+HashNumber SharedParserAtomsTable::EntryHasher::hash(const Lookup& l) {
+  return l->hash();
+}
+
+/* static */
+bool SharedParserAtomsTable::EntryHasher::match(const Entry* entry,
+                                                const Lookup& l) {
+  // ParserAtoms are stored as Latin1 whenever possible, so equal strings
+  // always have the same character width.
+  return entry->hash == l->hash() && entry->length == l->length() &&
+         entry->hasTwoByteChars == l->hasTwoByteChars() &&
+         memcmp(entry->chars(), CharsOf(l), CharsSize(l)) == 0;
+}
+
+SharedParserAtomsTable::Shard::Shard() : lock(mutexid::SharedParserAtoms) {}
+
+SharedParserAtomsTable::Shard::~Shard() {
+  for (auto iter = entries.iter(); !iter.done(); iter.next()) {
+    js_free(iter.get());
+  }
+}
+
+/* static */
+bool SharedParserAtomsTable::enable() {
+  if (!singleton_) {
+    SharedParserAtomsTable* table = js_new<SharedParserAtomsTable>();
+    if (!table) {
+      return false;
+    }
+    if (!singleton_.compareExchange(nullptr, table)) {
+      js_delete(table);
+    }
+  }
+
+  enabled_ = true;
+  return true;
+}
+
+/* static */
+void SharedParserAtomsTable::disable() { enabled_ = false; }
+
+/* static */
+void SharedParserAtomsTable::freeSingleton() {
+  enabled_ = false;
+  js_delete(singleton_.exchange(nullptr));
+}
+
+uint32_t SharedParserAtomsTable::lookupOrAdd(const ParserAtom* atom) {
+  lookups_++;
+
+  Shard& shard = shards_[atom->hash() & (ShardCount - 1)];
+  LockGuard<Mutex> guard(shard.lock);
+
+  EntrySet::AddPtr p = shard.entries.lookupForAdd(atom);
+  if (p) {
+    duplicates_++;
+    return (*p)->id;
+  }
+
+  size_t charsSize = CharsSize(atom);
+  if (bytes_ + sizeof(Entry) + charsSize > MaxBytes || nextId_ > MaxId) {
+    return 0;
+  }
+
+  uint8_t* mem = js_pod_malloc<uint8_t>(sizeof(Entry) + charsSize);
+  if (!mem) {
+    return 0;
+  }
+  Entry* entry = new (mem) Entry();
+  entry->hash = atom->hash();
+  entry->length = atom->length();
+  entry->hasTwoByteChars = atom->hasTwoByteChars();
+  memcpy(mem + sizeof(Entry), CharsOf(atom), charsSize);
+
+  // Other shards may concurrently take the last ids.
+  entry->id = nextId_++;
+  if (entry->id > MaxId || !shard.entries.add(p, entry)) {
+    js_free(mem);
+    return 0;
+  }
+
+  bytes_ += sizeof(Entry) + charsSize;
+  return entry->id;
+}
+
+void SharedParserAtomsTable::getStats(
+    JS::SharedParserAtomsStats* stats) const {
+  stats->lookups = lookups_;
+  stats->duplicates = duplicates_;
+  stats->entries = std::min(uint32_t(nextId_ - 1), MaxId);
+  stats->bytes = bytes_;
+  stats->instantiationHits = instantiationHits_;
+}
+
+JS_PUBLIC_API bool JS::EnableSharedParserAtoms() {
+  return SharedParserAtomsTable::enable();
+}
+
+JS_PUBLIC_API void JS::DisableSharedParserAtoms() {
+  SharedParserAtomsTable::disable();
+}
+
+JS_PUBLIC_API void JS::GetSharedParserAtomsStats(
+    JS::SharedParserAtomsStats* stats) {
+  *stats = JS::SharedParserAtomsStats();
+  if (SharedParserAtomsTable* table =
+          SharedParserAtomsTable::getEvenIfDisabled()) {
+    table->getStats(stats);
+  }
+}
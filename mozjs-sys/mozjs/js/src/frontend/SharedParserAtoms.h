@@ -0,0 +1,128 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef frontend_SharedParserAtoms_h
+#define frontend_SharedParserAtoms_h
+
+#include "mozilla/Atomics.h"  // mozilla::Atomic
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t, uint64_t
+
+#include "js/AllocPolicy.h"   // SystemAllocPolicy
+#include "js/HashTable.h"     // HashSet, HashNumber
+#include "threading/Mutex.h"  // Mutex
+
+namespace JS {
+struct SharedParserAtomsStats;
+}
+
+namespace js {
+namespace frontend {
+
+class ParserAtom;
+
+// A process-wide table of the parser atoms interned by all compilations, which
+// gives each distinct string a process-wide id.
+//
+// Each ParserAtomsTable still owns its ParserAtoms, but records in them the id
+// of their string when they are added. Compilations running concurrently on
+// helper threads then agree on the id of the identifiers they share, and the
+// instantiation of their stencils can look up the JSAtom previously created
+// for an id in the per-zone SharedParserAtomCache, without hashing the string
+// or comparing its characters.
+//
+// The table is sharded by hash, with one lock per shard, so that concurrent
+// compilations rarely contend. Entries are never removed, so an id remains
+// valid until JS_ShutDown. Once the table reaches its size limit, new strings
+// get no id, and are instantiated as usual.
+//
+// The table only exists once enabled with JS::EnableSharedParserAtoms. It is
+// kept when it is disabled with JS::DisableSharedParserAtoms, so that the ids
+// already given to parser atoms and cached by zones remain valid, and enabling
+// it again keeps using the same ids.
+class SharedParserAtomsTable {
+  struct Entry {
+    HashNumber hash;
+    uint32_t length;
+    uint32_t id;
+    bool hasTwoByteChars;
+
+    // The characters are stored immediately after the Entry.
+    const void* chars() const { return this + 1; }
+  };
+
+  struct EntryHasher {
+    using Lookup = const ParserAtom*;
+
+    static HashNumber hash(const Lookup& l);
+    static bool match(const Entry* entry, const Lookup& l);
+  };
+
+  using EntrySet = HashSet<Entry*, EntryHasher, SystemAllocPolicy>;
+
+  struct Shard {
+    Mutex lock MOZ_UNANNOTATED;
+    EntrySet entries;
+
+    Shard();
+    ~Shard();
+  };
+
+  static constexpr size_t ShardCount = 16;
+  Shard shards_[ShardCount];
+
+  // The next id to assign. Zero is reserved for atoms without id.
+  mozilla::Atomic<uint32_t, mozilla::ReleaseAcquire> nextId_{1};
+
+  // The memory used by the entries and their characters.
+  mozilla::Atomic<size_t, mozilla::Relaxed> bytes_{0};
+
+  mozilla::Atomic<uint64_t, mozilla::Relaxed> lookups_{0};
+  mozilla::Atomic<uint64_t, mozilla::Relaxed> duplicates_{0};
+  mozilla::Atomic<uint64_t, mozilla::Relaxed> instantiationHits_{0};
+
+  static mozilla::Atomic<SharedParserAtomsTable*, mozilla::ReleaseAcquire>
+      singleton_;
+  static mozilla::Atomic<bool, mozilla::ReleaseAcquire> enabled_;
+
+ public:
+  // Ids are stored in the flags of ParserAtom, above its own flags.
+  static constexpr uint32_t IdBits = 24;
+  static constexpr uint32_t MaxId = (uint32_t(1) << IdBits) - 1;
+
+  // Stop adding strings once their characters use that much memory.
+  static constexpr size_t MaxBytes = 32 * 1024 * 1024;
+
+  static bool enable();
+  static void disable();
+  static void freeSingleton();
+
+  // Returns nullptr unless the table is enabled.
+  static SharedParserAtomsTable* get() {
+    if (!enabled_) {
+      return nullptr;
+    }
+    return singleton_;
+  }
+
+  // Returns the table if it was ever enabled, to find the strings of ids which
+  // were given while it was enabled.
+  static SharedParserAtomsTable* getEvenIfDisabled() { return singleton_; }
+
+  // Return the id of the string of |atom|, adding it to the table if needed.
+  // Returns 0 if the string cannot get an id. This never reports an error.
+  uint32_t lookupOrAdd(const ParserAtom* atom);
+
+  void noteInstantiationHit() { instantiationHits_++; }
+
+  void getStats(JS::SharedParserAtomsStats* stats) const;
+};
+
+} /* namespace frontend */
+} /* namespace js */
+
+#endif /* frontend_SharedParserAtoms_h */
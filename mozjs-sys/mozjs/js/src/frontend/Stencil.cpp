@@ -1922,20 +1922,23 @@ Scope* ScopeStencil::enclosingExistingScope(
 
 Scope* ScopeStencil::createScope(JSContext* cx, CompilationInput& input,
                                  CompilationGCOutput& gcOutput,
-                                 BaseParserScopeData* baseScopeData) const {
+                                 BaseParserScopeData* baseScopeData,
+                                 ScopeDataBuffer* preallocatedData) const {
   Rooted<Scope*> enclosingScope(cx, enclosingExistingScope(input, gcOutput));
-  return createScope(cx, input.atomCache, enclosingScope, baseScopeData);
+  return createScope(cx, input.atomCache, enclosingScope, baseScopeData,
+                     preallocatedData);
 }
 
 Scope* ScopeStencil::createScope(JSContext* cx, CompilationAtomCache& atomCache,
                                  Handle<Scope*> enclosingScope,
-                                 BaseParserScopeData* baseScopeData) const {
+                                 BaseParserScopeData* baseScopeData,
+                                 ScopeDataBuffer* preallocatedData) const {
   switch (kind()) {
     case ScopeKind::Function: {
       using ScopeType = FunctionScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, CallObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::Lexical:
     case ScopeKind::SimpleCatch:
@@ -1946,45 +1949,45 @@ Scope* ScopeStencil::createScope(JSContext* cx, CompilationAtomCache& atomCache,
       using ScopeType = LexicalScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, BlockLexicalEnvironmentObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::ClassBody: {
       using ScopeType = ClassBodyScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, BlockLexicalEnvironmentObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::FunctionBodyVar: {
       using ScopeType = VarScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, VarEnvironmentObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::Global:
     case ScopeKind::NonSyntactic: {
       using ScopeType = GlobalScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, std::nullptr_t>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::Eval:
     case ScopeKind::StrictEval: {
       using ScopeType = EvalScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, VarEnvironmentObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::Module: {
       using ScopeType = ModuleScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, ModuleEnvironmentObject>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::With: {
       using ScopeType = WithScope;
       MOZ_ASSERT(matchScopeKind<ScopeType>(kind()));
       return createSpecificScope<ScopeType, std::nullptr_t>(
-          cx, atomCache, enclosingScope, baseScopeData);
+          cx, atomCache, enclosingScope, baseScopeData, preallocatedData);
     }
     case ScopeKind::WasmFunction:
     case ScopeKind::WasmInstance: {
@@ -1995,6 +1998,46 @@ Scope* ScopeStencil::createScope(JSContext* cx, CompilationAtomCache& atomCache,
   MOZ_CRASH();
 }
 
+template <typename SpecificScopeT>
+static size_t RuntimeScopeDataSize(const BaseParserScopeData* baseScopeData) {
+  return SizeOfScopeData<typename SpecificScopeT::RuntimeData>(
+      baseScopeData->length);
+}
+
+size_t ScopeStencil::runtimeDataSize(
+    const BaseParserScopeData* baseScopeData) const {
+  switch (kind()) {
+    case ScopeKind::Function:
+      return RuntimeScopeDataSize<FunctionScope>(baseScopeData);
+    case ScopeKind::Lexical:
+    case ScopeKind::SimpleCatch:
+    case ScopeKind::Catch:
+    case ScopeKind::NamedLambda:
+    case ScopeKind::StrictNamedLambda:
+    case ScopeKind::FunctionLexical:
+      return RuntimeScopeDataSize<LexicalScope>(baseScopeData);
+    case ScopeKind::ClassBody:
+      return RuntimeScopeDataSize<ClassBodyScope>(baseScopeData);
+    case ScopeKind::FunctionBodyVar:
+      return RuntimeScopeDataSize<VarScope>(baseScopeData);
+    case ScopeKind::Global:
+    case ScopeKind::NonSyntactic:
+      return RuntimeScopeDataSize<GlobalScope>(baseScopeData);
+    case ScopeKind::Eval:
+    case ScopeKind::StrictEval:
+      return RuntimeScopeDataSize<EvalScope>(baseScopeData);
+    case ScopeKind::Module:
+      return RuntimeScopeDataSize<ModuleScope>(baseScopeData);
+    case ScopeKind::With:
+      return 0;
+    case ScopeKind::WasmFunction:
+    case ScopeKind::WasmInstance:
+      // ScopeStencil does not support WASM
+      break;
+  }
+  MOZ_CRASH();
+}
+
 bool CompilationState::prepareSharedDataStorage(FrontendContext* fc) {
   size_t allScriptCount = scriptData.length();
   size_t nonLazyScriptCount = nonLazyFunctionCount;
@@ -2278,9 +2321,16 @@ static bool InstantiateScopes(JSContext* cx, CompilationInput& input,
 
   MOZ_ASSERT(stencil.scopeData.size() == stencil.scopeNames.size());
   size_t scopeCount = stencil.scopeData.size();
+
+  // The runtime data of the scopes can be allocated off-thread by
+  // JS::PrepareForInstantiate.
+  MOZ_ASSERT_IF(!gcOutput.scopeData.empty(),
+                gcOutput.scopeData.length() == scopeCount);
+
   for (size_t i = 0; i < scopeCount; i++) {
-    Scope* scope = stencil.scopeData[i].createScope(cx, input, gcOutput,
-                                                    stencil.scopeNames[i]);
+    Scope* scope = stencil.scopeData[i].createScope(
+        cx, input, gcOutput, stencil.scopeNames[i],
+        gcOutput.preallocatedScopeData(ScopeIndex(i)));
     if (!scope) {
       return false;
     }
@@ -3043,8 +3093,52 @@ bool CompilationStencil::prepareForInstantiate(
 bool CompilationStencil::prepareForInstantiate(
     FrontendContext* fc, const CompilationStencil& stencil,
     PreallocatedCompilationGCOutput& gcOutput) {
-  return gcOutput.allocate(fc, stencil.scriptData.size(),
-                           stencil.scopeData.size());
+  if (!gcOutput.allocate(fc, stencil.scriptData.size(),
+                         stencil.scopeData.size())) {
+    return false;
+  }
+
+  return gcOutput.allocateInstantiationData(fc, stencil);
+}
+
+bool PreallocatedCompilationGCOutput::allocateInstantiationData(
+    FrontendContext* fc, const CompilationStencil& stencil) {
+  if (!atoms.resize(stencil.parserAtomData.size())) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+
+  size_t scopeCount = stencil.scopeData.size();
+  if (!scopeData.reserve(scopeCount)) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+  for (size_t i = 0; i < scopeCount; i++) {
+    const BaseParserScopeData* baseScopeData = stencil.scopeNames[i];
+    size_t size =
+        baseScopeData ? stencil.scopeData[i].runtimeDataSize(baseScopeData) : 0;
+
+    ScopeDataBuffer buffer;
+    if (size && !buffer.allocate(size)) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+    scopeData.infallibleAppend(std::move(buffer));
+  }
+
+  return true;
+}
+
+size_t PreallocatedCompilationGCOutput::sizeOfExcludingThis(
+    mozilla::MallocSizeOf mallocSizeOf) const {
+  size_t size = functions.sizeOfExcludingThis(mallocSizeOf) +
+                scopes.sizeOfExcludingThis(mallocSizeOf) +
+                atoms.sizeOfExcludingThis(mallocSizeOf) +
+                scopeData.sizeOfExcludingThis(mallocSizeOf);
+  for (const ScopeDataBuffer& buffer : scopeData) {
+    size += mallocSizeOf(buffer.get());
+  }
+  return size;
 }
 
 bool JS::PrepareForInstantiate(JS::FrontendContext* fc, JS::Stencil& stencil,
@@ -3765,6 +3859,35 @@ const CompilationStencil* InitialStencilAndDelazifications::storeDelazification(
   return delazifications_[functionIndex - 1];
 }
 
+void InitialStencilAndDelazifications::recordFirstCall(
+    const SourceExtent& extent) {
+  auto firstCalls = firstCalls_.lock();
+  (void)firstCalls->append(
+      JS::DelazificationProfileEntry{extent.sourceStart, extent.sourceEnd});
+}
+
+bool InitialStencilAndDelazifications::getFirstCalls(
+    JS::DelazificationProfile& profile) const {
+  profile.clear();
+
+  // The same stencil can be instantiated in multiple realms, in which case
+  // each realm records its own first calls.
+  HashSet<uint32_t, DefaultHasher<uint32_t>, SystemAllocPolicy> seen;
+
+  auto firstCalls = firstCalls_.lock();
+  for (const JS::DelazificationProfileEntry& entry : firstCalls.get()) {
+    auto p = seen.lookupForAdd(entry.sourceStart);
+    if (p) {
+      continue;
+    }
+    if (!seen.add(p, entry.sourceStart) || !profile.append(entry)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 CompilationStencil* InitialStencilAndDelazifications::getMerged(
     FrontendContext* fc) const {
   MOZ_ASSERT(canLazilyParse());
@@ -3823,6 +3946,12 @@ bool InitialStencilAndDelazifications::instantiateStencils(
     }
   }
 
+  // When recording the first calls, leave the functions lazy such that their
+  // first call still goes through the delazification cache, and is recorded.
+  if (input.options.profileGuidedDelazification()) {
+    return true;
+  }
+
   // At this point, gcOutput.script contains the top-level script, and
   // gcOutput.functions[i] contains i-th function, where 0-th item is
   // always nullptr.
@@ -3884,6 +4013,7 @@ size_t InitialStencilAndDelazifications::sizeOfExcludingThis(
   }
 
   size += functionKeyToInitialScriptIndex_.sizeOfExcludingThis(mallocSizeOf);
+  size += firstCalls_.lock()->sizeOfExcludingThis(mallocSizeOf);
 
   return size;
 }
@@ -5301,6 +5431,11 @@ void CompilationAtomCache::releaseBuffer(AtomCacheVector& atoms) {
   atoms = std::move(atoms_);
 }
 
+void CompilationAtomCache::steal(PreallocatedCompilationGCOutput&& pre) {
+  MOZ_ASSERT(atoms_.empty());
+  atoms_ = std::move(pre.atoms);
+}
+
 bool CompilationState::allocateGCThingsUninitialized(
     FrontendContext* fc, ScriptIndex scriptIndex, size_t length,
     TaggedScriptThingIndex** cursor) {
@@ -5869,6 +6004,7 @@ JS_PUBLIC_API JSScript* JS::InstantiateGlobalStencil(
   Rooted<CompilationInput> input(cx, CompilationInput(compileOptions));
   Rooted<CompilationGCOutput> gcOutput(cx);
   if (storage) {
+    input.get().atomCache.steal(std::move(*storage->gcOutput_));
     gcOutput.get().steal(std::move(*storage->gcOutput_));
   }
 
@@ -5894,6 +6030,7 @@ JS_PUBLIC_API JSObject* JS::InstantiateModuleStencil(
   Rooted<CompilationInput> input(cx, CompilationInput(compileOptions));
   Rooted<CompilationGCOutput> gcOutput(cx);
   if (storage) {
+    input.get().atomCache.steal(std::move(*storage->gcOutput_));
     gcOutput.get().steal(std::move(*storage->gcOutput_));
   }
 
@@ -294,6 +294,35 @@ class BigIntStencil {
 
 using BigIntStencilVector = Vector<BigIntStencil, 0, js::SystemAllocPolicy>;
 
+// Memory allocated ahead of instantiation for the runtime data of a scope, see
+// ScopeStencil::runtimeDataSize.
+class ScopeDataBuffer {
+  UniquePtr<uint8_t[], JS::FreePolicy> bytes_;
+  size_t size_ = 0;
+
+ public:
+  // Allocate |size| bytes in the arena of JSContext allocations, which the
+  // scope data would otherwise come from.
+  [[nodiscard]] bool allocate(size_t size) {
+    MOZ_ASSERT(!bytes_);
+    bytes_.reset(js_pod_arena_malloc<uint8_t>(js::MallocArena, size));
+    if (!bytes_) {
+      return false;
+    }
+    size_ = size;
+    return true;
+  }
+
+  explicit operator bool() const { return !!bytes_; }
+  const uint8_t* get() const { return bytes_.get(); }
+  size_t size() const { return size_; }
+
+  uint8_t* release() {
+    size_ = 0;
+    return bytes_.release();
+  }
+};
+
 class ScopeStencil {
   friend class StencilXDR;
   friend class InputScope;
@@ -451,12 +480,21 @@ class ScopeStencil {
 
   bool isArrow() const { return flags_ & IsArrow; }
 
+  // If |preallocatedData| is not null and holds a buffer, the runtime data of
+  // the scope is created in it instead of allocating it.
   Scope* createScope(JSContext* cx, CompilationInput& input,
                      CompilationGCOutput& gcOutput,
-                     BaseParserScopeData* baseScopeData) const;
+                     BaseParserScopeData* baseScopeData,
+                     ScopeDataBuffer* preallocatedData = nullptr) const;
   Scope* createScope(JSContext* cx, CompilationAtomCache& atomCache,
                      Handle<Scope*> enclosingScope,
-                     BaseParserScopeData* baseScopeData) const;
+                     BaseParserScopeData* baseScopeData,
+                     ScopeDataBuffer* preallocatedData = nullptr) const;
+
+  // The size of the runtime data of the scope created by createScope, or 0 if
+  // the scope has no data. This does not depend on the JSContext, such that
+  // the data can be allocated off-thread.
+  size_t runtimeDataSize(const BaseParserScopeData* baseScopeData) const;
 
 #if defined(DEBUG) || defined(JS_JITSPEW)
   void dump() const;
@@ -471,7 +509,7 @@ class ScopeStencil {
   template <typename SpecificScopeType>
   UniquePtr<typename SpecificScopeType::RuntimeData> createSpecificScopeData(
       JSContext* cx, CompilationAtomCache& atomCache,
-      BaseParserScopeData* baseData) const;
+      BaseParserScopeData* baseData, ScopeDataBuffer* preallocatedData) const;
 
   template <typename SpecificEnvironmentType>
   [[nodiscard]] bool createSpecificShape(
@@ -481,7 +519,8 @@ class ScopeStencil {
   template <typename SpecificScopeType, typename SpecificEnvironmentType>
   Scope* createSpecificScope(JSContext* cx, CompilationAtomCache& atomCache,
                              Handle<Scope*> enclosingScope,
-                             BaseParserScopeData* baseData) const;
+                             BaseParserScopeData* baseData,
+                             ScopeDataBuffer* preallocatedData) const;
 
   template <typename ScopeT>
   static constexpr bool matchScopeKind(ScopeKind kind) {
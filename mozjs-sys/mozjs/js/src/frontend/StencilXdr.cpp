@@ -512,7 +512,12 @@ template <XDRMode mode>
   uint32_t totalLength = sizeof(ParserAtom) + (CharSize * header->length());
 
   if constexpr (mode == XDR_ENCODE) {
-    MOZ_TRY(xdr->codeBytes(*atomp, totalLength));
+    // The shared id is only meaningful within this process.
+    alignas(ParserAtom) uint8_t headerCopy[sizeof(ParserAtom)];
+    memcpy(headerCopy, *atomp, sizeof(ParserAtom));
+    reinterpret_cast<ParserAtom*>(headerCopy)->clearSharedId();
+    MOZ_TRY(xdr->codeBytes(headerCopy, sizeof(ParserAtom)));
+    MOZ_TRY(xdr->codeBytes(*atomp + 1, totalLength - sizeof(ParserAtom)));
   } else {
     const auto& options = static_cast<XDRStencilDecoder*>(xdr)->options();
     if (options.borrowBuffer) {
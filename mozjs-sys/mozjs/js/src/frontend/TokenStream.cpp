@@ -11,6 +11,7 @@
 #include "mozilla/ArrayUtils.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/Likely.h"
+#include "mozilla/MathAlgorithms.h"
 #include "mozilla/Maybe.h"
 #include "mozilla/MemoryChecking.h"
 #include "mozilla/ScopeExit.h"
@@ -28,6 +29,10 @@
 #include <type_traits>
 #include <utility>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "jsnum.h"
 
 #include "frontend/FrontendContext.h"
@@ -2256,9 +2261,120 @@ static const uint8_t firstCharKinds[] = {
 static_assert(LastCharKind < (1 << (sizeof(firstCharKinds[0]) * 8)),
               "Elements of firstCharKinds[] are too small");
 
+template <size_t N>
+static MOZ_ALWAYS_INLINE bool IsPlainAsciiCodeUnit(uint32_t unit,
+                                                   const char (&stops)[N]) {
+  if (unit >= 0x80) {
+    return false;
+  }
+  for (char stop : stops) {
+    if (unit == uint32_t(stop)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef __SSE2__
+// Return the index of the first code unit in the 16 bytes at |p| that is
+// non-ASCII or one of |stops|, or -1 if there is none.
+template <size_t N>
+static MOZ_ALWAYS_INLINE int FindFirstNonPlainUnitSSE2(const uint8_t* p,
+                                                       const char (&stops)[N]) {
+  __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+  // Non-ASCII bytes have their high bit set, which is all movemask looks at.
+  __m128i hits = units;
+  for (char stop : stops) {
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(units, _mm_set1_epi8(stop)));
+  }
+
+  int mask = _mm_movemask_epi8(hits);
+  return mask ? int(mozilla::CountTrailingZeroes32(mask)) : -1;
+}
+
+template <size_t N>
+static MOZ_ALWAYS_INLINE int FindFirstNonPlainUnitSSE2(const char16_t* p,
+                                                       const char (&stops)[N]) {
+  __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+  __m128i ascii = _mm_cmpeq_epi16(
+      _mm_and_si128(units, _mm_set1_epi16(int16_t(0xFF80))),
+      _mm_setzero_si128());
+  __m128i hits = _mm_andnot_si128(ascii, _mm_cmpeq_epi16(units, units));
+  for (char stop : stops) {
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi16(units, _mm_set1_epi16(stop)));
+  }
+
+  // Each 16-bit lane contributes two bits to the mask.
+  int mask = _mm_movemask_epi8(hits);
+  return mask ? int(mozilla::CountTrailingZeroes32(mask) / 2) : -1;
+}
+#endif
+
+template <typename Unit>
+template <size_t N>
+void SourceUnits<Unit>::skipPlainAsciiCodeUnits(const char (&stops)[N]) {
+  MOZ_ASSERT(!isPoisoned(), "shouldn't skip if poisoned");
+
+  using RawUnit =
+      std::conditional_t<std::is_same_v<Unit, char16_t>, char16_t, uint8_t>;
+  static_assert(sizeof(RawUnit) == sizeof(Unit));
+
+  const RawUnit* cur = reinterpret_cast<const RawUnit*>(ptr);
+  const RawUnit* end = reinterpret_cast<const RawUnit*>(limit_);
+
+#ifdef __SSE2__
+  constexpr size_t UnitsPerBlock = 16 / sizeof(RawUnit);
+  while (mozilla::PointerRangeSize(cur, end) >= UnitsPerBlock) {
+    int index = FindFirstNonPlainUnitSSE2(cur, stops);
+    if (index >= 0) {
+      ptr = reinterpret_cast<const Unit*>(cur + index);
+      return;
+    }
+    cur += UnitsPerBlock;
+  }
+#endif
+
+  while (cur < end && IsPlainAsciiCodeUnit(*cur, stops)) {
+    cur++;
+  }
+
+  ptr = reinterpret_cast<const Unit*>(cur);
+}
+
+// Append a run of ASCII code units found by skipPlainAsciiCodeUnits, which
+// thus contains no line breaks to normalize, to |charBuffer|.
+static bool AppendPlainAsciiRun(CharBuffer& charBuffer, const char16_t* cur,
+                                const char16_t* end) {
+  return charBuffer.append(cur, end);
+}
+
+static bool AppendPlainAsciiRun(CharBuffer& charBuffer, const Utf8Unit* cur,
+                                const Utf8Unit* end) {
+  if (!charBuffer.reserve(charBuffer.length() + PointerRangeSize(cur, end))) {
+    return false;
+  }
+  for (; cur < end; cur++) {
+    MOZ_ASSERT(IsAscii(*cur));
+    charBuffer.infallibleAppend(char16_t(cur->toUint8()));
+  }
+  return true;
+}
+
+// Code units at which the scans of comments and string and template literals
+// below must stop and look more closely.
+static constexpr char SingleLineCommentStops[] = {'\r', '\n'};
+static constexpr char MultiLineCommentStops[] = {'*', '@', '#', '\r', '\n'};
+
 template <>
 void SourceUnits<char16_t>::consumeRestOfSingleLineComment() {
   while (MOZ_LIKELY(!atEnd())) {
+    skipPlainAsciiCodeUnits(SingleLineCommentStops);
+    if (atEnd()) {
+      return;
+    }
+
     char16_t unit = peekCodeUnit();
     if (IsLineTerminator(unit)) {
       return;
@@ -2271,6 +2387,11 @@ void SourceUnits<char16_t>::consumeRestOfSingleLineComment() {
 template <>
 void SourceUnits<Utf8Unit>::consumeRestOfSingleLineComment() {
   while (MOZ_LIKELY(!atEnd())) {
+    skipPlainAsciiCodeUnits(SingleLineCommentStops);
+    if (atEnd()) {
+      return;
+    }
+
     const Utf8Unit unit = peekCodeUnit();
     if (IsSingleUnitLineTerminator(unit)) {
       return;
@@ -3146,6 +3267,8 @@ template <typename Unit, class AnyCharsAccess>
           unsigned linenoBefore = anyChars.lineno;
 
           do {
+            this->sourceUnits.skipPlainAsciiCodeUnits(MultiLineCommentStops);
+
             int32_t unit = getCodeUnit();
             if (unit == EOF) {
               error(JSMSG_UNTERMINATED_COMMENT);
@@ -3264,11 +3387,28 @@ bool TokenStreamSpecific<Unit, AnyCharsAccess>::getStringOrTemplateToken(
     return;
   };
 
+  // Runs of ASCII code units other than these are appended to |charBuffer|
+  // wholesale.  ('$' only matters in templates, but stopping at it in strings
+  // is harmless.)
+  const char plainRunStops[] = {untilChar, '\\', '\r', '\n', '$'};
+
   // We need to detect any of these chars:  " or ', \n (or its
   // equivalents), \\, EOF.  Because we detect EOL sequences here and
   // put them back immediately, we can use getCodeUnit().
   int32_t unit;
-  while ((unit = getCodeUnit()) != untilChar) {
+  while (true) {
+    const Unit* plainRun = this->sourceUnits.addressOfNextCodeUnit();
+    this->sourceUnits.skipPlainAsciiCodeUnits(plainRunStops);
+    const Unit* plainRunEnd = this->sourceUnits.addressOfNextCodeUnit();
+    if (!AppendPlainAsciiRun(this->charBuffer, plainRun, plainRunEnd)) {
+      return false;
+    }
+
+    unit = getCodeUnit();
+    if (unit == untilChar) {
+      break;
+    }
+
     if (unit == EOF) {
       ReportPrematureEndOfLiteral(JSMSG_EOF_BEFORE_END_OF_LITERAL);
       return false;
@@ -1459,6 +1459,16 @@ class SourceUnits {
    */
   void consumeRestOfSingleLineComment();
 
+  /**
+   * Consume code units up to (but not including) the first one that is either
+   * non-ASCII or one of the ASCII code units in |stops|, or up to the end of
+   * the source.  Callers use this to skip over the long runs of code units in
+   * comments and string literals that need no further examination.  Where
+   * the platform supports it, a block of code units is examined at a time.
+   */
+  template <size_t N>
+  void skipPlainAsciiCodeUnits(const char (&stops)[N]);
+
   /**
    * The maximum radius of code around the location of an error that should
    * be included in a syntax error message -- this many code units to either
@@ -620,6 +620,7 @@ void Zone::fixupAfterMovingGC() {
 
 void Zone::purgeAtomCache() {
   atomCache_.ref().reset();
+  sharedParserAtomCache_.ref().reset();
 
   // Also purge the dtoa caches so that subsequent lookups populate atom
   // cache too.
@@ -345,6 +345,38 @@ class AtomCacheHashTable {
   std::array<EntrySet, sSize> mEntrySets;
 };
 
+// SharedParserAtomCache maps the process-wide ids given to parser atoms by
+// frontend::SharedParserAtomsTable to the JSAtoms recently instantiated for
+// them. Unlike AtomCacheHashTable, lookups use the id as index and need
+// neither the hash nor the characters of the string.
+class SharedParserAtomCache {
+ public:
+  MOZ_ALWAYS_INLINE JSAtom* lookup(uint32_t id) const {
+    MOZ_ASSERT(id != 0);
+    const Entry& entry = mEntries[id & (sSize - 1)];
+    return entry.mId == id ? entry.mAtom : nullptr;
+  }
+
+  MOZ_ALWAYS_INLINE void add(uint32_t id, JSAtom* atom) {
+    MOZ_ASSERT(id != 0);
+    Entry& entry = mEntries[id & (sSize - 1)];
+    entry.mId = id;
+    entry.mAtom = atom;
+  }
+
+ private:
+  struct Entry {
+    uint32_t mId = 0;
+    // No read barrier is required here because the table is cleared at the
+    // start of GC.
+    JSAtom* mAtom = nullptr;
+  };
+
+  static constexpr uint32_t sSize = 4 * 1024;
+  static_assert(mozilla::IsPowerOfTwo(sSize));
+  std::array<Entry, sSize> mEntries;
+};
+
 }  // namespace js
 
 namespace JS {
@@ -491,6 +523,11 @@ class Zone : public js::ZoneAllocator, public js::gc::GraphNodeBase<JS::Zone> {
   // Set of atoms recently used by this Zone. Purged on GC.
   js::MainThreadOrGCTaskData<js::UniquePtr<js::AtomCacheHashTable>> atomCache_;
 
+  // Atoms recently instantiated by this Zone for shared parser atoms. Purged
+  // on GC.
+  js::MainThreadOrGCTaskData<js::UniquePtr<js::SharedParserAtomCache>>
+      sharedParserAtomCache_;
+
   // Cache storing allocated external strings. Purged on GC.
   js::MainThreadOrGCTaskData<js::ExternalStringCache> externalStringCache_;
 
@@ -829,6 +866,16 @@ class Zone : public js::ZoneAllocator, public js::gc::GraphNodeBase<JS::Zone> {
     return atomCache_.ref().get();
   }
 
+  // Same as atomCache, for atoms looked up by shared parser atom id.
+  js::SharedParserAtomCache* sharedParserAtomCache() {
+    if (sharedParserAtomCache_.ref()) {
+      return sharedParserAtomCache_.ref().get();
+    }
+
+    sharedParserAtomCache_ = js::MakeUnique<js::SharedParserAtomCache>();
+    return sharedParserAtomCache_.ref().get();
+  }
+
   void purgeAtomCache();
 
   js::ExternalStringCache& externalStringCache() {
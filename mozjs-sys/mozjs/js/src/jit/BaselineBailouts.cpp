@@ -508,7 +508,7 @@ void BaselineStackBuilder::setNextCallee(
       !iter_.ionScript()->purgedICScripts() && canUseTrialInlinedICScripts_) {
     // Update icScript_ to point to the icScript of nextCallee
     const uint32_t pcOff = script_->pcToOffset(pc_);
-    icScript_ = icScript_->findInlinedChild(pcOff);
+    icScript_ = icScript_->findInlinedChild(pcOff, nextCallee->nonLazyScript());
   } else {
     // If we don't know for certain that it's TrialInliningState::Inlined,
     // just use the callee's own ICScript. We could still have the trial
@@ -2718,10 +2718,12 @@ ICAttachResult js::jit::AttachBaselineCacheIRStub(
 
   if (writer.tooLarge()) {
     cx->runtime()->setUseCounter(cx->global(), JSUseCounter::IC_STUB_TOO_LARGE);
+    stub->state().trackAttachFailure(ICAttachFailure::TooLarge);
     return ICAttachResult::TooLarge;
   }
   if (writer.oom()) {
     cx->runtime()->setUseCounter(cx->global(), JSUseCounter::IC_STUB_OOM);
+    stub->state().trackAttachFailure(ICAttachFailure::OOM);
     return ICAttachResult::OOM;
   }
   MOZ_ASSERT(!writer.failed());
@@ -2739,6 +2741,7 @@ ICAttachResult js::jit::AttachBaselineCacheIRStub(
 
   if (!LookupOrCompileStub(cx, kind, writer, stubInfo, code, name,
                            /* isAOTFill = */ false, cx->zone()->jitZone())) {
+    stub->state().trackAttachFailure(ICAttachFailure::OOM);
     return ICAttachResult::OOM;
   }
 
@@ -2764,6 +2767,7 @@ ICAttachResult js::jit::AttachBaselineCacheIRStub(
             "Tried attaching identical stub for (%s:%u:%u)",
             outerScript->filename(), outerScript->lineno(),
             outerScript->column().oneOriginValue());
+    stub->state().trackAttachFailure(ICAttachFailure::DuplicateStub);
     return ICAttachResult::DuplicateStub;
   }
 
@@ -2814,6 +2818,7 @@ ICAttachResult js::jit::AttachBaselineCacheIRStub(
 
   void* newStubMem = cx->zone()->jitZone()->stubSpace()->alloc(bytesNeeded);
   if (!newStubMem) {
+    stub->state().trackAttachFailure(ICAttachFailure::OOM);
     return ICAttachResult::OOM;
   }
 
@@ -2830,6 +2835,11 @@ ICAttachResult js::jit::AttachBaselineCacheIRStub(
       stub->setTrialInliningState(TrialInliningState::Failure);
       break;
     case TrialInliningState::Inlined:
+      // When inlining a polymorphic call site, TrialInliner attaches one
+      // trial-inlined stub for each target.
+      if (writer.trialInliningState() == TrialInliningState::Inlined) {
+        break;
+      }
       stub->setTrialInliningState(TrialInliningState::Failure);
       icScript->removeInlinedChild(stub->pcOffset());
       break;
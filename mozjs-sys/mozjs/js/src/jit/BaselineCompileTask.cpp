@@ -17,11 +17,15 @@ using namespace js::jit;
 
 void BaselineCompileTask::runHelperThreadTask(
     AutoLockHelperThreadState& locked) {
+  startTime_ = mozilla::TimeStamp::Now();
+
   {
     AutoUnlockHelperThreadState unlock(locked);
     runTask();
   }
 
+  compileTime_ = mozilla::TimeStamp::Now() - startTime_;
+
   FinishOffThreadBaselineCompile(this, locked);
 
   // Ping the main thread so that the compiled code can be incorporated at
@@ -49,6 +53,28 @@ class MOZ_RAII AutoEnterBaselineBackend {
 #endif
 };
 
+void BaselineCompileTask::setQueued(mozilla::TimeStamp now,
+                                    const AutoLockHelperThreadState&) {
+  queuedTime_ = now;
+  queuedWarmUpCount_ = warmUpCount();
+}
+
+uint32_t BaselineCompileTask::warmUpCount() const {
+  uint32_t count = 0;
+  for (auto* snapshot : snapshots_) {
+    count += snapshot->script()->getWarmUpCount();
+  }
+  return count;
+}
+
+size_t BaselineCompileTask::bytecodeLength() const {
+  size_t length = 0;
+  for (auto* snapshot : snapshots_) {
+    length += snapshot->script()->length();
+  }
+  return length;
+}
+
 void BaselineCompileTask::markScriptsAsCompiling() {
   for (auto* snapshot : snapshots_) {
     JSScript* script = snapshot->script();
@@ -103,6 +129,14 @@ void BaselineCompileTask::FinishOffThreadTask(BaselineCompileTask* task) {
 }
 
 void BaselineCompileTask::finishOnMainThread(JSContext* cx) {
+  // Record queue wait and compile times in glean.
+  if (queuedTime_ && startTime_) {
+    cx->metrics().BASELINE_COMPILE_QUEUE_TIME(startTime_ - queuedTime_);
+  }
+  if (compileTime_) {
+    cx->metrics().BASELINE_COMPILE_TIME(compileTime_);
+  }
+
   AutoRealm ar(cx, firstScript());
   for (auto* snapshot : snapshots_) {
     if (!snapshot->compiler_->finishCompile(cx)) {
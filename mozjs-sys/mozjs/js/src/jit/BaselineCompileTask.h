@@ -9,6 +9,7 @@
 
 #include "mozilla/LinkedList.h"
 #include "mozilla/Maybe.h"
+#include "mozilla/TimeStamp.h"
 
 #include "jit/BaselineCodeGen.h"
 #include "jit/OffthreadSnapshot.h"
@@ -115,6 +116,15 @@ class BaselineCompileTask final : public HelperThreadTask {
 
   bool failed() const { return failed_; }
 
+  void setQueued(mozilla::TimeStamp now, const AutoLockHelperThreadState&);
+  mozilla::TimeStamp queuedTime() const { return queuedTime_; }
+  uint32_t queuedWarmUpCount() const { return queuedWarmUpCount_; }
+
+  // The sum of the warm-up counts and bytecode lengths of all scripts in
+  // this batch.
+  uint32_t warmUpCount() const;
+  size_t bytecodeLength() const;
+
  private:
   // All scripts are in the same realm, so we can use an arbitrary script
   // to access the realm/zone/runtime.
@@ -125,6 +135,12 @@ class BaselineCompileTask final : public HelperThreadTask {
   BaselineSnapshotList snapshots_;
 
   bool failed_ = false;
+
+  // See the corresponding fields of IonCompileTask.
+  mozilla::TimeStamp queuedTime_;
+  uint32_t queuedWarmUpCount_ = 0;
+  mozilla::TimeStamp startTime_;
+  mozilla::TimeDuration compileTime_;
 };
 
 }  // namespace js::jit
@@ -3,24 +3,227 @@
  * This Source Code Form is subject to the terms of the Mozilla Public
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
-#ifdef JS_CACHEIR_SPEW
+#include "jit/CacheIRHealth.h"
+
+#include "mozilla/Maybe.h"
+
+#include "gc/Zone.h"
+#include "jit/BaselineIC.h"
+#include "jit/CacheIRCompiler.h"
+#include "jit/JitScript.h"
+#include "jit/JitZone.h"
+#include "js/ColumnNumber.h"  // JS::LimitedColumnNumberOneOrigin
+#include "js/experimental/ICHealth.h"  // JS::GetScriptICHealthReport, JS::GetICHealthReport
+#include "js/Printer.h"  // JSSprinter, EscapePrinter, JSONEscape
+#include "vm/BytecodeUtil.h"
+#include "vm/JSFunction.h"
+#include "vm/JSONPrinter.h"
+#include "vm/JSScript.h"
+
+#include "vm/JSObject-inl.h"
+#include "vm/Realm-inl.h"
 
-#  include "jit/CacheIRHealth.h"
+using namespace js;
+using namespace js::jit;
 
-#  include "mozilla/Maybe.h"
+static const char* ICModeName(ICState::Mode mode) {
+  switch (mode) {
+    case ICState::Mode::Specialized:
+      return "specialized";
+    case ICState::Mode::Megamorphic:
+      return "megamorphic";
+    case ICState::Mode::Generic:
+      return "generic";
+  }
+  MOZ_CRASH("Unexpected mode");
+}
 
-#  include "gc/Zone.h"
-#  include "jit/BaselineIC.h"
-#  include "jit/CacheIRCompiler.h"
-#  include "jit/JitScript.h"
-#  include "js/ColumnNumber.h"  // JS::LimitedColumnNumberOneOrigin
-#  include "vm/JSScript.h"
+static const char* ICAttachFailureName(ICAttachFailure failure) {
+  switch (failure) {
+    case ICAttachFailure::None:
+      return "none";
+    case ICAttachFailure::DuplicateStub:
+      return "duplicateStub";
+    case ICAttachFailure::TooLarge:
+      return "tooLarge";
+    case ICAttachFailure::OOM:
+      return "oom";
+  }
+  MOZ_CRASH("Unexpected failure");
+}
 
-#  include "vm/JSObject-inl.h"
-#  include "vm/Realm-inl.h"
+namespace {
 
-using namespace js;
-using namespace js::jit;
+struct ICHealthCounts {
+  uint32_t numStubs = 0;
+  uint64_t stubHits = 0;
+  uint64_t fallbackHits = 0;
+
+  ICHealthCounts(ICEntry& entry, ICFallbackStub* fallback) {
+    for (ICStub* stub = entry.firstStub(); stub != fallback;
+         stub = stub->toCacheIRStub()->next()) {
+      numStubs++;
+      stubHits += stub->enteredCount();
+    }
+    fallbackHits = fallback->enteredCount();
+  }
+
+  uint64_t totalHits() const { return stubHits + fallbackHits; }
+};
+
+}  // namespace
+
+static bool IsUnhealthyIC(ICFallbackStub* fallback,
+                          const ICHealthCounts& counts) {
+  ICState& state = fallback->state();
+  if (state.mode() != ICState::Mode::Specialized) {
+    return true;
+  }
+  if (counts.numStubs > 1) {
+    return true;
+  }
+  return counts.numStubs == 0 && state.hasFailures();
+}
+
+static void PrintICEntryHealth(JSScript* script, ICFallbackStub* fallback,
+                               const ICHealthCounts& counts,
+                               JSONPrinter& json) {
+  ICState& state = fallback->state();
+  jsbytecode* pc = script->offsetToPC(fallback->pcOffset());
+
+  json.beginObject();
+  json.property("offset", fallback->pcOffset());
+  json.property("op", CodeName(JSOp(*pc)));
+
+  JS::LimitedColumnNumberOneOrigin column;
+  json.property("line", PCToLineNumber(script, pc, &column));
+  json.property("column", column.oneOriginValue());
+
+  json.property("mode", ICModeName(state.mode()));
+  json.property("stubs", counts.numStubs);
+  json.property("stubHits", counts.stubHits);
+  json.property("fallbackHits", counts.fallbackHits);
+  json.property("failures", uint32_t(state.numFailures()));
+  json.property("transitions", uint32_t(state.numTransitions()));
+  if (state.lastAttachFailure() != ICAttachFailure::None) {
+    json.property("attachFailure",
+                  ICAttachFailureName(state.lastAttachFailure()));
+  }
+  json.endObject();
+}
+
+bool js::jit::PrintICHealthReport(JSScript* script, JSONPrinter& json,
+                                  bool onlyUnhealthy, uint32_t minHits) {
+  JitScript* jitScript = script->maybeJitScript();
+
+  auto shouldPrint = [&](ICFallbackStub* fallback,
+                         const ICHealthCounts& counts) {
+    if (!onlyUnhealthy) {
+      return true;
+    }
+    return counts.totalHits() >= minHits && IsUnhealthyIC(fallback, counts);
+  };
+
+  if (onlyUnhealthy) {
+    if (!jitScript) {
+      return false;
+    }
+    bool found = false;
+    for (size_t i = 0; i < jitScript->numICEntries() && !found; i++) {
+      ICFallbackStub* fallback = jitScript->fallbackStub(i);
+      ICHealthCounts counts(jitScript->icEntry(i), fallback);
+      found = shouldPrint(fallback, counts);
+    }
+    if (!found) {
+      return false;
+    }
+  }
+
+  json.beginObject();
+
+  {
+    GenericPrinter& out = json.beginStringProperty("file");
+    if (const char* filename = script->filename()) {
+      JSONEscape esc;
+      EscapePrinter ep(out, esc);
+      ep.put(filename);
+    }
+    json.endStringProperty();
+  }
+  json.property("line", script->lineno());
+  json.property("column", script->column().oneOriginValue());
+
+  if (JSFunction* fun = script->function()) {
+    if (JSAtom* atom = fun->fullDisplayAtom()) {
+      json.property("name", atom);
+    }
+  }
+
+  json.beginListProperty("entries");
+  if (jitScript) {
+    for (size_t i = 0; i < jitScript->numICEntries(); i++) {
+      ICFallbackStub* fallback = jitScript->fallbackStub(i);
+      ICHealthCounts counts(jitScript->icEntry(i), fallback);
+      if (shouldPrint(fallback, counts)) {
+        PrintICEntryHealth(script, fallback, counts, json);
+      }
+    }
+  }
+  json.endList();
+
+  json.endObject();
+  return true;
+}
+
+JS_PUBLIC_API JSString* JS::GetScriptICHealthReport(
+    JSContext* cx, Handle<JSScript*> script) {
+  cx->check(script);
+
+  JSSprinter sp(cx);
+  if (!sp.init()) {
+    return nullptr;
+  }
+
+  {
+    JS::AutoCheckCannotGC nogc;
+    JSONPrinter json(sp, false);
+    (void)PrintICHealthReport(script, json, /* onlyUnhealthy = */ false, 0);
+  }
+
+  return sp.release(cx);
+}
+
+JS_PUBLIC_API JSString* JS::GetICHealthReport(JSContext* cx,
+                                              uint32_t minHits) {
+  JSSprinter sp(cx);
+  if (!sp.init()) {
+    return nullptr;
+  }
+
+  {
+    // Nothing below can GC, so it is safe to look at the scripts of the
+    // JitScripts without exposing them.
+    JS::AutoCheckCannotGC nogc;
+    JSONPrinter json(sp, false);
+    json.beginObject();
+    json.beginListProperty("scripts");
+    if (JitZone* jitZone = cx->zone()->jitZone()) {
+      jitZone->forEachJitScript([&](JitScript* jitScript) {
+        JSScript* script = jitScript->owningScript();
+        if (!script->selfHosted()) {
+          (void)PrintICHealthReport(script, json, /* onlyUnhealthy = */ true,
+                                    minHits);
+        }
+      });
+    }
+    json.endList();
+    json.endObject();
+  }
+
+  return sp.release(cx);
+}
+
+#ifdef JS_CACHEIR_SPEW
 
 // TODO: Refine how we assign happiness based on total health score.
 CacheIRHealth::Happiness CacheIRHealth::determineStubHappiness(
@@ -7,14 +7,47 @@
 #ifndef jit_CacheIRHealth_h
 #define jit_CacheIRHealth_h
 
+#include <stdint.h>
+
+#include "NamespaceImports.h"
+
+#include "js/TypeDecls.h"
+
+namespace js {
+
+class JSONPrinter;
+
+namespace jit {
+
+// [SMDOC] IC Health Counters
+//
+// Unlike the CacheIR health report below, which is only available in builds
+// with JS_CACHEIR_SPEW, the IC health counters are always maintained. They
+// consist of the entered counts of the stubs and the fallback stub of each IC,
+// plus the counters in ICState: the number of failed attach attempts, the
+// number of mode transitions (Specialized -> Megamorphic -> Generic) and the
+// reason of the last failed attach. All of these are only updated on the
+// fallback path, so they add no overhead to the optimized stubs.
+//
+// The report is computed on demand by walking the IC entries of a JitScript.
+// See JS::GetScriptICHealthReport and JS::GetICHealthReport in
+// js/experimental/ICHealth.h for the JSON format.
+
+// Print the IC health of |script| to |json| as a JSON object. If
+// |onlyUnhealthy| is true, only print ICs which are not monomorphic and which
+// have been hit at least |minHits| times, and print nothing at all if there
+// are no such ICs. Returns whether anything was printed.
+bool PrintICHealthReport(JSScript* script, JSONPrinter& json,
+                         bool onlyUnhealthy, uint32_t minHits);
+
+}  // namespace jit
+}  // namespace js
+
 #ifdef JS_CACHEIR_SPEW
 
 #  include "mozilla/Sprintf.h"
 
-#  include "NamespaceImports.h"
-
 #  include "jit/CacheIR.h"
-#  include "js/TypeDecls.h"
 
 enum class JSOp : uint8_t;
 
@@ -22,6 +22,17 @@ enum class TrialInliningState : uint8_t {
   Failure,
 };
 
+// Why the most recent attempt to attach a CacheIR stub to an IC failed after
+// the IR generator produced a stub. Used by the IC health report, see
+// CacheIRHealth.h. Attempts where no IR generator applied are only reflected
+// in the failure count.
+enum class ICAttachFailure : uint8_t {
+  None = 0,
+  DuplicateStub,
+  TooLarge,
+  OOM,
+};
+
 // ICState stores information about a Baseline or Ion IC.
 class ICState {
  public:
@@ -57,8 +68,19 @@ class ICState {
   // Number of times we failed to attach a stub.
   uint8_t numFailures_;
 
+  // Saturating count of mode transitions over the lifetime of this IC. Unlike
+  // the fields above, this is not cleared by reset() so that it survives stub
+  // purging. Only used for IC health reporting.
+  uint8_t numTransitions_ : 5;
+
+  // The ICAttachFailure of the most recent failed attach. Only used for IC
+  // health reporting.
+  uint8_t lastAttachFailure_ : 3;
+
   static const size_t MaxOptimizedStubs = 6;
 
+  static const size_t MaxTransitions = (1 << 5) - 1;
+
   void setMode(Mode mode) {
     mode_ = uint32_t(mode);
     MOZ_ASSERT(Mode(mode_) == mode, "mode must fit in bitfield");
@@ -68,6 +90,9 @@ class ICState {
     MOZ_ASSERT(mode > this->mode());
     setMode(mode);
     numFailures_ = 0;
+    if (numTransitions_ < MaxTransitions) {
+      numTransitions_++;
+    }
   }
 
   MOZ_ALWAYS_INLINE size_t maxFailures() const {
@@ -80,11 +105,16 @@ class ICState {
   }
 
  public:
-  ICState() { reset(); }
+  ICState() : numTransitions_(0) { reset(); }
 
   Mode mode() const { return Mode(mode_); }
   size_t numOptimizedStubs() const { return numOptimizedStubs_; }
   bool hasFailures() const { return (numFailures_ != 0); }
+  size_t numFailures() const { return numFailures_; }
+  size_t numTransitions() const { return numTransitions_; }
+  ICAttachFailure lastAttachFailure() const {
+    return ICAttachFailure(lastAttachFailure_);
+  }
   bool newStubIsFirstStub() const {
     return (mode() == Mode::Specialized && numOptimizedStubs() == 0);
   }
@@ -140,6 +170,7 @@ class ICState {
     mayHaveFoldedStub_ = false;
     numOptimizedStubs_ = 0;
     numFailures_ = 0;
+    lastAttachFailure_ = uint32_t(ICAttachFailure::None);
   }
   void trackAttached() {
     // We'd like to assert numOptimizedStubs_ < MaxOptimizedStubs, but
@@ -152,6 +183,7 @@ class ICState {
     // to delay hitting Generic mode. Reset to 1 instead of 0 so that
     // code which inspects state can distinguish no-failures from rare-failures.
     numFailures_ = std::min(numFailures_, static_cast<uint8_t>(1));
+    lastAttachFailure_ = uint32_t(ICAttachFailure::None);
   }
   void trackNotAttached() {
     // Note: we can't assert numFailures_ < maxFailures() because
@@ -165,6 +197,11 @@ class ICState {
     numOptimizedStubs_--;
   }
   void trackUnlinkedAllStubs() { numOptimizedStubs_ = 0; }
+  void trackAttachFailure(ICAttachFailure failure) {
+    lastAttachFailure_ = uint32_t(failure);
+    MOZ_ASSERT(lastAttachFailure() == failure,
+               "ICAttachFailure must fit in bitfield");
+  }
 
   void clearUsedByTranspiler() { usedByTranspiler_ = false; }
   void setUsedByTranspiler() { usedByTranspiler_ = true; }
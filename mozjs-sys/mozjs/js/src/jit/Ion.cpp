@@ -368,6 +368,12 @@ static bool LinkCodeGen(JSContext* cx, CodeGenerator* codegen,
 }
 
 static bool LinkBackgroundCodeGen(JSContext* cx, IonCompileTask* task) {
+  // Record how long the task waited for a helper thread in glean.
+  if (task->queuedTime() && task->startTime()) {
+    cx->metrics().ION_COMPILE_QUEUE_TIME(task->startTime() -
+                                         task->queuedTime());
+  }
+
   CodeGenerator* codegen = task->backgroundCodegen();
   if (!codegen) {
     return false;
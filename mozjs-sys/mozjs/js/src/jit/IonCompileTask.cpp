@@ -25,6 +25,8 @@ void IonCompileTask::runHelperThreadTask(AutoLockHelperThreadState& locked) {
   // mutations.
   alloc().lifoAlloc()->setReadWrite();
 
+  setStarted(mozilla::TimeStamp::Now(), locked);
+
   {
     AutoUnlockHelperThreadState unlock(locked);
     runTask();
@@ -52,6 +54,27 @@ void IonCompileTask::runTask() {
   setBackgroundCodegen(jit::CompileBackEnd(&mirGen_, snapshot_));
 }
 
+void IonCompileTask::setQueued(mozilla::TimeStamp now,
+                               const AutoLockHelperThreadState&) {
+  queuedTime_ = now;
+  queuedWarmUpCount_ = script()->jitScript()->warmUpCount();
+}
+
+void IonCompileTask::setStarted(mozilla::TimeStamp now,
+                                const AutoLockHelperThreadState&) {
+  startTime_ = now;
+}
+
+void IonCompileTask::preempt(const AutoLockHelperThreadState&) {
+  MOZ_ASSERT(!preempted_);
+  preempted_ = true;
+
+  // The compilation fails at the next cancellation check. Failed off-thread
+  // compilations are discarded when linking, so the script can be compiled
+  // again once it warms up.
+  mirGen_.cancel();
+}
+
 void IonCompileTask::trace(JSTracer* trc) {
   if (!mirGen_.runtime->runtimeMatches(trc->runtime())) {
     return;
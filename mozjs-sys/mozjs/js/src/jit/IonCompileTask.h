@@ -8,6 +8,7 @@
 #define jit_IonCompileTask_h
 
 #include "mozilla/LinkedList.h"
+#include "mozilla/TimeStamp.h"
 
 #include "jit/CompilationDependencyTracker.h"
 #include "jit/MIRGenerator.h"
@@ -41,6 +42,19 @@ class IonCompileTask final : public HelperThreadTask,
   // removed from the helper threads. Thus this should be safe.
   const mozilla::Atomic<bool, mozilla::ReleaseAcquire>& isExecuting_;
 
+  // When this task was added to the helper thread worklist and the script's
+  // warm-up count at that time. Used to prioritize tasks by how fast their
+  // scripts are warming up. These and the fields below are protected by the
+  // helper thread lock.
+  mozilla::TimeStamp queuedTime_;
+  uint32_t queuedWarmUpCount_ = 0;
+
+  // When a helper thread started running this task.
+  mozilla::TimeStamp startTime_;
+
+  // Whether this task was cancelled to make room for a hotter script.
+  bool preempted_ = false;
+
  public:
   explicit IonCompileTask(JSContext* cx, MIRGenerator& mirGen,
                           WarpSnapshot* snapshot);
@@ -62,6 +76,15 @@ class IonCompileTask final : public HelperThreadTask,
   // executing JS code. This changes the way we prioritize tasks.
   bool isMainThreadRunningJS() const { return isExecuting_; }
 
+  void setQueued(mozilla::TimeStamp now, const AutoLockHelperThreadState&);
+  mozilla::TimeStamp queuedTime() const { return queuedTime_; }
+  uint32_t queuedWarmUpCount() const { return queuedWarmUpCount_; }
+  void setStarted(mozilla::TimeStamp now, const AutoLockHelperThreadState&);
+  mozilla::TimeStamp startTime() const { return startTime_; }
+
+  bool preempted() const { return preempted_; }
+  void preempt(const AutoLockHelperThreadState&);
+
   ThreadType threadType() override { return THREAD_TYPE_ION; }
   void runTask();
   void runHelperThreadTask(AutoLockHelperThreadState& locked) override;
@@ -115,6 +115,10 @@ DefaultJitOptions::DefaultJitOptions() {
   // Toggle whether eager scalar replacement is globally disabled.
   SET_DEFAULT(disableScalarReplacement, false);
 
+  // Toggles whether scalar replacement can materialize objects which only
+  // escape in exit regions, such as error paths.
+  SET_DEFAULT(disablePartialEscapeAnalysis, false);
+
   // Toggles whether CacheIR stubs are used.
   SET_DEFAULT(disableCacheIR, false);
 
@@ -274,6 +278,10 @@ DefaultJitOptions::DefaultJitOptions() {
   // The minimum entry count for an IC stub before it can be trial-inlined.
   SET_DEFAULT(inliningEntryThreshold, 100);
 
+  // The maximum number of targets of a polymorphic call site that can be
+  // trial-inlined together. Values below 2 disable polymorphic inlining.
+  SET_DEFAULT(polymorphicInliningMaxTargets, 4);
+
   // An artificial testing limit for the maximum supported offset of
   // pc-relative jump and call instructions.
   SET_DEFAULT(jumpThreshold, UINT32_MAX);
@@ -297,6 +305,11 @@ DefaultJitOptions::DefaultJitOptions() {
   SET_DEFAULT(ionMaxLocalsAndArgs, 10 * 1000);
   SET_DEFAULT(ionMaxLocalsAndArgsMainThread, 256);
 
+  // How long (in milliseconds) an off-thread Ion compilation can run before it
+  // may be cancelled to make room for a script that is warming up much faster.
+  // Zero disables preemption.
+  SET_DEFAULT(ionCompilePreemptionMs, 50);
+
 #if defined(JS_CODEGEN_MIPS64) || defined(JS_CODEGEN_LOONG64) || \
     defined(JS_CODEGEN_RISCV64)
   SET_DEFAULT(spectreIndexMasking, false);
@@ -65,6 +65,7 @@ struct DefaultJitOptions {
   bool disableRangeAnalysis;
   bool disableRecoverIns;
   bool disableScalarReplacement;
+  bool disablePartialEscapeAnalysis;
   bool disableCacheIR;
   bool disableSink;
   bool disableRedundantShapeGuards;
@@ -114,6 +115,7 @@ struct DefaultJitOptions {
   uint32_t osrPcMismatchesBeforeRecompile;
   uint32_t smallFunctionMaxBytecodeLength;
   uint32_t inliningEntryThreshold;
+  uint32_t polymorphicInliningMaxTargets;
   uint32_t jumpThreshold;
   uint32_t branchPruningHitCountFactor;
   uint32_t branchPruningInstFactor;
@@ -124,6 +126,7 @@ struct DefaultJitOptions {
   uint32_t ionMaxScriptSizeMainThread;
   uint32_t ionMaxLocalsAndArgs;
   uint32_t ionMaxLocalsAndArgsMainThread;
+  uint32_t ionCompilePreemptionMs;
   uint32_t wasmBatchBaselineThreshold;
   uint32_t wasmBatchIonThreshold;
 #ifdef ENABLE_JS_AOT_ICS
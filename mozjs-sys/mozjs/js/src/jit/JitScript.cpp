@@ -226,6 +226,12 @@ void ICScript::trace(JSTracer* trc) {
   for (gc::AllocSite* site : allocSites_) {
     site->trace(trc);
   }
+
+  if (inlinedChildren_) {
+    for (auto& callsite : *inlinedChildren_) {
+      TraceEdge(trc, &callsite.calleeScript_, "ic-script-inlined-callee");
+    }
+  }
 }
 
 bool ICScript::traceWeak(JSTracer* trc) {
@@ -242,8 +248,15 @@ bool ICScript::traceWeak(JSTracer* trc) {
 }
 
 bool ICScript::addInlinedChild(JSContext* cx, UniquePtr<ICScript> child,
-                               uint32_t pcOffset) {
-  MOZ_ASSERT(!hasInlinedChild(pcOffset));
+                               JSScript* calleeScript, uint32_t pcOffset) {
+#ifdef DEBUG
+  if (inlinedChildren_) {
+    for (auto& callsite : *inlinedChildren_) {
+      MOZ_ASSERT(callsite.pcOffset_ != pcOffset ||
+                 callsite.calleeScript_ != calleeScript);
+    }
+  }
+#endif
 
   if (!inlinedChildren_) {
     inlinedChildren_ = cx->make_unique<Vector<CallSite>>(cx);
@@ -254,7 +267,7 @@ bool ICScript::addInlinedChild(JSContext* cx, UniquePtr<ICScript> child,
 
   // First reserve space in inlinedChildren_ to ensure that if the ICScript is
   // added to the inlining root, it can also be added to inlinedChildren_.
-  CallSite callsite(child.get(), pcOffset);
+  CallSite callsite(child.get(), calleeScript, pcOffset);
   if (!inlinedChildren_->reserve(inlinedChildren_->length() + 1)) {
     return false;
   }
@@ -265,9 +278,11 @@ bool ICScript::addInlinedChild(JSContext* cx, UniquePtr<ICScript> child,
   return true;
 }
 
-ICScript* ICScript::findInlinedChild(uint32_t pcOffset) {
+ICScript* ICScript::findInlinedChild(uint32_t pcOffset,
+                                     JSScript* calleeScript) {
   for (auto& callsite : *inlinedChildren_) {
-    if (callsite.pcOffset_ == pcOffset) {
+    if (callsite.pcOffset_ == pcOffset &&
+        callsite.calleeScript_ == calleeScript) {
       return callsite.callee_;
     }
   }
@@ -300,6 +315,20 @@ void ICScript::purgeInactiveICScripts() {
     return;
   }
 
+  // The IC chain of a polymorphic call site refers to the ICScripts of all of
+  // its inlined callees, and purgeStubs clones that chain if any of them is
+  // active. Keep the other callees at the same call site alive in that case.
+  for (auto& callsite : *inlinedChildren_) {
+    if (!callsite.callee_->active()) {
+      continue;
+    }
+    for (auto& other : *inlinedChildren_) {
+      if (other.pcOffset_ == callsite.pcOffset_) {
+        other.callee_->setActive();
+      }
+    }
+  }
+
   inlinedChildren_->eraseIf(
       [](const CallSite& callsite) { return !callsite.callee_->active(); });
 
@@ -521,11 +550,18 @@ void ICScript::purgeStubs(Zone* zone, ICStubSpace& newStubSpace) {
         hasInlinedChild(fallback->pcOffset())) {
       MOZ_ASSERT(active());
 #ifdef DEBUG
-      // The callee script must be active. Also assert its bytecode size field
-      // is valid, because this helps catch memory safety issues (bug 1871947).
-      ICScript* callee = findInlinedChild(fallback->pcOffset());
-      MOZ_ASSERT(callee->active());
-      MOZ_ASSERT(callee->bytecodeSize() < inliningRoot()->totalBytecodeSize());
+      // The callee scripts must be active. Also assert their bytecode size
+      // field is valid, because this helps catch memory safety issues (bug
+      // 1871947).
+      for (auto& callsite : *inlinedChildren_) {
+        if (callsite.pcOffset_ != fallback->pcOffset()) {
+          continue;
+        }
+        ICScript* callee = callsite.callee_;
+        MOZ_ASSERT(callee->active());
+        MOZ_ASSERT(callee->bytecodeSize() <
+                   inliningRoot()->totalBytecodeSize());
+      }
 #endif
 
       JSRuntime* rt = zone->runtimeFromMainThread();
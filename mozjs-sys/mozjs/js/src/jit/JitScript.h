@@ -188,10 +188,12 @@ class alignas(uintptr_t) ICScript final : public TrailingArray<ICScript> {
 
   ICEntry& icEntryFromPCOffset(uint32_t pcOffset);
 
+  // A call site has one inlined child per trial-inlined callee. Polymorphic
+  // call sites can have more than one.
   [[nodiscard]] bool addInlinedChild(JSContext* cx,
                                      js::UniquePtr<ICScript> child,
-                                     uint32_t pcOffset);
-  ICScript* findInlinedChild(uint32_t pcOffset);
+                                     JSScript* calleeScript, uint32_t pcOffset);
+  ICScript* findInlinedChild(uint32_t pcOffset, JSScript* calleeScript);
   void removeInlinedChild(uint32_t pcOffset);
   bool hasInlinedChild(uint32_t pcOffset);
 
@@ -220,9 +222,11 @@ class alignas(uintptr_t) ICScript final : public TrailingArray<ICScript> {
  private:
   class CallSite {
    public:
-    CallSite(ICScript* callee, uint32_t pcOffset)
-        : callee_(callee), pcOffset_(pcOffset) {}
+    CallSite(ICScript* callee, JSScript* calleeScript, uint32_t pcOffset)
+        : callee_(callee), calleeScript_(calleeScript), pcOffset_(pcOffset) {}
     ICScript* callee_;
+    // The script |callee_| was created for.
+    HeapPtr<JSScript*> calleeScript_;
     uint32_t pcOffset_;
   };
 
@@ -6,7 +6,10 @@
 
 #include "jit/ScalarReplacement.h"
 
+#include "mozilla/ScopeExit.h"
+
 #include "jit/IonAnalysis.h"
+#include "jit/JitOptions.h"
 #include "jit/JitSpewer.h"
 #include "jit/MIR-wasm.h"
 #include "jit/MIR.h"
@@ -76,6 +79,9 @@ bool EmulateStateOf<MemoryView>::run(MemoryView& view) {
       MNode* ins = *iter++;
       if (ins->isDefinition()) {
         MDefinition* def = ins->toDefinition();
+        if constexpr (MemoryView::SupportsMaterialization) {
+          view.maybeMaterializeBefore(def);
+        }
         switch (def->op()) {
 #define MIR_OP(op)                 \
   case MDefinition::Opcode::op:    \
@@ -149,8 +155,98 @@ static bool PhiOperandsEqualTo(MPhi* phi, MInstruction* newObject) {
   return true;
 }
 
+// Instructions before which a partially escaped object is materialized.
+using MaterializationSites = Vector<MInstruction*, 4, JitAllocPolicy>;
+
+// Objects allocated by materializing a partially escaped object.
+using MaterializedObjects = Vector<MInstruction*, 4, JitAllocPolicy>;
+
+static bool IsMaterializedObject(const MaterializedObjects& materialized,
+                                 MInstruction* ins) {
+  for (MInstruction* obj : materialized) {
+    if (obj == ins) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static bool IsObjectEscaped(MDefinition* ins, MInstruction* newObject,
-                            const Shape* shapeDefault = nullptr);
+                            const Shape* shapeDefault = nullptr,
+                            MaterializationSites* sites = nullptr);
+
+// Return true if every block reachable from |block| is dominated by it and
+// |block| cannot be reached again from its successors. An instruction in such
+// a block runs at most once per execution of the blocks dominating it, and
+// nothing it defines or modifies flows back into the rest of the graph.
+static bool IsExitRegion(MBasicBlock* block) {
+  Vector<MBasicBlock*, 8, SystemAllocPolicy> worklist;
+  Vector<MBasicBlock*, 8, SystemAllocPolicy> marked;
+
+  auto unmarkAll = mozilla::MakeScopeExit([&]() {
+    for (MBasicBlock* b : marked) {
+      b->unmark();
+    }
+  });
+
+  // OOM is conservatively treated as not being an exit region.
+  auto push = [&](MBasicBlock* b) {
+    if (b->isMarked()) {
+      return true;
+    }
+    b->mark();
+    return marked.append(b) && worklist.append(b);
+  };
+
+  for (size_t i = 0; i < block->numSuccessors(); i++) {
+    if (!push(block->getSuccessor(i))) {
+      return false;
+    }
+  }
+
+  while (!worklist.empty()) {
+    MBasicBlock* b = worklist.popCopy();
+    if (b == block || !block->dominates(b)) {
+      return false;
+    }
+    for (size_t i = 0; i < b->numSuccessors(); i++) {
+      if (!push(b->getSuccessor(i))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Partial escape analysis: instead of giving up on an object which escapes,
+// we can allocate it right before the escaping instruction if that instruction
+// is in an exit region, such as an error path ending with a throw. The object
+// keeps being scalar replaced everywhere else, and is only allocated when the
+// exit region is entered.
+//
+// For the moment, only plain objects without dynamic slots are materialized.
+//
+// |sites| is null for the objects allocated by an earlier materialization.
+// These escape at the instruction they were materialized before, and
+// materializing them again would allocate another copy before the same
+// instruction, and so on forever.
+static bool CanMaterializeBefore(MDefinition* def, MInstruction* newObject,
+                                 MaterializationSites* sites) {
+  if (!sites || JitOptions.disablePartialEscapeAnalysis) {
+    return false;
+  }
+  if (!newObject->isNewPlainObject() ||
+      newObject->toNewPlainObject()->numDynamicSlots() != 0) {
+    return false;
+  }
+  if (!def->isInstruction() || !IsExitRegion(def->block())) {
+    return false;
+  }
+
+  JitSpewDef(JitSpew_Escape, "is materialized before\n", def);
+  return sites->append(def->toInstruction());
+}
 
 // Returns False if the lambda is not escaped and if it is optimizable by
 // ScalarReplacementOfObject.
@@ -233,7 +329,8 @@ static bool IsLambdaEscaped(MInstruction* lambda, MInstruction* newObject,
 // For the moment, this code is dumb as it only supports objects which are not
 // changing shape.
 static bool IsObjectEscaped(MDefinition* ins, MInstruction* newObject,
-                            const Shape* shapeDefault) {
+                            const Shape* shapeDefault,
+                            MaterializationSites* sites) {
   MOZ_ASSERT(ins->type() == MIRType::Object || ins->isPhi());
   MOZ_ASSERT(IsOptimizableObjectInstruction(newObject));
 
@@ -277,6 +374,9 @@ static bool IsObjectEscaped(MDefinition* ins, MInstruction* newObject,
           break;
         }
 
+        if (CanMaterializeBefore(def, newObject, sites)) {
+          break;
+        }
         JitSpewDef(JitSpew_Escape, "is escaped by\n", def);
         return true;
 
@@ -397,6 +497,9 @@ static bool IsObjectEscaped(MDefinition* ins, MInstruction* newObject,
         break;
 
       default:
+        if (CanMaterializeBefore(def, newObject, sites)) {
+          break;
+        }
         JitSpewDef(JitSpew_Escape, "is escaped by\n", def);
         return true;
     }
@@ -410,6 +513,7 @@ class ObjectMemoryView : public MDefinitionVisitorDefaultNoop {
  public:
   using BlockState = MObjectState;
   static const char phaseName[];
+  static constexpr bool SupportsMaterialization = true;
 
  private:
   TempAllocator& alloc_;
@@ -417,6 +521,8 @@ class ObjectMemoryView : public MDefinitionVisitorDefaultNoop {
   MInstruction* obj_;
   MBasicBlock* startBlock_;
   BlockState* state_;
+  const MaterializationSites& sites_;
+  MaterializedObjects& materialized_;
 
   // Used to improve the memory usage by sharing common modification.
   const MResumePoint* lastResumePoint_;
@@ -424,7 +530,9 @@ class ObjectMemoryView : public MDefinitionVisitorDefaultNoop {
   bool oom_;
 
  public:
-  ObjectMemoryView(TempAllocator& alloc, MInstruction* obj);
+  ObjectMemoryView(TempAllocator& alloc, MInstruction* obj,
+                   const MaterializationSites& sites,
+                   MaterializedObjects& materialized);
 
   MBasicBlock* startingBlock();
   bool initStartingState(BlockState** outState);
@@ -443,8 +551,10 @@ class ObjectMemoryView : public MDefinitionVisitorDefaultNoop {
 
  private:
   MDefinition* functionForCallObject(MDefinition* ins);
+  void materializeBefore(MInstruction* ins);
 
  public:
+  void maybeMaterializeBefore(MDefinition* def);
   void visitResumePoint(MResumePoint* rp);
   void visitObjectState(MObjectState* ins);
   void visitStoreFixedSlot(MStoreFixedSlot* ins);
@@ -472,12 +582,16 @@ class ObjectMemoryView : public MDefinitionVisitorDefaultNoop {
 /* static */ const char ObjectMemoryView::phaseName[] =
     "Scalar Replacement of Object";
 
-ObjectMemoryView::ObjectMemoryView(TempAllocator& alloc, MInstruction* obj)
+ObjectMemoryView::ObjectMemoryView(TempAllocator& alloc, MInstruction* obj,
+                                   const MaterializationSites& sites,
+                                   MaterializedObjects& materialized)
     : alloc_(alloc),
       undefinedVal_(nullptr),
       obj_(obj),
       startBlock_(obj->block()),
       state_(nullptr),
+      sites_(sites),
+      materialized_(materialized),
       lastResumePoint_(nullptr),
       oom_(false) {
   // Annotate snapshots RValue such that we recover the store first.
@@ -626,6 +740,87 @@ void ObjectMemoryView::assertSuccess() {
 }
 #endif
 
+void ObjectMemoryView::maybeMaterializeBefore(MDefinition* def) {
+  if (sites_.empty() || !def->isInstruction()) {
+    return;
+  }
+
+  // The object may already have been materialized by a dominating site, in
+  // which case |def| uses the materialized object instead.
+  MInstruction* ins = def->toInstruction();
+  for (MInstruction* site : sites_) {
+    if (site != ins) {
+      continue;
+    }
+    for (size_t i = 0, e = ins->numOperands(); i < e; i++) {
+      if (ins->getOperand(i) == obj_) {
+        materializeBefore(ins);
+        return;
+      }
+    }
+    return;
+  }
+}
+
+void ObjectMemoryView::materializeBefore(MInstruction* ins) {
+  MOZ_ASSERT(state_);
+  MOZ_ASSERT(obj_->isNewPlainObject());
+  MBasicBlock* block = ins->block();
+
+  // Allocate a new object like the one we are replacing, and initialize its
+  // slots with their values at this point.
+  MNewPlainObject* templateObj = obj_->toNewPlainObject();
+  auto* newObject = MNewPlainObject::New(
+      alloc_, templateObj->getOperand(0)->toConstant(),
+      templateObj->numFixedSlots(), templateObj->numDynamicSlots(),
+      templateObj->allocKind(), templateObj->initialHeap());
+  block->insertBefore(ins, newObject);
+  if (!materialized_.append(newObject)) {
+    oom_ = true;
+    return;
+  }
+
+  MOZ_ASSERT(state_->numSlots() <= state_->numFixedSlots());
+  for (size_t slot = 0; slot < state_->numSlots(); slot++) {
+    MDefinition* value = state_->getFixedSlot(slot);
+    auto* store =
+        MStoreFixedSlot::NewUnbarriered(alloc_, newObject, slot, value);
+    block->insertBefore(ins, store);
+
+    auto* barrier = MPostWriteBarrier::New(alloc_, newObject, value);
+    block->insertBefore(ins, barrier);
+  }
+
+  // Replace all uses of the object which are dominated by |ins|. These are
+  // |ins| itself, the instructions and resume points following it in its
+  // block, and everything in the blocks it dominates.
+  for (MInstructionIterator iter(block->begin(ins)); iter != block->end();
+       iter++) {
+    for (size_t i = 0, e = iter->numOperands(); i < e; i++) {
+      if (iter->getOperand(i) == obj_) {
+        iter->replaceOperand(i, newObject);
+      }
+    }
+    if (MResumePoint* rp = iter->resumePoint()) {
+      for (size_t i = 0, e = rp->numOperands(); i < e; i++) {
+        if (rp->getOperand(i) == obj_) {
+          rp->replaceOperand(i, newObject);
+        }
+      }
+    }
+  }
+
+  for (MUseIterator i(obj_->usesBegin()); i != obj_->usesEnd();) {
+    MUse* use = *i++;
+    MBasicBlock* consumerBlock = use->consumer()->block();
+    if (consumerBlock != block && block->dominates(consumerBlock)) {
+      use->replaceProducer(newObject);
+    }
+  }
+
+  JitSpewDef(JitSpew_Escape, "Materialized object before\n", ins);
+}
+
 void ObjectMemoryView::visitResumePoint(MResumePoint* rp) {
   // As long as the MObjectState is not yet seen next to the allocation, we do
   // not patch the resume point to recover the side effects.
@@ -1262,6 +1457,7 @@ class ArrayMemoryView : public MDefinitionVisitorDefaultNoop {
  public:
   using BlockState = MArrayState;
   static const char* phaseName;
+  static constexpr bool SupportsMaterialization = false;
 
  private:
   TempAllocator& alloc_;
@@ -3024,6 +3220,7 @@ class WasmStructMemoryView : public MDefinitionVisitorDefaultNoop {
  public:
   using BlockState = MWasmStructState;
   static const char phaseName[];
+  static constexpr bool SupportsMaterialization = false;
 
  private:
   TempAllocator& alloc_;
@@ -3374,6 +3571,8 @@ bool ScalarReplacement(const MIRGenerator* mir, MIRGraph& graph) {
   EmulateStateOf<ObjectMemoryView> replaceObject(mir, graph);
   EmulateStateOf<ArrayMemoryView> replaceArray(mir, graph);
   EmulateStateOf<WasmStructMemoryView> replaceWasmStructs(mir, graph);
+  MaterializationSites sites(graph.alloc());
+  MaterializedObjects materialized(graph.alloc());
   bool addedPhi = false;
 
   for (ReversePostorderIterator block = graph.rpoBegin();
@@ -3384,9 +3583,15 @@ bool ScalarReplacement(const MIRGenerator* mir, MIRGraph& graph) {
 
     for (MInstructionIterator ins = block->begin(); ins != block->end();
          ins++) {
+      // Objects allocated by materialization are visited later in RPO, but
+      // are never materialized again.
+      sites.clear();
       if (IsOptimizableObjectInstruction(*ins) &&
-          !IsObjectEscaped(*ins, *ins)) {
-        ObjectMemoryView view(graph.alloc(), *ins);
+          !IsObjectEscaped(*ins, *ins, nullptr,
+                           IsMaterializedObject(materialized, *ins)
+                               ? nullptr
+                               : &sites)) {
+        ObjectMemoryView view(graph.alloc(), *ins, sites, materialized);
         if (!replaceObject.run(view)) {
           return false;
         }
@@ -207,6 +207,7 @@ Maybe<InlinableCallData> FindInlinableCallData(ICCacheIRStub* stub) {
   ObjOperandId calleeGuardOperand;
   CallFlags flags;
   JSFunction* target = nullptr;
+  bool guardsSpecificFunction = false;
 
   CacheIRReader reader(stubInfo);
   while (reader.more()) {
@@ -226,6 +227,7 @@ Maybe<InlinableCallData> FindInlinableCallData(ICCacheIRStub* stub) {
         (void)reader.stubOffset();  // nargsAndFlags
         uintptr_t rawTarget = stubInfo->getStubRawWord(stubData, targetOffset);
         target = reinterpret_cast<JSFunction*>(rawTarget);
+        guardsSpecificFunction = true;
         break;
       }
       case CacheOp::GuardFunctionScript: {
@@ -234,6 +236,7 @@ Maybe<InlinableCallData> FindInlinableCallData(ICCacheIRStub* stub) {
         uint32_t targetOffset = reader.stubOffset();
         uintptr_t rawTarget = stubInfo->getStubRawWord(stubData, targetOffset);
         target = reinterpret_cast<BaseScript*>(rawTarget)->function();
+        guardsSpecificFunction = false;
         (void)reader.stubOffset();  // nargsAndFlags
         break;
       }
@@ -295,6 +298,7 @@ Maybe<InlinableCallData> FindInlinableCallData(ICCacheIRStub* stub) {
     data->calleeOperand = calleeGuardOperand;
     data->callFlags = flags;
     data->target = target;
+    data->guardsSpecificFunction = guardsSpecificFunction;
   }
   return data;
 }
@@ -716,7 +720,8 @@ ICScript* TrialInliner::createInlinedICScript(JSFunction* target,
 
   uint32_t pcOffset = loc.bytecodeToOffset(script_);
   ICScript* result = inlinedICScript.get();
-  if (!icScript_->addInlinedChild(cx(), std::move(inlinedICScript), pcOffset)) {
+  if (!icScript_->addInlinedChild(cx(), std::move(inlinedICScript),
+                                  targetScript, pcOffset)) {
     return nullptr;
   }
   MOZ_ASSERT(result->numICEntries() == targetScript->numICEntries());
@@ -738,17 +743,7 @@ bool TrialInliner::maybeInlineCall(ICEntry& entry, ICFallbackStub* fallback,
                                    BytecodeLocation loc) {
   ICCacheIRStub* stub = maybeSingleStub(entry);
   if (!stub) {
-#ifdef JS_JITSPEW
-    if (fallback->numOptimizedStubs() > 1) {
-      JitSpew(JitSpew_WarpTrialInlining,
-              "Inlining candidate JSOp::%s (offset=%u):", CodeName(loc.getOp()),
-              fallback->pcOffset());
-      JitSpewIndent spewIndent(JitSpew_WarpTrialInlining);
-      JitSpew(JitSpew_WarpTrialInlining, "SKIP: Polymorphic (%u stubs)",
-              (unsigned)fallback->numOptimizedStubs());
-    }
-#endif
-    return true;
+    return maybeInlinePolymorphicCall(entry, fallback, loc);
   }
 
   MOZ_ASSERT(!icScript_->hasInlinedChild(fallback->pcOffset()));
@@ -789,6 +784,142 @@ bool TrialInliner::maybeInlineCall(ICEntry& entry, ICFallbackStub* fallback,
   return replaceICStub(entry, fallback, writer, CacheKind::Call);
 }
 
+bool TrialInliner::maybeInlinePolymorphicCall(ICEntry& entry,
+                                              ICFallbackStub* fallback,
+                                              BytecodeLocation loc) {
+  // Look for a chain of stubs that each call a different known target, and
+  // which together handled all calls since the last stub was attached. Replace
+  // them with one trial-inlined stub per target. The stubs still guard on the
+  // callee, so other callees continue to go through the fallback stub.
+  if (fallback->trialInliningState() != TrialInliningState::Candidate ||
+      fallback->numOptimizedStubs() < 2 || fallback->enteredCount() != 0 ||
+      fallback->mayHaveFoldedStub()) {
+    return true;
+  }
+
+  JitSpew(JitSpew_WarpTrialInlining,
+          "Inlining candidate JSOp::%s (offset=%u):", CodeName(loc.getOp()),
+          fallback->pcOffset());
+  JitSpewIndent spewIndent(JitSpew_WarpTrialInlining);
+
+  uint32_t numStubs = fallback->numOptimizedStubs();
+  if (numStubs > JitOptions.polymorphicInliningMaxTargets) {
+    JitSpew(JitSpew_WarpTrialInlining,
+            "SKIP: Polymorphic (%u stubs, maximum %u)", unsigned(numStubs),
+            unsigned(JitOptions.polymorphicInliningMaxTargets));
+    return true;
+  }
+
+  struct PolymorphicTarget {
+    ICCacheIRStub* stub;
+    InlinableCallData data;
+  };
+  Vector<PolymorphicTarget, 4> targets(cx());
+
+  size_t totalSize = inliningRootTotalBytecodeSize();
+  for (ICStub* next = entry.firstStub(); next != fallback;
+       next = next->toCacheIRStub()->next()) {
+    ICCacheIRStub* stub = next->toCacheIRStub();
+
+    // Dispatching in Warp compares the callee against each target, so every
+    // stub must guard on a specific function.
+    Maybe<InlinableCallData> data = FindInlinableCallData(stub);
+    if (data.isNothing() || !data->guardsSpecificFunction) {
+      JitSpew(JitSpew_WarpTrialInlining, "SKIP: Polymorphic (unknown target)");
+      return true;
+    }
+    MOZ_ASSERT(!data->icScript);
+
+    // Each target needs its own ICScript for this call site.
+    for (const PolymorphicTarget& other : targets) {
+      if (other.data.target->baseScript() == data->target->baseScript()) {
+        JitSpew(JitSpew_WarpTrialInlining,
+                "SKIP: Polymorphic (targets share a script)");
+        return true;
+      }
+    }
+
+    if (getInliningDecision(data->target, stub, loc) ==
+        TrialInliningDecision::NoInline) {
+      return true;
+    }
+
+    // All targets are inlined together, so they must fit in the script size
+    // budget together.
+    totalSize += data->target->nonLazyScript()->length();
+    if (totalSize > JitOptions.ionMaxScriptSize) {
+      JitSpew(JitSpew_WarpTrialInlining, "SKIP: total size too big");
+      return true;
+    }
+
+    if (!targets.append(PolymorphicTarget{stub, *data})) {
+      ReportOutOfMemory(cx());
+      return false;
+    }
+  }
+  MOZ_ASSERT(targets.length() == numStubs);
+
+  // Attach the new stubs in front of the existing ones, starting with the
+  // last stub so that the order of the chain is preserved. The existing stubs
+  // are unlinked afterwards: until then, their stub data is used for cloning
+  // the shared prefix.
+  // If we fail part of the way, discard all stubs, including the ones we
+  // already attached, and let the IC attach regular stubs again.
+  auto giveUp = [&]() {
+    fallback->discardStubs(cx()->zone(), &entry);
+    fallback->setTrialInliningState(TrialInliningState::Failure);
+    icScript_->removeInlinedChild(fallback->pcOffset());
+  };
+
+  ICCacheIRStub* lastNewStub = nullptr;
+  for (size_t i = targets.length(); i > 0; i--) {
+    const PolymorphicTarget& target = targets[i - 1];
+
+    ICScript* newICScript = createInlinedICScript(target.data.target, loc);
+    if (!newICScript) {
+      giveUp();
+      return false;
+    }
+
+    CacheIRWriter writer(cx());
+    Int32OperandId argcId(writer.setInputOperandId(0));
+    cloneSharedPrefix(target.stub, target.data.endOfSharedPrefix, writer);
+
+    writer.callInlinedFunction(target.data.calleeOperand, argcId, newICScript,
+                               target.data.callFlags,
+                               ClampFixedArgc(loc.getCallArgc()));
+    writer.returnFromIC();
+
+    // Note: AttachBaselineCacheIRStub never throws an exception.
+    ICAttachResult result =
+        AttachBaselineCacheIRStub(cx(), writer, CacheKind::Call, script_,
+                                  icScript_, fallback, "TrialInline");
+    if (result != ICAttachResult::Attached) {
+      giveUp();
+      if (result == ICAttachResult::OOM) {
+        ReportOutOfMemory(cx());
+        return false;
+      }
+      MOZ_ASSERT(result == ICAttachResult::TooLarge);
+      return true;
+    }
+    MOZ_ASSERT(fallback->trialInliningState() == TrialInliningState::Inlined);
+
+    if (!lastNewStub) {
+      lastNewStub = entry.firstStub()->toCacheIRStub();
+    }
+  }
+
+  for (const PolymorphicTarget& target : targets) {
+    MOZ_ASSERT(lastNewStub->next() == target.stub);
+    fallback->unlinkStub(cx()->zone(), &entry, lastNewStub, target.stub);
+  }
+
+  JitSpew(JitSpew_WarpTrialInlining, "SUCCESS: Inlined %u targets",
+          unsigned(targets.length()));
+  return true;
+}
+
 bool TrialInliner::maybeInlineGetter(ICEntry& entry, ICFallbackStub* fallback,
                                      BytecodeLocation loc, CacheKind kind) {
   ICCacheIRStub* stub = maybeSingleStub(entry);
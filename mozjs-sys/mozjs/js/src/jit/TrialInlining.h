@@ -44,6 +44,12 @@
  * private ICScript, which is specialized for its caller.
  *
  * The same approach can be used to inline recursively.
+ *
+ * Call sites that see a small number of different callees are handled in the
+ * same way: each target gets its own ICScript and its own specialized stub,
+ * guarded on the callee function. WarpBuilder then dispatches on the callee
+ * and inlines each target, with a generic call for any other callee. See
+ * TrialInliner::maybeInlinePolymorphicCall.
  */
 
 class JS_PUBLIC_API JSTracer;
@@ -121,6 +127,9 @@ class InlinableCallData : public InlinableOpData {
  public:
   ObjOperandId calleeOperand;
   CallFlags callFlags;
+  // Whether the callee is guarded with GuardSpecificFunction instead of
+  // GuardFunctionScript.
+  bool guardsSpecificFunction = false;
 };
 
 class InlinableGetterData : public InlinableOpData {
@@ -161,6 +170,9 @@ class MOZ_RAII TrialInliner {
   [[nodiscard]] bool tryInlining();
   [[nodiscard]] bool maybeInlineCall(ICEntry& entry, ICFallbackStub* fallback,
                                      BytecodeLocation loc);
+  [[nodiscard]] bool maybeInlinePolymorphicCall(ICEntry& entry,
+                                                ICFallbackStub* fallback,
+                                                BytecodeLocation loc);
   [[nodiscard]] bool maybeInlineGetter(ICEntry& entry, ICFallbackStub* fallback,
                                        BytecodeLocation loc, CacheKind kind);
   [[nodiscard]] bool maybeInlineSetter(ICEntry& entry, ICFallbackStub* fallback,
@@ -1912,6 +1912,12 @@ bool WarpBuilder::buildCallOp(BytecodeLocation loc) {
   bool constructing = IsConstructOp(op);
   bool ignoresReturnValue = (op == JSOp::CallIgnoresRv || loc.resultIsPopped());
 
+  if (const auto* polymorphicSnapshot =
+          getOpSnapshot<WarpPolymorphicInlinedCall>(loc)) {
+    return buildPolymorphicInlinedCall(loc, polymorphicSnapshot, argc,
+                                       constructing, ignoresReturnValue);
+  }
+
   CallInfo callInfo(alloc(), constructing, ignoresReturnValue);
   if (!callInfo.init(current, argc)) {
     return false;
@@ -3778,6 +3784,112 @@ bool WarpBuilder::buildInlinedCall(BytecodeLocation loc,
   return true;
 }
 
+bool WarpBuilder::buildPolymorphicInlinedCall(
+    BytecodeLocation loc, const WarpPolymorphicInlinedCall* snapshot,
+    uint32_t argc, bool constructing, bool ignoresReturnValue) {
+  // Compare the callee with each target in turn and branch to a block that
+  // inlines the matching one. The call's operands are still on the stack when
+  // each branch starts, so bailouts from the branch's CacheIR guards resume
+  // at the call op. The last block makes a generic call, and all branches
+  // join after the call op.
+  uint32_t numFormals = argc + 2 + uint32_t(constructing);
+  MDefinition* callee = current->peek(-int32_t(numFormals));
+  if (callee->type() != MIRType::Object) {
+    auto* unbox =
+        MUnbox::New(alloc(), callee, MIRType::Object, MUnbox::Fallible);
+    current->add(unbox);
+    callee = unbox;
+  }
+
+  MIRGraphReturns exits(alloc());
+  for (uint32_t i = 0; i < snapshot->numTargets(); i++) {
+    const WarpPolymorphicInlinedCall::Target& target = snapshot->target(i);
+
+    MInstruction* expected;
+    if (target.callee().isNurseryIndex()) {
+      expected = MNurseryObject::New(alloc(), target.callee().toNurseryIndex());
+    } else {
+      expected = MConstant::NewObject(alloc(), target.callee().toObject());
+    }
+    current->add(expected);
+
+    auto* compare = MCompare::New(alloc(), callee, expected, JSOp::StrictEq,
+                                  MCompare::Compare_Object);
+    current->add(compare);
+
+    MTest* test = MTest::New(alloc(), compare, /* ifTrue = */ nullptr,
+                             /* ifFalse = */ nullptr);
+    current->end(test);
+    MBasicBlock* testBlock = current;
+
+    if (!startNewBlock(testBlock, loc)) {
+      return false;
+    }
+    test->initSuccessor(MTest::TrueBranchIndex, current);
+
+    // See buildCallOp.
+    const WarpInlinedCall* inlinedCall = target.inlinedCall();
+    CallInfo callInfo(alloc(), constructing, ignoresReturnValue);
+    if (!callInfo.init(current, argc)) {
+      return false;
+    }
+    callInfo.markAsInlined();
+    if (!transpileCall(loc, inlinedCall->cacheIRSnapshot(), &callInfo)) {
+      return false;
+    }
+    if (!buildInlinedCall(loc, inlinedCall, callInfo)) {
+      return false;
+    }
+    if (!exits.append(current)) {
+      return false;
+    }
+
+    if (!startNewBlock(testBlock, loc)) {
+      return false;
+    }
+    test->initSuccessor(MTest::FalseBranchIndex, current);
+  }
+
+  // Use a generic call for any other callee.
+  CallInfo callInfo(alloc(), constructing, ignoresReturnValue);
+  if (!callInfo.init(current, argc)) {
+    return false;
+  }
+
+  bool needsThisCheck = false;
+  if (callInfo.constructing()) {
+    buildCreateThis(callInfo);
+    needsThisCheck = true;
+  }
+
+  MCall* call = makeCall(callInfo, needsThisCheck);
+  if (!call) {
+    return false;
+  }
+
+  current->add(call);
+  current->push(call);
+  if (!resumeAfter(call, loc)) {
+    return false;
+  }
+
+  // Join all branches, merging the return values with a phi.
+  MBasicBlock* pred = current;
+  if (!startNewBlock(pred, loc.next())) {
+    return false;
+  }
+  pred->end(MGoto::New(alloc(), current));
+
+  for (MBasicBlock* exit : exits) {
+    exit->end(MGoto::New(alloc(), current));
+    if (!current->addPredecessor(alloc(), exit)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 MDefinition* WarpBuilder::patchInlinedReturns(CompileInfo* calleeCompileInfo,
                                               CallInfo& callInfo,
                                               MIRGraphReturns& exits,
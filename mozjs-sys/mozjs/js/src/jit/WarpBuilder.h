@@ -284,6 +284,9 @@ class MOZ_STACK_CLASS WarpBuilder : public WarpBuilderShared {
   [[nodiscard]] bool buildInlinedCall(BytecodeLocation loc,
                                       const WarpInlinedCall* snapshot,
                                       CallInfo& callInfo);
+  [[nodiscard]] bool buildPolymorphicInlinedCall(
+      BytecodeLocation loc, const WarpPolymorphicInlinedCall* snapshot,
+      uint32_t argc, bool constructing, bool ignoresReturnValue);
 
   MDefinition* patchInlinedReturns(CompileInfo* calleeCompileInfo,
                                    CallInfo& callInfo, MIRGraphReturns& exits,
@@ -70,6 +70,10 @@ class MOZ_STACK_CLASS WarpScriptOracle {
                                       BytecodeLocation loc, ICCacheIRStub* stub,
                                       ICFallbackStub* fallbackStub,
                                       uint8_t* stubDataCopy);
+  AbortReasonOr<bool> maybeInlinePolymorphicCall(WarpOpSnapshotList& snapshots,
+                                                 BytecodeLocation loc,
+                                                 ICCacheIRStub* firstStub,
+                                                 ICFallbackStub* fallbackStub);
   AbortReasonOr<bool> maybeInlinePolymorphicTypes(WarpOpSnapshotList& snapshots,
                                                   BytecodeLocation loc,
                                                   ICCacheIRStub* firstStub,
@@ -878,6 +882,17 @@ AbortReasonOr<Ok> WarpScriptOracle::maybeInlineIC(WarpOpSnapshotList& snapshots,
   }
 
   if (!firstStubHandlesAllCases) {
+    // If trial inlining attached a stub for each target of a polymorphic call,
+    // we can inline all of them and dispatch on the callee.
+    if (fallbackStub->trialInliningState() == TrialInliningState::Inlined) {
+      bool inlinedCall;
+      MOZ_TRY_VAR(inlinedCall, maybeInlinePolymorphicCall(snapshots, loc, stub,
+                                                          fallbackStub));
+      if (inlinedCall) {
+        return Ok();
+      }
+    }
+
     // In some polymorphic cases, we can generate better code than the
     // default fallback if we know the observed types of the operands
     // and their relative frequency.
@@ -1158,6 +1173,213 @@ AbortReasonOr<bool> WarpScriptOracle::maybeInlineCall(
   return true;
 }
 
+AbortReasonOr<bool> WarpScriptOracle::maybeInlinePolymorphicCall(
+    WarpOpSnapshotList& snapshots, BytecodeLocation loc,
+    ICCacheIRStub* firstStub, ICFallbackStub* fallbackStub) {
+  MOZ_ASSERT(fallbackStub->trialInliningState() == TrialInliningState::Inlined);
+
+  // Only call ICs can have more than one trial-inlined stub. If the fallback
+  // stub was entered, some callee isn't handled by any of them.
+  if (!loc.isInvokeOp() || fallbackStub->enteredCount() != 0) {
+    return false;
+  }
+
+  // Collect the stubs that have been entered, hottest first. Each of them
+  // calls a different known target.
+  uint32_t numStubs = fallbackStub->numOptimizedStubs();
+  ICCacheIRStub** stubs = alloc_.allocateArray<ICCacheIRStub*>(numStubs);
+  if (!stubs) {
+    return abort(AbortReason::Alloc);
+  }
+
+  uint32_t numTargets = 0;
+  for (ICStub* next = firstStub; next != fallbackStub;
+       next = next->toCacheIRStub()->next()) {
+    ICCacheIRStub* stub = next->toCacheIRStub();
+    if (stub->enteredCount() == 0) {
+      continue;
+    }
+
+    // Only create a snapshot if all opcodes are supported by the transpiler.
+    CacheIRReader reader(stub->stubInfo());
+    while (reader.more()) {
+      CacheOp op = reader.readOp();
+      CacheIROpInfo opInfo = CacheIROpInfos[size_t(op)];
+      reader.skip(opInfo.argLength);
+      if (!opInfo.transpile) {
+        return false;
+      }
+    }
+
+    Maybe<InlinableCallData> data = FindInlinableCallData(stub);
+    if (data.isNothing() || !data->icScript || !data->guardsSpecificFunction) {
+      return false;
+    }
+
+    RootedFunction targetFunction(cx_, data->target);
+    if (!TrialInliner::canInline(targetFunction, script_, loc)) {
+      return false;
+    }
+
+    MOZ_ASSERT(numTargets < numStubs);
+    uint32_t i = numTargets++;
+    while (i > 0 && stubs[i - 1]->enteredCount() < stub->enteredCount()) {
+      stubs[i] = stubs[i - 1];
+      i--;
+    }
+    stubs[i] = stub;
+  }
+
+  // Inline as many of the hottest targets as fit in the script size budget.
+  // Calls to the other targets use a generic call.
+  size_t totalSize = oracle_->accumulatedBytecodeSize();
+  uint32_t numInlined = 0;
+  for (; numInlined < numTargets; numInlined++) {
+    Maybe<InlinableCallData> data = FindInlinableCallData(stubs[numInlined]);
+    totalSize += data->target->nonLazyScript()->length();
+    if (totalSize > JitOptions.ionMaxScriptSize) {
+      break;
+    }
+  }
+  if (numInlined == 0) {
+    return false;
+  }
+
+  auto* targets =
+      alloc_.allocateArray<WarpPolymorphicInlinedCall::Target>(numInlined);
+  if (!targets) {
+    return abort(AbortReason::Alloc);
+  }
+
+  uint32_t offset = loc.bytecodeToOffset(script_);
+  LifoAlloc* lifoAlloc = alloc_.lifoAlloc();
+
+  for (uint32_t i = 0; i < numInlined; i++) {
+    ICCacheIRStub* stub = stubs[i];
+    Maybe<InlinableCallData> data = FindInlinableCallData(stub);
+    RootedFunction targetFunction(cx_, data->target);
+    RootedScript targetScript(cx_, targetFunction->nonLazyScript());
+    ICScript* icScript = data->icScript;
+
+    // Add the inlined script to the inline script tree.
+    InlineScriptTree* inlineScriptTree = info_->inlineScriptTree()->addCallee(
+        &alloc_, loc.toRawBytecode(), targetScript,
+        /* isMonomorphicallyInlined = */ false);
+    if (!inlineScriptTree) {
+      return abort(AbortReason::Alloc);
+    }
+
+    // Create a CompileInfo for the inlined script.
+    jsbytecode* osrPc = nullptr;
+    bool needsArgsObj = targetScript->needsArgsObj();
+    CompileInfo* info = lifoAlloc->new_<CompileInfo>(
+        mirGen_.runtime, targetScript, targetFunction, osrPc, needsArgsObj,
+        inlineScriptTree);
+    if (!info) {
+      return abort(AbortReason::Alloc);
+    }
+
+    WarpCacheIR* cacheIRSnapshot;
+    WarpObjectField callee = WarpObjectField::fromObject(targetFunction);
+    {
+      // Check GC is not possible between updating stub pointers and creating
+      // the snapshot.
+      JS::AutoAssertNoGC nogc;
+
+      const CacheIRStubInfo* stubInfo = stub->stubInfo();
+      uint8_t* stubDataCopy = nullptr;
+      size_t bytesNeeded = stubInfo->stubDataSize();
+      if (bytesNeeded > 0) {
+        stubDataCopy = alloc_.allocateArray<uint8_t>(bytesNeeded);
+        if (!stubDataCopy) {
+          return abort(AbortReason::Alloc);
+        }
+        std::copy_n(stub->stubDataStart(), bytesNeeded, stubDataCopy);
+        if (!replaceNurseryAndAllocSitePointers(stub, stubInfo,
+                                                stubDataCopy)) {
+          return abort(AbortReason::Alloc);
+        }
+      }
+
+      JitCode* jitCode = stub->jitCode();
+      cacheIRSnapshot = new (alloc_.fallible())
+          WarpCacheIR(offset, jitCode, stubInfo, stubDataCopy);
+      if (!cacheIRSnapshot) {
+        return abort(AbortReason::Alloc);
+      }
+
+      // Read barrier for weak stub data copied into the snapshot.
+      Zone* zone = jitCode->zone();
+      if (zone->needsIncrementalBarrier()) {
+        TraceWeakCacheIRStub(zone->barrierTracer(), stub, stubInfo);
+      }
+
+      if (IsInsideNursery(targetFunction)) {
+        uint32_t nurseryIndex;
+        if (!oracle_->registerNurseryObject(targetFunction, &nurseryIndex)) {
+          return abort(AbortReason::Alloc);
+        }
+        callee = WarpObjectField::fromNurseryIndex(nurseryIndex);
+      }
+    }
+
+    // Take a snapshot of the inlined script (which may do more
+    // inlining recursively).
+    WarpScriptOracle scriptOracle(cx_, oracle_, targetScript, info, icScript);
+
+    AbortReasonOr<WarpScriptSnapshot*> maybeScriptSnapshot =
+        scriptOracle.createScriptSnapshot();
+
+    if (maybeScriptSnapshot.isErr()) {
+      JitSpew(JitSpew_WarpTranspiler,
+              "Can't create snapshot for polymorphic JSOp::%s",
+              CodeName(loc.getOp()));
+
+      switch (maybeScriptSnapshot.unwrapErr()) {
+        case AbortReason::Disable: {
+          // If the target script can't be warp-compiled, mark it as
+          // uninlineable, clean up, and fall through to the non-inlined path.
+          // The trial-inlined stubs remain attached, but new stubs will no
+          // longer be trial-inlined.
+          targetScript->setUninlineable();
+          for (uint32_t j = 0; j < i; j++) {
+            info_->inlineScriptTree()->removeCallee(
+                targets[j].inlinedCall()->info()->inlineScriptTree());
+          }
+          info_->inlineScriptTree()->removeCallee(inlineScriptTree);
+          icScript_->removeInlinedChild(offset);
+          fallbackStub->setTrialInliningState(TrialInliningState::Failure);
+          return false;
+        }
+        case AbortReason::Error:
+        case AbortReason::Alloc:
+          return Err(maybeScriptSnapshot.unwrapErr());
+        default:
+          MOZ_CRASH("Unexpected abort reason");
+      }
+    }
+
+    WarpScriptSnapshot* scriptSnapshot = maybeScriptSnapshot.unwrap();
+    oracle_->addScriptSnapshot(scriptSnapshot, icScript,
+                               targetScript->length());
+
+    auto* inlinedCall = new (alloc_.fallible())
+        WarpInlinedCall(offset, cacheIRSnapshot, scriptSnapshot, info);
+    if (!inlinedCall) {
+      return abort(AbortReason::Alloc);
+    }
+    new (&targets[i]) WarpPolymorphicInlinedCall::Target(callee, inlinedCall);
+  }
+
+  if (!AddOpSnapshot<WarpPolymorphicInlinedCall>(alloc_, snapshots, offset,
+                                                 targets, numInlined)) {
+    return abort(AbortReason::Alloc);
+  }
+  fallbackStub->setUsedByTranspiler();
+
+  return true;
+}
+
 bool WarpOracle::snapshotJitZoneStub(JitZone::StubKind kind) {
   if (zoneStubs_[kind]) {
     return true;
@@ -202,6 +202,19 @@ void WarpInlinedCall::dumpData(GenericPrinter& out) const {
   cacheIRSnapshot_->dumpData(out);
 }
 
+void WarpPolymorphicInlinedCall::dumpData(GenericPrinter& out) const {
+  for (uint32_t i = 0; i < numTargets_; i++) {
+    const Target& target = targets_[i];
+    if (target.callee().isNurseryIndex()) {
+      out.printf("    callee: nursery index %u\n",
+                 target.callee().toNurseryIndex());
+    } else {
+      out.printf("    callee: 0x%p\n", target.callee().toObject());
+    }
+    target.inlinedCall()->dumpData(out);
+  }
+}
+
 void WarpPolymorphicTypes::dumpData(GenericPrinter& out) const {
   out.printf("    types:\n");
   for (auto& typeData : list_) {
@@ -424,3 +437,14 @@ void WarpInlinedCall::traceData(JSTracer* trc) {
   // Note: scriptSnapshot_ is traced through WarpSnapshot.
   cacheIRSnapshot_->trace(trc);
 }
+
+void WarpPolymorphicInlinedCall::traceData(JSTracer* trc) {
+  for (uint32_t i = 0; i < numTargets_; i++) {
+    const Target& target = targets_[i];
+    if (!target.callee().isNurseryIndex()) {
+      TraceWarpStubPtr<JSObject>(trc, target.callee().rawData(),
+                                 "warp-polymorphic-callee");
+    }
+    target.inlinedCall()->traceData(trc);
+  }
+}
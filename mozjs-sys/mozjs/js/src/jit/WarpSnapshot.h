@@ -48,6 +48,7 @@ class WarpScriptSnapshot;
   _(WarpBailout)                 \
   _(WarpCacheIR)                 \
   _(WarpInlinedCall)             \
+  _(WarpPolymorphicInlinedCall)  \
   _(WarpPolymorphicTypes)
 
 // WarpOpSnapshot is the base class for data attached to a single bytecode op by
@@ -330,6 +331,52 @@ class WarpInlinedCall : public WarpOpSnapshot {
 #endif
 };
 
+// Information for inlining the targets of a polymorphic scripted call IC.
+// WarpBuilder compares the callee with each target in order and inlines the
+// matching one. Other callees use a generic call.
+class WarpPolymorphicInlinedCall : public WarpOpSnapshot {
+ public:
+  class Target {
+    WarpObjectField callee_;
+    WarpInlinedCall* inlinedCall_;
+
+   public:
+    Target(WarpObjectField callee, WarpInlinedCall* inlinedCall)
+        : callee_(callee), inlinedCall_(inlinedCall) {}
+
+    WarpObjectField callee() const { return callee_; }
+    WarpInlinedCall* inlinedCall() const { return inlinedCall_; }
+  };
+
+ private:
+  // Allocated in the compilation's LifoAlloc, hottest target first.
+  Target* targets_;
+  uint32_t numTargets_;
+
+ public:
+  static constexpr Kind ThisKind = Kind::WarpPolymorphicInlinedCall;
+
+  WarpPolymorphicInlinedCall(uint32_t offset, Target* targets,
+                             uint32_t numTargets)
+      : WarpOpSnapshot(ThisKind, offset),
+        targets_(targets),
+        numTargets_(numTargets) {
+    MOZ_ASSERT(numTargets > 0);
+  }
+
+  uint32_t numTargets() const { return numTargets_; }
+  const Target& target(uint32_t i) const {
+    MOZ_ASSERT(i < numTargets_);
+    return targets_[i];
+  }
+
+  void traceData(JSTracer* trc);
+
+#ifdef JS_JITSPEW
+  void dumpData(GenericPrinter& out) const;
+#endif
+};
+
 // Information for inlining an ordered set of types
 class WarpPolymorphicTypes : public WarpOpSnapshot {
   TypeDataList list_;
@@ -13,25 +13,179 @@
 using namespace js;
 using namespace js::jit;
 
-using LastSeenMap = js::HashMap<uint32_t, MDefinition*, DefaultHasher<uint32_t>,
-                                SystemAllocPolicy>;
+namespace {
+
+// A position at which the index `base + offset` is known to be in bounds,
+// which implies that every index from `base` to `base + offset` is in bounds.
+struct CheckedIndex {
+  // The bounds check, or the phi whose inputs are all checked.
+  MDefinition* check;
+
+  // The checked index, which is `base` or `MWasmAddOffset(base, offset)`.
+  MDefinition* index;
+  uint64_t offset;
+};
+
+using CheckedIndexVector = Vector<CheckedIndex, 1, SystemAllocPolicy>;
+
+// Map from the id of a base to the positions at which it was checked.
+using CheckedIndexMap =
+    js::HashMap<uint32_t, CheckedIndexVector, DefaultHasher<uint32_t>,
+                SystemAllocPolicy>;
+
+}  // namespace
+
+// The number of blocks visited when looking for checks which together dominate
+// a bounds check.
+static const uint32_t MaxCoverageBlocks = 16;
+
+// Split an index into a base and a constant offset. MWasmAddOffset traps on
+// overflow, so the base is not larger than the index. Zero extension preserves
+// the order of indices.
+static MDefinition* DecomposeIndex(MDefinition* index, uint64_t* offset) {
+  if (index->isWasmExtendU32Index()) {
+    index = index->toWasmExtendU32Index()->input();
+  }
+  if (index->isWasmAddOffset()) {
+    *offset = index->toWasmAddOffset()->offset();
+    return index->toWasmAddOffset()->base();
+  }
+  *offset = 0;
+  return index;
+}
+
+// Find a check of `base + offset` or a larger offset which dominates the end of
+// `block`. With Spectre index masking, the check replaces the uses of the
+// redundant check, so it must check the very same index.
+static const CheckedIndex* FindDominatingCheck(const CheckedIndexVector& checks,
+                                               MBasicBlock* block,
+                                               MDefinition* index,
+                                               uint64_t offset) {
+  for (const CheckedIndex& checked : checks) {
+    if (checked.offset < offset || !checked.check->block()->dominates(block)) {
+      continue;
+    }
+    if (JitOptions.spectreIndexMasking && checked.index != index) {
+      continue;
+    }
+    return &checked;
+  }
+  return nullptr;
+}
+
+static bool IsCheckedOnEntry(const CheckedIndexVector& checks,
+                             MDefinition* base, MBasicBlock* block,
+                             uint64_t offset, uint32_t* budget);
+
+// Whether `base + offset` is checked on every path reaching the end of
+// `block`, either by a dominating check or by checks on all the paths through
+// its predecessors.
+static bool IsCheckedAtEnd(const CheckedIndexVector& checks, MDefinition* base,
+                           MBasicBlock* block, uint64_t offset,
+                           uint32_t* budget) {
+  if (FindDominatingCheck(checks, block, nullptr, offset)) {
+    return true;
+  }
+  return IsCheckedOnEntry(checks, base, block, offset, budget);
+}
+
+static bool IsCheckedOnEntry(const CheckedIndexVector& checks,
+                             MDefinition* base, MBasicBlock* block,
+                             uint64_t offset, uint32_t* budget) {
+  // Loop headers are reached from their backedge, whose checks are not known
+  // yet, and a block which the base does not dominate cannot follow a check
+  // of the base.
+  if (block->isLoopHeader() || block == base->block() ||
+      !base->block()->dominates(block) || block->numPredecessors() == 0) {
+    return false;
+  }
+  if (*budget < block->numPredecessors()) {
+    return false;
+  }
+  *budget -= block->numPredecessors();
+
+  for (size_t i = 0; i < block->numPredecessors(); i++) {
+    if (!IsCheckedAtEnd(checks, base, block->getPredecessor(i), offset,
+                        budget)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Move the bounds checks at the start of a loop header, whose operands are
+// defined before the loop, to the end of the loop's preheader. The header is
+// always entered from the preheader, and nothing observable precedes the
+// checks in the header, so the checks trap at the same point of the first
+// iteration, and are no longer repeated by the following iterations. The scan
+// stops at an interrupt check, as the interrupt callback may run arbitrary
+// code, which could grow the memory.
+static void HoistLoopInvariantBoundsChecks(MIRGraph& graph) {
+  for (ReversePostorderIterator bIter(graph.rpoBegin());
+       bIter != graph.rpoEnd(); bIter++) {
+    MBasicBlock* header = *bIter;
+    if (!header->isLoopHeader()) {
+      continue;
+    }
+    MBasicBlock* preheader = header->loopPredecessor();
+
+    for (MInstructionIterator iter(header->begin()); iter != header->end();) {
+      MInstruction* ins = *iter++;
+      if (ins->isWasmBoundsCheck()) {
+        MWasmBoundsCheck* bc = ins->toWasmBoundsCheck();
+        if (bc->isMemory0() && bc->index()->block()->dominates(preheader) &&
+            bc->boundsCheckLimit()->block()->dominates(preheader)) {
+          JitSpew(JitSpew_WasmBCE, "Hoisting bounds check %u out of loop %u",
+                  bc->id(), header->id());
+          header->moveBefore(preheader->lastIns(), bc);
+          continue;
+        }
+      }
+      if (ins->isEffectful() || ins->isGuard()) {
+        break;
+      }
+    }
+  }
+}
+
+static void SetRedundant(MWasmBoundsCheck* bc, MDefinition* replacement) {
+  JitSpew(JitSpew_WasmBCE, "Eliminating bounds check %u", bc->id());
+  bc->setRedundant();
+  if (JitOptions.spectreIndexMasking) {
+    bc->replaceAllUsesWith(replacement);
+  } else {
+    MOZ_ASSERT(!bc->hasUses());
+  }
+}
 
 // The Wasm Bounds Check Elimination (BCE) pass looks for bounds checks
-// on SSA values that have already been checked. (in the same block or in a
-// dominating block). These bounds checks are redundant and thus eliminated.
+// on indices that have already been checked. These bounds checks are
+// redundant and thus eliminated. A bounds check is redundant when:
+//
+// - its index is a constant below the minimum length of the memory;
+//
+// - a dominating check covers its index, that is a check of the same base with
+//   the same or a larger constant offset, as `base + offset` cannot overflow;
+//
+// - a set of checks covers its index on every path reaching it, for instance
+//   checks in both arms of a conditional. The replacement of a check by the
+//   check it duplicates cannot be expressed then, so this is not done with
+//   Spectre index masking.
+//
+// Beforehand, the loop-invariant checks at the start of a loop header are
+// hoisted out of the loop, so that they are performed once and dominate the
+// checks of the loop body.
 //
 // Note: This is safe in the presense of dynamic memory sizes as long as they
 // can ONLY GROW. If we allow SHRINKING the heap, this pass should be
 // RECONSIDERED.
-//
-// TODO (dbounov): Are there a lot of cases where there is no single dominating
-// check, but a set of checks that together dominate a redundant check?
-//
-// TODO (dbounov): Generalize to constant additions relative to one base
 bool jit::EliminateBoundsChecks(const MIRGenerator* mir, MIRGraph& graph) {
   JitSpew(JitSpew_WasmBCE, "Begin");
-  // Map for dominating block where a given definition was checked
-  LastSeenMap lastSeen;
+
+  HoistLoopInvariantBoundsChecks(graph);
+
+  // Map from bases to the positions at which they were checked.
+  CheckedIndexMap checkedIndices;
 
   for (ReversePostorderIterator bIter(graph.rpoBegin());
        bIter != graph.rpoEnd(); bIter++) {
@@ -63,29 +217,35 @@ bool jit::EliminateBoundsChecks(const MIRGenerator* mir, MIRGraph& graph) {
                (addr->toConstant()->type() == MIRType::Int64 &&
                 uint64_t(addr->toConstant()->toInt64()) <
                     mir->minWasmMemory0Length()))) {
-            bc->setRedundant();
-            if (JitOptions.spectreIndexMasking) {
-              bc->replaceAllUsesWith(addr);
-            } else {
-              MOZ_ASSERT(!bc->hasUses());
-            }
-          } else {
-            LastSeenMap::AddPtr ptr = lastSeen.lookupForAdd(addr->id());
-            if (ptr) {
-              MDefinition* prevCheckOrPhi = ptr->value();
-              if (prevCheckOrPhi->block()->dominates(block)) {
-                bc->setRedundant();
-                if (JitOptions.spectreIndexMasking) {
-                  bc->replaceAllUsesWith(prevCheckOrPhi);
-                } else {
-                  MOZ_ASSERT(!bc->hasUses());
-                }
-              }
-            } else {
-              if (!lastSeen.add(ptr, addr->id(), def)) {
-                return false;
-              }
-            }
+            SetRedundant(bc, addr);
+            break;
+          }
+
+          uint64_t offset;
+          MDefinition* base = DecomposeIndex(addr, &offset);
+          CheckedIndexMap::AddPtr ptr = checkedIndices.lookupForAdd(base->id());
+          if (!ptr &&
+              !checkedIndices.add(ptr, base->id(), CheckedIndexVector())) {
+            return false;
+          }
+          CheckedIndexVector& checks = ptr->value();
+
+          if (const CheckedIndex* checked =
+                  FindDominatingCheck(checks, block, addr, offset)) {
+            SetRedundant(bc, checked->check);
+            break;
+          }
+
+          uint32_t budget = MaxCoverageBlocks;
+          if (!JitOptions.spectreIndexMasking &&
+              IsCheckedOnEntry(checks, base, block, offset, &budget)) {
+            SetRedundant(bc, nullptr);
+          }
+
+          // Record the check, or the position at which the redundant check
+          // was found to be covered, for the checks it dominates.
+          if (!checks.append(CheckedIndex{bc, addr, offset})) {
+            return false;
           }
           break;
         }
@@ -96,12 +256,12 @@ bool jit::EliminateBoundsChecks(const MIRGenerator* mir, MIRGraph& graph) {
           MOZ_ASSERT(phi->numOperands() > 0);
 
           // If all incoming values to a phi node are safe (i.e. have a
-          // check that dominates this block) then we can consider this
-          // phi node checked.
+          // check that covers the end of the corresponding predecessor)
+          // then we can consider this phi node checked.
           //
-          // Note that any phi that is part of a cycle
-          // will not be "safe" since the value coming on the backedge
-          // cannot be in lastSeen because its block hasn't been traversed yet.
+          // Note that any phi that is part of a cycle will usually not be
+          // "safe" since the value coming on the backedge is only checked
+          // in blocks which haven't been traversed yet.
           for (int i = 0, nOps = phi->numOperands(); i < nOps; i++) {
             MDefinition* src = phi->getOperand(i);
 
@@ -113,15 +273,21 @@ bool jit::EliminateBoundsChecks(const MIRGenerator* mir, MIRGraph& graph) {
               MOZ_ASSERT(!src->isWasmBoundsCheck());
             }
 
-            LastSeenMap::Ptr checkPtr = lastSeen.lookup(src->id());
-            if (!checkPtr || !checkPtr->value()->block()->dominates(block)) {
+            uint64_t offset;
+            MDefinition* base = DecomposeIndex(src, &offset);
+            CheckedIndexMap::Ptr checkPtr = checkedIndices.lookup(base->id());
+            if (!checkPtr ||
+                !FindDominatingCheck(checkPtr->value(),
+                                     block->getPredecessor(i), src, offset)) {
               phiChecked = false;
               break;
             }
           }
 
           if (phiChecked) {
-            if (!lastSeen.put(def->id(), def)) {
+            CheckedIndexVector checks;
+            if (!checks.append(CheckedIndex{def, def, 0}) ||
+                !checkedIndices.put(def->id(), std::move(checks))) {
               return false;
             }
           }
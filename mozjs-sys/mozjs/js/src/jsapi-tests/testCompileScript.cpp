@@ -7,6 +7,7 @@
 #include "mozilla/Utf8.h"       // mozilla::Utf8Unit
 
 #include "frontend/CompilationStencil.h"  // JS::Stencil, frontend::CompilationStencil
+#include "js/CompilationAndEvaluation.h"  // JS_ExecuteScript
 #include "js/CompileOptions.h"  // JS::CompileOptions, JS::InstantiateOptions
 #include "js/experimental/CompileScript.h"  // JS::NewFrontendContext
 #include "js/SourceText.h"                  // JS::Source{Ownership,Text}
@@ -232,6 +233,19 @@ bool testPrepareForInstantiate() {
   // TODO storage.gcOutput_ is private, so there isn't a good way to check the
   // scriptData and scopeData capacities
 
+  // The instantiation uses the atom cache and the scope data allocated by
+  // PrepareForInstantiate.
+  JS::InstantiateOptions instantiateOptions(options);
+  JS::RootedScript script(
+      cx, JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil,
+                                       &storage));
+  CHECK(script);
+
+  JS::RootedValue rval(cx);
+  CHECK(JS_ExecuteScript(cx, script, &rval));
+  CHECK(rval.isInt32());
+  CHECK(rval.toInt32() == 42);
+
   return true;
 }
 END_TEST(testCompileScript);
@@ -0,0 +1,65 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jit/JitOptions.h"  // js::jit::IsBaselineInterpreterEnabled
+#include "js/experimental/ICHealth.h"  // JS::Get{Script,}ICHealthReport
+#include "js/PropertyAndElement.h"     // JS_SetProperty
+#include "jsapi-tests/tests.h"
+
+BEGIN_TEST(testICHealthReport) {
+  // ICs are only allocated for scripts that run in the baseline tiers.
+  if (!js::jit::IsBaselineInterpreterEnabled()) {
+    return true;
+  }
+
+  // The property access in |f| sees more shapes than an IC can hold stubs
+  // for, so it transitions to megamorphic mode.
+  JS::RootedValue v(cx);
+  EVAL(
+      "function f(o) { return o.x; }\n"
+      "for (var i = 0; i < 200; i++) {\n"
+      "  var o = {x: i};\n"
+      "  o['p' + (i % 10)] = i;\n"
+      "  f(o);\n"
+      "}\n"
+      "f",
+      &v);
+  CHECK(v.isObject());
+
+  JS::RootedFunction fun(cx, JS_GetObjectFunction(&v.toObject()));
+  CHECK(fun);
+  JS::RootedScript script(cx, JS_GetFunctionScript(cx, fun));
+  CHECK(script);
+
+  JS::RootedString report(cx, JS::GetScriptICHealthReport(cx, script));
+  CHECK(report);
+  JS::RootedValue reportVal(cx, JS::StringValue(report));
+  CHECK(JS_SetProperty(cx, global, "report", reportVal));
+  EVAL(
+      "var r = JSON.parse(report);\n"
+      "r.name === 'f' && r.entries.some(e => e.op === 'GetProp' &&\n"
+      "                                      e.mode !== 'specialized' &&\n"
+      "                                      e.transitions >= 1)",
+      &v);
+  CHECK(v.isTrue());
+
+  // The zone-wide report only includes unhealthy ICs, and should find the
+  // same site.
+  report = JS::GetICHealthReport(cx, 1);
+  CHECK(report);
+  reportVal.setString(report);
+  CHECK(JS_SetProperty(cx, global, "report", reportVal));
+  EVAL(
+      "var r = JSON.parse(report);\n"
+      "r.scripts.some(s => s.name === 'f' &&\n"
+      "                    s.entries.some(e => e.op === 'GetProp'))",
+      &v);
+  CHECK(v.isTrue());
+
+  return true;
+}
+END_TEST(testICHealthReport)
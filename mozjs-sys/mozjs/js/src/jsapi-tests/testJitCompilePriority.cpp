@@ -0,0 +1,160 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+#include "mozilla/TimeStamp.h"
+
+#include "jit/CompileInfo.h"
+#include "jit/IonCompileTask.h"
+#include "jit/JitOptions.h"
+#include "jit/JitScript.h"
+#include "js/PropertyAndElement.h"  // JS_GetProperty
+#include "jsapi-tests/testJitMinimalFunc.h"
+#include "jsapi-tests/tests.h"
+#include "vm/HelperThreadState.h"
+
+#include "jit/InlineScriptTree-inl.h"
+#include "jit/JitScript-inl.h"
+#include "vm/JSScript-inl.h"
+
+using namespace js;
+using namespace js::jit;
+
+using mozilla::TimeDuration;
+using mozilla::TimeStamp;
+
+// An Ion compilation of a script, which is never run.
+struct TestIonCompileTask : MinimalAlloc {
+  JitCompileOptions options;
+  CompileInfo info;
+  MIRGraph graph;
+  MIRGenerator mir;
+  IonCompileTask task;
+
+  TestIonCompileTask(JSContext* cx, JSScript* script)
+      : info(CompileRuntime::get(cx->runtime()), script, nullptr, nullptr,
+             false, InlineScriptTree::New(&alloc, nullptr, nullptr, script)),
+        graph(&alloc),
+        mir(CompileRealm::get(script->realm()), options, &alloc, &graph,
+            &info, static_cast<const OptimizationInfo*>(nullptr)),
+        task(cx, mir, nullptr) {}
+};
+
+BEGIN_TEST(testJitCompilePriority) {
+  // A small script and a larger one, with a JitScript to count warm-ups.
+  JS::RootedValue v(cx);
+  EVAL(
+      "function small(x) { return x + 1; }\n"
+      "function large(x) {\n"
+      "  var a = x * 2, b = x * 3, c = x * 4, d = x * 5;\n"
+      "  for (var i = 0; i < 10; i++) { a += b; b += c; c += d; d += a; }\n"
+      "  return a + b + c + d;\n"
+      "}\n"
+      "small(1) + large(1);",
+      &v);
+  JS::RootedScript smallScript(cx, getScript("small"));
+  JS::RootedScript largeScript(cx, getScript("large"));
+  CHECK(smallScript && largeScript);
+  CHECK(smallScript->length() < largeScript->length());
+
+  AutoKeepJitScripts keepJitScripts(cx);
+  CHECK(smallScript->ensureHasJitScript(cx, keepJitScripts));
+  CHECK(largeScript->ensureHasJitScript(cx, keepJitScripts));
+
+  uint32_t preemptionMs = JitOptions.ionCompilePreemptionMs;
+  JitOptions.ionCompilePreemptionMs = 50;
+  auto restore = mozilla::MakeScopeExit(
+      [&] { JitOptions.ionCompilePreemptionMs = preemptionMs; });
+
+  CHECK(checkSelectionOrder(smallScript, largeScript));
+  CHECK(checkPreemption(smallScript, largeScript));
+  return true;
+}
+
+JSScript* getScript(const char* name) {
+  JS::RootedValue v(cx);
+  if (!JS_GetProperty(cx, global, name, &v) || !v.isObject()) {
+    return nullptr;
+  }
+  JS::RootedFunction fun(cx, JS_GetObjectFunction(&v.toObject()));
+  return fun ? JS_GetFunctionScript(cx, fun) : nullptr;
+}
+
+// The task of the script which warms up the fastest since it was queued is
+// compiled first, even if the other script has run more in total.
+bool checkSelectionOrder(JS::HandleScript smallScript,
+                         JS::HandleScript largeScript) {
+  smallScript->jitScript()->resetWarmUpCount(0);
+  largeScript->jitScript()->resetWarmUpCount(100000);
+
+  TestIonCompileTask largeTask(cx, largeScript);
+  TestIonCompileTask smallTask(cx, smallScript);
+
+  AutoLockHelperThreadState lock;
+  TimeStamp queued = TimeStamp::Now();
+  largeTask.task.setQueued(queued, lock);
+  smallTask.task.setQueued(queued, lock);
+
+  GlobalHelperThreadState::IonCompileTaskVector worklist;
+  CHECK(worklist.append(&largeTask.task));
+  CHECK(worklist.append(&smallTask.task));
+
+  smallScript->jitScript()->resetWarmUpCount(1000);
+  largeScript->jitScript()->resetWarmUpCount(100010);
+
+  TimeStamp now = queued + TimeDuration::FromMilliseconds(10);
+  size_t index = GlobalHelperThreadState::highestPriorityIonCompileIndex(
+      worklist, now, /* checkExecutionStatus */ false);
+  CHECK(index == 1);
+  worklist.erase(&worklist[index]);
+
+  index = GlobalHelperThreadState::highestPriorityIonCompileIndex(
+      worklist, now, /* checkExecutionStatus */ false);
+  CHECK(index == 0);
+  CHECK(worklist[index] == &largeTask.task);
+  return true;
+}
+
+// A new task which is much hotter cancels a running compilation which has
+// gone cold, once that has run for longer than ionCompilePreemptionMs.
+bool checkPreemption(JS::HandleScript smallScript,
+                     JS::HandleScript largeScript) {
+  smallScript->jitScript()->resetWarmUpCount(0);
+  largeScript->jitScript()->resetWarmUpCount(0);
+
+  TestIonCompileTask runningTask(cx, largeScript);
+  TestIonCompileTask newTask(cx, smallScript);
+
+  AutoLockHelperThreadState lock;
+  TimeStamp now = TimeStamp::Now();
+  runningTask.task.setQueued(now - TimeDuration::FromMilliseconds(200), lock);
+  newTask.task.setQueued(now, lock);
+
+  GlobalHelperThreadState::HelperThreadTaskVector runningTasks;
+  CHECK(runningTasks.append(&runningTask.task));
+
+  // A compilation which just started is left alone.
+  runningTask.task.setStarted(now - TimeDuration::FromMilliseconds(10), lock);
+  CHECK(!GlobalHelperThreadState::ionCompileTaskToPreempt(
+      runningTasks, &newTask.task, now));
+
+  // A stale one is cancelled.
+  runningTask.task.setStarted(now - TimeDuration::FromMilliseconds(100), lock);
+  IonCompileTask* victim = GlobalHelperThreadState::ionCompileTaskToPreempt(
+      runningTasks, &newTask.task, now);
+  CHECK(victim == &runningTask.task);
+  CHECK(!runningTask.mir.shouldCancel("test"));
+  victim->preempt(lock);
+  CHECK(runningTask.task.preempted());
+  CHECK(runningTask.mir.shouldCancel("test"));
+
+  // Only one compilation is cancelled at a time.
+  CHECK(!GlobalHelperThreadState::ionCompileTaskToPreempt(
+      runningTasks, &newTask.task, now));
+  return true;
+}
+END_TEST(testJitCompilePriority)
@@ -12,6 +12,7 @@
 #include "jit/MIRGenerator.h"
 #include "jit/MIRGraph.h"
 #include "jit/RangeAnalysis.h"
+#include "jit/ScalarReplacement.h"
 #include "jit/ValueNumbering.h"
 
 namespace js {
@@ -116,6 +117,20 @@ struct MinimalFunc : MinimalAlloc {
     }
     return true;
   }
+
+  bool runScalarReplacement() {
+    if (!SplitCriticalEdges(graph)) {
+      return false;
+    }
+    RenumberBlocks(graph);
+    if (!BuildDominatorTree(&mir, graph)) {
+      return false;
+    }
+    if (!BuildPhiReverseMapping(graph)) {
+      return false;
+    }
+    return ScalarReplacement(&mir, graph);
+  }
 };
 
 }  // namespace jit
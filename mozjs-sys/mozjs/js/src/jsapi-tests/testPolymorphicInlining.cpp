@@ -0,0 +1,88 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jit/Ion.h"        // js::jit::IsIonEnabled
+#include "jit/JitScript.h"  // js::jit::JitScript
+#include "js/GCAPI.h"       // JS::NonIncrementalGC, JS::PrepareForFullGC
+#include "jsapi-tests/tests.h"
+
+#include "vm/JSScript-inl.h"
+
+static bool sCompactOnNextCall = false;
+
+static bool MaybeCompact(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  if (sCompactOnNextCall) {
+    sCompactOnNextCall = false;
+    JS::PrepareForFullGC(cx);
+    JS::NonIncrementalGC(cx, JS::GCOptions::Shrink, JS::GCReason::API);
+  }
+  args.rval().setUndefined();
+  return true;
+}
+
+// Compacting the heap while an Ion frame with polymorphically inlined callees
+// is on the stack invalidates it. Bailing out of it must still find the
+// ICScript of the inlined callee after the callee's script was moved.
+BEGIN_TEST(testPolymorphicInlining_CompactingGCBailout) {
+  // The Ion JIT may be unavailable due to --disable-jit or lack of support
+  // for this platform.
+  if (!js::jit::IsIonEnabled(cx)) {
+    return true;
+  }
+  bool offthreadBaseline = cx->runtime()->canUseOffthreadBaselineCompilation();
+  bool offthreadIon = cx->runtime()->canUseOffthreadIonCompilation();
+  cx->runtime()->setOffthreadCompilationEnabled(false);
+
+  CHECK(JS_DefineFunction(cx, global, "maybeCompact", MaybeCompact, 0, 0));
+
+  JS::RootedValue v(cx);
+  EVAL(
+      "function f1(x) { maybeCompact(); return x + 1; }\n"
+      "function f2(x) { maybeCompact(); return x + 2; }\n"
+      "function run(n) {\n"
+      "  var s = 0;\n"
+      "  for (var i = 0; i < n; i++) {\n"
+      "    var f = (i & 1) ? f1 : f2;\n"
+      "    s += f(i);\n"
+      "  }\n"
+      "  return s;\n"
+      "}\n"
+      "for (var j = 0; j < 10; j++) {\n"
+      "  run(1000);\n"
+      "}\n"
+      "run",
+      &v);
+  CHECK(v.isObject());
+
+  JS::RootedFunction run(cx, JS_GetObjectFunction(&v.toObject()));
+  CHECK(run);
+  JS::RootedScript script(cx, JS_GetFunctionScript(cx, run));
+  CHECK(script);
+  CHECK(script->hasJitScript());
+  CHECK(script->jitScript()->hasInliningRoot());
+
+  // Compact from within the first inlined call, then run the rest of the loop
+  // in Baseline after the invalidation bailout.
+  sCompactOnNextCall = true;
+  JS::RootedValue rval(cx);
+  JS::RootedValue arg(cx, JS::Int32Value(1000));
+  CHECK(JS_CallFunction(cx, global, run, JS::HandleValueArray(arg), &rval));
+  CHECK(!sCompactOnNextCall);
+  CHECK(rval.isInt32());
+  CHECK_EQUAL(rval.toInt32(), 499500 + 500 + 1000);
+
+  // The call site can be inlined again.
+  EVAL("for (var j = 0; j < 10; j++) { run(1000); } run(1000)", &v);
+  CHECK(v.isInt32());
+  CHECK_EQUAL(v.toInt32(), 499500 + 500 + 1000);
+
+  cx->runtime()->setOffthreadBaselineCompilationEnabled(offthreadBaseline);
+  cx->runtime()->setOffthreadIonCompilationEnabled(offthreadIon);
+  return true;
+}
+END_TEST(testPolymorphicInlining_CompactingGCBailout)
@@ -0,0 +1,60 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifdef ENABLE_PORTABLE_BASELINE_INTERP
+
+#  include "mozilla/ScopeExit.h"
+
+#  include "jsapi-tests/tests.h"
+#  include "vm/PortableBaselineInterpret.h"
+
+BEGIN_TEST(testPortableBaselineInterp_FusedCompareAndBranch) {
+  uint32_t oldEnabled, oldThreshold;
+  CHECK(JS_GetGlobalJitCompilerOption(
+      cx, JSJITCOMPILER_PORTABLE_BASELINE_ENABLE, &oldEnabled));
+  CHECK(JS_GetGlobalJitCompilerOption(
+      cx, JSJITCOMPILER_PORTABLE_BASELINE_WARMUP_THRESHOLD, &oldThreshold));
+  auto restore = mozilla::MakeScopeExit([&] {
+    JS_SetGlobalJitCompilerOption(cx, JSJITCOMPILER_PORTABLE_BASELINE_ENABLE,
+                                  oldEnabled);
+    JS_SetGlobalJitCompilerOption(
+        cx, JSJITCOMPILER_PORTABLE_BASELINE_WARMUP_THRESHOLD, oldThreshold);
+  });
+  JS_SetGlobalJitCompilerOption(cx, JSJITCOMPILER_PORTABLE_BASELINE_ENABLE, 1);
+  JS_SetGlobalJitCompilerOption(
+      cx, JSJITCOMPILER_PORTABLE_BASELINE_WARMUP_THRESHOLD, 0);
+
+#  ifdef DEBUG
+  uint64_t fusedBefore = js::pbl::FusedBranchCountForTesting();
+#  endif
+
+  // Every iteration ends in int32 comparisons followed by conditional jumps,
+  // both taken and not taken.
+  JS::RootedValue v(cx);
+  EVAL(
+      "function f(n) {\n"
+      "  var s = 0;\n"
+      "  for (var i = 0; i < n; i++) {\n"
+      "    if (i % 3 === 0) s += i;\n"
+      "    if (i !== n - 1 && i >= n - 5) s++;\n"
+      "  }\n"
+      "  return s;\n"
+      "}\n"
+      "f(1000);",
+      &v);
+  CHECK(v.isInt32());
+  CHECK_EQUAL(v.toInt32(), 166837);
+
+#  ifdef DEBUG
+  // The loop condition and both tests of each of the 1000 iterations.
+  CHECK(js::pbl::FusedBranchCountForTesting() - fusedBefore >= 3000);
+#  endif
+  return true;
+}
+END_TEST(testPortableBaselineInterp_FusedCompareAndBranch)
+
+#endif  // ENABLE_PORTABLE_BASELINE_INTERP
@@ -0,0 +1,178 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "builtin/TestingFunctions.h"  // testingFunc_assertRecoveredOnBailout
+#include "jit/InlinableNatives.h"      // JitInfo_TestAssertRecoveredOnBailout
+#include "jit/Ion.h"                   // js::jit::IsIonEnabled
+#include "jit/JitOptions.h"            // js::jit::JitOptions
+#include "jit/MIR.h"
+#include "js/PropertySpec.h"           // JS_INLINABLE_FN
+#include "jsapi-tests/testJitMinimalFunc.h"
+#include "jsapi-tests/tests.h"
+#include "vm/NativeObject.h"
+
+#include "gc/ObjectKind-inl.h"  // js::gc::GetGCObjectKind
+#include "vm/JSScript-inl.h"
+
+static const JSFunctionSpec testingFunctions[] = {
+    JS_INLINABLE_FN("assertRecoveredOnBailout",
+                    js::testingFunc_assertRecoveredOnBailout, 2, 0,
+                    TestAssertRecoveredOnBailout),
+    JS_FS_END};
+
+// An object which only escapes on a cold exit path is scalar replaced on the
+// hot path, and materialized with its current slot values on the cold one.
+// assertRecoveredOnBailout fails the Ion compilation if its operand is not
+// recovered on bailout, that is if the object is still allocated.
+BEGIN_TEST(testScalarReplacement_PartialEscape) {
+  // The Ion JIT may be unavailable due to --disable-jit or lack of support
+  // for this platform.
+  if (!js::jit::IsIonEnabled(cx)) {
+    return true;
+  }
+  bool offthreadBaseline = cx->runtime()->canUseOffthreadBaselineCompilation();
+  bool offthreadIon = cx->runtime()->canUseOffthreadIonCompilation();
+  cx->runtime()->setOffthreadCompilationEnabled(false);
+
+  CHECK(JS_DefineFunctions(cx, global, testingFunctions));
+
+  JS::RootedValue v(cx);
+  EVAL(
+      "function f(x) {\n"
+      "  var o = {a: x, b: x + 1};\n"
+      "  assertRecoveredOnBailout(o, true);\n"
+      "  o.b += 1;\n"
+      "  if (x < 0) {\n"
+      "    throw o;\n"
+      "  }\n"
+      "  return o.a + o.b;\n"
+      "}\n"
+      "var sum = 0;\n"
+      "for (var i = 0; i < 5000; i++) {\n"
+      "  sum += f(i);\n"
+      "}\n"
+      "f",
+      &v);
+  CHECK(v.isObject());
+
+  JS::RootedFunction fun(cx, JS_GetObjectFunction(&v.toObject()));
+  CHECK(fun);
+  JS::RootedScript script(cx, JS_GetFunctionScript(cx, fun));
+  CHECK(script);
+  CHECK(script->hasIonScript());
+
+  // The object thrown from the Ion code has the values of its slots at the
+  // point it escaped.
+  EVAL(
+      "var thrown;\n"
+      "try {\n"
+      "  f(-5);\n"
+      "} catch (e) {\n"
+      "  thrown = e;\n"
+      "}\n"
+      "thrown.a === -5 && thrown.b === -3",
+      &v);
+  CHECK(v.isTrue());
+
+  // Without partial escape analysis, the object escapes and is allocated.
+  bool disabled = js::jit::JitOptions.disablePartialEscapeAnalysis;
+  js::jit::JitOptions.disablePartialEscapeAnalysis = true;
+  EVAL(
+      "function g(x) {\n"
+      "  var o = {a: x, b: x + 1};\n"
+      "  assertRecoveredOnBailout(o, false);\n"
+      "  if (x < 0) {\n"
+      "    throw o;\n"
+      "  }\n"
+      "  return o.a + o.b;\n"
+      "}\n"
+      "for (var i = 0; i < 5000; i++) {\n"
+      "  g(i);\n"
+      "}\n",
+      &v);
+  js::jit::JitOptions.disablePartialEscapeAnalysis = disabled;
+
+  cx->runtime()->setOffthreadBaselineCompilationEnabled(offthreadBaseline);
+  cx->runtime()->setOffthreadIonCompilationEnabled(offthreadIon);
+  return true;
+}
+END_TEST(testScalarReplacement_PartialEscape)
+
+// An object which escapes in an exit block is allocated there once. The object
+// allocated by materialization escapes at the same instruction, and is not
+// materialized again.
+BEGIN_TEST(testScalarReplacement_MaterializeOnce) {
+  using namespace js::jit;
+
+  JS::RootedValue v(cx);
+  EVAL("({a: 0})", &v);
+  JS::RootedObject templateObject(cx, &v.toObject());
+  js::NativeObject& nobj = templateObject->as<js::NativeObject>();
+  CHECK(nobj.numFixedSlots() > 0);
+  CHECK(nobj.numDynamicSlots() == 0);
+
+  MinimalFunc func;
+  MBasicBlock* entry = func.createEntryBlock();
+  MBasicBlock* exit = func.createBlock(entry);
+  MBasicBlock* join = func.createBlock(entry);
+
+  // var o = {a: p};
+  // if (p) {
+  //   throw o;
+  // }
+  // return o.a;
+  MParameter* p = func.createParameter();
+  entry->add(p);
+  MConstant* shape = MConstant::NewShape(func.alloc, nobj.shape());
+  entry->add(shape);
+  MNewPlainObject* obj = MNewPlainObject::New(
+      func.alloc, shape, nobj.numFixedSlots(), 0,
+      js::gc::GetGCObjectKind(nobj.numFixedSlots()), js::gc::Heap::Default);
+  entry->add(obj);
+  entry->add(MStoreFixedSlot::NewUnbarriered(func.alloc, obj, 0, p));
+  entry->end(MTest::New(func.alloc, p, exit, join));
+
+  MThrow* throwIns = MThrow::New(func.alloc, obj);
+  exit->add(throwIns);
+  exit->end(MUnreachable::New(func.alloc));
+
+  MLoadFixedSlot* load = MLoadFixedSlot::New(func.alloc, obj, 0);
+  join->add(load);
+  MReturn* ret = MReturn::New(func.alloc, load);
+  join->end(ret);
+
+  CHECK(func.runScalarReplacement());
+
+  // The exit block allocates a single object, which holds the value of the
+  // slot and is thrown.
+  MNewPlainObject* materialized = nullptr;
+  size_t numAllocations = 0;
+  for (MInstructionIterator iter(exit->begin()); iter != exit->end(); iter++) {
+    if (iter->isNewPlainObject()) {
+      materialized = iter->toNewPlainObject();
+      numAllocations++;
+    }
+  }
+  CHECK(numAllocations == 1);
+  CHECK(materialized != obj);
+  CHECK(throwIns->getOperand(0) == materialized);
+
+  size_t numStores = 0;
+  for (MInstructionIterator iter(exit->begin()); iter != exit->end(); iter++) {
+    if (iter->isStoreFixedSlot()) {
+      CHECK(iter->toStoreFixedSlot()->object() == materialized);
+      CHECK(iter->toStoreFixedSlot()->value() == p);
+      numStores++;
+    }
+  }
+  CHECK(numStores == 1);
+
+  // Elsewhere the object is scalar replaced.
+  CHECK(ret->getOperand(0) == p);
+  return true;
+}
+END_TEST(testScalarReplacement_MaterializeOnce)
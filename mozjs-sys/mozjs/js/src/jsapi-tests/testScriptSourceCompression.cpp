@@ -23,6 +23,7 @@
 #include "js/CompileOptions.h"  // JS::CompileOptions, JS::InstantiateOptions
 #include "js/Conversions.h"     // JS::ToString
 #include "js/experimental/JSStencil.h"  // JS::Stencil, JS::InstantiateGlobalStencil
+#include "js/friend/SourceCompression.h"  // js::SetSourceCompressionCodec
 #include "js/MemoryFunctions.h"         // JS_malloc
 #include "js/RootingAPI.h"              // JS::MutableHandle, JS::Rooted
 #include "js/SourceText.h"              // JS::SourceOwnership, JS::SourceText
@@ -474,6 +475,47 @@ bool run() {
 }
 END_TEST(testScriptSourceCompression_spansMultipleMiddleChunks)
 
+BEGIN_TEST(testScriptSourceCompression_lz4) {
+  js::SetSourceCompressionCodec(cx, js::SourceCompressionCodec::LZ4);
+  bool ok = run<char16_t>() && run<Utf8Unit>();
+  js::SetSourceCompressionCodec(cx, js::SourceCompressionCodec::Zlib);
+  CHECK(ok);
+  return true;
+}
+
+template <typename Unit>
+bool run() {
+  // Three chunks.
+  constexpr size_t len = (3 * ChunkSize) / sizeof(Unit);
+  auto source = MakeSourceAllWhitespace<Unit>(cx, len);
+  CHECK(source);
+
+  // This function contains the middle chunk and further extends one
+  // character to each side.
+  constexpr size_t FunctionSize = 2 + ChunkSize / sizeof(Unit);
+
+  // Write out a 'r' or 's' function.
+  constexpr char FunctionName = 'q' + sizeof(Unit);
+  WriteFunctionOfSizeAtOffset(source, len, FunctionName, FunctionSize,
+                              ChunkSize / sizeof(Unit) - 1);
+
+  JS::Rooted<JSFunction*> fun(cx);
+  fun = EvaluateChars(cx, std::move(source), len, FunctionName, __FUNCTION__);
+  CHECK(fun);
+
+  CompressSourceSync(fun, cx);
+
+  // Decompress twice, the second time from the uncompressed source cache.
+  for (size_t i = 0; i < 2; i++) {
+    JS::Rooted<JSString*> str(cx, DecompressSource(cx, fun));
+    CHECK(str);
+    CHECK(IsExpectedFunctionString(str, FunctionName, cx));
+  }
+
+  return true;
+}
+END_TEST(testScriptSourceCompression_lz4)
+
 BEGIN_TEST(testScriptSourceCompression_automatic) {
   constexpr size_t len = MinimumCompressibleLength + 55;
   auto chars = MakeSourceAllWhitespace<char16_t>(cx, len);
@@ -5,12 +5,15 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include "mozilla/ScopeExit.h"  // mozilla::MakeScopeExit
+
 #include <string.h>
 
 #include "jsapi.h"
 
 #include "frontend/CompilationStencil.h"
 #include "js/CompilationAndEvaluation.h"
+#include "js/ContextOptions.h"  // JS::ContextOptionsRef
 #include "js/EnvironmentChain.h"  // JS::EnvironmentChain
 #include "js/experimental/CompileScript.h"
 #include "js/experimental/JSStencil.h"
@@ -18,7 +21,10 @@
 #include "js/PropertyAndElement.h"  // JS_GetProperty, JS_HasOwnProperty, JS_SetProperty
 #include "js/Transcoding.h"
 #include "jsapi-tests/tests.h"
+#include "util/Text.h"         // js::DuplicateString
+#include "vm/BytecodeUtil.h"   // js::GetBytecodeLength, GET_JUMP_OFFSET
 #include "vm/HelperThreads.h"  // js::RunPendingSourceCompressions
+#include "vm/JSScript.h"       // js::PCToLineNumber
 #include "vm/Monitor.h"        // js::Monitor, js::AutoLockMonitor
 
 BEGIN_TEST(testStencil_Basic) {
@@ -340,3 +346,556 @@ static bool TestGetBuildId(JS::BuildIdCharVector* buildId) {
   return buildId->append(buildid, sizeof(buildid));
 }
 END_TEST(testStencil_TranscodeBorrowing)
+
+BEGIN_TEST(testStencil_ParallelFullParse) {
+  const char* chars =
+      "function f() { return 1; }\n"
+      "function g() { function h() { return 2; } return h(); }\n"
+      "var k = () => { var l = function () { return 3; }; return l(); };\n"
+      "class C { m() { return 4; } }\n"
+      "f() + g() + k() + new C().m();\n";
+
+  JS::SourceText<mozilla::Utf8Unit> srcBuf;
+  CHECK(srcBuf.init(cx, chars, strlen(chars), JS::SourceOwnership::Borrowed));
+
+  JS::CompileOptions options(cx);
+  options.setEagerDelazificationStrategy(
+      JS::DelazificationOption::ParallelFullParse);
+  RefPtr<JS::Stencil> stencil =
+      JS::CompileGlobalScriptToStencil(cx, options, srcBuf);
+  CHECK(stencil);
+
+  // Every lazy function, including the inner ones, is delazified before the
+  // stencil is returned.
+  CHECK(stencil->canLazilyParse());
+  const js::frontend::CompilationStencil* initial = stencil->getInitial();
+  size_t numLazyFunctions = 0;
+  for (size_t i = 1; i < initial->scriptData.size(); i++) {
+    const js::frontend::ScriptStencil& data = initial->scriptData[i];
+    if (data.isGhost() || !data.functionFlags.isInterpreted() ||
+        data.hasSharedData()) {
+      continue;
+    }
+    CHECK(stencil->getDelazificationAt(i));
+    numLazyFunctions++;
+  }
+  CHECK(numLazyFunctions >= 6);
+
+  JS::InstantiateOptions instantiateOptions(options);
+  JS::RootedScript script(
+      cx, JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil));
+  CHECK(script);
+
+  JS::RootedValue rval(cx);
+  CHECK(JS_ExecuteScript(cx, script, &rval));
+  CHECK(rval.isNumber() && rval.toNumber() == 10);
+
+  return true;
+}
+END_TEST(testStencil_ParallelFullParse)
+
+BEGIN_TEST(testStencil_DelazificationProfile) {
+  const char* chars =
+      "function f() { return 1; }\n"
+      "function g() { function h() { return 2; } return h(); }\n"
+      "function unused() { return 3; }\n"
+      "g() + f();\n";
+
+  JS::CompileOptions options(cx);
+  options.setEagerDelazificationStrategy(
+      JS::DelazificationOption::ConcurrentProfileGuided);
+
+  // Record the first calls of an execution.
+  uint32_t sourceHash;
+  JS::DelazificationProfile profile;
+  {
+    JS::SourceText<mozilla::Utf8Unit> srcBuf;
+    CHECK(srcBuf.init(cx, chars, strlen(chars),
+                      JS::SourceOwnership::Borrowed));
+    JS::RootedScript script(cx, JS::Compile(cx, options, srcBuf));
+    CHECK(script);
+    JS::RootedValue rval(cx);
+    CHECK(JS_ExecuteScript(cx, script, &rval));
+    CHECK(rval.isNumber() && rval.toNumber() == 3);
+    js::WaitForAllDelazifyTasks(cx->runtime());
+
+    CHECK(JS::GetDelazificationProfile(cx, script, &sourceHash, profile));
+  }
+  CHECK(profile.length() == 3);
+
+  // Profiles come from the embedder, and may list a function more than once,
+  // possibly with another end.
+  JS::DelazificationProfileEntry first = profile[0];
+  CHECK(profile.append(first));
+  CHECK(profile.append(
+      JS::DelazificationProfileEntry{first.sourceStart, first.sourceEnd + 1}));
+  CHECK(JS::SetDelazificationProfile(sourceHash, profile));
+
+  auto clearProfiles =
+      mozilla::MakeScopeExit([] { JS::ClearDelazificationProfiles(); });
+
+  // A later compilation of the same source text replays the profile.
+  JS::SourceText<mozilla::Utf8Unit> srcBuf;
+  CHECK(srcBuf.init(cx, chars, strlen(chars), JS::SourceOwnership::Borrowed));
+  JS::RootedScript script(cx, JS::Compile(cx, options, srcBuf));
+  CHECK(script);
+  js::WaitForAllDelazifyTasks(cx->runtime());
+
+  RefPtr<js::frontend::InitialStencilAndDelazifications> stencils =
+      script->sourceObject()->maybeGetStencils();
+  CHECK(stencils);
+  JS::RootedFunction f(cx, findFunction(script, "f"));
+  JS::RootedFunction g(cx, findFunction(script, "g"));
+  JS::RootedFunction unused(cx, findFunction(script, "unused"));
+  CHECK(f && g && unused);
+  JS::RootedFunction h(cx, findFunction(g->baseScript(), "h"));
+  CHECK(h);
+
+  // The profiled functions got delazified before being called, and only
+  // wait for their first call to be instantiated. The function which was
+  // not called by the recorded execution is left lazy.
+  for (JSFunction* fun : {f.get(), g.get(), h.get(), unused.get()}) {
+    CHECK(!fun->hasBytecode());
+  }
+  CHECK(stencils->getDelazificationFor(f->baseScript()->extent()));
+  CHECK(stencils->getDelazificationFor(g->baseScript()->extent()));
+  CHECK(stencils->getDelazificationFor(h->baseScript()->extent()));
+  CHECK(!stencils->getDelazificationFor(unused->baseScript()->extent()));
+
+  JS::RootedValue rval(cx);
+  CHECK(JS_ExecuteScript(cx, script, &rval));
+  CHECK(rval.isNumber() && rval.toNumber() == 3);
+
+  CHECK(f->hasBytecode());
+  CHECK(g->hasBytecode());
+  CHECK(h->hasBytecode());
+  CHECK(!unused->hasBytecode());
+  CHECK(!stencils->getDelazificationFor(unused->baseScript()->extent()));
+
+  return true;
+}
+
+// Find the inner function of |script| with the given name.
+JSFunction* findFunction(js::BaseScript* script, const char* name) {
+  for (JS::GCCellPtr gcThing : script->gcthings()) {
+    if (!gcThing.is<JSObject>() || !gcThing.as<JSObject>().is<JSFunction>()) {
+      continue;
+    }
+    JSFunction* fun = &gcThing.as<JSObject>().as<JSFunction>();
+    JSString* id = JS_GetMaybePartialFunctionId(fun);
+    if (id &&
+        JS_LinearStringEqualsAscii(JS_ASSERT_STRING_IS_LINEAR(id), name)) {
+      return fun;
+    }
+  }
+  return nullptr;
+}
+END_TEST(testStencil_DelazificationProfile)
+
+BEGIN_TEST(testStencil_Incremental) {
+  const char* previousChars =
+      "function f() { return 1; }\n"
+      "function g() { return 2; }\n"
+      "var x = 10;\n"
+      "function h() { function i() { return x; } return i(); }\n"
+      "f() + g() + h();\n";
+  const char* chars =
+      "function f() { return 1; }\n"
+      "function g() { return 2; }\n"
+      "var x = 30;\n"
+      "\n"
+      "function h() { function i() { return x; } return i(); }\n"
+      "f() + g() + h();\n";
+
+  JS::CompileOptions options(cx);
+
+  RefPtr<JS::Stencil> previous;
+  {
+    JS::SourceText<mozilla::Utf8Unit> srcBuf;
+    CHECK(srcBuf.init(cx, previousChars, strlen(previousChars),
+                      JS::SourceOwnership::Borrowed));
+    previous = JS::CompileGlobalScriptToStencil(cx, options, srcBuf);
+    CHECK(previous);
+  }
+
+  JS::SourceText<mozilla::Utf8Unit> srcBuf;
+  CHECK(srcBuf.init(cx, chars, strlen(chars), JS::SourceOwnership::Borrowed));
+  JS::IncrementalCompilationStats stats;
+  RefPtr<JS::Stencil> stencil = JS::CompileGlobalScriptToStencilIncrementally(
+      cx, options, srcBuf, previous, &stats);
+  CHECK(stencil);
+
+  // f and g precede the edit, h and its inner function i follow it.
+  CHECK_EQUAL(stats.reusedFunctions, 4u);
+  CHECK_EQUAL(stats.totalFunctions, 4u);
+
+  JS::InstantiateOptions instantiateOptions(options);
+  JS::RootedScript script(
+      cx, JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil));
+  CHECK(script);
+
+  JS::RootedValue rval(cx);
+  CHECK(JS_ExecuteScript(cx, script, &rval));
+  CHECK(rval.isNumber() && rval.toNumber() == 33);
+
+  return true;
+}
+END_TEST(testStencil_Incremental)
+
+BEGIN_TEST(testStencil_SharedParserAtoms) {
+  // The table is process-wide, don't leave it enabled for other tests.
+  CHECK(JS::EnableSharedParserAtoms());
+  auto disable =
+      mozilla::MakeScopeExit([] { JS::DisableSharedParserAtoms(); });
+
+  JS::SharedParserAtomsStats before;
+  JS::GetSharedParserAtomsStats(&before);
+
+  // Compile the same identifier in two separate compilations, as concurrent
+  // off-thread compilations would.
+  const char* chars =
+      "var sharedParserAtomName = 40;"
+      "sharedParserAtomName + 2;";
+  RefPtr<JS::Stencil> stencils[2];
+  for (RefPtr<JS::Stencil>& stencil : stencils) {
+    JS::FrontendContext* fc = JS::NewFrontendContext();
+    CHECK(fc);
+
+    JS::SourceText<mozilla::Utf8Unit> srcBuf;
+    CHECK(srcBuf.init(fc, chars, strlen(chars), JS::SourceOwnership::Borrowed));
+
+    JS::CompileOptions options(cx);
+    stencil = JS::CompileGlobalScriptToStencil(fc, options, srcBuf);
+    JS::DestroyFrontendContext(fc);
+    CHECK(stencil);
+  }
+
+  JS::SharedParserAtomsStats afterCompile;
+  JS::GetSharedParserAtomsStats(&afterCompile);
+  CHECK(afterCompile.duplicates > before.duplicates);
+
+  for (RefPtr<JS::Stencil>& stencil : stencils) {
+    JS::CompileOptions options(cx);
+    JS::InstantiateOptions instantiateOptions(options);
+    JS::RootedScript script(
+        cx, JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil));
+    CHECK(script);
+
+    JS::RootedValue rval(cx);
+    CHECK(JS_ExecuteScript(cx, script, &rval));
+    CHECK(rval.isNumber() && rval.toNumber() == 42);
+  }
+
+  // The second instantiation finds the atom of the first one by its id.
+  JS::SharedParserAtomsStats afterInstantiate;
+  JS::GetSharedParserAtomsStats(&afterInstantiate);
+  CHECK(afterInstantiate.instantiationHits > afterCompile.instantiationHits);
+
+  return true;
+}
+END_TEST(testStencil_SharedParserAtoms)
+
+BEGIN_TEST(testStencil_BytecodePeephole) {
+  // Nested conditionals and loops emit chains of jumps to jumps, and `return;`
+  // emits Undefined; Return.
+  const char* chars =
+      "(function f(n) {\n"
+      "  if (n < 0) {\n"
+      "    return;\n"
+      "  }\n"
+      "  var r = 0;\n"
+      "  for (let i = 0; i < n; i++) {\n"
+      "    if (i % 3 == 0) {\n"
+      "      if (i % 2 == 0) { r += 1; } else { r += 2; }\n"
+      "    } else if (i % 3 == 1) {\n"
+      "      switch (i % 4) { case 1: r += 3; break; default: r += 4; }\n"
+      "    } else {\n"
+      "      r += (i > 5 && i < 10) || i == 2 ? 5 : 6;\n"
+      "      continue;\n"
+      "    }\n"
+      "  }\n"
+      "  try {\n"
+      "    if (r > 1000) { throw r; }\n"
+      "  } catch (e) {\n"
+      "    return;\n"
+      "  }\n"
+      "  return r;\n"
+      "})";
+
+  JS::RootedFunction before(cx);
+  CHECK(compileFunction(chars, false, &before));
+  JS::RootedFunction after(cx);
+  CHECK(compileFunction(chars, true, &after));
+
+  JS::RootedScript beforeScript(cx, JS_GetFunctionScript(cx, before));
+  CHECK(beforeScript);
+  JS::RootedScript afterScript(cx, JS_GetFunctionScript(cx, after));
+  CHECK(afterScript);
+
+  // The optimized script is shorter, and has none of the sequences the pass
+  // rewrites.
+  CHECK(afterScript->length() < beforeScript->length());
+  CHECK(countRewritable(beforeScript) > 0);
+  CHECK(countRewritable(afterScript) == 0);
+
+  // Every instruction has the same source position, and the notes and
+  // offsets of the script moved along with the instructions.
+  js::Vector<uint32_t, 0, js::SystemAllocPolicy> offsets;
+  CHECK(matchBytecode(beforeScript, afterScript, offsets));
+  CHECK(afterScript->mainOffset() == offsets[beforeScript->mainOffset()]);
+
+  mozilla::Span<const js::TryNote> beforeTryNotes = beforeScript->trynotes();
+  mozilla::Span<const js::TryNote> afterTryNotes = afterScript->trynotes();
+  CHECK(beforeTryNotes.size() > 0);
+  CHECK(afterTryNotes.size() == beforeTryNotes.size());
+  for (size_t i = 0; i < beforeTryNotes.size(); i++) {
+    const js::TryNote& b = beforeTryNotes[i];
+    const js::TryNote& a = afterTryNotes[i];
+    CHECK(a.kind() == b.kind());
+    CHECK(a.stackDepth == b.stackDepth);
+    CHECK(a.start == offsets[b.start]);
+    CHECK(a.start + a.length == offsets[b.start + b.length]);
+  }
+
+  mozilla::Span<const js::ScopeNote> beforeScopeNotes =
+      beforeScript->scopeNotes();
+  mozilla::Span<const js::ScopeNote> afterScopeNotes =
+      afterScript->scopeNotes();
+  CHECK(beforeScopeNotes.size() > 0);
+  CHECK(afterScopeNotes.size() == beforeScopeNotes.size());
+  for (size_t i = 0; i < beforeScopeNotes.size(); i++) {
+    const js::ScopeNote& b = beforeScopeNotes[i];
+    const js::ScopeNote& a = afterScopeNotes[i];
+    CHECK(a.index == b.index);
+    CHECK(a.parent == b.parent);
+    CHECK(a.start == offsets[b.start]);
+    uint32_t end = b.start + b.length;
+    CHECK(a.start + a.length == (end == UINT32_MAX ? end : offsets[end]));
+  }
+
+  mozilla::Span<const uint32_t> beforeResumeOffsets =
+      beforeScript->resumeOffsets();
+  mozilla::Span<const uint32_t> afterResumeOffsets =
+      afterScript->resumeOffsets();
+  CHECK(afterResumeOffsets.size() == beforeResumeOffsets.size());
+  for (size_t i = 0; i < beforeResumeOffsets.size(); i++) {
+    CHECK(afterResumeOffsets[i] == offsets[beforeResumeOffsets[i]]);
+  }
+
+  // Both functions compute the same results.
+  for (int32_t n : {-1, 20}) {
+    JS::RootedValue arg(cx, JS::Int32Value(n));
+    JS::RootedValue beforeResult(cx);
+    CHECK(JS_CallFunction(cx, nullptr, before, JS::HandleValueArray(arg),
+                          &beforeResult));
+    JS::RootedValue afterResult(cx);
+    CHECK(JS_CallFunction(cx, nullptr, after, JS::HandleValueArray(arg),
+                          &afterResult));
+    CHECK_SAME(afterResult, beforeResult);
+  }
+  JS::RootedValue arg(cx, JS::Int32Value(20));
+  JS::RootedValue rval(cx);
+  CHECK(JS_CallFunction(cx, nullptr, after, JS::HandleValueArray(arg), &rval));
+  CHECK(rval.isInt32(70));
+
+  return true;
+}
+
+// Compile the function expression |chars|, with its inner functions, with or
+// without the peephole pass.
+bool compileFunction(const char* chars, bool peephole,
+                     JS::MutableHandleFunction fun) {
+  JS::SourceText<mozilla::Utf8Unit> srcBuf;
+  CHECK(srcBuf.init(cx, chars, strlen(chars), JS::SourceOwnership::Borrowed));
+
+  JS::ContextOptionsRef(cx).setBytecodePeephole(peephole);
+  JS::CompileOptions options(cx);
+  JS::ContextOptionsRef(cx).setBytecodePeephole(false);
+  CHECK(options.bytecodePeephole() == peephole);
+  options.setForceFullParse();
+
+  JS::RootedValue rval(cx);
+  CHECK(JS::Evaluate(cx, options, srcBuf, &rval));
+  CHECK(rval.isObject());
+  fun.set(JS_GetObjectFunction(&rval.toObject()));
+  CHECK(fun);
+  return true;
+}
+
+bool isJumpToJump(JSScript* script, jsbytecode* pc) {
+  jsbytecode* target = pc + GET_JUMP_OFFSET(pc);
+  if (JSOp(*target) != JSOp::JumpTarget) {
+    return false;
+  }
+  jsbytecode* next = target + js::JSOpLength_JumpTarget;
+  return next < script->codeEnd() && JSOp(*next) == JSOp::Goto &&
+         GET_JUMP_OFFSET(next) > 0;
+}
+
+// Count the jumps to forward jumps, and the Dup; Pop, Swap; Swap and
+// Undefined; Return sequences of |script|.
+size_t countRewritable(JSScript* script) {
+  size_t count = 0;
+  for (jsbytecode* pc = script->code(); pc < script->codeEnd();
+       pc += js::GetBytecodeLength(pc)) {
+    JSOp op = JSOp(*pc);
+    if (js::IsJumpOpcode(op)) {
+      if (isJumpToJump(script, pc)) {
+        count++;
+      }
+      continue;
+    }
+    jsbytecode* next = pc + js::GetBytecodeLength(pc);
+    if (next >= script->codeEnd()) {
+      break;
+    }
+    JSOp nextOp = JSOp(*next);
+    if ((op == JSOp::Dup && nextOp == JSOp::Pop) ||
+        (op == JSOp::Swap && nextOp == JSOp::Swap) ||
+        (op == JSOp::Undefined && nextOp == JSOp::Return)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Pair every instruction of |before| with the one the peephole pass left in
+// its place in |after|, check that both have the same source position, and
+// set |offsets| to the new offset of each instruction. Removed instructions
+// move to the offset of the next instruction.
+bool matchBytecode(JSScript* before, JSScript* after,
+                   js::Vector<uint32_t, 0, js::SystemAllocPolicy>& offsets) {
+  CHECK(offsets.appendN(UINT32_MAX, before->length() + 1));
+
+  jsbytecode* pc = before->code();
+  jsbytecode* newPc = after->code();
+  while (pc < before->codeEnd()) {
+    CHECK(newPc < after->codeEnd());
+    uint32_t newOffset = after->pcToOffset(newPc);
+    offsets[before->pcToOffset(pc)] = newOffset;
+
+    JSOp op = JSOp(*pc);
+    jsbytecode* next = pc + js::GetBytecodeLength(pc);
+    JSOp nextOp = next < before->codeEnd() ? JSOp(*next) : JSOp::Nop;
+    if ((op == JSOp::Dup && nextOp == JSOp::Pop) ||
+        (op == JSOp::Swap && nextOp == JSOp::Swap)) {
+      offsets[before->pcToOffset(next)] = newOffset;
+      pc = next + js::GetBytecodeLength(next);
+      continue;
+    }
+    if (op == JSOp::Undefined && nextOp == JSOp::Return &&
+        JSOp(*newPc) == JSOp::RetRval) {
+      pc = next;
+      offsets[before->pcToOffset(pc)] = newOffset;
+    } else {
+      CHECK(JSOp(*newPc) == op);
+    }
+
+    JS::LimitedColumnNumberOneOrigin column;
+    JS::LimitedColumnNumberOneOrigin newColumn;
+    CHECK(js::PCToLineNumber(before, pc, &column) ==
+          js::PCToLineNumber(after, newPc, &newColumn));
+    CHECK(column == newColumn);
+
+    // Jumps land on the instruction their target moved to, or further along
+    // a chain of jumps.
+    if (js::IsJumpOpcode(JSOp(*newPc))) {
+      JSOp target = JSOp(*(newPc + GET_JUMP_OFFSET(newPc)));
+      CHECK(target == JSOp::JumpTarget || target == JSOp::LoopHead);
+    }
+
+    pc += js::GetBytecodeLength(pc);
+    newPc += js::GetBytecodeLength(newPc);
+  }
+  CHECK(newPc == after->codeEnd());
+  offsets[before->length()] = after->length();
+  return true;
+}
+END_TEST(testStencil_BytecodePeephole)
+
+// Load modules from a fixed table, using specifiers as keys.
+class TestModuleGraphLoader : public JS::ModuleGraphLoader {
+  struct Source {
+    const char* key;
+    const char* text;
+  };
+  static constexpr Source sources_[] = {
+      {"main", "import { a } from 'a'; import { b } from 'b'; a() + b();"},
+      {"a", "import { c } from 'c'; export function a() { return c + 1; }"},
+      {"b",
+       "import { c } from 'c'; import { a } from 'a';"
+       "export function b() { return c + a(); }"},
+      {"c", "import 'main'; export const c = 20;"},
+      {"broken", "import 'c'; import 'bad';"},
+      {"bad", "export syntax error;"},
+  };
+
+ public:
+  bool resolve(const char* referrer, const char* specifier,
+               JS::UniqueChars* key) override {
+    *key = js::DuplicateString(specifier);
+    return !!*key;
+  }
+
+  bool load(JS::FrontendContext* fc, const char* key,
+            JS::SourceText<mozilla::Utf8Unit>& srcBuf) override {
+    for (const Source& source : sources_) {
+      if (strcmp(source.key, key) == 0) {
+        return srcBuf.init(fc, source.text, strlen(source.text),
+                           JS::SourceOwnership::Borrowed);
+      }
+    }
+    return false;
+  }
+};
+
+BEGIN_TEST(testStencil_ModuleGraph) {
+  TestModuleGraphLoader loader;
+  JS::CompileOptions options(cx);
+
+  JS::CompiledModuleGraph graph;
+  {
+    JS::FrontendContext* fc = JS::NewFrontendContext();
+    CHECK(fc);
+    bool ok = JS::CompileModuleGraphToStencils(fc, options, "main", loader,
+                                               &graph);
+    JS::DestroyFrontendContext(fc);
+    CHECK(ok);
+  }
+
+  // Each module is compiled once, and comes after the modules it imports,
+  // except for the import of "main" by "c" which closes a cycle.
+  CHECK(graph.length() == 4);
+  CHECK(strcmp(graph[0].key.get(), "c") == 0);
+  CHECK(strcmp(graph[1].key.get(), "a") == 0);
+  CHECK(strcmp(graph[2].key.get(), "b") == 0);
+  CHECK(strcmp(graph[3].key.get(), "main") == 0);
+  CHECK(graph[0].requestedModules.length() == 1);
+  CHECK(graph[0].requestedModules[0] == 3);
+  CHECK(graph[2].requestedModules.length() == 2);
+  CHECK(graph[2].requestedModules[0] == 0);
+  CHECK(graph[2].requestedModules[1] == 1);
+
+  for (JS::CompiledModule& module : graph) {
+    JS::InstantiateOptions instantiateOptions(options);
+    JS::RootedObject moduleObject(
+        cx, JS::InstantiateModuleStencil(cx, instantiateOptions,
+                                         module.stencil));
+    CHECK(moduleObject);
+  }
+
+  // Errors are reported to the FrontendContext of the caller, whichever
+  // thread compiled the module.
+  JS::CompiledModuleGraph badGraph;
+  JS::FrontendContext* fc = JS::NewFrontendContext();
+  CHECK(fc);
+  bool ok = JS::CompileModuleGraphToStencils(fc, options, "broken", loader,
+                                             &badGraph);
+  bool hadErrors = JS::HadFrontendErrors(fc);
+  JS::DestroyFrontendContext(fc);
+  CHECK(!ok);
+  CHECK(hadErrors);
+
+  return true;
+}
+END_TEST(testStencil_ModuleGraph)
@@ -0,0 +1,94 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/Utf8.h"  // mozilla::Utf8Unit
+
+#include <string.h>
+
+#include "js/CharacterEncoding.h"  // JS::UTF8CharsToNewTwoByteCharsZ
+#include "js/CompilationAndEvaluation.h"  // JS::Evaluate
+#include "js/SourceText.h"                // JS::Source{Ownership,Text}
+#include "js/String.h"  // JS_CompareStrings, JS_NewStringCopyUTF8Z
+#include "jsapi-tests/tests.h"
+
+// The tokenizer appends the plain ASCII runs of string and template literals
+// to its buffer a run at a time, and the units between runs one at a time.
+// Literals are evaluated both from UTF-8 and UTF-16 source, and long enough
+// for runs to span several blocks of the vectorized scan.
+BEGIN_TEST(testStringLiterals_PlainRuns) {
+  struct Case {
+    const char* source;
+    const char* expected;
+  };
+  static const Case cases[] = {
+      {"'a\\tb'", "a\tb"},
+      {"\"x\\ny\"", "x\ny"},
+      {"'0123456789abcdefghij\\\\0123456789abcdefghij\\x41 end'",
+       "0123456789abcdefghij\\0123456789abcdefghijA end"},
+      {"'one\\ttwo\\tthree\\tfour\\tfive\\tsix\\tseven\\teight'",
+       "one\ttwo\tthree\tfour\tfive\tsix\tseven\teight"},
+      {"'abcdefghijklmnopq\\\nrstuvwxyz'", "abcdefghijklmnopqrstuvwxyz"},
+      {"'caf\xC3\xA9 au lait, caf\xC3\xA9 cr\xC3\xA8me, and $1 more'",
+       "caf\xC3\xA9 au lait, caf\xC3\xA9 cr\xC3\xA8me, and $1 more"},
+      {"`abcdefghijklmnopqrstuvwxyz${1 + 1}ABCDEFGHIJKLMNOPQRSTUVWXYZ$"
+       "\\u0041tail`",
+       "abcdefghijklmnopqrstuvwxyz2ABCDEFGHIJKLMNOPQRSTUVWXYZ$Atail"},
+      {"`first line of a template\r\nsecond line, ${'a' + 'b'} and $ {}`",
+       "first line of a template\nsecond line, ab and $ {}"},
+  };
+
+  for (const Case& c : cases) {
+    CHECK(checkLiteral(c.source, c.expected));
+  }
+  return true;
+}
+
+bool checkLiteral(const char* source, const char* expected) {
+  JS::RootedString expectedStr(
+      cx, JS_NewStringCopyUTF8Z(
+              cx, JS::ConstUTF8CharsZ(expected, strlen(expected))));
+  CHECK(expectedStr);
+
+  JS::CompileOptions options(cx);
+  options.setFileAndLine(__FILE__, __LINE__);
+
+  JS::RootedValue rval(cx);
+  {
+    JS::SourceText<mozilla::Utf8Unit> srcBuf;
+    CHECK(srcBuf.init(cx, source, strlen(source),
+                      JS::SourceOwnership::Borrowed));
+    CHECK(JS::Evaluate(cx, options, srcBuf, &rval));
+    CHECK(equalStrings(rval, expectedStr));
+  }
+
+  {
+    size_t length;
+    JS::UniqueTwoByteChars chars(
+        JS::UTF8CharsToNewTwoByteCharsZ(
+            cx, JS::UTF8Chars(source, strlen(source)), &length,
+            js::MallocArena)
+            .get());
+    CHECK(chars);
+
+    JS::SourceText<char16_t> srcBuf;
+    CHECK(srcBuf.init(cx, chars.get(), length,
+                      JS::SourceOwnership::Borrowed));
+    CHECK(JS::Evaluate(cx, options, srcBuf, &rval));
+    CHECK(equalStrings(rval, expectedStr));
+  }
+
+  return true;
+}
+
+bool equalStrings(JS::HandleValue actual, JS::HandleString expected) {
+  CHECK(actual.isString());
+  int32_t result;
+  CHECK(JS_CompareStrings(cx, actual.toString(), expected, &result));
+  CHECK_EQUAL(result, 0);
+  return true;
+}
+END_TEST(testStringLiterals_PlainRuns)
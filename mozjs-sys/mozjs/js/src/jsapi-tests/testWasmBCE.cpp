@@ -0,0 +1,270 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+
+#include "jit/IonAnalysis.h"
+#include "jit/JitOptions.h"
+#include "jit/MIRGenerator.h"
+#include "jit/MIRGraph.h"
+#include "jit/WasmBCE.h"
+#include "js/ContextOptions.h"
+#include "wasm/WasmFeatures.h"  // IonAvailable, Memory64Available
+
+#include "jsapi-tests/testJitMinimalFunc.h"
+#include "jsapi-tests/tests.h"
+
+using namespace js;
+using namespace js::jit;
+
+static MParameter* AddInt32Parameter(MinimalFunc& func, MBasicBlock* block) {
+  MParameter* p = func.createParameter();
+  p->setResultType(MIRType::Int32);
+  block->add(p);
+  return p;
+}
+
+// Add a bounds check of `base + offset` to `block`.
+static MWasmBoundsCheck* AddBoundsCheck(MinimalFunc& func, MBasicBlock* block,
+                                        MDefinition* base, uint64_t offset,
+                                        MDefinition* limit) {
+  MDefinition* index = base;
+  if (offset) {
+    index = MWasmAddOffset::New(func.alloc, base, offset, wasm::TrapSiteDesc());
+    block->add(index->toInstruction());
+  }
+  auto* bc = MWasmBoundsCheck::New(func.alloc, index, limit,
+                                   wasm::TrapSiteDesc(),
+                                   MWasmBoundsCheck::Memory0);
+  block->add(bc);
+  return bc;
+}
+
+static void AddReturn(MinimalFunc& func, MBasicBlock* block) {
+  MConstant* u = MConstant::New(func.alloc, UndefinedValue());
+  block->add(u);
+  block->end(MReturn::New(func.alloc, u));
+}
+
+static bool RunBCE(MinimalFunc& func) {
+  RenumberBlocks(func.graph);
+  return BuildDominatorTree(&func.mir, func.graph) &&
+         EliminateBoundsChecks(&func.mir, func.graph);
+}
+
+// A check of `base + offset` covers the checks of `base` with smaller offsets
+// which it dominates.
+BEGIN_TEST(testWasmBCE_Dominance) {
+  bool spectreIndexMasking = JitOptions.spectreIndexMasking;
+  JitOptions.spectreIndexMasking = false;
+  auto restore = mozilla::MakeScopeExit(
+      [&] { JitOptions.spectreIndexMasking = spectreIndexMasking; });
+
+  MinimalFunc func;
+  MBasicBlock* entry = func.createEntryBlock();
+  MBasicBlock* next = func.createBlock(entry);
+
+  MParameter* i = AddInt32Parameter(func, entry);
+  MParameter* j = AddInt32Parameter(func, entry);
+  MParameter* limit = AddInt32Parameter(func, entry);
+  MWasmBoundsCheck* bc16 = AddBoundsCheck(func, entry, i, 16, limit);
+  entry->end(MGoto::New(func.alloc, next));
+
+  MWasmBoundsCheck* bc8 = AddBoundsCheck(func, next, i, 8, limit);
+  MWasmBoundsCheck* bc0 = AddBoundsCheck(func, next, i, 0, limit);
+  MWasmBoundsCheck* bc32 = AddBoundsCheck(func, next, i, 32, limit);
+  MWasmBoundsCheck* bcJ = AddBoundsCheck(func, next, j, 0, limit);
+  MWasmBoundsCheck* bc24 = AddBoundsCheck(func, next, i, 24, limit);
+  AddReturn(func, next);
+
+  CHECK(RunBCE(func));
+  CHECK(!bc16->isRedundant());
+  CHECK(bc8->isRedundant());
+  CHECK(bc0->isRedundant());
+  CHECK(!bc32->isRedundant());
+  CHECK(!bcJ->isRedundant());
+  CHECK(bc24->isRedundant());
+  return true;
+}
+END_TEST(testWasmBCE_Dominance)
+
+// Checks in both arms of a conditional cover the checks after it, up to the
+// smaller of their offsets. A check in one arm only covers nothing.
+BEGIN_TEST(testWasmBCE_TwoArms) {
+  bool spectreIndexMasking = JitOptions.spectreIndexMasking;
+  JitOptions.spectreIndexMasking = false;
+  auto restore = mozilla::MakeScopeExit(
+      [&] { JitOptions.spectreIndexMasking = spectreIndexMasking; });
+
+  MinimalFunc func;
+  MBasicBlock* entry = func.createEntryBlock();
+  MBasicBlock* left = func.createBlock(entry);
+  MBasicBlock* right = func.createBlock(entry);
+  MBasicBlock* join = func.createBlock(left);
+  MBasicBlock* left2 = func.createBlock(join);
+  MBasicBlock* right2 = func.createBlock(join);
+  MBasicBlock* join2 = func.createBlock(left2);
+
+  MParameter* i = AddInt32Parameter(func, entry);
+  MParameter* k = AddInt32Parameter(func, entry);
+  MParameter* limit = AddInt32Parameter(func, entry);
+  MParameter* cond = AddInt32Parameter(func, entry);
+  entry->end(MTest::New(func.alloc, cond, left, right));
+
+  MWasmBoundsCheck* bcLeft = AddBoundsCheck(func, left, i, 4, limit);
+  left->end(MGoto::New(func.alloc, join));
+  MWasmBoundsCheck* bcRight = AddBoundsCheck(func, right, i, 8, limit);
+  right->end(MGoto::New(func.alloc, join));
+  MOZ_ALWAYS_TRUE(join->addPredecessorWithoutPhis(right));
+
+  MWasmBoundsCheck* bc0 = AddBoundsCheck(func, join, i, 0, limit);
+  MWasmBoundsCheck* bc4 = AddBoundsCheck(func, join, i, 4, limit);
+  MWasmBoundsCheck* bc8 = AddBoundsCheck(func, join, i, 8, limit);
+  join->end(MTest::New(func.alloc, cond, left2, right2));
+
+  MWasmBoundsCheck* bcLeft2 = AddBoundsCheck(func, left2, k, 0, limit);
+  left2->end(MGoto::New(func.alloc, join2));
+  right2->end(MGoto::New(func.alloc, join2));
+  MOZ_ALWAYS_TRUE(join2->addPredecessorWithoutPhis(right2));
+
+  MWasmBoundsCheck* bcJoin2 = AddBoundsCheck(func, join2, k, 0, limit);
+  AddReturn(func, join2);
+
+  CHECK(RunBCE(func));
+  CHECK(!bcLeft->isRedundant());
+  CHECK(!bcRight->isRedundant());
+  CHECK(bc0->isRedundant());
+  CHECK(bc4->isRedundant());
+  CHECK(!bc8->isRedundant());
+  CHECK(!bcLeft2->isRedundant());
+  CHECK(!bcJoin2->isRedundant());
+  return true;
+}
+END_TEST(testWasmBCE_TwoArms)
+
+// A loop-invariant check at the start of a loop header moves to the
+// preheader, unless an interrupt check precedes it.
+BEGIN_TEST(testWasmBCE_Hoisting) {
+  bool spectreIndexMasking = JitOptions.spectreIndexMasking;
+  JitOptions.spectreIndexMasking = false;
+  auto restore = mozilla::MakeScopeExit(
+      [&] { JitOptions.spectreIndexMasking = spectreIndexMasking; });
+
+  CHECK(checkLoop(/* interruptCheck = */ false));
+  CHECK(checkLoop(/* interruptCheck = */ true));
+  return true;
+}
+
+bool checkLoop(bool interruptCheck) {
+  MinimalFunc func;
+  MBasicBlock* preheader = func.createEntryBlock();
+  MBasicBlock* header = func.createBlock(preheader);
+  MBasicBlock* body = func.createBlock(header);
+  MBasicBlock* exit = func.createBlock(header);
+
+  MParameter* i = AddInt32Parameter(func, preheader);
+  MParameter* limit = AddInt32Parameter(func, preheader);
+  MParameter* cond = AddInt32Parameter(func, preheader);
+  MParameter* instance = func.createParameter();
+  preheader->add(instance);
+  preheader->end(MGoto::New(func.alloc, header));
+
+  if (interruptCheck) {
+    header->add(MWasmInterruptCheck::New(func.alloc, instance,
+                                         wasm::TrapSiteDesc()));
+  }
+  MWasmBoundsCheck* bcHeader = AddBoundsCheck(func, header, i, 0, limit);
+  header->end(MTest::New(func.alloc, cond, body, exit));
+
+  MWasmBoundsCheck* bcBody = AddBoundsCheck(func, body, i, 0, limit);
+  body->end(MGoto::New(func.alloc, header));
+  MOZ_ALWAYS_TRUE(header->addPredecessorWithoutPhis(body));
+  header->setLoopHeader(body);
+
+  MWasmBoundsCheck* bcExit = AddBoundsCheck(func, exit, i, 0, limit);
+  AddReturn(func, exit);
+
+  CHECK(RunBCE(func));
+  CHECK(!bcHeader->isRedundant());
+  CHECK(bcHeader->block() == (interruptCheck ? header : preheader));
+  CHECK(bcBody->isRedundant());
+  CHECK(bcExit->isRedundant());
+  return true;
+}
+END_TEST(testWasmBCE_Hoisting)
+
+// Accesses whose checks are eliminated by the patterns above still trap when
+// out of bounds. The memory is a 64-bit one, which always uses explicit bounds
+// checks, and the module is compiled with Ion only.
+BEGIN_TEST(testWasmBCE_Traps) {
+  bool baseline = JS::ContextOptionsRef(cx).wasmBaseline();
+  JS::ContextOptionsRef(cx).setWasmBaseline(false);
+  auto restore = mozilla::MakeScopeExit(
+      [&] { JS::ContextOptionsRef(cx).setWasmBaseline(baseline); });
+  if (!wasm::IonAvailable(cx) || !wasm::Memory64Available(cx)) {
+    return true;
+  }
+
+  // (module
+  //   (memory i64 1)
+  //   (func (export "twoArms") (param $i i64) (param $c i32) (result i32)
+  //     (if (local.get $c)
+  //       (then (drop (i32.load offset=4 (local.get $i))))
+  //       (else (drop (i32.load offset=8 (local.get $i)))))
+  //     (i32.load (local.get $i)))
+  //   (func (export "dominated") (param $i i64) (result i32)
+  //     (i32.add (i32.load offset=8 (local.get $i))
+  //              (i32.load (local.get $i))))
+  //   (func (export "loop") (param $i i64) (param $n i32) (result i32)
+  //     (local $s i32)
+  //     (loop $l
+  //       (local.set $s (i32.add (local.get $s) (i32.load (local.get $i))))
+  //       (br_if $l (local.tee $n (i32.sub (local.get $n) (i32.const 1)))))
+  //     (local.get $s)))
+  JS::RootedValue v(cx);
+  EVAL(
+      "var {twoArms, dominated, loop} = new WebAssembly.Instance(\n"
+      "    new WebAssembly.Module(new Uint8Array([\n"
+      "  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,\n"
+      "  0x01, 0x0c, 0x02, 0x60, 0x02, 0x7e, 0x7f, 0x01, 0x7f,\n"
+      "  0x60, 0x01, 0x7e, 0x01, 0x7f,\n"
+      "  0x03, 0x04, 0x03, 0x00, 0x01, 0x00,\n"
+      "  0x05, 0x03, 0x01, 0x04, 0x01,\n"
+      "  0x07, 0x1e, 0x03,\n"
+      "  0x07, 0x74, 0x77, 0x6f, 0x41, 0x72, 0x6d, 0x73, 0x00, 0x00,\n"
+      "  0x09, 0x64, 0x6f, 0x6d, 0x69, 0x6e, 0x61, 0x74, 0x65, 0x64,\n"
+      "  0x00, 0x01,\n"
+      "  0x04, 0x6c, 0x6f, 0x6f, 0x70, 0x00, 0x02,\n"
+      "  0x0a, 0x46, 0x03,\n"
+      "  0x19, 0x00, 0x20, 0x01, 0x04, 0x40, 0x20, 0x00, 0x28, 0x02, 0x04,\n"
+      "  0x1a, 0x05, 0x20, 0x00, 0x28, 0x02, 0x08, 0x1a, 0x0b,\n"
+      "  0x20, 0x00, 0x28, 0x02, 0x00, 0x0b,\n"
+      "  0x0d, 0x00, 0x20, 0x00, 0x28, 0x02, 0x08, 0x20, 0x00, 0x28, 0x02,\n"
+      "  0x00, 0x6a, 0x0b,\n"
+      "  0x1c, 0x01, 0x01, 0x7f, 0x03, 0x40, 0x20, 0x02, 0x20, 0x00, 0x28,\n"
+      "  0x02, 0x00, 0x6a, 0x21, 0x02, 0x20, 0x01, 0x41, 0x01, 0x6b, 0x22,\n"
+      "  0x01, 0x0d, 0x00, 0x0b, 0x20, 0x02, 0x0b]))).exports;\n"
+      "function traps(f) {\n"
+      "  try {\n"
+      "    f();\n"
+      "  } catch (e) {\n"
+      "    return e instanceof WebAssembly.RuntimeError;\n"
+      "  }\n"
+      "  return false;\n"
+      "}\n"
+      "twoArms(65528n, 1) === 0 && twoArms(65524n, 0) === 0 &&\n"
+      "traps(() => twoArms(65532n, 1)) && traps(() => twoArms(65528n, 0)) &&\n"
+      "traps(() => twoArms(65536n, 1)) && traps(() => twoArms(-1n, 0)) &&\n"
+      "dominated(65524n) === 0 && traps(() => dominated(65525n)) &&\n"
+      "traps(() => dominated(65536n)) &&\n"
+      "loop(65532n, 3) === 0 && traps(() => loop(65533n, 3)) &&\n"
+      "traps(() => loop(65536n, 1))",
+      &v);
+  CHECK(v.isTrue());
+  return true;
+}
+END_TEST(testWasmBCE_Traps)
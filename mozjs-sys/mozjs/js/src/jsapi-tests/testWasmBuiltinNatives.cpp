@@ -0,0 +1,280 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <iterator>  // std::size
+
+#include "js/BigInt.h"        // JS::NumberToBigInt, JS::ToBigInt{,64}
+#include "js/Conversions.h"   // JS::ToInt32, JS::ToNumber, JS::ToBoolean
+#include "js/PropertySpec.h"  // JS_FN, JS_FS_END
+#include "js/WasmBuiltins.h"  // JS::RegisterWasmBuiltinNatives
+#include "jsapi-tests/tests.h"
+#include "wasm/WasmFeatures.h"  // js::wasm::HasSupport
+
+static int sTypedCalls = 0;
+static int sNativeCalls = 0;
+static int32_t sRecorded = 0;
+
+static int32_t TypedAddI32(int32_t a, int32_t b) {
+  sTypedCalls++;
+  return int32_t(uint32_t(a) + uint32_t(b));
+}
+
+static int64_t TypedAddI64(int64_t a, int64_t b) {
+  sTypedCalls++;
+  return int64_t(uint64_t(a) + uint64_t(b));
+}
+
+static float TypedAddF32(float a, float b) {
+  sTypedCalls++;
+  return a + b;
+}
+
+static double TypedAddF64(double a, double b) {
+  sTypedCalls++;
+  return a + b;
+}
+
+static void* TypedPickRef(void* ref, int32_t pick) {
+  sTypedCalls++;
+  return pick ? ref : nullptr;
+}
+
+static void TypedRecord(int32_t value) {
+  sTypedCalls++;
+  sRecorded = value;
+}
+
+static bool NativeAddI32(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  int32_t a, b;
+  if (!JS::ToInt32(cx, args.get(0), &a) ||
+      !JS::ToInt32(cx, args.get(1), &b)) {
+    return false;
+  }
+  args.rval().setInt32(int32_t(uint32_t(a) + uint32_t(b)));
+  return true;
+}
+
+static bool NativeAddI64(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  JS::BigInt* a = JS::ToBigInt(cx, args.get(0));
+  if (!a) {
+    return false;
+  }
+  int64_t lhs = JS::ToBigInt64(a);
+  JS::BigInt* b = JS::ToBigInt(cx, args.get(1));
+  if (!b) {
+    return false;
+  }
+  int64_t rhs = JS::ToBigInt64(b);
+  JS::BigInt* result = JS::NumberToBigInt(cx, int64_t(uint64_t(lhs) + rhs));
+  if (!result) {
+    return false;
+  }
+  args.rval().setBigInt(result);
+  return true;
+}
+
+static bool NativeAddF32(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  double a, b;
+  if (!JS::ToNumber(cx, args.get(0), &a) ||
+      !JS::ToNumber(cx, args.get(1), &b)) {
+    return false;
+  }
+  args.rval().setDouble(float(a) + float(b));
+  return true;
+}
+
+static bool NativeAddF64(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  double a, b;
+  if (!JS::ToNumber(cx, args.get(0), &a) ||
+      !JS::ToNumber(cx, args.get(1), &b)) {
+    return false;
+  }
+  args.rval().setDouble(a + b);
+  return true;
+}
+
+static bool NativePickRef(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  if (JS::ToBoolean(args.get(1))) {
+    args.rval().set(args.get(0));
+  } else {
+    args.rval().setNull();
+  }
+  return true;
+}
+
+static bool NativeRecord(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  sNativeCalls++;
+  if (!JS::ToInt32(cx, args.get(0), &sRecorded)) {
+    return false;
+  }
+  args.rval().setUndefined();
+  return true;
+}
+
+static const JSFunctionSpec wasmBuiltinFunctions[] = {
+    JS_FN("addI32", NativeAddI32, 2, 0),
+    JS_FN("addI64", NativeAddI64, 2, 0),
+    JS_FN("addF32", NativeAddF32, 2, 0),
+    JS_FN("addF64", NativeAddF64, 2, 0),
+    JS_FN("pickRef", NativePickRef, 2, 0),
+    JS_FN("record", NativeRecord, 1, 0),
+    JS_FS_END};
+
+using JS::WasmBuiltinType;
+
+static const WasmBuiltinType addI32Params[] = {WasmBuiltinType::I32,
+                                               WasmBuiltinType::I32};
+static const WasmBuiltinType addI64Params[] = {WasmBuiltinType::I64,
+                                               WasmBuiltinType::I64};
+static const WasmBuiltinType addF32Params[] = {WasmBuiltinType::F32,
+                                               WasmBuiltinType::F32};
+static const WasmBuiltinType addF64Params[] = {WasmBuiltinType::F64,
+                                               WasmBuiltinType::F64};
+static const WasmBuiltinType pickRefParams[] = {WasmBuiltinType::ExternRef,
+                                                WasmBuiltinType::I32};
+static const WasmBuiltinType recordParams[] = {WasmBuiltinType::I32};
+
+static const JS::WasmBuiltinNative wasmBuiltinNatives[] = {
+    {NativeAddI32, JS_FUNC_TO_DATA_PTR(void*, TypedAddI32), addI32Params, 2,
+     true, WasmBuiltinType::I32},
+    {NativeAddI64, JS_FUNC_TO_DATA_PTR(void*, TypedAddI64), addI64Params, 2,
+     true, WasmBuiltinType::I64},
+    {NativeAddF32, JS_FUNC_TO_DATA_PTR(void*, TypedAddF32), addF32Params, 2,
+     true, WasmBuiltinType::F32},
+    {NativeAddF64, JS_FUNC_TO_DATA_PTR(void*, TypedAddF64), addF64Params, 2,
+     true, WasmBuiltinType::F64},
+    {NativePickRef, JS_FUNC_TO_DATA_PTR(void*, TypedPickRef), pickRefParams,
+     2, true, WasmBuiltinType::ExternRef},
+    {NativeRecord, JS_FUNC_TO_DATA_PTR(void*, TypedRecord), recordParams, 1,
+     false, WasmBuiltinType::I32},
+};
+
+// The natives must be registered before any module is compiled.
+BEGIN_PROCESS_INIT(registerWasmBuiltinNatives) {
+  return JS::RegisterWasmBuiltinNatives(wasmBuiltinNatives,
+                                        std::size(wasmBuiltinNatives));
+}
+END_PROCESS_INIT(registerWasmBuiltinNatives)
+
+// Imports of registered natives with their registered signature are called
+// through their typed function from wasm, and through their JSNative from JS
+// or when imported with another signature.
+BEGIN_TEST(testWasmBuiltinNatives) {
+  if (!js::wasm::HasSupport(cx)) {
+    return true;
+  }
+
+  CHECK(JS_DefineFunctions(cx, global, wasmBuiltinFunctions));
+
+  // (module
+  //   (import "env" "addI32" (func (param i32 i32) (result i32)))
+  //   (import "env" "addI64" (func (param i64 i64) (result i64)))
+  //   (import "env" "addF32" (func (param f32 f32) (result f32)))
+  //   (import "env" "addF64" (func (param f64 f64) (result f64)))
+  //   (import "env" "pickRef"
+  //     (func (param externref i32) (result externref)))
+  //   (import "env" "record" (func (param i32)))
+  //   (import "env" "addI32AsF64" (func (param f64 f64) (result f64)))
+  //   ;; For each import, a function of the same type exported with the
+  //   ;; same name, which calls the import with its arguments.
+  //   ...)
+  JS::RootedValue v(cx);
+  EVAL(
+      "var exports = new WebAssembly.Instance(\n"
+      "    new WebAssembly.Module(new Uint8Array([\n"
+      "  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,\n"
+      "  0x01, 0x23, 0x06, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x60, 0x02,\n"
+      "  0x7e, 0x7e, 0x01, 0x7e, 0x60, 0x02, 0x7d, 0x7d, 0x01, 0x7d, 0x60,\n"
+      "  0x02, 0x7c, 0x7c, 0x01, 0x7c, 0x60, 0x02, 0x6f, 0x7f, 0x01, 0x6f,\n"
+      "  0x60, 0x01, 0x7f, 0x00,\n"
+      "  0x02, 0x62, 0x07, 0x03, 0x65, 0x6e, 0x76, 0x06, 0x61, 0x64, 0x64,\n"
+      "  0x49, 0x33, 0x32, 0x00, 0x00, 0x03, 0x65, 0x6e, 0x76, 0x06, 0x61,\n"
+      "  0x64, 0x64, 0x49, 0x36, 0x34, 0x00, 0x01, 0x03, 0x65, 0x6e, 0x76,\n"
+      "  0x06, 0x61, 0x64, 0x64, 0x46, 0x33, 0x32, 0x00, 0x02, 0x03, 0x65,\n"
+      "  0x6e, 0x76, 0x06, 0x61, 0x64, 0x64, 0x46, 0x36, 0x34, 0x00, 0x03,\n"
+      "  0x03, 0x65, 0x6e, 0x76, 0x07, 0x70, 0x69, 0x63, 0x6b, 0x52, 0x65,\n"
+      "  0x66, 0x00, 0x04, 0x03, 0x65, 0x6e, 0x76, 0x06, 0x72, 0x65, 0x63,\n"
+      "  0x6f, 0x72, 0x64, 0x00, 0x05, 0x03, 0x65, 0x6e, 0x76, 0x0b, 0x61,\n"
+      "  0x64, 0x64, 0x49, 0x33, 0x32, 0x41, 0x73, 0x46, 0x36, 0x34, 0x00,\n"
+      "  0x03,\n"
+      "  0x03, 0x08, 0x07, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x03,\n"
+      "  0x07, 0x46, 0x07, 0x06, 0x61, 0x64, 0x64, 0x49, 0x33, 0x32, 0x00,\n"
+      "  0x07, 0x06, 0x61, 0x64, 0x64, 0x49, 0x36, 0x34, 0x00, 0x08, 0x06,\n"
+      "  0x61, 0x64, 0x64, 0x46, 0x33, 0x32, 0x00, 0x09, 0x06, 0x61, 0x64,\n"
+      "  0x64, 0x46, 0x36, 0x34, 0x00, 0x0a, 0x07, 0x70, 0x69, 0x63, 0x6b,\n"
+      "  0x52, 0x65, 0x66, 0x00, 0x0b, 0x06, 0x72, 0x65, 0x63, 0x6f, 0x72,\n"
+      "  0x64, 0x00, 0x0c, 0x0b, 0x61, 0x64, 0x64, 0x49, 0x33, 0x32, 0x41,\n"
+      "  0x73, 0x46, 0x36, 0x34, 0x00, 0x0d,\n"
+      "  0x0a, 0x3e, 0x07, 0x08, 0x00, 0x20, 0x00, 0x20, 0x01, 0x10, 0x00,\n"
+      "  0x0b, 0x08, 0x00, 0x20, 0x00, 0x20, 0x01, 0x10, 0x01, 0x0b, 0x08,\n"
+      "  0x00, 0x20, 0x00, 0x20, 0x01, 0x10, 0x02, 0x0b, 0x08, 0x00, 0x20,\n"
+      "  0x00, 0x20, 0x01, 0x10, 0x03, 0x0b, 0x08, 0x00, 0x20, 0x00, 0x20,\n"
+      "  0x01, 0x10, 0x04, 0x0b, 0x06, 0x00, 0x20, 0x00, 0x10, 0x05, 0x0b,\n"
+      "  0x08, 0x00, 0x20, 0x00, 0x20, 0x01, 0x10, 0x06, 0x0b])),\n"
+      "    {env: {addI32, addI64, addF32, addF64, pickRef, record,\n"
+      "           addI32AsF64: addI32}}).exports;\n",
+      &v);
+
+  // Builtin thunks have been created, so it is too late to register natives.
+  CHECK(!JS::RegisterWasmBuiltinNatives(wasmBuiltinNatives, 1));
+
+  // Calls from wasm with the registered signatures.
+  sTypedCalls = sNativeCalls = 0;
+  EVAL(
+      "var obj = {};\n"
+      "exports.addI32(0x7fffffff, 1) === -0x80000000 &&\n"
+      "exports.addI64(1n << 62n, 1n << 62n) === -(1n << 63n) &&\n"
+      "exports.addF32(0.1, 0.2) === Math.fround(Math.fround(0.1) +\n"
+      "                                         Math.fround(0.2)) &&\n"
+      "exports.addF64(0.1, 0.2) === 0.1 + 0.2 &&\n"
+      "exports.pickRef(obj, 1) === obj && exports.pickRef(obj, 0) === null &&\n"
+      "exports.pickRef('str', 1) === 'str' && exports.pickRef(5, 1) === 5 &&\n"
+      "exports.record(42) === undefined",
+      &v);
+  CHECK(v.isTrue());
+  CHECK_EQUAL(sRecorded, 42);
+#ifdef JS_SIMULATOR
+  // The simulator always calls the JSNatives.
+  CHECK_EQUAL(sTypedCalls, 0);
+  CHECK_EQUAL(sNativeCalls, 9);
+#else
+  CHECK_EQUAL(sTypedCalls, 9);
+  CHECK_EQUAL(sNativeCalls, 0);
+#endif
+
+  // A call from wasm with another signature goes to the JSNative.
+  sTypedCalls = sNativeCalls = 0;
+  EVAL("exports.addI32AsF64(1.5, 2)", &v);
+  CHECK(v.isNumber());
+  CHECK_EQUAL(v.toNumber(), 3.0);
+  CHECK_EQUAL(sTypedCalls, 0);
+  CHECK_EQUAL(sNativeCalls, 1);
+
+  // Calls from JS go to the JSNatives.
+  sTypedCalls = sNativeCalls = 0;
+  EVAL(
+      "addI32(0x7fffffff, 1) === -0x80000000 && addF64(0.5, 0.25) === 0.75 &&\n"
+      "pickRef(obj, 0) === null && record(7) === undefined",
+      &v);
+  CHECK(v.isTrue());
+  CHECK_EQUAL(sRecorded, 7);
+  CHECK_EQUAL(sTypedCalls, 0);
+  CHECK_EQUAL(sNativeCalls, 4);
+  return true;
+}
+END_TEST(testWasmBuiltinNatives)
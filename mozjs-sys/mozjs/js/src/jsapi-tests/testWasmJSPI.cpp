@@ -0,0 +1,113 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+
+#include <iterator>
+
+#include "js/Prefs.h"
+#include "js/PropertyAndElement.h"  // JS_SetProperty
+#include "jsapi-tests/testWasmModules.h"
+#include "jsapi-tests/tests.h"
+#include "jsfriendapi.h"  // js::RunJobs
+#include "vm/JSContext.h"
+#include "wasm/WasmConstants.h"  // SuspendableStacksPoolMaxCount
+#include "wasm/WasmContext.h"
+#include "wasm/WasmFeatures.h"  // HasSupport, JSPromiseIntegrationAvailable
+
+using namespace js;
+using namespace js::wasm;
+
+// A suspender takes the stack released by an earlier one, once that one has
+// returned, instead of allocating a new stack.
+BEGIN_TEST(testWasmJSPI_StackReuse) {
+#ifdef ENABLE_WASM_JSPI
+  if (!HasSupport(cx)) {
+    return true;
+  }
+
+  // WebAssembly.promising and WebAssembly.Suspending are only defined on
+  // globals created while the feature is enabled.
+  auto restorePref =
+      SetPrefForScope(JS::Prefs::wasm_js_promise_integration,
+                      JS::Prefs::set_wasm_js_promise_integration, true);
+  if (!JSPromiseIntegrationAvailable(cx)) {
+    return true;
+  }
+  CHECK(createGlobal());
+  JSAutoRealm ar(cx, global);
+
+  // Empty the pool, which may hold stacks of earlier tests using this
+  // context, then release a single stack into it.
+  SuspenderContext& scx = cx->wasm().promiseIntegration;
+  void* stacks[SuspendableStacksPoolMaxCount];
+  for (void*& stack : stacks) {
+    stack = scx.allocateStackMemory();
+    CHECK(stack);
+  }
+  auto releaseStacks = mozilla::MakeScopeExit([&] {
+    for (size_t i = 1; i < std::size(stacks); i++) {
+      scx.releaseStackMemory(stacks[i]);
+    }
+  });
+  scx.releaseStackMemory(stacks[0]);
+
+  SharedModule module = CompileTestModule(cx, CallImportModule);
+  CHECK(module);
+  JS::RootedObject moduleObj(cx, module->createObject(cx));
+  CHECK(moduleObj);
+  JS::RootedValue moduleVal(cx, JS::ObjectValue(*moduleObj));
+  CHECK(JS_SetProperty(cx, global, "module", moduleVal));
+
+  JS::RootedValue v(cx);
+  EVAL(
+      "var resolvers = [];\n"
+      "var results = [];\n"
+      "var f = new WebAssembly.Suspending(\n"
+      "    () => new Promise(resolve => resolvers.push(resolve)));\n"
+      "var run = WebAssembly.promising(\n"
+      "    new WebAssembly.Instance(module, {m: {f}}).exports.run);\n"
+      "function start() { run().then(result => results.push(result)); }\n"
+      "function resolveAll(value) {\n"
+      "  resolvers.splice(0).forEach(resolve => resolve(value));\n"
+      "}\n",
+      &v);
+
+  // Suspend and resume twice in a row. Both suspenders run on the pooled
+  // stack, which goes back to the pool when they return.
+  for (int i = 0; i < 2; i++) {
+    EVAL("start(); resolvers.length", &v);
+    CHECK(v.isInt32(1));
+    EVAL("resolveAll(41);", &v);
+    js::RunJobs(cx);
+    EVAL("results.length === 1 && results.pop() === 42", &v);
+    CHECK(v.isTrue());
+
+    void* stack = scx.allocateStackMemory();
+    CHECK(stack == stacks[0]);
+    scx.releaseStackMemory(stack);
+  }
+
+  // Only one of two suspended suspenders gets the pooled stack, but both
+  // stacks are pooled on return.
+  EVAL("start(); start(); resolvers.length", &v);
+  CHECK(v.isInt32(2));
+  EVAL("resolveAll(1);", &v);
+  js::RunJobs(cx);
+  EVAL("results.length === 2 && results.every(result => result === 2)", &v);
+  CHECK(v.isTrue());
+
+  void* first = scx.allocateStackMemory();
+  void* second = scx.allocateStackMemory();
+  CHECK(first && second);
+  CHECK(first == stacks[0] || second == stacks[0]);
+  scx.releaseStackMemory(first);
+  scx.releaseStackMemory(second);
+#endif
+  return true;
+}
+END_TEST(testWasmJSPI_StackReuse)
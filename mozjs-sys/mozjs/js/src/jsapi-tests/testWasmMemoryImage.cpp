@@ -0,0 +1,111 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "js/PropertyAndElement.h"  // JS_GetProperty
+#include "js/WasmModule.h"           // JS::GetWasmModule
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmFeatures.h"  // HasSupport
+#include "wasm/WasmModule.h"
+
+// The first instance of a module copies the data segments into its memory,
+// later ones map an image of them copy-on-write. Either way, every instance
+// starts with the same contents, and writes to one instance's memory are not
+// visible to the others.
+BEGIN_TEST(testWasmMemoryImage_Instantiate) {
+  if (!js::wasm::HasSupport(cx)) {
+    return true;
+  }
+
+  // (module
+  //   (memory (export "mem") 2)
+  //   (data (i32.const 0) "abc")
+  //   (data (i32.const 70000) "xyz")
+  //   (data (i32.const 1) "Z"))
+  JS::RootedValue v(cx);
+  EVAL(
+      "var module = new WebAssembly.Module(new Uint8Array([\n"
+      "  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,\n"
+      "  0x05, 0x03, 0x01, 0x00, 0x02,\n"
+      "  0x07, 0x07, 0x01, 0x03, 0x6d, 0x65, 0x6d, 0x02, 0x00,\n"
+      "  0x0b, 0x19, 0x03,\n"
+      "  0x00, 0x41, 0x00, 0x0b, 0x03, 0x61, 0x62, 0x63,\n"
+      "  0x00, 0x41, 0xf0, 0xa2, 0x04, 0x0b, 0x03, 0x78, 0x79, 0x7a,\n"
+      "  0x00, 0x41, 0x01, 0x0b, 0x01, 0x5a]));\n"
+      "function read(bytes, offset, length) {\n"
+      "  return String.fromCharCode(...bytes.subarray(offset,\n"
+      "                                               offset + length));\n"
+      "}\n"
+      "function check(bytes) {\n"
+      "  return bytes.length === 2 * 65536 &&\n"
+      "         read(bytes, 0, 4) === 'aZc\\0' &&\n"
+      "         read(bytes, 69999, 5) === '\\0xyz\\0' &&\n"
+      "         bytes[65535] === 0 && bytes[131071] === 0;\n"
+      "}\n"
+      "var instances = [];\n"
+      "var ok = check(new Uint8Array(\n"
+      "    new WebAssembly.Instance(module).exports.mem.buffer));\n"
+      "ok",
+      &v);
+  CHECK(v.isTrue());
+
+  // The first instantiation copied the data segments.
+  JS::RootedValue moduleVal(cx);
+  CHECK(JS_GetProperty(cx, global, "module", &moduleVal));
+  CHECK(moduleVal.isObject());
+  JS::RootedObject moduleObj(cx, &moduleVal.toObject());
+  RefPtr<JS::WasmModule> jsModule = JS::GetWasmModule(moduleObj);
+  CHECK(jsModule);
+  const js::wasm::Module& module =
+      static_cast<const js::wasm::Module&>(*jsModule);
+  CHECK(!module.testingHasMemoryImage(0));
+
+  EVAL(
+      "for (var i = 0; i < 4; i++) {\n"
+      "  var mem = new WebAssembly.Instance(module).exports.mem;\n"
+      "  var bytes = new Uint8Array(mem.buffer);\n"
+      "  ok = ok && check(bytes);\n"
+      "  bytes[0] = 0x41 + i;\n"
+      "  bytes[70001] = 0x41 + i;\n"
+      "  bytes[100000] = 0x41 + i;\n"
+      "  instances.push(mem);\n"
+      "}\n"
+      "for (var i = 0; i < instances.length; i++) {\n"
+      "  var bytes = new Uint8Array(instances[i].buffer);\n"
+      "  ok = ok && bytes[0] === 0x41 + i && bytes[70001] === 0x41 + i &&\n"
+      "       bytes[100000] === 0x41 + i && read(bytes, 1, 2) === 'Zc';\n"
+      "}\n"
+      "ok",
+      &v);
+  CHECK(v.isTrue());
+
+  // The second instantiation created the image, which is used from then on.
+  // Images are only available on Linux.
+#ifdef XP_LINUX
+  CHECK(module.testingHasMemoryImage(0));
+#endif
+
+  // Growing a memory initialized from an image keeps its contents, and adds
+  // zeroed pages.
+  EVAL(
+      "var mem = new WebAssembly.Instance(module).exports.mem;\n"
+      "mem.grow(1);\n"
+      "var bytes = new Uint8Array(mem.buffer);\n"
+      "bytes.length === 3 * 65536 && read(bytes, 0, 3) === 'aZc' &&\n"
+      "read(bytes, 70000, 3) === 'xyz' && bytes[131072] === 0 &&\n"
+      "bytes[196607] === 0",
+      &v);
+  CHECK(v.isTrue());
+
+  // Instances which are still alive are unaffected.
+  EVAL(
+      "instances.every((mem, i) => new Uint8Array(mem.buffer)[0] === 0x41 + i)",
+      &v);
+  CHECK(v.isTrue());
+  return true;
+}
+END_TEST(testWasmMemoryImage_Instantiate)
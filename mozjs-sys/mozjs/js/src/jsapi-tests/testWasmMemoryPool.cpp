@@ -0,0 +1,130 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+
+#include "gc/Memory.h"         // js::gc::SystemPageSize
+#include "js/GCAPI.h"          // JS::NonIncrementalGC, JS::PrepareForFullGC
+#include "js/WasmModule.h"     // JS::SetWasmMemoryPoolSize
+#include "jsapi-tests/tests.h"
+#include "vm/ArrayBufferObject.h"  // js::MapBufferMemory, js::WasmReservedBytes
+#include "wasm/WasmFeatures.h"     // js::wasm::HasSupport
+#include "wasm/WasmMemory.h"       // js::wasm::TakePooledMemory
+
+using namespace js;
+
+// A released reservation is reused by the next memory of the same size, with
+// all the pages it had committed zeroed. Reservations of other sizes are not.
+BEGIN_TEST(testWasmMemoryPool_Reuse) {
+#if !defined(XP_WIN) && !defined(__wasi__)
+  JS::SetWasmMemoryPoolSize(1);
+  auto disablePool =
+      mozilla::MakeScopeExit([] { JS::SetWasmMemoryPoolSize(0); });
+
+  const size_t pageSize = gc::SystemPageSize();
+  const size_t mappedSize = 16 * pageSize;
+  const size_t committedSize = 4 * pageSize;
+  const wasm::AddressType t = wasm::AddressType::I32;
+
+  // Write to the initial pages, and to a page committed by growing.
+  uint8_t* base = static_cast<uint8_t*>(
+      MapBufferMemory(t, mappedSize, committedSize));
+  CHECK(base);
+  memset(base, 0xab, committedSize);
+  CHECK(CommitBufferMemory(base + committedSize, pageSize));
+  memset(base + committedSize, 0xcd, pageSize);
+  uint64_t reservedBytes = WasmReservedBytes();
+  UnmapBufferMemory(t, base, mappedSize, committedSize + pageSize);
+
+  // The pooled reservation still counts against the reservation limit.
+  CHECK(WasmReservedBytes() == reservedBytes - mappedSize);
+  CHECK(wasm::PooledMemoryBytes() == mappedSize);
+
+  // The pool is full, so this reservation is unmapped on release.
+  uint8_t* other = static_cast<uint8_t*>(
+      MapBufferMemory(t, 2 * mappedSize, committedSize));
+  CHECK(other);
+  CHECK(other != base);
+  UnmapBufferMemory(t, other, 2 * mappedSize, committedSize);
+
+  uint8_t* reused = static_cast<uint8_t*>(
+      MapBufferMemory(t, mappedSize, committedSize + pageSize));
+  CHECK(reused == base);
+  CHECK(wasm::PooledMemoryBytes() == 0);
+  for (size_t i = 0; i < committedSize + pageSize; i++) {
+    CHECK(reused[i] == 0);
+  }
+  UnmapBufferMemory(t, reused, mappedSize, committedSize + pageSize);
+
+  // MapBufferMemory empties the pool like this before failing for exceeding
+  // the reservation limit.
+  CHECK(wasm::PooledMemoryBytes() == mappedSize);
+  wasm::ReleasePooledMemory();
+  CHECK(wasm::PooledMemoryBytes() == 0);
+  CHECK(!wasm::TakePooledMemory(mappedSize));
+
+  // Shrinking the pool releases its reservations.
+  base = static_cast<uint8_t*>(MapBufferMemory(t, mappedSize, committedSize));
+  CHECK(base);
+  UnmapBufferMemory(t, base, mappedSize, committedSize);
+  CHECK(wasm::PooledMemoryBytes() == mappedSize);
+  JS::SetWasmMemoryPoolSize(0);
+  CHECK(wasm::PooledMemoryBytes() == 0);
+  CHECK(!wasm::TakePooledMemory(mappedSize));
+#endif
+  return true;
+}
+END_TEST(testWasmMemoryPool_Reuse)
+
+// Memories which had a memory image mapped over them are also zeroed when their
+// reservation is reused.
+BEGIN_TEST(testWasmMemoryPool_MemoryImage) {
+  if (!wasm::HasSupport(cx)) {
+    return true;
+  }
+
+  JS::SetWasmMemoryPoolSize(4);
+  auto disablePool =
+      mozilla::MakeScopeExit([] { JS::SetWasmMemoryPoolSize(0); });
+
+  // (module
+  //   (memory (export "mem") 2)
+  //   (data (i32.const 0) "abc")
+  //   (data (i32.const 70000) "xyz"))
+  JS::RootedValue v(cx);
+  EVAL(
+      "var module = new WebAssembly.Module(new Uint8Array([\n"
+      "  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,\n"
+      "  0x05, 0x03, 0x01, 0x00, 0x02,\n"
+      "  0x07, 0x07, 0x01, 0x03, 0x6d, 0x65, 0x6d, 0x02, 0x00,\n"
+      "  0x0b, 0x13, 0x02,\n"
+      "  0x00, 0x41, 0x00, 0x0b, 0x03, 0x61, 0x62, 0x63,\n"
+      "  0x00, 0x41, 0xf0, 0xa2, 0x04, 0x0b, 0x03, 0x78, 0x79, 0x7a]));\n"
+      "for (var i = 0; i < 4; i++) {\n"
+      "  var bytes = new Uint8Array(\n"
+      "      new WebAssembly.Instance(module).exports.mem.buffer);\n"
+      "  bytes[100000] = 1;\n"
+      "}\n"
+      "bytes = null;\n",
+      &v);
+
+  JS::PrepareForFullGC(cx);
+  JS::NonIncrementalGC(cx, JS::GCOptions::Shrink, JS::GCReason::API);
+
+  EVAL(
+      "var ok = true;\n"
+      "for (var i = 0; i < 4; i++) {\n"
+      "  var bytes = new Uint8Array(\n"
+      "      new WebAssembly.Memory({initial: 2}).buffer);\n"
+      "  ok = ok && bytes.every(b => b === 0);\n"
+      "}\n"
+      "ok",
+      &v);
+  CHECK(v.isTrue());
+  return true;
+}
+END_TEST(testWasmMemoryPool_MemoryImage)
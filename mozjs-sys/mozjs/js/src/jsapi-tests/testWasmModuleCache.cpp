@@ -0,0 +1,118 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+
+#include "js/Prefs.h"
+#include "js/WasmModule.h"  // JS::GetWasmModule, JS::SetWasmModuleCacheCapacity
+#include "jsapi-tests/testWasmModules.h"
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmFeatures.h"  // HasSupport, MultiMemoryAvailable
+
+using namespace js;
+
+// Modules compiled from the same bytecode with the same arguments are shared
+// while they are cached, and the least recently used ones are evicted.
+BEGIN_TEST(testWasmModuleCache) {
+  if (!wasm::HasSupport(cx)) {
+    return true;
+  }
+
+  JS::SetWasmModuleCacheCapacity(2);
+  auto disableCache =
+      mozilla::MakeScopeExit([] { JS::SetWasmModuleCacheCapacity(0); });
+
+  // Three different modules: an empty one, one with the type [] -> [], and
+  // one with the type [i32] -> []. They are all compiled by the same caller.
+  EXEC(
+      "var header = [0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00];\n"
+      "var bytes = [\n"
+      "  new Uint8Array(header),\n"
+      "  new Uint8Array([...header, 0x01, 0x04, 0x01, 0x60, 0x00, 0x00]),\n"
+      "  new Uint8Array([...header, 0x01, 0x05, 0x01, 0x60, 0x01, 0x7f,\n"
+      "                  0x00])];\n"
+      "function compile(i) { return new WebAssembly.Module(bytes[i]); }\n");
+
+  // Hits and misses.
+  RefPtr<JS::WasmModule> a = compile(0);
+  CHECK(a);
+  CHECK(compile(0) == a);
+  RefPtr<JS::WasmModule> b = compile(1);
+  CHECK(b);
+  CHECK(b != a);
+  CHECK(compile(1) == b);
+
+  // Modules compiled by another caller, which is reported in stack traces,
+  // are not shared. Caching that module evicts `b`, as `a` was used last.
+  CHECK(compile(0) == a);
+  JS::RootedValue v(cx);
+  EVAL("new WebAssembly.Module(bytes[0])", &v);
+  JS::RootedObject otherCaller(cx, &v.toObject());
+  CHECK(JS::GetWasmModule(otherCaller) != a);
+  CHECK(compile(0) == a);
+
+  // Nor are modules compiled with other features.
+  bool multiMemory = wasm::MultiMemoryAvailable(cx);
+  {
+    auto restoreMultiMemory = wasm::SetPrefForScope(
+        JS::Prefs::wasm_multi_memory, JS::Prefs::set_wasm_multi_memory,
+        !JS::Prefs::wasm_multi_memory());
+    if (wasm::MultiMemoryAvailable(cx) != multiMemory) {
+      RefPtr<JS::WasmModule> otherFeatures = compile(0);
+      CHECK(otherFeatures);
+      CHECK(otherFeatures != a);
+    }
+  }
+  CHECK(compile(0) == a);
+
+  // Start again with `a` and then `b` cached, and use `a`, so that caching a
+  // third module evicts `b`.
+  JS::SetWasmModuleCacheCapacity(0);
+  JS::SetWasmModuleCacheCapacity(2);
+  a = compile(0);
+  b = compile(1);
+  CHECK(compile(0) == a);
+  RefPtr<JS::WasmModule> c = compile(2);
+  CHECK(c);
+  CHECK(compile(0) == a);
+  CHECK(compile(2) == c);
+  RefPtr<JS::WasmModule> b2 = compile(1);
+  CHECK(b2);
+  CHECK(b2 != b);
+
+  // Caching `b2` evicted `a`, which was then the least recently used.
+  CHECK(compile(2) == c);
+  CHECK(compile(1) == b2);
+  CHECK(compile(0) != a);
+
+  // Setting the capacity to 0 releases the cached modules, and disables the
+  // cache.
+  RefPtr<JS::WasmModule> cached = compile(1);
+  CHECK(cached);
+  JS::SetWasmModuleCacheCapacity(0);
+  RefPtr<JS::WasmModule> uncached = compile(1);
+  CHECK(uncached);
+  CHECK(uncached != cached);
+  CHECK(compile(1) != uncached);
+  JS::SetWasmModuleCacheCapacity(2);
+  CHECK(compile(1) != cached);
+  return true;
+}
+
+RefPtr<JS::WasmModule> compile(int i) {
+  JS::RootedValue v(cx);
+  JS::RootedValue arg(cx, JS::Int32Value(i));
+  if (!JS_CallFunctionName(cx, global, "compile",
+                           JS::HandleValueArray(arg), &v) ||
+      !v.isObject()) {
+    return nullptr;
+  }
+  JS::RootedObject moduleObj(cx, &v.toObject());
+  return JS::GetWasmModule(moduleObj);
+}
+END_TEST(testWasmModuleCache)
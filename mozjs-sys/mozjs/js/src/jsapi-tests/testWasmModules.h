@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsapi_tests_testWasmModules_h
+#define jsapi_tests_testWasmModules_h
+
+#include "mozilla/ScopeExit.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wasm/WasmCompile.h"  // CompileBuffer
+#include "wasm/WasmCompileArgs.h"
+#include "wasm/WasmModule.h"
+
+namespace js {
+namespace wasm {
+
+// (module
+//   (import "m" "f" (func $f (result i32)))
+//   (func (export "run") (result i32)
+//     call $f i32.const 1 i32.add))
+static const uint8_t CallImportModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01,
+    0x60, 0x00, 0x01, 0x7f, 0x02, 0x07, 0x01, 0x01, 0x6d, 0x01, 0x66,
+    0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x07, 0x07, 0x01, 0x03, 0x72,
+    0x75, 0x6e, 0x00, 0x01, 0x0a, 0x09, 0x01, 0x07, 0x00, 0x10, 0x00,
+    0x41, 0x01, 0x6a, 0x0b};
+
+// Compile a module with the default features, reporting any error to |cx|.
+template <size_t N>
+SharedModule CompileTestModule(
+    JSContext* cx, const uint8_t (&bytes)[N],
+    JS::OptimizedEncodingListener* listener = nullptr) {
+  FeatureOptions options;
+  SharedCompileArgs compileArgs =
+      CompileArgs::buildAndReport(cx, ScriptedCaller(), options);
+  if (!compileArgs) {
+    return nullptr;
+  }
+  BytecodeSource source(bytes, N);
+  UniqueChars error;
+  UniqueCharsVector warnings;
+  SharedModule module =
+      CompileBuffer(*compileArgs, BytecodeBufferOrSource(source), &error,
+                    &warnings, listener);
+  if (!module) {
+    if (error) {
+      JS_ReportErrorASCII(cx, "%s", error.get());
+    } else {
+      ReportOutOfMemory(cx);
+    }
+    return nullptr;
+  }
+  return module;
+}
+
+// Set a pref for the rest of the scope, e.g.
+//
+//   auto restore = SetPrefForScope(JS::Prefs::wasm_multi_memory,
+//                                  JS::Prefs::set_wasm_multi_memory, true);
+template <typename T>
+[[nodiscard]] auto SetPrefForScope(T (*get)(), void (*set)(T), T value) {
+  T old = get();
+  set(value);
+  return mozilla::MakeScopeExit([=] { set(old); });
+}
+
+}  // namespace wasm
+}  // namespace js
+
+#endif  // jsapi_tests_testWasmModules_h
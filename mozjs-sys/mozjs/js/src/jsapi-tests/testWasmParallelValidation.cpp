@@ -0,0 +1,203 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <iterator>
+#include <string.h>
+
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmCompileArgs.h"  // BytecodeSource, FeatureOptions
+#include "wasm/WasmFeatures.h"     // HasSupport
+#include "wasm/WasmValidate.h"
+
+using namespace js;
+using namespace js::wasm;
+
+// The module has this many functions of type [] -> [], whose bodies are nops
+// and are each this many bytes, for a code section of about 1.2 MiB.
+static const uint32_t ParallelValidationNumFuncs = 300;
+static const uint32_t ParallelValidationBodySize = 4096;
+
+// Sizes are encoded with padding, so that they can be patched in place.
+static bool AppendPaddedVarU32(Bytes* bytes, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    if (!bytes->append(uint8_t((value & 0x7f) | 0x80))) {
+      return false;
+    }
+    value >>= 7;
+  }
+  return bytes->append(uint8_t(value));
+}
+
+static void PatchPaddedVarU32(Bytes* bytes, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*bytes)[offset + i] = uint8_t((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  (*bytes)[offset + 4] = uint8_t(value);
+}
+
+// Function bodies which fail validation are reported with the same error as by
+// serial validation, whichever batch they are in, and even when a helper
+// thread runs out of memory.
+BEGIN_TEST(testWasmParallelValidation) {
+  if (!HasSupport(cx)) {
+    return true;
+  }
+
+  // The offsets of the body sizes, each followed by its body.
+  Vector<size_t, 0, SystemAllocPolicy> bodyOffsets;
+  Bytes valid;
+  CHECK(makeModule(&valid, &bodyOffsets));
+  CHECK(valid.length() > 1024 * 1024);
+
+  UniqueChars error;
+  bool isValid;
+  CHECK(checkSameResult(valid, &isValid, &error));
+  CHECK(isValid);
+
+  // An invalid body, in a later batch than the first.
+  Bytes lateInvalid;
+  CHECK(lateInvalid.appendAll(valid));
+  makeInvalid(&lateInvalid, bodyOffsets[250]);
+  UniqueChars lateError;
+  CHECK(checkSameResult(lateInvalid, &isValid, &lateError));
+  CHECK(!isValid && lateError);
+
+  // A second invalid body, in an earlier batch, is the one reported.
+  Bytes twoInvalid;
+  CHECK(twoInvalid.appendAll(lateInvalid));
+  makeInvalid(&twoInvalid, bodyOffsets[20]);
+  UniqueChars earlyError;
+  CHECK(checkSameResult(twoInvalid, &isValid, &earlyError));
+  CHECK(!isValid && earlyError);
+  CHECK(strcmp(earlyError.get(), lateError.get()) != 0);
+
+  // A malformed body size is reported if the bodies before it are valid, and
+  // stops validation of the bodies after it.
+  Bytes badSize;
+  CHECK(badSize.appendAll(lateInvalid));
+  PatchPaddedVarU32(&badSize, bodyOffsets[200], MaxFunctionBytes + 1);
+  UniqueChars sizeError;
+  CHECK(checkSameResult(badSize, &isValid, &sizeError));
+  CHECK(!isValid && sizeError);
+  CHECK(strstr(sizeError.get(), "function body too big"));
+
+  makeInvalid(&badSize, bodyOffsets[20]);
+  CHECK(checkSameResult(badSize, &isValid, &error));
+  CHECK(!isValid && error);
+  CHECK(strcmp(error.get(), earlyError.get()) == 0);
+
+#ifdef DEBUG  // js::oom functions are only available in debug builds.
+  // Running out of memory on the main thread or on a helper thread is reported
+  // as such, never as a validation error, and does not hide the error of an
+  // earlier invalid body.
+  for (ThreadType thread : {THREAD_TYPE_MAIN, THREAD_TYPE_WASM_VALIDATE}) {
+    CHECK(checkOOM(valid, thread, nullptr));
+    CHECK(checkOOM(lateInvalid, thread, lateError.get()));
+  }
+#endif
+
+  return true;
+}
+
+bool makeModule(Bytes* bytes,
+                Vector<size_t, 0, SystemAllocPolicy>* bodyOffsets) {
+  static const uint8_t header[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,  // magic, version
+      0x01, 0x04, 0x01, 0x60, 0x00, 0x00,              // type [] -> []
+  };
+  CHECK(bytes->append(header, std::size(header)));
+
+  // Function section.
+  CHECK(bytes->append(0x03));
+  CHECK(AppendPaddedVarU32(bytes, 5 + ParallelValidationNumFuncs));
+  CHECK(AppendPaddedVarU32(bytes, ParallelValidationNumFuncs));
+  CHECK(bytes->appendN(0x00, ParallelValidationNumFuncs));
+
+  // Code section.
+  CHECK(bytes->append(0x0a));
+  CHECK(AppendPaddedVarU32(
+      bytes, 5 + ParallelValidationNumFuncs *
+                     (5 + ParallelValidationBodySize)));
+  CHECK(AppendPaddedVarU32(bytes, ParallelValidationNumFuncs));
+  for (uint32_t i = 0; i < ParallelValidationNumFuncs; i++) {
+    CHECK(bodyOffsets->append(bytes->length()));
+    CHECK(AppendPaddedVarU32(bytes, ParallelValidationBodySize));
+    CHECK(bytes->append(0x00));  // no locals
+    CHECK(bytes->appendN(0x01, ParallelValidationBodySize - 2));  // nop
+    CHECK(bytes->append(0x0b));  // end
+  }
+  return true;
+}
+
+// Replace a nop in the middle of a body with an i32.add, which has no
+// operands.
+void makeInvalid(Bytes* bytes, size_t bodyOffset) {
+  (*bytes)[bodyOffset + 5 + ParallelValidationBodySize / 2] = 0x6a;
+}
+
+bool validate(const Bytes& bytes, ParallelValidation parallel,
+              UniqueChars* error) {
+  BytecodeSource source(bytes.begin(), bytes.length());
+  FeatureOptions options;
+  return Validate(cx, source, options, error, parallel);
+}
+
+// Validate the module serially, and then in parallel, and check that both
+// give the same result and error.
+bool checkSameResult(const Bytes& bytes, bool* isValid, UniqueChars* error) {
+  UniqueChars serialError;
+  bool serial = validate(bytes, ParallelValidation::Disabled, &serialError);
+  CHECK(serial || serialError);
+
+  UniqueChars parallelError;
+  bool parallel = validate(bytes, ParallelValidation::Allowed, &parallelError);
+  CHECK(parallel == serial);
+  if (!serial) {
+    CHECK(parallelError);
+    CHECK(strcmp(parallelError.get(), serialError.get()) == 0);
+  }
+
+  *isValid = serial;
+  *error = std::move(serialError);
+  return true;
+}
+
+#ifdef DEBUG
+// Validate the module while failing allocations on |thread|, and check that
+// validation succeeds, fails on out-of-memory with a null error, or fails with
+// |expectedError|. Validating the module takes thousands of allocations, so
+// only some of them are made to fail, more sparsely as they get later.
+bool checkOOM(const Bytes& bytes, ThreadType thread,
+              const char* expectedError) {
+  const uint64_t maxAllocs = 1000000;
+  uint64_t oomAfter;
+  for (oomAfter = 1; oomAfter < maxAllocs; oomAfter += 1 + oomAfter / 8) {
+    oom::simulator.simulateFailureAfter(oom::FailureSimulator::Kind::OOM,
+                                        oomAfter, thread, false);
+    UniqueChars error;
+    bool ok = validate(bytes, ParallelValidation::Allowed, &error);
+    bool hadOOM = oom::HadSimulatedOOM();
+    oom::simulator.reset();
+
+    if (ok) {
+      CHECK(!expectedError);
+    } else if (error) {
+      CHECK(expectedError);
+      CHECK(strcmp(error.get(), expectedError) == 0);
+    }
+    if (!hadOOM) {
+      CHECK(ok == !expectedError);
+      break;
+    }
+  }
+  CHECK(oomAfter < maxAllocs);
+  return true;
+}
+#endif
+END_TEST(testWasmParallelValidation)
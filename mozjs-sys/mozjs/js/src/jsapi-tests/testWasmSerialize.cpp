@@ -0,0 +1,129 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "js/StreamConsumer.h"  // JS::OptimizedEncodingListener
+#include "jsapi-tests/testWasmModules.h"
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmCode.h"
+#include "wasm/WasmCompile.h"  // CompilePartialTier2
+#include "wasm/WasmFeatures.h"  // HasSupport, BaselineAvailable, IonAvailable
+#include "wasm/WasmModule.h"
+
+using namespace js;
+using namespace js::wasm;
+
+// (module
+//   (func (export "add") (param i32 i32) (result i32)
+//     local.get 0 local.get 1 i32.add)
+//   (func (export "mul") (param i32 i32) (result i32)
+//     local.get 0 local.get 1 i32.mul))
+static const uint8_t AddMulModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01,
+    0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x03, 0x03, 0x02, 0x00, 0x00,
+    0x07, 0x0d, 0x02, 0x03, 0x61, 0x64, 0x64, 0x00, 0x00, 0x03, 0x6d,
+    0x75, 0x6c, 0x00, 0x01, 0x0a, 0x11, 0x02, 0x07, 0x00, 0x20, 0x00,
+    0x20, 0x01, 0x6a, 0x0b, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6c,
+    0x0b};
+
+// Nothing stores the optimized encoding of lazily tiered modules, but the
+// presence of a listener asks for the module to be serializable.
+struct MOZ_STACK_CLASS NullListener : JS::OptimizedEncodingListener {
+  MozExternalRefCountType MOZ_XPCOM_ABI AddRef() override { return 0; }
+  MozExternalRefCountType MOZ_XPCOM_ABI Release() override { return 0; }
+  void storeOptimizedEncoding(const uint8_t* bytes, size_t length) override {}
+};
+
+BEGIN_TEST(testWasmSerialize_LazyTiering) {
+  if (!HasSupport(cx) || !BaselineAvailable(cx) || !IonAvailable(cx)) {
+    return true;
+  }
+
+  // Without a listener, the link data is dropped and the module can't be
+  // serialized.
+  SharedModule unrequested = CompileTestModule(cx, AddMulModule);
+  CHECK(unrequested);
+
+  // Lazy tiering is disabled by prefs, or by a lack of helper threads.
+  if (unrequested->code().mode() != CompileMode::LazyTiering) {
+    return true;
+  }
+  CHECK(!unrequested->canSerialize());
+  CHECK(checkInstance(*unrequested));
+
+  NullListener listener;
+  SharedModule requested = CompileTestModule(cx, AddMulModule, &listener);
+  CHECK(requested);
+  CHECK(requested->code().mode() == CompileMode::LazyTiering);
+  CHECK(requested->canSerialize());
+  const Module& module = *requested;
+
+  // Nothing has tiered up yet.
+  RefPtr<Module> copy = roundTrip(module);
+  CHECK(copy);
+  CHECK(copy->code().mode() == CompileMode::LazyTiering);
+  CHECK(copy->code().funcTier(0) == Tier::Baseline);
+  CHECK(copy->code().funcTier(1) == Tier::Baseline);
+  CHECK(checkInstance(*copy));
+
+  // Only the tiered up function is optimized after the round trip.
+  CHECK(tierUp(module, 1));
+  copy = roundTrip(module);
+  CHECK(copy);
+  CHECK(copy->code().funcTier(0) == Tier::Baseline);
+  CHECK(copy->code().funcTier(1) == Tier::Optimized);
+  CHECK(checkInstance(*copy));
+
+  // The deserialized module tiers up the rest, and round trips again with
+  // both of its partial tier-2 blocks.
+  CHECK(tierUp(*copy, 0));
+  RefPtr<Module> copy2 = roundTrip(*copy);
+  CHECK(copy2);
+  CHECK(copy2->code().funcTier(0) == Tier::Optimized);
+  CHECK(copy2->code().funcTier(1) == Tier::Optimized);
+  CHECK(checkInstance(*copy2));
+
+  // The original module is unaffected by its copies.
+  CHECK(module.code().funcTier(0) == Tier::Baseline);
+  CHECK(checkInstance(module));
+  return true;
+}
+
+RefPtr<Module> roundTrip(const Module& module) {
+  Bytes bytes;
+  if (!module.serialize(&bytes)) {
+    return nullptr;
+  }
+  return Module::deserialize(bytes.begin(), bytes.length());
+}
+
+bool tierUp(const Module& module, uint32_t funcIndex) {
+  UniqueChars error;
+  UniqueCharsVector warnings;
+  mozilla::Atomic<bool> cancelled(false);
+  CHECK(CompilePartialTier2(module.code(), funcIndex, &error, &warnings,
+                            &cancelled));
+  CHECK(module.code().funcTier(funcIndex) == Tier::Optimized);
+  return true;
+}
+
+bool checkInstance(const Module& module) {
+  JS::RootedObject moduleObj(cx, module.createObject(cx));
+  CHECK(moduleObj);
+  JS::RootedValue moduleVal(cx, JS::ObjectValue(*moduleObj));
+  CHECK(JS_SetProperty(cx, global, "module", moduleVal));
+
+  JS::RootedValue v(cx);
+  EVAL(
+      "var {add, mul} = new WebAssembly.Instance(module).exports;\n"
+      "add(2, 3) === 5 && mul(4, 5) === 20 && add(-1, 1) === 0 &&\n"
+      "mul(0x10000, 0x10000) === 0",
+      &v);
+  CHECK(v.isTrue());
+  return true;
+}
+END_TEST(testWasmSerialize_LazyTiering)
@@ -0,0 +1,151 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <initializer_list>
+#include <iterator>
+
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmGcObject.h"  // WasmStructObject
+#include "wasm/WasmTypeDef.h"
+#include "wasm/WasmValType.h"
+
+using namespace js;
+using namespace js::wasm;
+
+// Fields are laid out in declaration order, except that they fill the padding
+// left by aligning earlier fields. A subtype's layout starts with its
+// supertype's, and references placed in padding are traced.
+BEGIN_TEST(testWasmStructLayout) {
+  const StorageType ref = RefType::extern_();
+
+  // (struct i8 i64 externref i8)
+  StructType super;
+  CHECK(makeStruct(
+      {StorageType::I8, StorageType::I64, ref, StorageType::I8}, &super));
+
+  // (struct i8 i64 externref i8 v128 externref i32 i16)
+  StructType sub;
+  CHECK(makeStruct({StorageType::I8, StorageType::I64, ref, StorageType::I8,
+                    StorageType::V128, ref, StorageType::I32,
+                    StorageType::I16},
+                   &sub));
+
+  // Aligning the i64 leaves holes of 1, 2 and 4 bytes at 1, 2 and 4, and
+  // aligning the v128 leaves one of 8 bytes after the fields before it. With
+  // 8 byte references the second reference fills that last hole, with 4 byte
+  // ones the first reference fills the hole at 4.
+#ifdef JS_64BIT
+  const uint32_t superOffsets[] = {0, 8, 16, 1};
+  const uint32_t superSize = 24;
+  const uint32_t subOffsets[] = {0, 8, 16, 1, 32, 24, 4, 2};
+  const uint32_t subSize = 48;
+#else
+  const uint32_t superOffsets[] = {0, 8, 4, 1};
+  const uint32_t superSize = 16;
+  const uint32_t subOffsets[] = {0, 8, 4, 1, 16, 32, 36, 2};
+  const uint32_t subSize = 48;
+#endif
+  CHECK(checkOffsets(super, superOffsets, std::size(superOffsets), superSize));
+  CHECK(checkOffsets(sub, subOffsets, std::size(subOffsets), subSize));
+
+  for (uint32_t i = 0; i < super.fields_.length(); i++) {
+    CHECK(sub.fieldOffset(i) == super.fieldOffset(i));
+  }
+
+  CHECK(checkLayout(super));
+  CHECK(checkLayout(sub));
+
+  // A struct which does not fit inline, with a reference after the inline
+  // area. With 8 byte references, it fills the hole left by aligning the
+  // v128.
+  Vector<StorageType, 0, SystemAllocPolicy> types;
+  CHECK(types.append(StorageType::I8));
+  CHECK(types.appendN(StorageType::I64,
+                      WasmStructObject_MaxInlineBytes / sizeof(uint64_t)));
+  CHECK(types.append(StorageType::V128));
+  CHECK(types.append(ref));
+  StructType large;
+  CHECK(makeStruct(types, &large));
+  CHECK(large.size_ > WasmStructObject_MaxInlineBytes);
+  CHECK(checkLayout(large));
+#ifdef JS_64BIT
+  CHECK(large.fieldOffset(types.length() - 1) ==
+        WasmStructObject_MaxInlineBytes + 8);
+  CHECK(large.outlineTraceOffsets_.length() == 1);
+#endif
+  return true;
+}
+
+template <typename Types>
+bool makeStruct(const Types& types, StructType* structType) {
+  FieldTypeVector fields;
+  for (StorageType type : types) {
+    CHECK(fields.append(FieldType(type, true)));
+  }
+  *structType = StructType(std::move(fields));
+  CHECK(structType->init());
+  return true;
+}
+
+bool makeStruct(std::initializer_list<StorageType> types,
+                StructType* structType) {
+  return makeStruct<std::initializer_list<StorageType>>(types, structType);
+}
+
+bool checkOffsets(const StructType& structType, const uint32_t* offsets,
+                  size_t numOffsets, uint32_t size) {
+  CHECK(structType.fields_.length() == numOffsets);
+  for (uint32_t i = 0; i < numOffsets; i++) {
+    CHECK(structType.fieldOffset(i) == offsets[i]);
+  }
+  CHECK(structType.size_ == size);
+  return true;
+}
+
+// Check that the fields are naturally aligned, are within the struct, do not
+// overlap or cross the end of the inline area, and that every reference is in
+// the trace offsets of its area.
+bool checkLayout(const StructType& structType) {
+  const FieldTypeVector& fields = structType.fields_;
+  InlineTraceOffsetVector inlineOffsets;
+  OutlineTraceOffsetVector outlineOffsets;
+  for (uint32_t i = 0; i < fields.length(); i++) {
+    uint32_t offset = structType.fieldOffset(i);
+    uint32_t size = fields[i].type.size();
+    CHECK(offset % size == 0);
+    CHECK(offset + size <= structType.size_);
+    CHECK(offset >= WasmStructObject_MaxInlineBytes ||
+          offset + size <= WasmStructObject_MaxInlineBytes);
+
+    for (uint32_t j = 0; j < i; j++) {
+      uint32_t otherOffset = structType.fieldOffset(j);
+      CHECK(offset + size <= otherOffset ||
+            otherOffset + fields[j].type.size() <= offset);
+    }
+
+    if (fields[i].type.isRefRepr()) {
+      bool isOutline;
+      uint32_t areaOffset;
+      WasmStructObject::fieldOffsetToAreaAndOffset(fields[i].type, offset,
+                                                   &isOutline, &areaOffset);
+      CHECK(isOutline ? outlineOffsets.append(areaOffset)
+                      : inlineOffsets.append(areaOffset));
+    }
+  }
+
+  CHECK(structType.inlineTraceOffsets_.length() == inlineOffsets.length());
+  for (size_t i = 0; i < inlineOffsets.length(); i++) {
+    CHECK(structType.inlineTraceOffsets_[i] == inlineOffsets[i]);
+  }
+  CHECK(structType.outlineTraceOffsets_.length() == outlineOffsets.length());
+  for (size_t i = 0; i < outlineOffsets.length(); i++) {
+    CHECK(structType.outlineTraceOffsets_[i] == outlineOffsets[i]);
+  }
+  return true;
+}
+END_TEST(testWasmStructLayout)
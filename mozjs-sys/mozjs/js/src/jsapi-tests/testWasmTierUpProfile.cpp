@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/ScopeExit.h"
+
+#include "js/WasmModule.h"  // JS::*WasmTierUpProfile*
+#include "jsapi-tests/testWasmModules.h"
+#include "jsapi-tests/tests.h"
+
+#include "wasm/WasmCode.h"
+#include "wasm/WasmFeatures.h"  // HasSupport, BaselineAvailable, IonAvailable
+#include "wasm/WasmModule.h"
+
+using namespace js;
+using namespace js::wasm;
+
+// The functions of a lazily tiered module which were requested to tier up are
+// requested again when the same module is compiled with their profile
+// registered. Function indices which are not those of a function defined by
+// the module are ignored.
+BEGIN_TEST(testWasmTierUpProfile_RoundTrip) {
+  if (!HasSupport(cx) || !BaselineAvailable(cx) || !IonAvailable(cx)) {
+    return true;
+  }
+  auto clearProfiles =
+      mozilla::MakeScopeExit([] { JS::ClearWasmTierUpProfiles(); });
+
+  SharedModule first = CompileTestModule(cx, CallImportModule);
+  CHECK(first);
+  const Module& module = *first;
+
+  // Lazy tiering is disabled by prefs, or by a lack of helper threads.
+  if (module.code().mode() != CompileMode::LazyTiering) {
+    return true;
+  }
+
+  // Nothing was requested to tier up yet.
+  uint32_t hash;
+  JS::WasmTierUpProfile profile;
+  CHECK(JS::GetWasmTierUpProfile(*first, &hash, profile));
+  CHECK(profile.empty());
+
+  // Function 0 is the import, and function 1 the one defined by the module.
+  CHECK(module.code().requestTierUp(1));
+  CHECK(JS::GetWasmTierUpProfile(*first, &hash, profile));
+  CHECK(profile.length() == 1);
+  CHECK(profile[0] == 1);
+
+  // Register the profile with an imported and an out-of-range function.
+  JS::WasmTierUpProfile registered;
+  CHECK(registered.append(0));
+  CHECK(registered.append(1));
+  CHECK(registered.append(7));
+  CHECK(JS::SetWasmTierUpProfile(hash, registered));
+
+  // The same module compiled again has the same key, and function 1 was
+  // requested to tier up by finishModule.
+  SharedModule second = CompileTestModule(cx, CallImportModule);
+  CHECK(second);
+  uint32_t secondHash;
+  JS::WasmTierUpProfile secondProfile;
+  CHECK(JS::GetWasmTierUpProfile(*second, &secondHash, secondProfile));
+  CHECK(secondHash == hash);
+  CHECK(secondProfile.length() == 1);
+  CHECK(secondProfile[0] == 1);
+
+  // Nothing is requested once the profiles are cleared.
+  JS::ClearWasmTierUpProfiles();
+  SharedModule third = CompileTestModule(cx, CallImportModule);
+  CHECK(third);
+  uint32_t thirdHash;
+  JS::WasmTierUpProfile thirdProfile;
+  CHECK(JS::GetWasmTierUpProfile(*third, &thirdHash, thirdProfile));
+  CHECK(thirdHash == hash);
+  CHECK(thirdProfile.empty());
+  return true;
+}
+END_TEST(testWasmTierUpProfile_RoundTrip)
@@ -21,6 +21,7 @@
 
 JSAPIRuntimeTest* JSAPIRuntimeTest::list;
 JSAPIFrontendTest* JSAPIFrontendTest::list;
+JSAPIProcessInit* JSAPIProcessInit::list;
 
 bool JSAPIRuntimeTest::init(JSContext* maybeReusableContext) {
   if (maybeReusableContext && reuseGlobal) {
@@ -241,6 +242,14 @@ int main(int argc, char* argv[]) {
       printf("TEST-UNEXPECTED-FAIL | jsapi-tests | JS_Init() failed.\n");
       return 1;
     }
+    for (JSAPIProcessInit* init = JSAPIProcessInit::list; init;
+         init = init->next) {
+      if (!init->run()) {
+        printf("TEST-UNEXPECTED-FAIL | jsapi-tests | %s failed.\n",
+               init->name());
+        return 1;
+      }
+    }
   } else {
     if (!JS_FrontendOnlyInit()) {
       printf("TEST-UNEXPECTED-FAIL | jsapi-tests | JS_Init() failed.\n");
@@ -633,4 +633,42 @@ class AutoLeaveZeal {
 };
 #endif
 
+/*
+ * A process init hook runs once, in main() right after JS_Init and before any
+ * test. It is for process-wide setup that must be done before anything uses
+ * the engine, such as registering natives with JS::RegisterWasmBuiltinNatives.
+ * Hooks are not run with --frontend-only.
+ *
+ *   BEGIN_PROCESS_INIT(registerNatives) {
+ *     return JS::RegisterWasmBuiltinNatives(natives, std::size(natives));
+ *   }
+ *   END_PROCESS_INIT(registerNatives)
+ */
+class JSAPIProcessInit {
+ public:
+  static JSAPIProcessInit* list;
+  JSAPIProcessInit* next;
+
+  JSAPIProcessInit() {
+    next = list;
+    list = this;
+  }
+
+  virtual ~JSAPIProcessInit() {}
+
+  virtual const char* name() = 0;
+  virtual bool run() = 0;
+};
+
+#define BEGIN_PROCESS_INIT(initname)                          \
+  class cls_##initname : public JSAPIProcessInit {            \
+   public:                                                    \
+    virtual const char* name() override { return #initname; } \
+    virtual bool run() override
+
+#define END_PROCESS_INIT(initname) \
+  }                                \
+  ;                                \
+  MOZ_RUNINIT static cls_##initname cls_##initname##_instance;
+
 #endif /* jsapi_tests_tests_h */
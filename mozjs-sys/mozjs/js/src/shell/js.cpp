@@ -126,7 +126,7 @@
 #include "js/Exception.h"                   // JS::StealPendingExceptionStack
 #include "js/experimental/BindingAllocs.h"  // JS_NewObjectWithGivenProtoAndUseAllocSite
 #include "js/experimental/CodeCoverage.h"   // js::EnableCodeCoverage
-#include "js/experimental/CompileScript.h"  // JS::NewFrontendContext, JS::DestroyFrontendContext, JS::HadFrontendErrors, JS::ConvertFrontendErrorsToRuntimeErrors, JS::CompileGlobalScriptToStencil, JS::CompileModuleScriptToStencil
+#include "js/experimental/CompileScript.h"  // JS::NewFrontendContext, JS::DestroyFrontendContext, JS::HadFrontendErrors, JS::ConvertFrontendErrorsToRuntimeErrors, JS::CompileGlobalScriptToStencil, JS::CompileModuleScriptToStencil, JS::EnableSharedParserAtoms
 #include "js/experimental/CTypes.h"         // JS::InitCTypesClass
 #include "js/experimental/Intl.h"  // JS::AddMoz{DateTimeFormat,DisplayNames}Constructor
 #include "js/experimental/JitInfo.h"  // JSJit{Getter,Setter,Method}CallArgs, JSJitGetterInfo, JSJit{Getter,Setter}Op, JSJitInfo
@@ -135,6 +135,7 @@
 #include "js/experimental/TypedData.h"   // JS_NewUint8Array
 #include "js/friend/DumpFunctions.h"     // JS::FormatStackDump
 #include "js/friend/ErrorMessages.h"     // js::GetErrorMessage, JSMSG_*
+#include "js/friend/SourceCompression.h"  // js::SetSourceCompressionCodec
 #include "js/friend/StackLimits.h"       // js::AutoCheckRecursionLimit
 #include "js/friend/WindowProxy.h"  // js::IsWindowProxy, js::SetWindowProxyClass, js::ToWindowProxyIfWindow, js::ToWindowIfWindowProxy
 #include "js/GCAPI.h"               // JS::AutoCheckCannotGC
@@ -12571,6 +12572,15 @@ bool InitOptionParser(OptionParser& op) {
                        "The maximum bytecode length of a 'small function' for "
                        "the purpose of inlining.",
                        -1) ||
+      !op.addIntOption('\0', "polymorphic-inlining-max-targets", "COUNT",
+                       "The maximum number of targets of a polymorphic call "
+                       "that can be trial-inlined (0 to disable).",
+                       -1) ||
+      !op.addIntOption('\0', "ion-compile-preemption-ms", "MS",
+                       "How long an off-thread Ion compilation can run before "
+                       "it may be cancelled in favor of a hotter script (0 to "
+                       "disable).",
+                       -1) ||
       !op.addBoolOption('\0', "only-inline-selfhosted",
                         "Only inline selfhosted functions") ||
       !op.addBoolOption('\0', "no-asmjs", "Disable asm.js compilation") ||
@@ -12652,6 +12662,9 @@ bool InitOptionParser(OptionParser& op) {
                           "Use shared stubs (default: on, off to disable)") ||
       !op.addStringOption('\0', "ion-scalar-replacement", "on/off",
                           "Scalar Replacement (default: on, off to disable)") ||
+      !op.addStringOption('\0', "ion-partial-escape", "on/off",
+                          "Scalar replace objects which only escape on exit "
+                          "paths (default: on, off to disable)") ||
       !op.addStringOption('\0', "ion-gvn", "[mode]",
                           "Specify Ion global value numbering:\n"
                           "  off: disable GVN\n"
@@ -12929,9 +12942,24 @@ bool InitOptionParser(OptionParser& op) {
           '\0', "delazification-mode", "[option]",
           "Select one of the delazification mode for scripts given on the "
           "command line, valid options are: "
-          "'on-demand', 'concurrent-df', 'eager', 'concurrent-df+on-demand'. "
-          "Choosing 'concurrent-df+on-demand' will run both concurrent-df and "
-          "on-demand delazification mode, and compare compilation outcome. ") ||
+          "'on-demand', 'concurrent-df', 'eager', 'parallel', "
+          "'profile-guided', 'concurrent-df+on-demand'. Choosing 'parallel' "
+          "will delazify all functions before running the script, using "
+          "--thread-count helper threads. Choosing 'profile-guided' will "
+          "delazify the functions in the order of their first call, as "
+          "recorded by a previous execution. Choosing "
+          "'concurrent-df+on-demand' will run both "
+          "concurrent-df and on-demand delazification mode, and compare "
+          "compilation outcome. ") ||
+      !op.addStringOption('\0', "source-compression", "[zlib|lz4]",
+                          "Select the codec used to compress the source text "
+                          "of scripts (default: zlib)") ||
+      !op.addBoolOption('\0', "bytecode-peephole",
+                        "Rewrite some instruction sequences of the emitted "
+                        "bytecode into cheaper ones") ||
+      !op.addBoolOption('\0', "shared-parser-atoms",
+                        "Share the atoms interned by the parser between all "
+                        "compilations of the process") ||
       !op.addBoolOption('\0', "wasm-compile-and-serialize",
                         "Compile the wasm bytecode from stdin and serialize "
                         "the results to stdout") ||
@@ -13305,7 +13333,8 @@ bool SetContextOptions(JSContext* cx, const OptionParser& op) {
       .setSourcePragmas(enableSourcePragmas)
       .setAsyncStack(enableAsyncStacks)
       .setAsyncStackCaptureDebuggeeOnly(enableAsyncStackCaptureDebuggeeOnly)
-      .setImportAttributes(enableImportAttributes);
+      .setImportAttributes(enableImportAttributes)
+      .setBytecodePeephole(op.getBoolOption("bytecode-peephole"));
 
   if (const char* str = op.getStringOption("shared-memory")) {
     if (strcmp(str, "off") == 0) {
@@ -13333,6 +13362,11 @@ bool SetContextOptions(JSContext* cx, const OptionParser& op) {
     } else if (strcmp(mode, "eager") == 0) {
       defaultDelazificationMode =
           JS::DelazificationOption::ParseEverythingEagerly;
+    } else if (strcmp(mode, "parallel") == 0) {
+      defaultDelazificationMode = JS::DelazificationOption::ParallelFullParse;
+    } else if (strcmp(mode, "profile-guided") == 0) {
+      defaultDelazificationMode =
+          JS::DelazificationOption::ConcurrentProfileGuided;
     } else if (strcmp(mode, "concurrent-df+on-demand") == 0 ||
                strcmp(mode, "on-demand+concurrent-df") == 0) {
       defaultDelazificationMode =
@@ -13342,6 +13376,22 @@ bool SetContextOptions(JSContext* cx, const OptionParser& op) {
     }
   }
 
+  if (const char* codec = op.getStringOption("source-compression")) {
+    if (strcmp(codec, "zlib") == 0) {
+      js::SetSourceCompressionCodec(cx, js::SourceCompressionCodec::Zlib);
+    } else if (strcmp(codec, "lz4") == 0) {
+      js::SetSourceCompressionCodec(cx, js::SourceCompressionCodec::LZ4);
+    } else {
+      return OptionFailure("source-compression", codec);
+    }
+  }
+
+  if (op.getBoolOption("shared-parser-atoms")) {
+    if (!JS::EnableSharedParserAtoms()) {
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -13501,6 +13551,16 @@ bool SetContextJITOptions(JSContext* cx, const OptionParser& op) {
     }
   }
 
+  if (const char* str = op.getStringOption("ion-partial-escape")) {
+    if (strcmp(str, "on") == 0) {
+      jit::JitOptions.disablePartialEscapeAnalysis = false;
+    } else if (strcmp(str, "off") == 0) {
+      jit::JitOptions.disablePartialEscapeAnalysis = true;
+    } else {
+      return OptionFailure("ion-partial-escape", str);
+    }
+  }
+
   if (op.getStringOption("ion-shared-stubs")) {
     // Dead option, preserved for now for potential fuzzer interaction.
   }
@@ -13776,6 +13836,18 @@ bool SetContextJITOptions(JSContext* cx, const OptionParser& op) {
     jit::JitOptions.smallFunctionMaxBytecodeLength = smallFunctionLength;
   }
 
+  int32_t polymorphicInliningMaxTargets =
+      op.getIntOption("polymorphic-inlining-max-targets");
+  if (polymorphicInliningMaxTargets >= 0) {
+    jit::JitOptions.polymorphicInliningMaxTargets =
+        polymorphicInliningMaxTargets;
+  }
+
+  int32_t ionCompilePreemptionMs = op.getIntOption("ion-compile-preemption-ms");
+  if (ionCompilePreemptionMs >= 0) {
+    jit::JitOptions.ionCompilePreemptionMs = ionCompilePreemptionMs;
+  }
+
   if (op.getBoolOption("ion-eager")) {
     jit::JitOptions.setEagerIonCompilation();
   }
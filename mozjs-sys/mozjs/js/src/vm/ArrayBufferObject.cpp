@@ -177,16 +177,31 @@ void* js::MapBufferMemory(wasm::AddressType t, size_t mappedSize,
   MOZ_ASSERT(initialCommittedSize % gc::SystemPageSize() == 0);
   MOZ_ASSERT(initialCommittedSize <= mappedSize);
 
-  auto failed = mozilla::MakeScopeExit(
-      [&] { wasmReservedBytes -= uint64_t(mappedSize); });
+#if !defined(XP_WIN) && !defined(__wasi__)
+  void* pooled = wasm::TakePooledMemory(mappedSize);
+#else
+  void* pooled = nullptr;
+#endif
+
+  auto failed = mozilla::MakeScopeExit([&] {
+    wasmReservedBytes -= uint64_t(mappedSize);
+#if !defined(XP_WIN) && !defined(__wasi__)
+    if (pooled) {
+      munmap(pooled, mappedSize);
+    }
+#endif
+  });
   wasmReservedBytes += uint64_t(mappedSize);
 
   // Test >= to guard against the case where multiple extant runtimes
-  // race to allocate.
-  if (wasmReservedBytes >= WasmReservedBytesMax) {
+  // race to allocate. Pooled reservations count against the limit, but are
+  // released before giving up, including those of the buffers freed by
+  // OnLargeAllocationFailure.
+  if (wasmReservedBytes + wasm::PooledMemoryBytes() >= WasmReservedBytesMax) {
     if (OnLargeAllocationFailure) {
       OnLargeAllocationFailure();
     }
+    wasm::ReleasePooledMemory();
     if (wasmReservedBytes >= WasmReservedBytesMax) {
       return nullptr;
     }
@@ -214,16 +229,21 @@ void* js::MapBufferMemory(wasm::AddressType t, size_t mappedSize,
   MOZ_ASSERT(data);
   memset(data, 0, mappedSize);
 #else   // !XP_WIN && !__wasi__
-  void* data =
-      MozTaggedAnonymousMmap(nullptr, mappedSize, PROT_NONE,
-                             MAP_PRIVATE | MAP_ANON, -1, 0, "wasm-reserved");
-  if (data == MAP_FAILED) {
-    return nullptr;
+  void* data = pooled;
+  if (!data) {
+    data = MozTaggedAnonymousMmap(nullptr, mappedSize, PROT_NONE,
+                                  MAP_PRIVATE | MAP_ANON, -1, 0,
+                                  "wasm-reserved");
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
   }
 
   // Note we will waste a page on zero-sized memories here
   if (mprotect(data, initialCommittedSize, PROT_READ | PROT_WRITE)) {
-    munmap(data, mappedSize);
+    if (!pooled) {
+      munmap(data, mappedSize);
+    }
     return nullptr;
   }
 
@@ -280,7 +300,9 @@ void js::UnmapBufferMemory(wasm::AddressType t, void* base, size_t mappedSize,
   free(base);
   (void)committedSize;
 #else
-  munmap(base, mappedSize);
+  if (!wasm::PoolReleasedMemory(base, mappedSize, committedSize)) {
+    munmap(base, mappedSize);
+  }
   gc::RecordMemoryFree(committedSize);
 #endif  // XP_WIN
 
@@ -36,6 +36,7 @@
 #include "util/CompleteFile.h"     // js::FileContents, js::ReadCompleteFile
 #include "util/Identifier.h"       // js::IsIdentifier
 #include "util/StringBuilder.h"    // js::StringBuilder
+#include "vm/ConcurrentDelazification.h"  // js::HashSourceTextForDelazificationProfile
 #include "vm/EnvironmentObject.h"  // js::CreateNonSyntacticEnvironmentChain
 #include "vm/ErrorReporting.h"  // js::ErrorMetadata, js::ReportCompileErrorLatin1
 #include "vm/Interpreter.h"     // js::Execute
@@ -230,6 +231,29 @@ JS_PUBLIC_API bool JS::FinishCollectingDelazifications(
   return ::FinishCollectingDelazifications(cx, sso, buffer);
 }
 
+JS_PUBLIC_API bool JS::GetDelazificationProfile(
+    JSContext* cx, JS::Handle<JSScript*> script, uint32_t* sourceHash,
+    JS::DelazificationProfile& profile) {
+  profile.clear();
+
+  ScriptSourceObject* sso = script->sourceObject();
+  if (!HashSourceTextForDelazificationProfile(cx, sso->source(), sourceHash)) {
+    return false;
+  }
+
+  RefPtr<frontend::InitialStencilAndDelazifications> stencils =
+      sso->maybeGetStencils();
+  if (!stencils) {
+    return true;
+  }
+
+  if (!stencils->getFirstCalls(profile)) {
+    ReportOutOfMemory(cx);
+    return false;
+  }
+  return true;
+}
+
 JS_PUBLIC_API void JS::AbortCollectingDelazifications(JS::HandleScript script) {
   if (!script) {
     return;
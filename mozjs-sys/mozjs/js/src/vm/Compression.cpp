@@ -6,24 +6,31 @@
 
 #include "vm/Compression.h"
 
+#include "mozilla/Compression.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/MemoryChecking.h"
 #include "mozilla/PodOperations.h"
 #include "mozilla/ScopeExit.h"
 
+#include <algorithm>
+
 #include "js/Utility.h"
 #include "util/Memory.h"
 
 using namespace js;
 
+using mozilla::Compression::LZ4;
+
 static void* zlib_alloc(void* cx, uInt items, uInt size) {
   return js_calloc(items, size);
 }
 
 static void zlib_free(void* cx, void* addr) { js_free(addr); }
 
-Compressor::Compressor(const unsigned char* inp, size_t inplen)
-    : inp(inp),
+Compressor::Compressor(const unsigned char* inp, size_t inplen,
+                       SourceCompressionCodec codec)
+    : codec(codec),
+      inp(inp),
       inplen(inplen),
       initialized(false),
       finished(false),
@@ -69,6 +76,10 @@ bool Compressor::init() {
   if (inplen >= UINT32_MAX) {
     return false;
   }
+  if (codec == SourceCompressionCodec::LZ4) {
+    // LZ4 keeps no state across chunks.
+    return true;
+  }
   // zlib is slow and we'd rather be done compression sooner
   // even if it means decompression is slower which penalizes
   // Function.toString()
@@ -97,6 +108,10 @@ void Compressor::setOutput(unsigned char* out, size_t outlen) {
 
 Compressor::Status Compressor::compressMore() {
   MOZ_ASSERT(zs.next_out);
+  if (codec == SourceCompressionCodec::LZ4) {
+    return compressMoreLZ4();
+  }
+
   uInt left = inplen - (zs.next_in - inp);
   if (left <= MAX_INPUT_SIZE) {
     zs.avail_in = left;
@@ -151,6 +166,33 @@ Compressor::Status Compressor::compressMore() {
   return done ? DONE : CONTINUE;
 }
 
+Compressor::Status Compressor::compressMoreLZ4() {
+  size_t left = inplen - (zs.next_in - inp);
+  size_t chunkBytes = std::min(left, CHUNK_SIZE);
+  MOZ_ASSERT(chunkBytes == chunkSize(inplen, chunkOffsets.length()));
+
+  size_t written = LZ4::compressLimitedOutput(
+      reinterpret_cast<const char*>(zs.next_in), chunkBytes,
+      reinterpret_cast<char*>(zs.next_out), zs.avail_out);
+  if (written == 0) {
+    // The chunk did not fit in the remaining output, compress it again once
+    // the output buffer got resized.
+    return MOREOUTPUT;
+  }
+
+  zs.next_in += chunkBytes;
+  zs.next_out += written;
+  zs.avail_out -= written;
+  outbytes += written;
+  if (!chunkOffsets.append(outbytes)) {
+    return OOM;
+  }
+
+  bool done = chunkBytes == left;
+  MOZ_ASSERT_IF(done, chunkOffsets.length() == (inplen - 1) / CHUNK_SIZE + 1);
+  return done ? DONE : CONTINUE;
+}
+
 size_t Compressor::totalBytesNeeded() const {
   return AlignBytes(outbytes, sizeof(uint32_t)) + sizeOfChunkOffsets();
 }
@@ -161,6 +203,10 @@ void Compressor::finish(char* dest, size_t destBytes) {
   CompressedDataHeader* compressedHeader =
       reinterpret_cast<CompressedDataHeader*>(dest);
   compressedHeader->compressedBytes = outbytes;
+  compressedHeader->codec = codec;
+
+  // Zero the padding bytes of the header, for the same reason as below.
+  mozilla::PodArrayZero(compressedHeader->padding);
 
   size_t outbytesAligned = AlignBytes(outbytes, sizeof(uint32_t));
 
@@ -224,6 +270,18 @@ bool js::DecompressStringChunk(const unsigned char* inp, size_t chunk,
   MOZ_ASSERT(compressedStart < compressedEnd);
   MOZ_ASSERT(compressedEnd <= compressedBytes);
 
+  if (header->codec == SourceCompressionCodec::LZ4) {
+    size_t decompressedBytes;
+    bool ok = LZ4::decompress(
+        reinterpret_cast<const char*>(inp + compressedStart),
+        compressedEnd - compressedStart, reinterpret_cast<char*>(out), outlen,
+        &decompressedBytes);
+    MOZ_RELEASE_ASSERT(ok);
+    MOZ_RELEASE_ASSERT(decompressedBytes == outlen);
+    return true;
+  }
+  MOZ_ASSERT(header->codec == SourceCompressionCodec::Zlib);
+
   bool lastChunk = compressedEnd == compressedBytes;
 
   // Mark the memory we pass to zlib as initialized for MSan.
@@ -12,12 +12,17 @@
 #include "jstypes.h"
 
 #include "js/AllocPolicy.h"
+#include "js/friend/SourceCompression.h"  // js::SourceCompressionCodec
 #include "js/Vector.h"
 
 namespace js {
 
 struct CompressedDataHeader {
   uint32_t compressedBytes;
+
+  // The codec which compressed the chunks following this header.
+  SourceCompressionCodec codec;
+  uint8_t padding[3];
 };
 
 class Compressor {
@@ -30,6 +35,11 @@ class Compressor {
   // Number of bytes we should hand to zlib each compressMore() call.
   static constexpr size_t MAX_INPUT_SIZE = 2 * 1024;
 
+  // With LZ4, every chunk is compressed independently by a single
+  // compressMore() call, and only the next_in, next_out and avail_out cursors
+  // of |zs| are used.
+  SourceCompressionCodec codec;
+
   z_stream zs;
   const unsigned char* inp;
   size_t inplen;
@@ -48,7 +58,13 @@ class Compressor {
  public:
   enum Status { MOREOUTPUT, DONE, CONTINUE, OOM };
 
-  Compressor(const unsigned char* inp, size_t inplen);
+ private:
+  Status compressMoreLZ4();
+
+ public:
+
+  Compressor(const unsigned char* inp, size_t inplen,
+             SourceCompressionCodec codec = SourceCompressionCodec::Zlib);
   ~Compressor();
   bool init();
   void setOutput(unsigned char* out, size_t outlen);
@@ -103,9 +119,10 @@ bool DecompressString(const unsigned char* inp, size_t inplen,
                       unsigned char* out, size_t outlen);
 
 /*
- * Decompress a single chunk of at most Compressor::CHUNK_SIZE bytes.
- * |chunk| is the chunk index. The caller must know the length of the output
- * (the uncompressed chunk) and allocate |out| to a string of that length.
+ * Decompress a single chunk of at most Compressor::CHUNK_SIZE bytes, with the
+ * codec recorded in the CompressedDataHeader of |inp|. |chunk| is the chunk
+ * index. The caller must know the length of the output (the uncompressed
+ * chunk) and allocate |out| to a string of that length.
  */
 bool DecompressStringChunk(const unsigned char* inp, size_t chunk,
                            unsigned char* out, size_t outlen);
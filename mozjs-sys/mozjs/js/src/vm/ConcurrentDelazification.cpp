@@ -7,12 +7,16 @@
 #include "vm/ConcurrentDelazification.h"
 
 #include "mozilla/Assertions.h"       // MOZ_ASSERT, MOZ_CRASH
+#include "mozilla/HashFunctions.h"    // mozilla::HashBytes
 #include "mozilla/RefPtr.h"           // RefPtr
 #include "mozilla/ReverseIterator.h"  // mozilla::Reversed
 #include "mozilla/ScopeExit.h"        // mozilla::MakeScopeExit
+#include "mozilla/Utf8.h"             // mozilla::Utf8Unit
 
-#include <stddef.h>  // size_t
-#include <utility>   // std::swap, std::move, std::pair
+#include <algorithm>   // std::push_heap, std::pop_heap
+#include <functional>  // std::greater
+#include <stddef.h>    // size_t
+#include <utility>     // std::swap, std::move, std::pair
 
 #include "ds/LifoAlloc.h"  // LifoAlloc
 #include "frontend/BytecodeCompiler.h"  // DelazifyCanonicalScriptedFunction, DelazifyFailureReason
@@ -22,7 +26,9 @@
 #include "frontend/Stencil.h"  // TaggedScriptThingIndex, ScriptStencilExtra
 #include "js/AllocPolicy.h"    // ReportOutOfMemory
 #include "js/experimental/JSStencil.h"  // RefPtrTraits<JS::Stencil>
-#include "vm/JSContext.h"               // JSContext
+#include "vm/HelperThreadState.h"  // HelperThreadState, AutoLockHelperThreadState
+#include "vm/JSContext.h"          // JSContext
+#include "vm/JSScript.h"           // ScriptSource, UncompressedSourceCache
 
 using namespace js;
 
@@ -141,6 +147,157 @@ bool LargeFirstDelazification::insert(ScriptIndex index,
   return true;
 }
 
+bool ProfileGuidedDelazification::init(FrontendContext* fc,
+                                       ScriptSource* source, bool* found) {
+  *found = false;
+
+  // Avoid hashing the source text when no profile got registered.
+  {
+    AutoLockHelperThreadState lock;
+    if (HelperThreadState().delazificationProfiles(lock).empty()) {
+      return true;
+    }
+  }
+
+  HashNumber hash;
+  if (!HashSourceTextForDelazificationProfile(nullptr, source, &hash)) {
+    return true;
+  }
+
+  JS::DelazificationProfile profile;
+  {
+    AutoLockHelperThreadState lock;
+    auto& profiles = HelperThreadState().delazificationProfiles(lock);
+    auto p = profiles.lookup(hash);
+    if (!p) {
+      return true;
+    }
+    if (!profile.appendAll(p->value())) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+  }
+
+  if (!ranks.reserve(profile.length())) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+  for (size_t i = 0; i < profile.length(); i++) {
+    // The profile is provided by the embedder, and might list a function more
+    // than once. Only its first call matters.
+    const JS::DelazificationProfileEntry& entry = profile[i];
+    auto p = ranks.lookupForAdd(entry.sourceStart);
+    if (p) {
+      continue;
+    }
+    if (!ranks.add(p, entry.sourceStart,
+                   std::pair(entry.sourceEnd, Rank(i)))) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+  }
+
+  *found = true;
+  return true;
+}
+
+DelazifyStrategy::ScriptIndex ProfileGuidedDelazification::next() {
+  std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+  return heap.popCopy().second;
+}
+
+bool ProfileGuidedDelazification::insert(ScriptIndex index,
+                                         frontend::ScriptStencilRef& ref) {
+  const SourceExtent& extent = ref.scriptExtra().extent;
+  auto p = ranks.lookup(extent.sourceStart);
+  if (!p || p->value().first != extent.sourceEnd) {
+    // This function is not expected to be called.
+    return true;
+  }
+
+  if (!heap.append(std::pair(p->value().second, index))) {
+    return false;
+  }
+  std::push_heap(heap.begin(), heap.end(), std::greater<>());
+  return true;
+}
+
+template <typename Unit>
+static HashNumber HashSourceUnits(const Unit* units, size_t length) {
+  return mozilla::HashBytes(units, length * sizeof(Unit));
+}
+
+template <typename Unit>
+static bool HashSourceText(JSContext* maybeCx, ScriptSource* source,
+                           HashNumber* hash) {
+  size_t length = source->length();
+  if (maybeCx) {
+    UncompressedSourceCache::AutoHoldEntry holder;
+    ScriptSource::PinnedUnits<Unit> units(maybeCx, source, holder, 0, length);
+    if (!units.get()) {
+      return false;
+    }
+    *hash = HashSourceUnits(units.get(), length);
+    return true;
+  }
+
+  ScriptSource::PinnedUnitsIfUncompressed<Unit> units(source, 0, length);
+  if (!units.get()) {
+    return false;
+  }
+  *hash = HashSourceUnits(units.get(), length);
+  return true;
+}
+
+bool js::HashSourceTextForDelazificationProfile(JSContext* maybeCx,
+                                                ScriptSource* source,
+                                                HashNumber* hash) {
+  if (!source->hasSourceText()) {
+    if (maybeCx) {
+      JS_ReportErrorASCII(maybeCx, "Source text is not available");
+    }
+    return false;
+  }
+
+  if (source->hasSourceType<mozilla::Utf8Unit>()) {
+    return HashSourceText<mozilla::Utf8Unit>(maybeCx, source, hash);
+  }
+
+  MOZ_ASSERT(source->hasSourceType<char16_t>());
+  return HashSourceText<char16_t>(maybeCx, source, hash);
+}
+
+bool ParallelDelazificationWorklist::init(
+    FrontendContext* fc, const frontend::CompilationStencil& initial) {
+  // Collect the functions to delazify with the same traversal as the
+  // concurrent delazification, which already orders them by size.
+  LargeFirstDelazification largeFirst;
+  ScriptIndex topLevel{0};
+  if (!largeFirst.add(fc, initial, topLevel)) {
+    return false;
+  }
+
+  if (!functions_.reserve(largeFirst.heap.length())) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+  while (!largeFirst.done()) {
+    functions_.infallibleAppend(largeFirst.next());
+  }
+
+  return true;
+}
+
+bool ParallelDelazificationWorklist::next(ScriptIndex* index) {
+  size_t i = next_++;
+  if (i >= functions_.length()) {
+    return false;
+  }
+
+  *index = functions_[i];
+  return true;
+}
+
 bool DelazificationContext::init(
     const JS::ReadOnlyCompileOptions& options,
     frontend::InitialStencilAndDelazifications* stencils) {
@@ -180,6 +337,33 @@ bool DelazificationContext::init(
       // largest function first.
       strategy_ = fc_.getAllocator()->make_unique<LargeFirstDelazification>();
       break;
+    case JS::DelazificationOption::ParallelFullParse:
+      // ParallelFullParse hands out the functions of the top-level script
+      // through a ParallelDelazificationWorklist, and visits their inner
+      // functions depth first.
+      strategy_ = fc_.getAllocator()->make_unique<DepthFirstDelazification>();
+      return !!strategy_;
+    case JS::DelazificationOption::ConcurrentProfileGuided: {
+      // ConcurrentProfileGuided visit the functions listed by the profile
+      // registered for the source text, in the order of their first call.
+      // Without a profile, it visits all functions depth first.
+      auto profileGuided =
+          fc_.getAllocator()->make_unique<ProfileGuidedDelazification>();
+      if (!profileGuided) {
+        return false;
+      }
+      bool found;
+      if (!profileGuided->init(&fc_, stencil.source, &found)) {
+        return false;
+      }
+      if (found) {
+        strategy_ = std::move(profileGuided);
+      } else {
+        strategy_ =
+            fc_.getAllocator()->make_unique<DepthFirstDelazification>();
+      }
+      break;
+    }
     case JS::DelazificationOption::ParseEverythingEagerly:
       // ParseEverythingEagerly parse all functions eagerly, thus leaving no
       // functions to be parsed on demand.
@@ -264,6 +448,33 @@ bool DelazificationContext::delazify() {
   return true;
 }
 
+bool DelazificationContext::delazify(
+    ParallelDelazificationWorklist& worklist) {
+  using namespace js::frontend;
+  MOZ_ASSERT(done());
+
+  ScriptIndex index;
+  while (worklist.next(&index)) {
+    {
+      BorrowingCompilationStencil borrow(merger_.getResult());
+      ScriptStencilRef ref{borrow, index};
+      if (!strategy_->insert(index, ref)) {
+        ReportOutOfMemory(&fc_);
+        return false;
+      }
+    }
+
+    // Delazify the function and all its inner functions. Functions which are
+    // not delazified because of errors remain lazy and would be delazified
+    // on-demand.
+    if (!delazify()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool DelazificationContext::done() const {
   if (!strategy_) {
     return true;
@@ -7,6 +7,8 @@
 #ifndef vm_ConcurrentDelazification_h
 #define vm_ConcurrentDelazification_h
 
+#include "mozilla/Atomics.h"          // mozilla::Atomic
+#include "mozilla/HashFunctions.h"    // HashNumber
 #include "mozilla/MemoryReporting.h"  // mozilla::MallocSizeOf
 
 #include <stddef.h>  // size_t
@@ -17,12 +19,14 @@
 #include "js/AllocPolicy.h"               // SystemAllocPolicy
 #include "js/CompileOptions.h"  // JS::PrefableCompileOptions, JS::ReadOnlyCompileOptions
 #include "js/experimental/JSStencil.h"  // RefPtrTraits for InitialStencilAndDelazifications
+#include "js/HashTable.h"               // HashMap, DefaultHasher
 #include "js/UniquePtr.h"               // UniquePtr
 #include "js/Vector.h"                  // Vector
 
 namespace js {
 
 class FrontendContext;
+class ScriptSource;
 
 // Base class for implementing the various strategies to iterate over the
 // functions to be delazified, or to decide when to stop doing any
@@ -101,6 +105,75 @@ struct LargeFirstDelazification final : public DelazifyStrategy {
   bool insert(ScriptIndex, frontend::ScriptStencilRef&) override;
 };
 
+// Delazify the functions listed by an execution profile, in the order of their
+// first call during the execution which recorded the profile. Functions which
+// are not part of the profile are not delazified, as they are not expected to
+// be called.
+//
+// Inner functions can only be delazified after their enclosing function. As a
+// function is always called after its enclosing function, the inner functions
+// of the profile are inserted as their enclosing function gets delazified, and
+// only wait on functions with a lower rank.
+struct ProfileGuidedDelazification final : public DelazifyStrategy {
+  using Rank = uint32_t;
+
+  // Source end and rank within the profile of the functions to delazify,
+  // indexed by the start of their source range.
+  HashMap<uint32_t, std::pair<uint32_t, Rank>, DefaultHasher<uint32_t>,
+          SystemAllocPolicy>
+      ranks;
+
+  // Heap of the functions to delazify, with the lowest rank first.
+  Vector<std::pair<Rank, ScriptIndex>, 0, SystemAllocPolicy> heap;
+
+  // Look up the profile registered for the source text. Sets |found| to false
+  // if there is no profile, or if the source text is not available.
+  [[nodiscard]] bool init(FrontendContext* fc, ScriptSource* source,
+                          bool* found);
+
+  bool done() const override { return heap.empty(); }
+  ScriptIndex next() override;
+  void clear() override { return heap.clear(); }
+  bool insert(ScriptIndex, frontend::ScriptStencilRef&) override;
+};
+
+// Compute the hash of the source text, which is the key of the execution
+// profiles used by ProfileGuidedDelazification. Without a JSContext, this
+// returns false if the source text is compressed, otherwise this returns false
+// in case of errors reported on the context.
+[[nodiscard]] bool HashSourceTextForDelazificationProfile(JSContext* maybeCx,
+                                                          ScriptSource* source,
+                                                          HashNumber* hash);
+
+// The functions of the top-level script which have to be delazified by the
+// ParallelFullParse mode, ordered from the largest to the smallest. Each of
+// the threads participating in the parallel parse takes the next function from
+// this list, and delazifies it along with all its inner functions. Starting
+// with the largest functions keeps the threads busy until the end, as only
+// small functions remain to be distributed at that point.
+//
+// The function trees are independent, as the top-level script is already
+// compiled, thus each thread only needs the initial stencil as context.
+class ParallelDelazificationWorklist {
+  using ScriptIndex = frontend::ScriptIndex;
+  Vector<ScriptIndex, 0, SystemAllocPolicy> functions_;
+
+  // Index of the next function to hand out.
+  mozilla::Atomic<size_t> next_{0};
+
+ public:
+  ParallelDelazificationWorklist() = default;
+
+  [[nodiscard]] bool init(FrontendContext* fc,
+                          const frontend::CompilationStencil& initial);
+
+  size_t length() const { return functions_.length(); }
+
+  // Take the next function to delazify. Returns false once every function
+  // got handed out. This function is thread-safe.
+  bool next(ScriptIndex* index);
+};
+
 class DelazificationContext {
   const JS::PrefableCompileOptions initialPrefableOptions_;
 
@@ -131,6 +204,11 @@ class DelazificationContext {
             frontend::InitialStencilAndDelazifications* stencils);
   bool delazify();
 
+  // Delazify functions taken from the shared `worklist`, until it is empty.
+  // Used by the ParallelFullParse mode, where the DelazificationContext does
+  // not queue the functions of the top-level script when initialized.
+  bool delazify(ParallelDelazificationWorklist& worklist);
+
   // This function is called by `delazify` function to know whether the
   // delazification should be interrupted.
   //
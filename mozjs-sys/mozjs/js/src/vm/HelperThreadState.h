@@ -32,6 +32,7 @@
 #include "js/AllocPolicy.h"               // SystemAllocPolicy
 #include "js/CompileOptions.h"            // JS::ReadOnlyCompileOptions
 #include "js/experimental/JSStencil.h"  // JS::InstantiationStorage
+#include "js/HashTable.h"               // HashMap, HashNumber
 #include "js/HelperThreadAPI.h"         // JS::HelperThreadTaskCallback
 #include "js/MemoryMetrics.h"           // JS::GlobalStats
 #include "js/ProfilingStack.h"  // JS::RegisterThreadCallback, JS::UnregisterThreadCallback
@@ -40,7 +41,7 @@
 #include "js/Utility.h"                   // ThreadType
 #include "threading/ConditionVariable.h"  // ConditionVariable
 #include "threading/ProtectedData.h"      // WriteOnceData
-#include "vm/ConcurrentDelazification.h"  // DelazificationContext
+#include "vm/ConcurrentDelazification.h"  // DelazificationContext, ParallelDelazificationWorklist
 #include "vm/HelperThreads.h"  // AutoLockHelperThreadState, AutoUnlockHelperThreadState
 #include "vm/HelperThreadTask.h"             // HelperThreadTask
 #include "vm/JSContext.h"                    // JSContext
@@ -55,6 +56,9 @@ namespace js {
 
 struct DelazifyTask;
 struct FreeDelazifyTask;
+class ModuleGraphCompilation;
+struct ModuleGraphCompileTask;
+struct ParallelDelazifyTask;
 struct PromiseHelperTask;
 class PromiseObject;
 
@@ -69,6 +73,9 @@ namespace wasm {
 struct CompileTask;
 using CompileTaskPtrFifo = Fifo<CompileTask*, 0, SystemAllocPolicy>;
 
+struct ValidateTask;
+using ValidateTaskPtrVector = Vector<ValidateTask*, 0, SystemAllocPolicy>;
+
 struct CompleteTier2GeneratorTask : public HelperThreadTask {
   virtual ~CompleteTier2GeneratorTask() = default;
   virtual void cancel() = 0;
@@ -120,11 +127,20 @@ class GlobalHelperThreadState {
       Vector<jit::BaselineCompileTask*, 1, SystemAllocPolicy>;
   using IonCompileTaskVector =
       Vector<jit::IonCompileTask*, 0, SystemAllocPolicy>;
+  using HelperThreadTaskVector =
+      Vector<HelperThreadTask*, 0, SystemAllocPolicy>;
   using IonFreeTaskVector =
       Vector<js::UniquePtr<jit::IonFreeTask>, 0, SystemAllocPolicy>;
   using DelazifyTaskList = mozilla::LinkedList<DelazifyTask>;
   using FreeDelazifyTaskVector =
       Vector<js::UniquePtr<FreeDelazifyTask>, 1, SystemAllocPolicy>;
+  using ParallelDelazifyTaskVector =
+      Vector<ParallelDelazifyTask*, 0, SystemAllocPolicy>;
+  using ModuleGraphCompileTaskVector =
+      Vector<ModuleGraphCompileTask*, 0, SystemAllocPolicy>;
+  using DelazificationProfileMap =
+      HashMap<HashNumber, JS::DelazificationProfile, DefaultHasher<HashNumber>,
+              SystemAllocPolicy>;
   using SourceCompressionTaskVector =
       Vector<UniquePtr<SourceCompressionTask>, 0, SystemAllocPolicy>;
   using PromiseHelperTaskVector =
@@ -159,6 +175,7 @@ class GlobalHelperThreadState {
   wasm::CompileTaskPtrFifo wasmWorklist_tier2_;
   wasm::CompleteTier2GeneratorTaskPtrVector wasmCompleteTier2GeneratorWorklist_;
   wasm::PartialTier2CompileTaskPtrVector wasmPartialTier2CompileWorklist_;
+  wasm::ValidateTaskPtrVector wasmValidateWorklist_;
 
   // Count of finished CompleteTier2Generator tasks.
   uint32_t wasmCompleteTier2GeneratorsFinished_;
@@ -180,6 +197,21 @@ class GlobalHelperThreadState {
   // risk.
   FreeDelazifyTaskVector freeDelazifyTaskVector_;
 
+  // Tasks helping a ParallelFullParse compilation. These are owned by the
+  // compiling thread, which removes the ones which did not start before it
+  // finished, see DelazifyInParallel.
+  ParallelDelazifyTaskVector parallelDelazifyWorklist_;
+
+  // Tasks helping CompileModuleGraphToStencils. These are owned by the
+  // ModuleGraphCompilation, which removes the ones which did not start before
+  // the graph got compiled.
+  ModuleGraphCompileTaskVector moduleGraphWorklist_;
+
+  // Execution profiles used by the ConcurrentProfileGuided delazification
+  // mode, keyed by the hash of the source text they were recorded for. See
+  // JS::SetDelazificationProfile.
+  DelazificationProfileMap delazificationProfiles_;
+
   // Source compression worklist of tasks that we do not yet know can start.
   SourceCompressionTaskVector compressionPendingList_;
 
@@ -193,8 +225,6 @@ class GlobalHelperThreadState {
   // GCRuntime before being dispatched to the helper thread system.
   GCParallelTaskList gcParallelWorklist_;
 
-  using HelperThreadTaskVector =
-      Vector<HelperThreadTask*, 0, SystemAllocPolicy>;
   // Vector of running HelperThreadTask.
   // This is used to get the HelperThreadTask that are currently running.
   HelperThreadTaskVector helperTasks_;
@@ -231,6 +261,8 @@ class GlobalHelperThreadState {
   size_t maxWasmPartialTier2CompileThreads() const;
   size_t maxPromiseHelperThreads() const;
   size_t maxDelazifyThreads() const;
+  size_t maxParallelDelazifyThreads() const;
+  size_t maxModuleGraphThreads() const;
   size_t maxCompressionThreads() const;
   size_t maxGCParallelThreads() const;
 
@@ -270,6 +302,20 @@ class GlobalHelperThreadState {
     return terminating_;
   }
 
+  // Scheduling of off-thread Ion compilations by warm-up velocity, see
+  // HelperThreads.cpp. These only depend on their arguments, so that they can
+  // be tested.
+  //
+  // The index in |worklist| of the task to compile next, or its length if
+  // there is none.
+  static size_t highestPriorityIonCompileIndex(
+      const IonCompileTaskVector& worklist, mozilla::TimeStamp now,
+      bool checkExecutionStatus);
+  // The running compilation to cancel in favor of |task|, if any.
+  static jit::IonCompileTask* ionCompileTaskToPreempt(
+      const HelperThreadTaskVector& runningTasks, jit::IonCompileTask* task,
+      mozilla::TimeStamp now);
+
  private:
   void notifyOne(const AutoLockHelperThreadState&);
 
@@ -329,6 +375,11 @@ class GlobalHelperThreadState {
     return wasmPartialTier2CompileWorklist_;
   }
 
+  wasm::ValidateTaskPtrVector& wasmValidateWorklist(
+      const AutoLockHelperThreadState&) {
+    return wasmValidateWorklist_;
+  }
+
   void incWasmCompleteTier2GeneratorsFinished(
       const AutoLockHelperThreadState&) {
     wasmCompleteTier2GeneratorsFinished_++;
@@ -353,6 +404,21 @@ class GlobalHelperThreadState {
     return freeDelazifyTaskVector_;
   }
 
+  ParallelDelazifyTaskVector& parallelDelazifyWorklist(
+      const AutoLockHelperThreadState&) {
+    return parallelDelazifyWorklist_;
+  }
+
+  ModuleGraphCompileTaskVector& moduleGraphWorklist(
+      const AutoLockHelperThreadState&) {
+    return moduleGraphWorklist_;
+  }
+
+  DelazificationProfileMap& delazificationProfiles(
+      const AutoLockHelperThreadState&) {
+    return delazificationProfiles_;
+  }
+
   SourceCompressionTaskVector& compressionPendingList(
       const AutoLockHelperThreadState&) {
     return compressionPendingList_;
@@ -384,12 +450,15 @@ class GlobalHelperThreadState {
       const AutoLockHelperThreadState& lock);
   bool canStartWasmPartialTier2CompileTask(
       const AutoLockHelperThreadState& lock);
+  bool canStartWasmValidateTask(const AutoLockHelperThreadState& lock);
   bool canStartPromiseHelperTask(const AutoLockHelperThreadState& lock);
   bool canStartBaselineCompileTask(const AutoLockHelperThreadState& lock);
   bool canStartIonCompileTask(const AutoLockHelperThreadState& lock);
   bool canStartIonFreeTask(const AutoLockHelperThreadState& lock);
   bool canStartFreeDelazifyTask(const AutoLockHelperThreadState& lock);
   bool canStartDelazifyTask(const AutoLockHelperThreadState& lock);
+  bool canStartParallelDelazifyTask(const AutoLockHelperThreadState& lock);
+  bool canStartModuleGraphCompileTask(const AutoLockHelperThreadState& lock);
   bool canStartCompressionTask(const AutoLockHelperThreadState& lock);
   bool canStartGCParallelTask(const AutoLockHelperThreadState& lock);
 
@@ -404,6 +473,8 @@ class GlobalHelperThreadState {
       const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetWasmPartialTier2CompileTask(
       const AutoLockHelperThreadState& lock);
+  HelperThreadTask* maybeGetWasmValidateTask(
+      const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetPromiseHelperTask(
       const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetBaselineCompileTask(
@@ -416,6 +487,10 @@ class GlobalHelperThreadState {
   HelperThreadTask* maybeGetFreeDelazifyTask(
       const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetDelazifyTask(const AutoLockHelperThreadState& lock);
+  HelperThreadTask* maybeGetParallelDelazifyTask(
+      const AutoLockHelperThreadState& lock);
+  HelperThreadTask* maybeGetModuleGraphCompileTask(
+      const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetCompressionTask(
       const AutoLockHelperThreadState& lock);
   HelperThreadTask* maybeGetGCParallelTask(
@@ -423,6 +498,9 @@ class GlobalHelperThreadState {
 
   jit::IonCompileTask* highestPriorityPendingIonCompile(
       const AutoLockHelperThreadState& lock, bool checkExecutionStatus);
+  void maybePreemptIonCompileTask(jit::IonCompileTask* task,
+                                  mozilla::TimeStamp now,
+                                  const AutoLockHelperThreadState& lock);
 
   bool checkTaskThreadLimit(ThreadType threadType, size_t maxThreads,
                             bool isMaster,
@@ -476,6 +554,7 @@ class GlobalHelperThreadState {
   bool submitTask(wasm::UniqueCompleteTier2GeneratorTask task);
   bool submitTask(wasm::UniquePartialTier2CompileTask task);
   bool submitTask(wasm::CompileTask* task, wasm::CompileState state);
+  bool submitTask(wasm::ValidateTask* task);
   bool submitTask(jit::BaselineCompileTask* task,
                   const AutoLockHelperThreadState& locked);
   bool submitTask(UniquePtr<jit::IonFreeTask>&& task,
@@ -487,6 +566,10 @@ class GlobalHelperThreadState {
   void submitTask(DelazifyTask* task, const AutoLockHelperThreadState& locked);
   bool submitTask(UniquePtr<FreeDelazifyTask> task,
                   const AutoLockHelperThreadState& locked);
+  bool submitTask(ParallelDelazifyTask* task,
+                  const AutoLockHelperThreadState& locked);
+  bool submitTask(ModuleGraphCompileTask* task,
+                  const AutoLockHelperThreadState& locked);
   bool submitTask(PromiseHelperTask* task);
   bool submitTask(GCParallelTask* task,
                   const AutoLockHelperThreadState& locked);
@@ -587,6 +670,67 @@ struct FreeDelazifyTask : public HelperThreadTask {
   const char* getName() override { return "FreeDelazifyTask"; }
 };
 
+// Delazify functions taken from a ParallelDelazificationWorklist, on behalf of
+// a compilation using the ParallelFullParse mode.
+//
+// As opposed to DelazifyTask, these tasks are owned by the compiling thread,
+// which delazifies functions from the same worklist, and waits for the tasks
+// which started to finish before returning the stencil.
+struct ParallelDelazifyTask : public HelperThreadTask {
+  const JS::ReadOnlyCompileOptions& options;
+  frontend::InitialStencilAndDelazifications* stencils;
+  ParallelDelazificationWorklist& worklist;
+
+  DelazificationContext delazificationCx;
+
+  // Whether the task got taken out of the worklist to be run, and whether it
+  // is done running. Both are protected by the helper thread lock.
+  bool started = false;
+  bool finished = false;
+
+  ParallelDelazifyTask(const JS::ReadOnlyCompileOptions& options,
+                       frontend::InitialStencilAndDelazifications* stencils,
+                       ParallelDelazificationWorklist& worklist,
+                       size_t stackQuota);
+
+  void runHelperThreadTask(AutoLockHelperThreadState& locked) override;
+  [[nodiscard]] bool runTask();
+  ThreadType threadType() override {
+    return ThreadType::THREAD_TYPE_PARALLEL_DELAZIFY;
+  }
+
+  const char* getName() override { return "ParallelDelazifyTask"; }
+};
+
+// Compile modules of a graph on behalf of CompileModuleGraphToStencils.
+//
+// The task compiles modules until none remain to be compiled, and is submitted
+// again when more imported modules are discovered. It is owned by the
+// ModuleGraphCompilation, whose thread compiles modules too.
+struct ModuleGraphCompileTask : public HelperThreadTask {
+  ModuleGraphCompilation& compilation;
+
+  // Record any errors happening while loading or compiling modules.
+  FrontendContext fc;
+  size_t stackQuota;
+
+  // Whether the task is in the worklist, and whether it is running. Both are
+  // protected by the helper thread lock.
+  bool queued = false;
+  bool running = false;
+
+  ModuleGraphCompileTask(ModuleGraphCompilation& compilation,
+                         size_t stackQuota)
+      : compilation(compilation), stackQuota(stackQuota) {}
+
+  void runHelperThreadTask(AutoLockHelperThreadState& locked) override;
+  ThreadType threadType() override {
+    return ThreadType::THREAD_TYPE_MODULE_GRAPH;
+  }
+
+  const char* getName() override { return "ModuleGraphCompileTask"; }
+};
+
 // It is not desirable to eagerly compress: if lazy functions that are tied to
 // the ScriptSource were to be executed relatively soon after parsing, they
 // would need to block on decompression, which hurts responsiveness.
@@ -612,6 +756,9 @@ class SourceCompressionTask : public HelperThreadTask {
   // The source to be compressed.
   RefPtr<ScriptSource> source_;
 
+  // The codec selected by the runtime when the task was enqueued.
+  SourceCompressionCodec codec_;
+
   // The resultant compressed string. If the compressed string is larger
   // than the original, or we OOM'd during compression, or nothing else
   // except the task is holding the ScriptSource alive when scheduled to
@@ -621,7 +768,10 @@ class SourceCompressionTask : public HelperThreadTask {
  public:
   // The majorGCNumber is used for scheduling tasks.
   SourceCompressionTask(JSRuntime* rt, ScriptSource* source)
-      : runtime_(rt), majorGCNumber_(rt->gc.majorGCCount()), source_(source) {
+      : runtime_(rt),
+        majorGCNumber_(rt->gc.majorGCCount()),
+        source_(source),
+        codec_(rt->sourceCompressionCodec) {
     source->noteSourceCompressionTask();
   }
   virtual ~SourceCompressionTask() = default;
@@ -18,6 +18,8 @@ class AutoLockHelperThreadState;
 struct DelazifyTask;
 struct FreeDelazifyTask;
 class GlobalHelperThreadState;
+struct ModuleGraphCompileTask;
+struct ParallelDelazifyTask;
 class SourceCompressionTask;
 
 namespace jit {
@@ -64,6 +66,16 @@ struct MapTypeToThreadType<FreeDelazifyTask> {
   static const ThreadType threadType = THREAD_TYPE_DELAZIFY_FREE;
 };
 
+template <>
+struct MapTypeToThreadType<ParallelDelazifyTask> {
+  static const ThreadType threadType = THREAD_TYPE_PARALLEL_DELAZIFY;
+};
+
+template <>
+struct MapTypeToThreadType<ModuleGraphCompileTask> {
+  static const ThreadType threadType = THREAD_TYPE_MODULE_GRAPH;
+};
+
 template <>
 struct MapTypeToThreadType<SourceCompressionTask> {
   static const ThreadType threadType = THREAD_TYPE_COMPRESS;
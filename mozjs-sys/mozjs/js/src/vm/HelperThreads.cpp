@@ -18,6 +18,7 @@
 #include "jit/BaselineCompileTask.h"
 #include "jit/Ion.h"
 #include "jit/IonCompileTask.h"
+#include "jit/JitOptions.h"
 #include "jit/JitRuntime.h"
 #include "jit/JitScript.h"
 #include "js/CompileOptions.h"  // JS::PrefableCompileOptions, JS::ReadOnlyCompileOptions
@@ -28,15 +29,19 @@
 #include "js/UniquePtr.h"
 #include "js/Utility.h"
 #include "threading/CpuCount.h"
+#include "util/NativeStack.h"  // js::GetNativeStackBase
 #include "vm/ErrorReporting.h"
 #include "vm/HelperThreadState.h"
 #include "vm/InternalThreadPool.h"
+#include "vm/ModuleGraphCompilation.h"  // ModuleGraphCompilation
 #include "vm/MutexIDs.h"
 #include "wasm/WasmGenerator.h"
+#include "wasm/WasmValidate.h"
 
 using namespace js;
 
 using mozilla::TimeDuration;
+using mozilla::TimeStamp;
 
 static void CancelOffThreadWasmCompleteTier2GeneratorLocked(
     AutoLockHelperThreadState& lock);
@@ -406,13 +411,23 @@ void GlobalHelperThreadState::addSizeOfIncludingThis(
       wasmWorklist_tier2_.sizeOfExcludingThis(mallocSizeOf) +
       wasmCompleteTier2GeneratorWorklist_.sizeOfExcludingThis(mallocSizeOf) +
       wasmPartialTier2CompileWorklist_.sizeOfExcludingThis(mallocSizeOf) +
+      wasmValidateWorklist_.sizeOfExcludingThis(mallocSizeOf) +
       promiseHelperTasks_.sizeOfExcludingThis(mallocSizeOf) +
+      parallelDelazifyWorklist_.sizeOfExcludingThis(mallocSizeOf) +
+      moduleGraphWorklist_.sizeOfExcludingThis(mallocSizeOf) +
       compressionPendingList_.sizeOfExcludingThis(mallocSizeOf) +
       compressionWorklist_.sizeOfExcludingThis(mallocSizeOf) +
       compressionFinishedList_.sizeOfExcludingThis(mallocSizeOf) +
       gcParallelWorklist_.sizeOfExcludingThis(mallocSizeOf, lock) +
       helperTasks_.sizeOfExcludingThis(mallocSizeOf);
 
+  // Report the registered delazification profiles
+  htStats.stateData +=
+      delazificationProfiles_.shallowSizeOfExcludingThis(mallocSizeOf);
+  for (auto iter = delazificationProfiles_.iter(); !iter.done(); iter.next()) {
+    htStats.stateData += iter.get().value().sizeOfExcludingThis(mallocSizeOf);
+  }
+
   // Report IonCompileTasks on wait lists
   for (auto task : ionWorklist_) {
     htStats.ionCompileTask += task->sizeOfExcludingThis(mallocSizeOf);
@@ -475,6 +490,20 @@ size_t GlobalHelperThreadState::maxDelazifyThreads() const {
   return std::min(cpuCount, threadCount);
 }
 
+size_t GlobalHelperThreadState::maxParallelDelazifyThreads() const {
+  if (IsHelperThreadSimulatingOOM(js::THREAD_TYPE_PARALLEL_DELAZIFY)) {
+    return 1;
+  }
+  return std::min(cpuCount, threadCount);
+}
+
+size_t GlobalHelperThreadState::maxModuleGraphThreads() const {
+  if (IsHelperThreadSimulatingOOM(js::THREAD_TYPE_MODULE_GRAPH)) {
+    return 1;
+  }
+  return std::min(cpuCount, threadCount);
+}
+
 size_t GlobalHelperThreadState::maxCompressionThreads() const {
   if (IsHelperThreadSimulatingOOM(js::THREAD_TYPE_COMPRESS)) {
     return 1;
@@ -579,7 +608,10 @@ const GlobalHelperThreadState::Selector GlobalHelperThreadState::selectors[] = {
     &GlobalHelperThreadState::maybeGetBaselineCompileTask,
     &GlobalHelperThreadState::maybeGetIonCompileTask,
     &GlobalHelperThreadState::maybeGetWasmTier1CompileTask,
+    &GlobalHelperThreadState::maybeGetWasmValidateTask,
     &GlobalHelperThreadState::maybeGetPromiseHelperTask,
+    &GlobalHelperThreadState::maybeGetParallelDelazifyTask,
+    &GlobalHelperThreadState::maybeGetModuleGraphCompileTask,
     &GlobalHelperThreadState::maybeGetFreeDelazifyTask,
     &GlobalHelperThreadState::maybeGetDelazifyTask,
     &GlobalHelperThreadState::maybeGetCompressionTask,
@@ -593,8 +625,11 @@ bool GlobalHelperThreadState::canStartTasks(
     const AutoLockHelperThreadState& lock) {
   return canStartGCParallelTask(lock) || canStartBaselineCompileTask(lock) ||
          canStartIonCompileTask(lock) || canStartWasmTier1CompileTask(lock) ||
-         canStartPromiseHelperTask(lock) || canStartFreeDelazifyTask(lock) ||
-         canStartDelazifyTask(lock) || canStartCompressionTask(lock) ||
+         canStartWasmValidateTask(lock) || canStartPromiseHelperTask(lock) ||
+         canStartParallelDelazifyTask(lock) ||
+         canStartModuleGraphCompileTask(lock) ||
+         canStartFreeDelazifyTask(lock) || canStartDelazifyTask(lock) ||
+         canStartCompressionTask(lock) ||
          canStartIonFreeTask(lock) || canStartWasmTier2CompileTask(lock) ||
          canStartWasmCompleteTier2GeneratorTask(lock) ||
          canStartWasmPartialTier2CompileTask(lock);
@@ -712,38 +747,69 @@ bool GlobalHelperThreadState::canStartIonCompileTask(
                               lock);
 }
 
-static bool IonCompileTaskHasHigherPriority(jit::IonCompileTask* first,
-                                            jit::IonCompileTask* second) {
-  // Return true if priority(first) > priority(second).
-  //
-  // This method can return whatever it wants, though it really ought to be a
-  // total order. The ordering is allowed to race (change on the fly), however.
-
-  // A higher warm-up counter indicates a higher priority.
-  jit::JitScript* firstJitScript = first->script()->jitScript();
-  jit::JitScript* secondJitScript = second->script()->jitScript();
-  return firstJitScript->warmUpCount() / first->script()->length() >
-         secondJitScript->warmUpCount() / second->script()->length();
-}
-
-jit::IonCompileTask* GlobalHelperThreadState::highestPriorityPendingIonCompile(
-    const AutoLockHelperThreadState& lock, bool checkExecutionStatus) {
-  auto& worklist = ionWorklist(lock);
-  MOZ_ASSERT(!worklist.empty());
-
+// Off-thread JIT compilations are prioritized by the warm-up velocity of the
+// scripts they compile: the number of warm-up counter increments per
+// millisecond since the task was queued, divided by the bytecode length as an
+// estimate of the compilation cost. This lets a small script that keeps
+// running overtake a large one that has gone cold, which matters most during
+// bursty startup. A task that was just queued counts as one warm-up in the
+// last millisecond.
+//
+// Warm-up counts are read without synchronization, so priorities are allowed
+// to race (change on the fly).
+static double WarmUpVelocity(uint32_t queuedWarmUpCount, uint32_t warmUpCount,
+                             TimeStamp queuedTime, TimeStamp now,
+                             size_t length) {
+  // The warm-up counter may have been reset, for example by a GC, since the
+  // task was queued.
+  uint32_t warmUps = warmUpCount >= queuedWarmUpCount
+                         ? warmUpCount - queuedWarmUpCount
+                         : warmUpCount;
+  double elapsedMs = std::max((now - queuedTime).ToMilliseconds(), 1.0);
+  return (double(warmUps) + 1.0) / elapsedMs /
+         double(std::max(length, size_t(1)));
+}
+
+static double IonCompileTaskPriority(jit::IonCompileTask* task,
+                                     TimeStamp now) {
+  JSScript* script = task->script();
+  return WarmUpVelocity(task->queuedWarmUpCount(),
+                        script->jitScript()->warmUpCount(), task->queuedTime(),
+                        now, script->length());
+}
+
+// A running Ion compilation is only preempted if the new task's priority is at
+// least this many times higher.
+static constexpr double IonCompilePreemptionPriorityRatio = 10.0;
+
+/* static */
+size_t GlobalHelperThreadState::highestPriorityIonCompileIndex(
+    const IonCompileTaskVector& worklist, TimeStamp now,
+    bool checkExecutionStatus) {
   // Get the highest priority IonCompileTask which has not started compilation
-  // yet.
+  // yet. Ties are broken in queue order.
   size_t index = worklist.length();
+  double bestPriority = 0.0;
   for (size_t i = 0; i < worklist.length(); i++) {
     if (checkExecutionStatus && !worklist[i]->isMainThreadRunningJS()) {
       continue;
     }
-    if (i < index ||
-        IonCompileTaskHasHigherPriority(worklist[i], worklist[index])) {
+    double priority = IonCompileTaskPriority(worklist[i], now);
+    if (index == worklist.length() || priority > bestPriority) {
       index = i;
+      bestPriority = priority;
     }
   }
+  return index;
+}
 
+jit::IonCompileTask* GlobalHelperThreadState::highestPriorityPendingIonCompile(
+    const AutoLockHelperThreadState& lock, bool checkExecutionStatus) {
+  auto& worklist = ionWorklist(lock);
+  MOZ_ASSERT(!worklist.empty());
+
+  size_t index = highestPriorityIonCompileIndex(worklist, TimeStamp::Now(),
+                                                checkExecutionStatus);
   if (index == worklist.length()) {
     return nullptr;
   }
@@ -780,14 +846,77 @@ bool GlobalHelperThreadState::submitTask(
     return false;
   }
 
+  TimeStamp now = TimeStamp::Now();
+  task->setQueued(now, locked);
+
   // The build is moving off-thread. Freeze the LifoAlloc to prevent any
   // unwanted mutations.
   task->alloc().lifoAlloc()->setReadOnly();
 
+  maybePreemptIonCompileTask(task, now, locked);
+
   dispatch(locked);
   return true;
 }
 
+void GlobalHelperThreadState::maybePreemptIonCompileTask(
+    jit::IonCompileTask* task, TimeStamp now,
+    const AutoLockHelperThreadState& lock) {
+  // Only preempt a compilation if all Ion threads are busy. The helper thread
+  // then picks the highest priority pending task, which is not necessarily
+  // |task|.
+  if (checkTaskThreadLimit(THREAD_TYPE_ION, maxIonCompilationThreads(), lock)) {
+    return;
+  }
+
+  if (jit::IonCompileTask* victim =
+          ionCompileTaskToPreempt(helperTasks(lock), task, now)) {
+    victim->preempt(lock);
+  }
+}
+
+/* static */
+jit::IonCompileTask* GlobalHelperThreadState::ionCompileTaskToPreempt(
+    const HelperThreadTaskVector& runningTasks, jit::IonCompileTask* task,
+    TimeStamp now) {
+  // Choose the running compilation with the lowest priority, if it has been
+  // running for a while and |task| is much hotter.
+  uint32_t thresholdMs = jit::JitOptions.ionCompilePreemptionMs;
+  if (thresholdMs == 0) {
+    return nullptr;
+  }
+
+  TimeDuration threshold = TimeDuration::FromMilliseconds(thresholdMs);
+  jit::IonCompileTask* victim = nullptr;
+  double victimPriority = 0.0;
+  for (auto* helper : runningTasks) {
+    if (!helper->is<jit::IonCompileTask>()) {
+      continue;
+    }
+
+    jit::IonCompileTask* running = helper->as<jit::IonCompileTask>();
+    if (running->preempted()) {
+      // A compilation was already cancelled and will free its thread soon.
+      return nullptr;
+    }
+    if (!running->startTime() || now - running->startTime() < threshold) {
+      continue;
+    }
+
+    double priority = IonCompileTaskPriority(running, now);
+    if (!victim || priority < victimPriority) {
+      victim = running;
+      victimPriority = priority;
+    }
+  }
+
+  if (victim && IonCompileTaskPriority(task, now) >=
+                    victimPriority * IonCompilePreemptionPriorityRatio) {
+    return victim;
+  }
+  return nullptr;
+}
+
 bool js::StartOffThreadIonCompile(jit::IonCompileTask* task,
                                   const AutoLockHelperThreadState& lock) {
   return HelperThreadState().submitTask(task, lock);
@@ -1099,7 +1228,27 @@ HelperThreadTask* GlobalHelperThreadState::maybeGetBaselineCompileTask(
     return nullptr;
   }
 
-  return baselineWorklist(lock).popCopy();
+  // Get the batch with the highest warm-up velocity, see
+  // IonCompileTaskPriority. Ties are broken in favor of the most recently
+  // queued batch.
+  auto& worklist = baselineWorklist(lock);
+  TimeStamp now = TimeStamp::Now();
+  size_t index = 0;
+  double bestPriority = 0.0;
+  for (size_t i = worklist.length(); i > 0; i--) {
+    jit::BaselineCompileTask* task = worklist[i - 1];
+    double priority =
+        WarmUpVelocity(task->queuedWarmUpCount(), task->warmUpCount(),
+                       task->queuedTime(), now, task->bytecodeLength());
+    if (i == worklist.length() || priority > bestPriority) {
+      index = i - 1;
+      bestPriority = priority;
+    }
+  }
+
+  jit::BaselineCompileTask* task = worklist[index];
+  worklist.erase(&worklist[index]);
+  return task;
 }
 
 bool GlobalHelperThreadState::submitTask(
@@ -1110,6 +1259,8 @@ bool GlobalHelperThreadState::submitTask(
     return false;
   }
 
+  task->setQueued(TimeStamp::Now(), locked);
+
   dispatch(locked);
   return true;
 }
@@ -1249,6 +1400,23 @@ void GlobalHelperThreadState::submitTask(
   dispatch(locked);
 }
 
+JS_PUBLIC_API bool JS::SetDelazificationProfile(
+    uint32_t sourceHash, const JS::DelazificationProfile& profile) {
+  JS::DelazificationProfile copy;
+  if (!copy.appendAll(profile)) {
+    return false;
+  }
+
+  AutoLockHelperThreadState lock;
+  return HelperThreadState().delazificationProfiles(lock).put(sourceHash,
+                                                              std::move(copy));
+}
+
+JS_PUBLIC_API void JS::ClearDelazificationProfiles() {
+  AutoLockHelperThreadState lock;
+  HelperThreadState().delazificationProfiles(lock).clearAndCompact();
+}
+
 void js::StartOffThreadDelazification(
     JSContext* maybeCx, const JS::ReadOnlyCompileOptions& options,
     frontend::InitialStencilAndDelazifications* stencils) {
@@ -1466,6 +1634,211 @@ void js::WaitForAllDelazifyTasks(JSRuntime* rt) {
   }
 }
 
+//== ParallelDelazifyTask =================================================
+
+bool GlobalHelperThreadState::canStartParallelDelazifyTask(
+    const AutoLockHelperThreadState& lock) {
+  return !parallelDelazifyWorklist(lock).empty() &&
+         checkTaskThreadLimit(THREAD_TYPE_PARALLEL_DELAZIFY,
+                              maxParallelDelazifyThreads(), lock);
+}
+
+HelperThreadTask* GlobalHelperThreadState::maybeGetParallelDelazifyTask(
+    const AutoLockHelperThreadState& lock) {
+  if (!canStartParallelDelazifyTask(lock)) {
+    return nullptr;
+  }
+
+  ParallelDelazifyTask* task = parallelDelazifyWorklist(lock).popCopy();
+  task->started = true;
+  return task;
+}
+
+bool GlobalHelperThreadState::submitTask(
+    ParallelDelazifyTask* task, const AutoLockHelperThreadState& locked) {
+  if (!parallelDelazifyWorklist(locked).append(task)) {
+    return false;
+  }
+  dispatch(locked);
+  return true;
+}
+
+// Recover the stack quota of the current thread from the stack limit which got
+// set on its FrontendContext.
+static JS::NativeStackSize StackQuotaFromLimit(FrontendContext* fc) {
+  JS::NativeStackLimit limit = fc->stackLimit();
+  if (limit == JS::NativeStackLimitMax) {
+    return 0;
+  }
+
+  JS::NativeStackBase base = GetNativeStackBase();
+#if JS_STACK_GROWTH_DIRECTION > 0
+  return limit - base + 1;
+#else
+  return base - limit + 1;
+#endif
+}
+
+void js::DelazifyInParallel(
+    JSContext* maybeCx, FrontendContext* fc,
+    const JS::ReadOnlyCompileOptions& options,
+    frontend::InitialStencilAndDelazifications* stencils) {
+  MOZ_ASSERT(options.parallelFullParse());
+
+  // Skip eager delazification if code coverage is enabled.
+  if (maybeCx && maybeCx->realm()->collectCoverageForDebug()) {
+    return;
+  }
+
+  // NOTE: As for off-thread delazification, errors are not reported. Any
+  // function which is not delazified here is delazified on-demand.
+  ParallelDelazificationWorklist worklist;
+  {
+    FrontendContext worklistFc;
+    if (!worklist.init(&worklistFc, *stencils->getInitial())) {
+      return;
+    }
+  }
+  if (worklist.length() == 0) {
+    return;
+  }
+
+  // The current thread delazifies functions too, thus only start helper tasks
+  // for the remaining threads which can be kept busy.
+  size_t numHelpers = 0;
+  if (CanUseExtraThreads()) {
+    AutoLockHelperThreadState lock;
+    if (HelperThreadState().isInitialized(lock)) {
+      numHelpers = std::min(HelperThreadState().maxParallelDelazifyThreads(),
+                            worklist.length()) -
+                   1;
+    }
+  }
+
+  Vector<UniquePtr<ParallelDelazifyTask>, 0, SystemAllocPolicy> helpers;
+  if (!helpers.reserve(numHelpers)) {
+    numHelpers = 0;
+  }
+  for (size_t i = 0; i < numHelpers; i++) {
+    auto task = MakeUnique<ParallelDelazifyTask>(
+        options, stencils, worklist, HelperThreadState().stackQuota);
+    if (!task) {
+      break;
+    }
+    helpers.infallibleAppend(std::move(task));
+  }
+
+  {
+    AutoLockHelperThreadState lock;
+    for (auto& task : helpers) {
+      if (!HelperThreadState().submitTask(task.get(), lock)) {
+        break;
+      }
+    }
+  }
+
+  ParallelDelazifyTask current(options, stencils, worklist,
+                              StackQuotaFromLimit(fc));
+  (void)current.runTask();
+
+  // The worklist is empty at this point, or this thread failed. In both
+  // cases, tasks which did not start yet have nothing to add, remove them and
+  // wait for the others.
+  AutoLockHelperThreadState lock;
+  auto& pending = HelperThreadState().parallelDelazifyWorklist(lock);
+  for (auto& task : helpers) {
+    if (!task->started) {
+      pending.eraseIfEqual(task.get());
+    }
+  }
+  while (true) {
+    bool inProgress = false;
+    for (auto& task : helpers) {
+      if (task->started && !task->finished) {
+        inProgress = true;
+        break;
+      }
+    }
+    if (!inProgress) {
+      break;
+    }
+
+    HelperThreadState().wait(lock);
+  }
+}
+
+ParallelDelazifyTask::ParallelDelazifyTask(
+    const JS::ReadOnlyCompileOptions& options,
+    frontend::InitialStencilAndDelazifications* stencils,
+    ParallelDelazificationWorklist& worklist, size_t stackQuota)
+    : options(options),
+      stencils(stencils),
+      worklist(worklist),
+      delazificationCx(options.prefableOptions(), stackQuota) {}
+
+void ParallelDelazifyTask::runHelperThreadTask(
+    AutoLockHelperThreadState& locked) {
+  {
+    AutoUnlockHelperThreadState unlock(locked);
+    (void)runTask();
+  }
+
+  // The compiling thread is notified by runOneTask once this function
+  // returns.
+  finished = true;
+}
+
+bool ParallelDelazifyTask::runTask() {
+  // Each thread clones the initial stencil in its DelazificationContext, to
+  // merge the delazified functions which are providing the context of their
+  // inner functions.
+  return delazificationCx.init(options, stencils) &&
+         delazificationCx.delazify(worklist);
+}
+
+//== ModuleGraphCompileTask ===============================================
+
+bool GlobalHelperThreadState::canStartModuleGraphCompileTask(
+    const AutoLockHelperThreadState& lock) {
+  return !moduleGraphWorklist(lock).empty() &&
+         checkTaskThreadLimit(THREAD_TYPE_MODULE_GRAPH, maxModuleGraphThreads(),
+                              lock);
+}
+
+HelperThreadTask* GlobalHelperThreadState::maybeGetModuleGraphCompileTask(
+    const AutoLockHelperThreadState& lock) {
+  if (!canStartModuleGraphCompileTask(lock)) {
+    return nullptr;
+  }
+
+  ModuleGraphCompileTask* task = moduleGraphWorklist(lock).popCopy();
+  task->queued = false;
+  task->running = true;
+  return task;
+}
+
+bool GlobalHelperThreadState::submitTask(
+    ModuleGraphCompileTask* task, const AutoLockHelperThreadState& locked) {
+  MOZ_ASSERT(!task->queued && !task->running);
+  if (!moduleGraphWorklist(locked).append(task)) {
+    return false;
+  }
+  task->queued = true;
+  dispatch(locked);
+  return true;
+}
+
+void ModuleGraphCompileTask::runHelperThreadTask(
+    AutoLockHelperThreadState& locked) {
+  // The stack limit depends on the thread running the task.
+  fc.setStackQuota(stackQuota);
+  compilation.compileModules(&fc, locked);
+
+  // The compiling thread is notified by runOneTask once this function
+  // returns.
+  running = false;
+}
+
 //== FreeDelazifyTask =====================================================
 
 bool GlobalHelperThreadState::canStartFreeDelazifyTask(
@@ -2002,6 +2375,55 @@ void js::CancelOffThreadWasmPartialTier2Compile() {
   CancelOffThreadWasmPartialTier2CompileLocked(lock);
 }
 
+//== WasmValidateTask =====================================================
+
+bool GlobalHelperThreadState::canStartWasmValidateTask(
+    const AutoLockHelperThreadState& lock) {
+  // Validation tasks are only submitted on multicore systems, see
+  // wasm::Validate, and share the limit of tier-1 compilation tasks.
+  return !wasmValidateWorklist(lock).empty() &&
+         checkTaskThreadLimit(THREAD_TYPE_WASM_VALIDATE,
+                              maxWasmCompilationThreads(), lock);
+}
+
+HelperThreadTask* GlobalHelperThreadState::maybeGetWasmValidateTask(
+    const AutoLockHelperThreadState& lock) {
+  if (!canStartWasmValidateTask(lock)) {
+    return nullptr;
+  }
+
+  return wasmValidateWorklist(lock).popCopy();
+}
+
+bool GlobalHelperThreadState::submitTask(wasm::ValidateTask* task) {
+  AutoLockHelperThreadState lock;
+  if (!wasmValidateWorklist(lock).append(task)) {
+    return false;
+  }
+
+  dispatch(lock);
+  return true;
+}
+
+bool js::StartOffThreadWasmValidate(wasm::ValidateTask* task) {
+  return HelperThreadState().submitTask(task);
+}
+
+wasm::ValidateTask* js::TakePendingWasmValidateTask(
+    const wasm::ValidateTaskState& taskState,
+    const AutoLockHelperThreadState& lock) {
+  wasm::ValidateTaskPtrVector& worklist =
+      HelperThreadState().wasmValidateWorklist(lock);
+  for (size_t i = worklist.length(); i > 0; i--) {
+    wasm::ValidateTask* task = worklist[i - 1];
+    if (&task->state == &taskState) {
+      worklist.erase(&worklist[i - 1]);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
 //== wasm task management =================================================
 
 bool GlobalHelperThreadState::canStartWasmCompile(
@@ -38,6 +38,7 @@ class SourceText;
 namespace js {
 
 class AutoLockHelperThreadState;
+class FrontendContext;
 struct PromiseHelperTask;
 class SourceCompressionTask;
 
@@ -64,6 +65,8 @@ struct CompleteTier2GeneratorTask;
 using UniqueCompleteTier2GeneratorTask = UniquePtr<CompleteTier2GeneratorTask>;
 struct PartialTier2CompileTask;
 using UniquePartialTier2CompileTask = UniquePtr<PartialTier2CompileTask>;
+struct ValidateTask;
+struct ValidateTaskState;
 }  // namespace wasm
 
 /*
@@ -136,6 +139,16 @@ size_t RemovePendingWasmCompileTasks(const wasm::CompileTaskState& taskState,
                                      wasm::CompileState state,
                                      const AutoLockHelperThreadState& lock);
 
+// Enqueues a task validating a batch of wasm function bodies.
+bool StartOffThreadWasmValidate(wasm::ValidateTask* task);
+
+// Remove a pending validation task queued with StartOffThreadWasmValidate
+// that belongs to |taskState|, so that the caller can run it itself. Return
+// null if there is none.
+wasm::ValidateTask* TakePendingWasmValidateTask(
+    const wasm::ValidateTaskState& taskState,
+    const AutoLockHelperThreadState& lock);
+
 // Enqueues a wasm Complete Tier-2 compilation task.  This (logically, at
 // least) manages a set of sub-tasks that perform compilation of groups of
 // functions.
@@ -298,6 +311,14 @@ void StartOffThreadDelazification(
     JSContext* maybeCx, const JS::ReadOnlyCompileOptions& options,
     frontend::InitialStencilAndDelazifications* stencils);
 
+// Delazify every function of `stencils` before returning, for the
+// ParallelFullParse mode. The functions of the top-level script are split
+// between the current thread and helper threads. Functions which could not be
+// delazified remain lazy and are delazified on-demand.
+void DelazifyInParallel(JSContext* maybeCx, FrontendContext* fc,
+                        const JS::ReadOnlyCompileOptions& options,
+                        frontend::InitialStencilAndDelazifications* stencils);
+
 // Drain the task queues and wait for all helper threads to finish running.
 //
 // Note that helper threads are shared between runtimes and it's possible that
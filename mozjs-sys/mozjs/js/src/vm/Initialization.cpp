@@ -19,6 +19,7 @@
 
 #include "builtin/AtomicsObject.h"
 #include "builtin/TestingFunctions.h"
+#include "frontend/SharedParserAtoms.h"  // js::frontend::SharedParserAtomsTable
 #include "gc/Statistics.h"
 #include "jit/Assembler.h"
 #include "jit/Ion.h"
@@ -257,6 +258,7 @@ static void ShutdownImpl(JS::detail::FrontendOnly frontendOnly) {
   }
 #endif
 
+  js::frontend::SharedParserAtomsTable::freeSingleton();
   js::frontend::WellKnownParserAtoms::freeSingleton();
   js::SharedImmutableStringsCache::freeSingleton();
 
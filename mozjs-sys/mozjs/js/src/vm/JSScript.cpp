@@ -964,8 +964,9 @@ const Unit* UncompressedSourceCache::lookup(const ScriptSourceChunk& ssc,
   }
 
   if (Map::Ptr p = map_->lookup(ssc)) {
+    p->value().lastUse = ++useCount_;
     holdEntry(holder, ssc);
-    return static_cast<const Unit*>(p->value().get());
+    return static_cast<const Unit*>(p->value().data.get());
   }
 
   return nullptr;
@@ -982,7 +983,11 @@ bool UncompressedSourceCache::put(const ScriptSourceChunk& ssc, SourceData data,
     }
   }
 
-  if (!map_->put(ssc, std::move(data))) {
+  if (map_->count() >= MaxEntries) {
+    evictLeastRecentlyUsed();
+  }
+
+  if (!map_->put(ssc, Entry{std::move(data), ++useCount_})) {
     return false;
   }
 
@@ -990,6 +995,23 @@ bool UncompressedSourceCache::put(const ScriptSourceChunk& ssc, SourceData data,
   return true;
 }
 
+void UncompressedSourceCache::evictLeastRecentlyUsed() {
+  // Only called by put, while no entry is held.
+  MOZ_ASSERT(!holder_);
+  MOZ_ASSERT(!map_->empty());
+
+  auto iter = map_->iter();
+  ScriptSourceChunk oldest = iter.get().key();
+  uint64_t oldestUse = iter.get().value().lastUse;
+  for (iter.next(); !iter.done(); iter.next()) {
+    if (iter.get().value().lastUse < oldestUse) {
+      oldest = iter.get().key();
+      oldestUse = iter.get().value().lastUse;
+    }
+  }
+  map_->remove(oldest);
+}
+
 void UncompressedSourceCache::purge() {
   if (!map_) {
     return;
@@ -997,7 +1019,7 @@ void UncompressedSourceCache::purge() {
 
   for (Map::Range r = map_->all(); !r.empty(); r.popFront()) {
     if (holder_ && r.front().key() == holder_->sourceChunk()) {
-      holder_->deferDelete(std::move(r.front().value()));
+      holder_->deferDelete(std::move(r.front().value().data));
       holder_ = nullptr;
     }
   }
@@ -1011,7 +1033,7 @@ size_t UncompressedSourceCache::sizeOfExcludingThis(
   if (map_ && !map_->empty()) {
     n += map_->shallowSizeOfIncludingThis(mallocSizeOf);
     for (Map::Range r = map_->all(); !r.empty(); r.popFront()) {
-      n += mallocSizeOf(r.front().value().get());
+      n += mallocSizeOf(r.front().value().data.get());
     }
   }
   return n;
@@ -1631,7 +1653,8 @@ void SourceCompressionTask::workEncodingSpecific() {
   }
 
   const Unit* chars = source_->uncompressedData<Unit>()->units();
-  Compressor comp(reinterpret_cast<const unsigned char*>(chars), inputBytes);
+  Compressor comp(reinterpret_cast<const unsigned char*>(chars), inputBytes,
+                  codec_);
   if (!comp.init()) {
     return;
   }
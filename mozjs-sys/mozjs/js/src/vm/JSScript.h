@@ -241,9 +241,20 @@ inline SourceData ToSourceData(EntryUnits<Unit> chars) {
 }
 
 class UncompressedSourceCache {
-  using Map = HashMap<ScriptSourceChunk, SourceData, ScriptSourceChunkHasher,
+  struct Entry {
+    SourceData data;
+
+    // Value of |useCount_| when this entry was last looked up or added.
+    uint64_t lastUse;
+  };
+
+  using Map = HashMap<ScriptSourceChunk, Entry, ScriptSourceChunkHasher,
                       SystemAllocPolicy>;
 
+  // Maximum number of decompressed chunks kept between GCs. When the cache is
+  // full, the least recently used chunk is evicted.
+  static constexpr size_t MaxEntries = 64;
+
  public:
   // Hold an entry in the source data cache and prevent it from being purged on
   // GC.
@@ -305,6 +316,7 @@ class UncompressedSourceCache {
  private:
   UniquePtr<Map> map_ = nullptr;
   AutoHoldEntry* holder_ = nullptr;
+  uint64_t useCount_ = 0;
 
  public:
   UncompressedSourceCache() = default;
@@ -321,6 +333,7 @@ class UncompressedSourceCache {
  private:
   void holdEntry(AutoHoldEntry& holder, const ScriptSourceChunk& ssc);
   void releaseEntry(AutoHoldEntry& holder);
+  void evictLeastRecentlyUsed();
 };
 
 template <typename Unit>
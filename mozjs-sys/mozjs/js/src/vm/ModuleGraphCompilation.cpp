@@ -0,0 +1,350 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vm/ModuleGraphCompilation.h"
+
+#include "mozilla/Utf8.h"  // mozilla::Utf8Unit
+
+#include <utility>  // std::move
+
+#include "frontend/CompilationStencil.h"  // frontend::CompilationStencil, frontend::InitialStencilAndDelazifications
+#include "frontend/FrontendContext.h"  // FrontendContext
+#include "frontend/ParserAtom.h"       // frontend::ParserAtomsTable
+#include "frontend/Stencil.h"          // frontend::StencilModuleRequest
+#include "js/CompileOptions.h"  // JS::CompileOptions, JS::ReadOnlyCompileOptions
+#include "js/SourceText.h"        // JS::SourceText
+#include "util/Text.h"            // DuplicateString
+#include "vm/HelperThreads.h"     // AutoLockHelperThreadState, AutoUnlockHelperThreadState
+#include "vm/HelperThreadState.h"  // HelperThreadState, ModuleGraphCompileTask
+#include "vm/Runtime.h"            // CanUseExtraThreads
+
+using namespace js;
+
+ModuleGraphCompilation::~ModuleGraphCompilation() {
+  MOZ_ASSERT(inProgress_ == 0);
+}
+
+bool ModuleGraphCompilation::compile(const char* entryKey,
+                                     JS::CompiledModuleGraph* graph) {
+  auto entry = MakeUnique<Module>();
+  if (!entry) {
+    ReportOutOfMemory(fc_);
+    return false;
+  }
+  entry->key = DuplicateString(fc_, entryKey);
+  if (!entry->key) {
+    return false;
+  }
+  if (!keys_.putNew(entry->key.get(), 0) || !pending_.append(0) ||
+      !modules_.append(std::move(entry))) {
+    ReportOutOfMemory(fc_);
+    return false;
+  }
+
+  // The current thread compiles modules too, thus only use helper tasks for
+  // the remaining threads.
+  size_t numHelpers = 0;
+  if (CanUseExtraThreads()) {
+    AutoLockHelperThreadState lock;
+    if (HelperThreadState().isInitialized(lock)) {
+      numHelpers = HelperThreadState().maxModuleGraphThreads() - 1;
+    }
+  }
+  if (!helpers_.reserve(numHelpers)) {
+    numHelpers = 0;
+  }
+  for (size_t i = 0; i < numHelpers; i++) {
+    auto task = MakeUnique<ModuleGraphCompileTask>(
+        *this, HelperThreadState().stackQuota);
+    if (!task) {
+      break;
+    }
+    helpers_.infallibleAppend(std::move(task));
+  }
+
+  {
+    AutoLockHelperThreadState lock;
+    compileModules(fc_, lock);
+    stopHelpers(lock);
+  }
+
+  if (failed_) {
+    if (failedModule_) {
+      // The error got reported on a helper thread. Compile the module again to
+      // report it to the compiling thread. If it does not happen again, then
+      // the helper thread most likely ran out of memory.
+      RequestKeyVector requestKeys;
+      if (compileModule(fc_, *modules_[*failedModule_], requestKeys)) {
+        ReportOutOfMemory(fc_);
+      }
+    }
+    return false;
+  }
+
+  return sortModules(graph);
+}
+
+void ModuleGraphCompilation::compileModules(FrontendContext* fc,
+                                            AutoLockHelperThreadState& lock) {
+  bool isCompilingThread = fc == fc_;
+
+  while (!failed_) {
+    if (pending_.empty()) {
+      // Helper tasks stop once no module remains, while the compiling thread
+      // waits for the modules in progress, which can import more modules.
+      if (!isCompilingThread || inProgress_ == 0) {
+        break;
+      }
+
+      // Start the helper tasks submitted by this thread before waiting.
+      if (lock.hasQueuedTasks()) {
+        AutoUnlockHelperThreadState unlock(lock);
+        continue;
+      }
+
+      HelperThreadState().wait(lock);
+      continue;
+    }
+
+    size_t index = pending_.popCopy();
+    Module& module = *modules_[index];
+    inProgress_++;
+
+    RequestKeyVector requestKeys;
+    bool ok;
+    {
+      AutoUnlockHelperThreadState unlock(lock);
+      ok = compileModule(fc, module, requestKeys);
+    }
+
+    inProgress_--;
+    if (!ok || !addRequestedModules(fc, module, requestKeys, lock)) {
+      if (!failed_) {
+        failed_ = true;
+        if (!isCompilingThread) {
+          failedModule_.emplace(index);
+        }
+      }
+    } else {
+      startHelpers(lock);
+    }
+
+    // Wake the compiling thread, waiting for imported modules.
+    HelperThreadState().notifyAll(lock);
+  }
+}
+
+bool ModuleGraphCompilation::compileModule(FrontendContext* fc,
+                                           Module& module,
+                                           RequestKeyVector& requestKeys) {
+  JS::SourceText<mozilla::Utf8Unit> srcBuf;
+  if (!loader_.load(fc, module.key.get(), srcBuf)) {
+    return false;
+  }
+
+  JS::CompileOptions options(nullptr, options_);
+  options.setFileAndLine(module.key.get(), 1);
+
+  RefPtr<JS::Stencil> stencil =
+      JS::CompileModuleScriptToStencil(fc, options, srcBuf);
+  if (!stencil) {
+    return false;
+  }
+
+  // Resolve the imported modules right away, such that they can be compiled
+  // while this thread continues with other modules.
+  const frontend::CompilationStencil& initial = *stencil->getInitial();
+  for (const frontend::StencilModuleRequest& request :
+       initial.moduleMetadata->moduleRequests) {
+    UniqueChars key;
+    if (request.attributes.empty()) {
+      UniqueChars specifier = frontend::ParserAtomsTable::toNewUTF8CharsZ(
+          fc, initial.parserAtomData, request.specifier);
+      if (!specifier ||
+          !loader_.resolve(module.key.get(), specifier.get(), &key)) {
+        return false;
+      }
+    }
+    if (!requestKeys.append(std::move(key))) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+  }
+
+  module.stencil = std::move(stencil);
+  return true;
+}
+
+bool ModuleGraphCompilation::addRequestedModules(
+    FrontendContext* fc, Module& module, RequestKeyVector& requestKeys,
+    const AutoLockHelperThreadState& lock) {
+  if (!module.requestedModules.reserve(requestKeys.length())) {
+    ReportOutOfMemory(fc);
+    return false;
+  }
+
+  for (UniqueChars& key : requestKeys) {
+    if (!key) {
+      module.requestedModules.infallibleAppend(JS::CompiledModule::NoModule);
+      continue;
+    }
+
+    KeyMap::AddPtr p = keys_.lookupForAdd(key.get());
+    if (p) {
+      module.requestedModules.infallibleAppend(p->value());
+      continue;
+    }
+
+    auto imported = MakeUnique<Module>();
+    if (!imported) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+    imported->key = std::move(key);
+
+    size_t index = modules_.length();
+    if (!keys_.add(p, imported->key.get(), index) || !pending_.append(index) ||
+        !modules_.append(std::move(imported))) {
+      ReportOutOfMemory(fc);
+      return false;
+    }
+    module.requestedModules.infallibleAppend(index);
+  }
+
+  return true;
+}
+
+void ModuleGraphCompilation::startHelpers(
+    const AutoLockHelperThreadState& lock) {
+  size_t queued = 0;
+  for (auto& task : helpers_) {
+    if (task->queued) {
+      queued++;
+    }
+  }
+
+  for (auto& task : helpers_) {
+    if (queued >= pending_.length()) {
+      break;
+    }
+    if (task->queued || task->running) {
+      continue;
+    }
+
+    // On failure, the pending modules are compiled by the running threads.
+    if (!HelperThreadState().submitTask(task.get(), lock)) {
+      break;
+    }
+    queued++;
+  }
+}
+
+void ModuleGraphCompilation::stopHelpers(AutoLockHelperThreadState& lock) {
+  // Tasks which did not start have nothing to compile.
+  auto& worklist = HelperThreadState().moduleGraphWorklist(lock);
+  for (auto& task : helpers_) {
+    if (task->queued) {
+      worklist.eraseIfEqual(task.get());
+      task->queued = false;
+    }
+  }
+
+  while (true) {
+    if (lock.hasQueuedTasks()) {
+      AutoUnlockHelperThreadState unlock(lock);
+      continue;
+    }
+
+    bool running = false;
+    for (auto& task : helpers_) {
+      if (task->running) {
+        running = true;
+        break;
+      }
+    }
+    if (!running) {
+      break;
+    }
+
+    HelperThreadState().wait(lock);
+  }
+}
+
+bool ModuleGraphCompilation::sortModules(JS::CompiledModuleGraph* graph) {
+  static constexpr size_t NoModule = JS::CompiledModule::NoModule;
+  size_t count = modules_.length();
+
+  // Order the modules with a depth-first post-order traversal of the imports,
+  // starting from the entry module. Every module is reachable from it.
+  struct Frame {
+    size_t module;
+    size_t request;
+  };
+  Vector<Frame, 0, SystemAllocPolicy> stack;
+  Vector<size_t, 0, SystemAllocPolicy> order;
+  Vector<size_t, 0, SystemAllocPolicy> newIndex;
+  if (!order.reserve(count) || !newIndex.appendN(NoModule, count) ||
+      !graph->reserve(graph->length() + count) ||
+      !stack.append(Frame{0, 0})) {
+    ReportOutOfMemory(fc_);
+    return false;
+  }
+
+  // Modules on the stack are given a placeholder index to break cycles.
+  static constexpr size_t Visiting = NoModule - 1;
+  newIndex[0] = Visiting;
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    const auto& requests = modules_[frame.module]->requestedModules;
+    if (frame.request < requests.length()) {
+      size_t imported = requests[frame.request++];
+      if (imported != NoModule && newIndex[imported] == NoModule) {
+        newIndex[imported] = Visiting;
+        if (!stack.append(Frame{imported, 0})) {
+          ReportOutOfMemory(fc_);
+          return false;
+        }
+      }
+      continue;
+    }
+
+    newIndex[frame.module] = graph->length() + order.length();
+    order.infallibleAppend(frame.module);
+    stack.popBack();
+  }
+  MOZ_ASSERT(order.length() == count);
+
+  for (size_t index : order) {
+    Module& module = *modules_[index];
+
+    JS::CompiledModule compiled;
+    compiled.key = std::move(module.key);
+    compiled.stencil = std::move(module.stencil);
+    compiled.requestedModules = std::move(module.requestedModules);
+    for (size_t& imported : compiled.requestedModules) {
+      if (imported != NoModule) {
+        imported = newIndex[imported];
+      }
+    }
+    graph->infallibleAppend(std::move(compiled));
+  }
+
+  // Keys of the KeyMap moved to the graph.
+  keys_.clear();
+  return true;
+}
+
+JS_PUBLIC_API bool JS::CompileModuleGraphToStencils(
+    JS::FrontendContext* fc, const JS::ReadOnlyCompileOptions& options,
+    const char* entryKey, ModuleGraphLoader& loader,
+    CompiledModuleGraph* graph) {
+#ifdef DEBUG
+  fc->assertNativeStackLimitThread();
+#endif
+
+  ModuleGraphCompilation compilation(fc, options, loader);
+  return compilation.compile(entryKey, graph);
+}
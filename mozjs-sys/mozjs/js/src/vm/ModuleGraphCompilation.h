@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef vm_ModuleGraphCompilation_h
+#define vm_ModuleGraphCompilation_h
+
+#include "mozilla/Attributes.h"  // MOZ_STACK_CLASS
+#include "mozilla/HashTable.h"   // mozilla::CStringHasher
+#include "mozilla/Maybe.h"       // mozilla::Maybe
+
+#include <stddef.h>  // size_t
+
+#include "NamespaceImports.h"  // UniqueChars
+
+#include "js/AllocPolicy.h"                 // SystemAllocPolicy
+#include "js/experimental/CompileScript.h"  // JS::ModuleGraphLoader, JS::CompiledModuleGraph
+#include "js/HashTable.h"                   // HashMap
+#include "js/UniquePtr.h"                   // UniquePtr
+#include "js/Vector.h"                      // Vector
+
+namespace JS {
+class JS_PUBLIC_API ReadOnlyCompileOptions;
+}
+
+namespace js {
+
+class AutoLockHelperThreadState;
+class FrontendContext;
+struct ModuleGraphCompileTask;
+
+// Compile a module graph to stencils, for JS::CompileModuleGraphToStencils.
+//
+// Each compiled module adds the modules it imports which are not known yet to
+// the list of modules to compile, such that modules are compiled as soon as
+// they are discovered. The compiling thread and ModuleGraphCompileTasks take
+// modules from that list until it is empty and no module being compiled can
+// add more.
+//
+// The state of the graph is protected by the helper thread lock, which is
+// released while loading and compiling modules.
+class MOZ_STACK_CLASS ModuleGraphCompilation {
+  struct Module {
+    UniqueChars key;
+    RefPtr<JS::Stencil> stencil;
+    Vector<size_t, 0, SystemAllocPolicy> requestedModules;
+  };
+
+  // The compiling thread, which receives the errors.
+  FrontendContext* fc_;
+  const JS::ReadOnlyCompileOptions& options_;
+  JS::ModuleGraphLoader& loader_;
+
+  // Modules, in the order of their discovery. The entry module is the first.
+  Vector<UniquePtr<Module>, 0, SystemAllocPolicy> modules_;
+
+  // Map the keys of modules_ to their index.
+  using KeyMap =
+      HashMap<const char*, size_t, mozilla::CStringHasher, SystemAllocPolicy>;
+  KeyMap keys_;
+
+  // Modules which are waiting to be compiled.
+  Vector<size_t, 0, SystemAllocPolicy> pending_;
+
+  // Number of modules being compiled.
+  size_t inProgress_ = 0;
+
+  // Set when a module cannot be compiled, to stop compiling the graph. When
+  // the error is reported on a helper thread, |failedModule_| is the module
+  // which has to be compiled again to report the error to |fc_|.
+  bool failed_ = false;
+  mozilla::Maybe<size_t> failedModule_;
+
+  Vector<UniquePtr<ModuleGraphCompileTask>, 0, SystemAllocPolicy> helpers_;
+
+  using RequestKeyVector = Vector<UniqueChars, 0, SystemAllocPolicy>;
+
+ public:
+  ModuleGraphCompilation(FrontendContext* fc,
+                         const JS::ReadOnlyCompileOptions& options,
+                         JS::ModuleGraphLoader& loader)
+      : fc_(fc), options_(options), loader_(loader) {}
+  ~ModuleGraphCompilation();
+
+  [[nodiscard]] bool compile(const char* entryKey,
+                             JS::CompiledModuleGraph* graph);
+
+  // Compile modules until none remain to be compiled. Called with the helper
+  // thread lock held, by the compiling thread and by helper tasks.
+  void compileModules(FrontendContext* fc, AutoLockHelperThreadState& lock);
+
+ private:
+  [[nodiscard]] bool compileModule(FrontendContext* fc, Module& module,
+                                   RequestKeyVector& requestKeys);
+  [[nodiscard]] bool addRequestedModules(FrontendContext* fc, Module& module,
+                                         RequestKeyVector& requestKeys,
+                                         const AutoLockHelperThreadState& lock);
+
+  void startHelpers(const AutoLockHelperThreadState& lock);
+  void stopHelpers(AutoLockHelperThreadState& lock);
+
+  [[nodiscard]] bool sortModules(JS::CompiledModuleGraph* graph);
+};
+
+} /* namespace js */
+
+#endif /* vm_ModuleGraphCompilation_h */
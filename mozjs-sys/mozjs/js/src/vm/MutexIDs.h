@@ -50,15 +50,21 @@
   _(BufferStreamState, 500)           \
   _(SharedArrayGrow, 500)             \
   _(SharedImmutableScriptData, 500)   \
+  _(SharedParserAtoms, 500)           \
   _(WasmTypeIdSet, 500)               \
   _(WasmCodeProfilingLabels, 500)     \
   _(WasmCodeBytesEnd, 500)            \
   _(WasmStreamEnd, 500)               \
   _(WasmStreamStatus, 500)            \
   _(WasmRuntimeInstances, 500)        \
+  _(WasmMemoryImages, 500)            \
+  _(WasmMemoryPool, 500)              \
+  _(WasmModuleCache, 500)             \
+  _(WasmTierUpProfiles, 500)          \
   _(WasmSignalInstallState, 500)      \
   _(MemoryTracker, 500)               \
   _(StencilCache, 500)                \
+  _(DelazificationProfile, 500)       \
   _(SourceCompression, 500)           \
   _(GCDelayedMarkingLock, 500)        \
   _(BufferAllocator, 500)             \
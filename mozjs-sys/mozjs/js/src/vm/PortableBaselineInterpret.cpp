@@ -14,6 +14,7 @@
 
 #include "vm/PortableBaselineInterpret.h"
 
+#include "mozilla/Atomics.h"
 #include "mozilla/Maybe.h"
 #include <algorithm>
 
@@ -1146,6 +1147,17 @@ uint64_t ICInterpretOps(uint64_t arg0, uint64_t arg1, ICStub* stub,
         if (reinterpret_cast<uintptr_t>(obj->shape()) != expectedShape) {
           FAIL_IC();
         }
+        // A shape guard is almost always followed by the slot access or
+        // prototype-chain walk it protects.
+        PREDICT_NEXT(LoadFixedSlotResult);
+        PREDICT_NEXT(LoadDynamicSlotResult);
+        PREDICT_NEXT(StoreFixedSlot);
+        PREDICT_NEXT(StoreDynamicSlot);
+        PREDICT_NEXT(LoadFixedSlot);
+        PREDICT_NEXT(LoadDynamicSlot);
+        PREDICT_NEXT(LoadDenseElementResult);
+        PREDICT_NEXT(GuardProto);
+        PREDICT_NEXT(LoadProto);
         DISPATCH_CACHEOP();
       }
 
@@ -1343,6 +1355,7 @@ uint64_t ICInterpretOps(uint64_t arg0, uint64_t arg1, ICStub* stub,
         if (!obj->is<NativeObject>()) {
           FAIL_IC();
         }
+        PREDICT_NEXT(GuardShape);
         DISPATCH_CACHEOP();
       }
 
@@ -1687,6 +1700,7 @@ uint64_t ICInterpretOps(uint64_t arg0, uint64_t arg1, ICStub* stub,
             reinterpret_cast<uintptr_t>(obj) + offset);
         Value actual = slot->get();
         WRITE_VALUE_REG(resultId.id(), actual);
+        PREDICT_NEXT(GuardToObject);
         DISPATCH_CACHEOP();
       }
 
@@ -1703,6 +1717,7 @@ uint64_t ICInterpretOps(uint64_t arg0, uint64_t arg1, ICStub* stub,
         // rather than a byte offset.
         Value actual = slots[slot];
         WRITE_VALUE_REG(resultId.id(), actual);
+        PREDICT_NEXT(GuardToObject);
         DISPATCH_CACHEOP();
       }
 
@@ -1812,6 +1827,7 @@ uint64_t ICInterpretOps(uint64_t arg0, uint64_t arg1, ICStub* stub,
             reinterpret_cast<NativeObject*>(READ_REG(objId.id()));
         WRITE_REG(resultId.id(),
                   reinterpret_cast<uint64_t>(nobj->staticPrototype()), OBJECT);
+        PREDICT_NEXT(GuardShape);
         DISPATCH_CACHEOP();
       }
 
@@ -5905,6 +5921,43 @@ static EnvironmentObject& getEnvironmentFromCoordinate(
 #  define PREDICT_NEXT(op)
 #endif
 
+#ifdef DEBUG
+static mozilla::Atomic<uint64_t, mozilla::Relaxed> fusedBranchCount;
+
+uint64_t FusedBranchCountForTesting() { return fusedBranchCount; }
+
+#  define COUNT_FUSED_BRANCH() fusedBranchCount++
+#else
+#  define COUNT_FUSED_BRANCH()
+#endif
+
+// Comparisons are usually followed by a conditional jump. Once the boolean
+// result has been written to the stack, branch on it directly rather than
+// dispatching to the jump and re-testing the type of its operand. The result
+// is still pushed first so that a debugger stopping at the jump sees the same
+// stack as it would without the fused path.
+#if !defined(TRACE_INTERP)
+#  define END_OP_AND_BRANCH(op, result)                                  \
+    ADVANCE(JSOpLength_##op);                                            \
+    if (JSOp(*pc) == JSOp::JumpIfFalse || JSOp(*pc) == JSOp::JumpIfTrue) { \
+      static_assert(JSOpLength_JumpIfFalse == JSOpLength_JumpIfTrue);    \
+      DEBUG_CHECK();                                                     \
+      COUNT_FUSED_BRANCH();                                              \
+      VIRTPOP();                                                         \
+      NEXT_IC();                                                         \
+      if ((result) == (JSOp(*pc) == JSOp::JumpIfTrue)) {                 \
+        ADVANCE(GET_JUMP_OFFSET(pc));                                    \
+        PREDICT_NEXT(JumpTarget);                                        \
+        PREDICT_NEXT(LoopHead);                                          \
+      } else {                                                           \
+        ADVANCE(JSOpLength_JumpIfFalse);                                 \
+      }                                                                  \
+    }                                                                    \
+    DISPATCH();
+#else
+#  define END_OP_AND_BRANCH(op, result) END_OP(op)
+#endif
+
 #ifdef ENABLE_COVERAGE
 #  define COUNT_COVERAGE_PC(PC)                                 \
     if (frame->script()->hasScriptCounts()) {                   \
@@ -6823,7 +6876,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Eq);
+            END_OP_AND_BRANCH(Eq, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6854,7 +6907,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Ne);
+            END_OP_AND_BRANCH(Ne, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6885,7 +6938,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Lt);
+            END_OP_AND_BRANCH(Lt, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6897,7 +6950,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Lt);
+            END_OP_AND_BRANCH(Lt, result);
           }
         }
         goto generic_cmp;
@@ -6911,7 +6964,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Le);
+            END_OP_AND_BRANCH(Le, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6923,7 +6976,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Le);
+            END_OP_AND_BRANCH(Le, result);
           }
         }
         goto generic_cmp;
@@ -6937,7 +6990,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Gt);
+            END_OP_AND_BRANCH(Gt, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6949,7 +7002,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Gt);
+            END_OP_AND_BRANCH(Gt, result);
           }
         }
         goto generic_cmp;
@@ -6963,7 +7016,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Ge);
+            END_OP_AND_BRANCH(Ge, result);
           }
           if (v0.isNumber() && v1.isNumber()) {
             double lhs = v1.toNumber();
@@ -6975,7 +7028,7 @@ PBIResult PortableBaselineInterpret(
             VIRTPOP();
             VIRTSPWRITE(0, StackVal(BooleanValue(result)));
             NEXT_IC();
-            END_OP(Ge);
+            END_OP_AND_BRANCH(Ge, result);
           }
         }
         goto generic_cmp;
@@ -6999,12 +7052,13 @@ PBIResult PortableBaselineInterpret(
               GOTO_ERROR();
             }
           }
+          if (JSOp(*pc) == JSOp::StrictNe) {
+            result = !result;
+          }
           VIRTPOP();
-          VIRTSPWRITE(0,
-                      StackVal(BooleanValue(
-                          (JSOp(*pc) == JSOp::StrictEq) ? result : !result)));
+          VIRTSPWRITE(0, StackVal(BooleanValue(result)));
           NEXT_IC();
-          END_OP(StrictEq);
+          END_OP_AND_BRANCH(StrictEq, result);
         } else {
           goto generic_cmp;
         }
@@ -8685,7 +8739,9 @@ PBIResult PortableBaselineInterpret(
         } else {
           VIRTPUSH(StackVal(frame->argv()[i]));
         }
-        END_OP(GetArg);
+        ADVANCE(JSOpLength_GetArg);
+        PREDICT_NEXT(GetProp);
+        DISPATCH();
       }
 
       CASE(GetFrameArg) {
@@ -8698,7 +8754,9 @@ PBIResult PortableBaselineInterpret(
         uint32_t i = GET_LOCALNO(pc);
         TRACE_PRINTF(" -> local: %d\n", int(i));
         VIRTPUSH(StackVal(GETLOCAL(i)));
-        END_OP(GetLocal);
+        ADVANCE(JSOpLength_GetLocal);
+        PREDICT_NEXT(GetProp);
+        DISPATCH();
       }
 
       CASE(ArgumentsLength) {
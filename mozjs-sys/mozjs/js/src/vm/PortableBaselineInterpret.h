@@ -340,6 +340,12 @@ PBIResult PortableBaselineInterpret(
 uint8_t* GetPortableFallbackStub(jit::BaselineICFallbackKind kind);
 uint8_t* GetICInterpreter();
 
+#ifdef DEBUG
+// The number of conditional jumps which were executed together with the
+// comparison before them, rather than dispatched to separately.
+uint64_t FusedBranchCountForTesting();
+#endif
+
 } /* namespace pbl */
 } /* namespace js */
 
@@ -100,6 +100,7 @@ JSRuntime::JSRuntime(JSRuntime* parentRuntime)
       sizeOfIncludingThisCompartmentCallback(nullptr),
       destroyRealmCallback(nullptr),
       realmNameCallback(nullptr),
+      sourceCompressionCodec(js::SourceCompressionCodec::Zlib),
       securityCallbacks(&NullSecurityCallbacks),
       DOMcallbacks(nullptr),
       destroyPrincipals(nullptr),
@@ -805,6 +806,12 @@ JS_PUBLIC_API void JS::DisableRecordingAllocations(JSContext* cx) {
   cx->runtime()->stopRecordingAllocations();
 }
 
+JS_PUBLIC_API void js::SetSourceCompressionCodec(
+    JSContext* cx, SourceCompressionCodec codec) {
+  MOZ_ASSERT(cx);
+  cx->runtime()->sourceCompressionCodec = codec;
+}
+
 JS_PUBLIC_API void JS::shadow::RegisterWeakCache(
     JSRuntime* rt, detail::WeakCacheBase* cachep) {
   rt->registerWeakCache(cachep);
@@ -28,9 +28,10 @@
 #include "js/AllocationRecording.h"
 #include "js/BuildId.h"  // JS::BuildIdOp
 #include "js/Context.h"
-#include "js/experimental/CTypes.h"     // JS::CTypesActivityCallback
-#include "js/friend/StackLimits.h"      // js::ReportOverRecursed
-#include "js/friend/UsageStatistics.h"  // JSAccumulateTelemetryDataCallback
+#include "js/experimental/CTypes.h"       // JS::CTypesActivityCallback
+#include "js/friend/SourceCompression.h"  // js::SourceCompressionCodec
+#include "js/friend/StackLimits.h"        // js::ReportOverRecursed
+#include "js/friend/UsageStatistics.h"    // JSAccumulateTelemetryDataCallback
 #include "js/GCVector.h"
 #include "js/HashTable.h"
 #include "js/Initialization.h"
@@ -494,6 +495,9 @@ struct JSRuntime {
 
   js::MainThreadData<mozilla::UniquePtr<js::SourceHook>> sourceHook;
 
+  /* Codec used to compress the source text of scripts. */
+  js::MainThreadData<js::SourceCompressionCodec> sourceCompressionCodec;
+
   js::MainThreadData<const JSSecurityCallbacks*> securityCallbacks;
   js::MainThreadData<const js::DOMCallbacks*> DOMcallbacks;
   js::MainThreadData<JSDestroyPrincipalsOp> destroyPrincipals;
@@ -245,11 +245,18 @@ static typename ConcreteScope::ParserData* NewEmptyParserScopeData(
 
 template <typename ConcreteScope, typename AtomT>
 static UniquePtr<AbstractScopeData<ConcreteScope, AtomT>> NewEmptyScopeData(
-    JSContext* cx, uint32_t length = 0) {
+    JSContext* cx, uint32_t length = 0,
+    frontend::ScopeDataBuffer* preallocatedData = nullptr) {
   using Data = AbstractScopeData<ConcreteScope, AtomT>;
 
-  size_t dataSize = SizeOfScopeData<Data>(length);
-  uint8_t* bytes = cx->pod_malloc<uint8_t>(dataSize);
+  uint8_t* bytes;
+  if (preallocatedData && *preallocatedData) {
+    MOZ_ASSERT(preallocatedData->size() == SizeOfScopeData<Data>(length));
+    bytes = preallocatedData->release();
+  } else {
+    size_t dataSize = SizeOfScopeData<Data>(length);
+    bytes = cx->pod_malloc<uint8_t>(dataSize);
+  }
   auto data = reinterpret_cast<Data*>(bytes);
   if (data) {
     new (data) Data(length);
@@ -260,7 +267,8 @@ static UniquePtr<AbstractScopeData<ConcreteScope, AtomT>> NewEmptyScopeData(
 template <typename ConcreteScope>
 static UniquePtr<typename ConcreteScope::RuntimeData> LiftParserScopeData(
     JSContext* cx, frontend::CompilationAtomCache& atomCache,
-    BaseParserScopeData* baseData) {
+    BaseParserScopeData* baseData,
+    frontend::ScopeDataBuffer* preallocatedData) {
   using ConcreteData = typename ConcreteScope::RuntimeData;
 
   auto* data = static_cast<typename ConcreteScope::ParserData*>(baseData);
@@ -283,7 +291,8 @@ static UniquePtr<typename ConcreteScope::RuntimeData> LiftParserScopeData(
 
   // Allocate a new scope-data of the right kind.
   UniquePtr<ConcreteData> scopeData(
-      NewEmptyScopeData<ConcreteScope, JSAtom>(cx, data->length));
+      NewEmptyScopeData<ConcreteScope, JSAtom>(cx, data->length,
+                                               preallocatedData));
   if (!scopeData) {
     return nullptr;
   }
@@ -1669,20 +1678,22 @@ bool ScopeStencil::createForWithScope(FrontendContext* fc,
 
 template <typename SpecificScopeT>
 UniquePtr<typename SpecificScopeT::RuntimeData>
-ScopeStencil::createSpecificScopeData(JSContext* cx,
-                                      CompilationAtomCache& atomCache,
-                                      BaseParserScopeData* baseData) const {
-  return LiftParserScopeData<SpecificScopeT>(cx, atomCache, baseData);
+ScopeStencil::createSpecificScopeData(
+    JSContext* cx, CompilationAtomCache& atomCache,
+    BaseParserScopeData* baseData, ScopeDataBuffer* preallocatedData) const {
+  return LiftParserScopeData<SpecificScopeT>(cx, atomCache, baseData,
+                                             preallocatedData);
 }
 
 template <>
 UniquePtr<FunctionScope::RuntimeData>
 ScopeStencil::createSpecificScopeData<FunctionScope>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    BaseParserScopeData* baseData) const {
+    BaseParserScopeData* baseData, ScopeDataBuffer* preallocatedData) const {
   // Allocate a new vm function-scope.
   UniquePtr<FunctionScope::RuntimeData> data =
-      LiftParserScopeData<FunctionScope>(cx, atomCache, baseData);
+      LiftParserScopeData<FunctionScope>(cx, atomCache, baseData,
+                                         preallocatedData);
   if (!data) {
     return nullptr;
   }
@@ -1694,10 +1705,11 @@ template <>
 UniquePtr<ModuleScope::RuntimeData>
 ScopeStencil::createSpecificScopeData<ModuleScope>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    BaseParserScopeData* baseData) const {
+    BaseParserScopeData* baseData, ScopeDataBuffer* preallocatedData) const {
   // Allocate a new vm module-scope.
   UniquePtr<ModuleScope::RuntimeData> data =
-      LiftParserScopeData<ModuleScope>(cx, atomCache, baseData);
+      LiftParserScopeData<ModuleScope>(cx, atomCache, baseData,
+                                       preallocatedData);
   if (!data) {
     return nullptr;
   }
@@ -1709,7 +1721,8 @@ ScopeStencil::createSpecificScopeData<ModuleScope>(
 template <>
 Scope* ScopeStencil::createSpecificScope<WithScope, std::nullptr_t>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const {
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const {
   return Scope::create(cx, ScopeKind::With, enclosingScope, nullptr);
 }
 
@@ -1717,9 +1730,11 @@ Scope* ScopeStencil::createSpecificScope<WithScope, std::nullptr_t>(
 template <>
 Scope* ScopeStencil::createSpecificScope<GlobalScope, std::nullptr_t>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const {
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const {
   Rooted<UniquePtr<GlobalScope::RuntimeData>> rootedData(
-      cx, createSpecificScopeData<GlobalScope>(cx, atomCache, baseData));
+      cx, createSpecificScopeData<GlobalScope>(cx, atomCache, baseData,
+                                               preallocatedData));
   if (!rootedData) {
     return nullptr;
   }
@@ -1732,12 +1747,13 @@ Scope* ScopeStencil::createSpecificScope<GlobalScope, std::nullptr_t>(
 }
 
 template <typename SpecificScopeT, typename SpecificEnvironmentT>
-Scope* ScopeStencil::createSpecificScope(JSContext* cx,
-                                         CompilationAtomCache& atomCache,
-                                         Handle<Scope*> enclosingScope,
-                                         BaseParserScopeData* baseData) const {
+Scope* ScopeStencil::createSpecificScope(
+    JSContext* cx, CompilationAtomCache& atomCache,
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const {
   Rooted<UniquePtr<typename SpecificScopeT::RuntimeData>> rootedData(
-      cx, createSpecificScopeData<SpecificScopeT>(cx, atomCache, baseData));
+      cx, createSpecificScopeData<SpecificScopeT>(cx, atomCache, baseData,
+                                                  preallocatedData));
   if (!rootedData) {
     return nullptr;
   }
@@ -1755,24 +1771,30 @@ Scope* ScopeStencil::createSpecificScope(JSContext* cx,
 
 template Scope* ScopeStencil::createSpecificScope<FunctionScope, CallObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
 template Scope*
 ScopeStencil::createSpecificScope<LexicalScope, BlockLexicalEnvironmentObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
 template Scope* ScopeStencil::createSpecificScope<
     ClassBodyScope, BlockLexicalEnvironmentObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
 template Scope*
 ScopeStencil::createSpecificScope<EvalScope, VarEnvironmentObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
 template Scope*
 ScopeStencil::createSpecificScope<VarScope, VarEnvironmentObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
 template Scope*
 ScopeStencil::createSpecificScope<ModuleScope, ModuleEnvironmentObject>(
     JSContext* cx, CompilationAtomCache& atomCache,
-    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData) const;
+    Handle<Scope*> enclosingScope, BaseParserScopeData* baseData,
+    ScopeDataBuffer* preallocatedData) const;
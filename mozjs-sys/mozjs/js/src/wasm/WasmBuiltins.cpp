@@ -35,6 +35,7 @@
 #include "js/experimental/JitInfo.h"  // JSJitInfo
 #include "js/friend/ErrorMessages.h"  // js::GetErrorMessage, JSMSG_*
 #include "js/friend/StackLimits.h"    // js::AutoCheckRecursionLimit
+#include "js/WasmBuiltins.h"            // JS::RegisterWasmBuiltinNatives
 #include "threading/Mutex.h"
 #include "util/Memory.h"
 #include "util/Poison.h"
@@ -2002,6 +2003,113 @@ static bool PopulateTypedNatives(TypedNativeToFuncPtrMap* typedNatives) {
 #undef FOR_EACH_UNARY_NATIVE
 #undef FOR_EACH_BINARY_NATIVE
 
+// Natives of the embedding, registered with JS::RegisterWasmBuiltinNatives,
+// can be imported and called through thunks as well. Their typed functions
+// are keyed by their JSNative, as they have no InlinableNative.
+
+struct EmbedderNative {
+  ABIFunctionType abiType;
+  void* funcPtr;
+};
+
+using EmbedderNativeMap =
+    HashMap<void*, EmbedderNative, DefaultHasher<void*>, SystemAllocPolicy>;
+
+static void AppendABIType(uint32_t* abiType, ABIType type) {
+  *abiType <<= ABITypeArgShift;
+  *abiType |= uint32_t(type);
+}
+
+static Maybe<ABIType> ToEmbedderABIType(ValType type) {
+  switch (type.kind()) {
+    case ValType::I32:
+      return Some(ABIType::Int32);
+    case ValType::I64:
+      return Some(ABIType::Int64);
+    case ValType::F32:
+      return Some(ABIType::Float32);
+    case ValType::F64:
+      return Some(ABIType::Float64);
+    case ValType::Ref:
+      if (type.refType().kind() == RefType::Extern) {
+        return Some(ABIType::General);
+      }
+      return Nothing();
+    default:
+      return Nothing();
+  }
+}
+
+static ABIType ToEmbedderABIType(JS::WasmBuiltinType type) {
+  switch (type) {
+    case JS::WasmBuiltinType::I32:
+      return ABIType::Int32;
+    case JS::WasmBuiltinType::I64:
+      return ABIType::Int64;
+    case JS::WasmBuiltinType::F32:
+      return ABIType::Float32;
+    case JS::WasmBuiltinType::F64:
+      return ABIType::Float64;
+    case JS::WasmBuiltinType::ExternRef:
+      return ABIType::General;
+  }
+  MOZ_CRASH("unexpected WasmBuiltinType");
+}
+
+static bool HasTooManyABIArgs(size_t numArgs) {
+  return (numArgs + 1) > (sizeof(uint32_t) * 8 / ABITypeArgShift);
+}
+
+// The ABI type with which an import of type `funcType` would call a typed
+// function. A nullable externref result is required, as the typed function
+// may return null.
+static Maybe<ABIFunctionType> ToEmbedderABIFunctionType(
+    const FuncType& funcType) {
+  const ValTypeVector& args = funcType.args();
+  const ValTypeVector& results = funcType.results();
+
+  if (results.length() > 1 || HasTooManyABIArgs(args.length())) {
+    return Nothing();
+  }
+
+  uint32_t abiType = 0;
+  for (ValType arg : args) {
+    Maybe<ABIType> argType = ToEmbedderABIType(arg);
+    if (!argType) {
+      return Nothing();
+    }
+    AppendABIType(&abiType, *argType);
+  }
+
+  if (results.empty()) {
+    AppendABIType(&abiType, ABIType::Void);
+  } else {
+    Maybe<ABIType> resultType = ToEmbedderABIType(results[0]);
+    if (!resultType ||
+        (results[0].isRefType() && !results[0].refType().isNullable())) {
+      return Nothing();
+    }
+    AppendABIType(&abiType, *resultType);
+  }
+
+  return Some(ABIFunctionType(abiType));
+}
+
+static Maybe<ABIFunctionType> ToEmbedderABIFunctionType(
+    const JS::WasmBuiltinNative& native) {
+  if (HasTooManyABIArgs(native.numParams)) {
+    return Nothing();
+  }
+
+  uint32_t abiType = 0;
+  for (uint32_t i = 0; i < native.numParams; i++) {
+    AppendABIType(&abiType, ToEmbedderABIType(native.params[i]));
+  }
+  AppendABIType(&abiType, native.hasResult ? ToEmbedderABIType(native.result)
+                                           : ABIType::Void);
+  return Some(ABIFunctionType(abiType));
+}
+
 // ============================================================================
 // [SMDOC] Process-wide builtin thunk set
 //
@@ -2012,9 +2120,11 @@ static bool PopulateTypedNatives(TypedNativeToFuncPtrMap* typedNatives) {
 //  - executing an exit prologue/epilogue which in turn allows any profiling
 //    iterator to see the full stack up to the wasm operation that called out
 //
-// Thunks are created for two kinds of C++ callees, enumerated above:
+// Thunks are created for three kinds of C++ callees, enumerated above:
 //  - SymbolicAddress: for statically compiled calls in the wasm module
 //  - Imported JS builtins: optimized calls to imports
+//  - Imported embedder natives: likewise, registered before the thunks are
+//    created
 //
 // All thunks are created up front, lazily, when the first wasm module is
 // compiled in the process. Thunks are kept alive until the JS engine shuts down
@@ -2029,6 +2139,15 @@ static bool PopulateTypedNatives(TypedNativeToFuncPtrMap* typedNatives) {
 using TypedNativeToCodeRangeMap =
     HashMap<TypedNative, uint32_t, TypedNative, SystemAllocPolicy>;
 
+struct EmbedderNativeCodeRange {
+  ABIFunctionType abiType;
+  uint32_t codeRangeIndex;
+};
+
+using EmbedderNativeToCodeRangeMap =
+    HashMap<void*, EmbedderNativeCodeRange, DefaultHasher<void*>,
+            SystemAllocPolicy>;
+
 using SymbolicAddressToCodeRangeArray =
     EnumeratedArray<SymbolicAddress, uint32_t, size_t(SymbolicAddress::Limit)>;
 
@@ -2037,6 +2156,7 @@ struct BuiltinThunks {
   size_t codeSize;
   CodeRangeVector codeRanges;
   TypedNativeToCodeRangeMap typedNativeToCodeRange;
+  EmbedderNativeToCodeRangeMap embedderNativeToCodeRange;
   SymbolicAddressToCodeRangeArray symbolicAddressToCodeRange;
   uint32_t provisionalLazyJitEntryOffset;
 
@@ -2052,6 +2172,10 @@ struct BuiltinThunks {
 MOZ_RUNINIT Mutex initBuiltinThunks(mutexid::WasmInitBuiltinThunks);
 mozilla::Atomic<const BuiltinThunks*> builtinThunks;
 
+// Protected by initBuiltinThunks, and only changed before builtinThunks is
+// created.
+static EmbedderNativeMap* embedderNatives = nullptr;
+
 bool wasm::EnsureBuiltinThunksInitialized() {
   AutoMarkJitCodeWritableForThread writable;
   return EnsureBuiltinThunksInitialized(writable);
@@ -2125,6 +2249,31 @@ bool wasm::EnsureBuiltinThunksInitialized(
     }
   }
 
+  if (embedderNatives) {
+    for (EmbedderNativeMap::Range r = embedderNatives->all(); !r.empty();
+         r.popFront()) {
+      const EmbedderNative& native = r.front().value();
+
+      uint32_t codeRangeIndex = thunks->codeRanges.length();
+      if (!thunks->embedderNativeToCodeRange.putNew(
+              r.front().key(),
+              EmbedderNativeCodeRange{native.abiType, codeRangeIndex})) {
+        return false;
+      }
+
+      ExitReason exitReason = ExitReason::Fixed::BuiltinNative;
+
+      CallableOffsets offsets;
+      if (!GenerateBuiltinThunk(masm, native.abiType, exitReason,
+                                native.funcPtr, &offsets)) {
+        return false;
+      }
+      if (!thunks->codeRanges.emplaceBack(CodeRange::BuiltinThunk, offsets)) {
+        return false;
+      }
+    }
+  }
+
   // Provisional lazy JitEntry stub: This is a shared stub that can be installed
   // in the jit-entry jump table.  It uses the JIT ABI and when invoked will
   // retrieve (via TlsContext()) and invoke the context-appropriate
@@ -2191,6 +2340,59 @@ void wasm::ReleaseBuiltinThunks() {
     js_delete(const_cast<BuiltinThunks*>(ptr));
     builtinThunks = nullptr;
   }
+  js_delete(embedderNatives);
+  embedderNatives = nullptr;
+}
+
+JS_PUBLIC_API bool JS::RegisterWasmBuiltinNatives(
+    const WasmBuiltinNative* natives, size_t numNatives) {
+  LockGuard<Mutex> guard(initBuiltinThunks);
+  if (builtinThunks) {
+    return false;
+  }
+
+#ifdef JS_SIMULATOR
+  // The simulator can only redirect calls with the ABI types it knows of.
+  return true;
+#else
+  // Check every signature before registering anything, so that a failure
+  // leaves no native of this call registered.
+  for (size_t i = 0; i < numNatives; i++) {
+    MOZ_ASSERT(natives[i].native && natives[i].typedFunc);
+    if (!ToEmbedderABIFunctionType(natives[i])) {
+      return false;
+    }
+  }
+
+  if (!embedderNatives) {
+    embedderNatives = js_new<EmbedderNativeMap>();
+    if (!embedderNatives) {
+      return false;
+    }
+  }
+
+  // Reserve room for all of the natives, so that adding them can't fail.
+  size_t capacity = embedderNatives->count() + numNatives;
+  if (capacity > UINT32_MAX || !embedderNatives->reserve(capacity)) {
+    if (embedderNatives->empty()) {
+      js_delete(embedderNatives);
+      embedderNatives = nullptr;
+    }
+    return false;
+  }
+
+  for (size_t i = 0; i < numNatives; i++) {
+    const WasmBuiltinNative& native = natives[i];
+    EmbedderNative entry{*ToEmbedderABIFunctionType(native), native.typedFunc};
+    void* key = JS_FUNC_TO_DATA_PTR(void*, native.native);
+    if (EmbedderNativeMap::Ptr p = embedderNatives->lookup(key)) {
+      p->value() = entry;
+    } else {
+      embedderNatives->putNewInfallible(key, entry);
+    }
+  }
+  return true;
+#endif
 }
 
 void* wasm::SymbolicAddressTarget(SymbolicAddress sym) {
@@ -2259,9 +2461,35 @@ static Maybe<ABIFunctionType> ToBuiltinABIFunctionType(
   return Some(ABIFunctionType(abiType));
 }
 
+static void* MaybeGetEmbedderNativeThunk(const BuiltinThunks& thunks,
+                                         JSFunction* f,
+                                         const FuncType& funcType) {
+  auto p = thunks.embedderNativeToCodeRange.readonlyThreadsafeLookup(
+      JS_FUNC_TO_DATA_PTR(void*, f->native()));
+  if (!p) {
+    return nullptr;
+  }
+
+  // The typed function can only be called with the signature it was
+  // registered with.
+  Maybe<ABIFunctionType> abiType = ToEmbedderABIFunctionType(funcType);
+  if (!abiType || *abiType != p->value().abiType) {
+    return nullptr;
+  }
+
+  return thunks.codeBase + thunks.codeRanges[p->value().codeRangeIndex].begin();
+}
+
 void* wasm::MaybeGetBuiltinThunk(JSFunction* f, const FuncType& funcType) {
   MOZ_ASSERT(builtinThunks);
 
+  const BuiltinThunks& thunks = *builtinThunks;
+  if (f->isNativeFun() && !thunks.embedderNativeToCodeRange.empty()) {
+    if (void* thunk = MaybeGetEmbedderNativeThunk(thunks, f, funcType)) {
+      return thunk;
+    }
+  }
+
   if (!f->isNativeFun() || !f->hasJitInfo() ||
       f->jitInfo()->type() != JSJitInfo::InlinableNative) {
     return nullptr;
@@ -2272,8 +2500,6 @@ void* wasm::MaybeGetBuiltinThunk(JSFunction* f, const FuncType& funcType) {
     return nullptr;
   }
 
-  const BuiltinThunks& thunks = *builtinThunks;
-
   // If this function must use the fdlibm implementation first try to lookup
   // the fdlibm version. If that version doesn't exist we still fallback to
   // the normal native.
@@ -46,10 +46,13 @@
 using namespace js;
 using namespace js::jit;
 using namespace js::wasm;
+using mozilla::AddToHash;
 using mozilla::Atomic;
 using mozilla::BinarySearch;
 using mozilla::BinarySearchIf;
 using mozilla::DebugOnly;
+using mozilla::HashBytes;
+using mozilla::HashGeneric;
 using mozilla::MakeEnumeratedRange;
 using mozilla::MallocSizeOf;
 using mozilla::Maybe;
@@ -683,6 +686,103 @@ bool Code::requestTierUp(uint32_t funcIndex) const {
   return true;
 }
 
+// See JS::SetWasmTierUpProfile.
+using TierUpProfileMap =
+    HashMap<HashNumber, JS::WasmTierUpProfile, DefaultHasher<HashNumber>,
+            SystemAllocPolicy>;
+
+static ExclusiveData<TierUpProfileMap>* sTierUpProfiles = nullptr;
+
+bool wasm::InitTierUpProfiles() {
+  MOZ_ASSERT(!sTierUpProfiles);
+  sTierUpProfiles =
+      js_new<ExclusiveData<TierUpProfileMap>>(mutexid::WasmTierUpProfiles);
+  return !!sTierUpProfiles;
+}
+
+void wasm::ShutDownTierUpProfiles() {
+  js_delete(sTierUpProfiles);
+  sTierUpProfiles = nullptr;
+}
+
+HashNumber Code::tierUpProfileKey() const {
+  // Function indices include the imported functions, so the key covers their
+  // number too.
+  HashNumber hash = HashGeneric(codeMeta_->numFuncImports);
+  if (const SharedBytes& codeSection = codeTailMeta_->codeSectionBytecode) {
+    hash = AddToHash(hash, HashBytes(codeSection->begin(),
+                                     codeSection->length()));
+  }
+  return hash;
+}
+
+bool Code::tierUpProfile(JS::WasmTierUpProfile* profile) const {
+  if (mode_ != CompileMode::LazyTiering) {
+    return true;
+  }
+  for (uint32_t funcIndex = codeMeta_->numFuncImports;
+       funcIndex < codeMeta_->numFuncs(); funcIndex++) {
+    const FuncState& state =
+        funcStates_[funcIndex - codeMeta_->numFuncImports];
+    if (state.tierUpState != TierUpState::NotRequested &&
+        !profile->append(funcIndex)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Code::requestProfiledTierUps() const {
+  MOZ_ASSERT(mode_ == CompileMode::LazyTiering);
+
+  // Copy the profile, so that the tasks are not started with the lock held.
+  JS::WasmTierUpProfile profile;
+  {
+    auto profiles = sTierUpProfiles->lock();
+    if (profiles->empty()) {
+      return;
+    }
+    TierUpProfileMap::Ptr p = profiles->lookup(tierUpProfileKey());
+    if (!p || !profile.appendAll(p->value())) {
+      return;
+    }
+  }
+
+  // The profile is provided by the embedding, and may not match the module if
+  // the hashes collide.
+  for (uint32_t funcIndex : profile) {
+    if (funcIndex < codeMeta_->numFuncImports ||
+        funcIndex >= codeMeta_->numFuncs()) {
+      continue;
+    }
+    if (!requestTierUp(funcIndex)) {
+      return;
+    }
+  }
+}
+
+JS_PUBLIC_API bool JS::GetWasmTierUpProfile(const WasmModule& module,
+                                            uint32_t* moduleHash,
+                                            WasmTierUpProfile& profile) {
+  const Code& code = static_cast<const Module&>(module).code();
+  *moduleHash = code.tierUpProfileKey();
+  return code.tierUpProfile(&profile);
+}
+
+JS_PUBLIC_API bool JS::SetWasmTierUpProfile(uint32_t moduleHash,
+                                            const WasmTierUpProfile& profile) {
+  WasmTierUpProfile copy;
+  if (!copy.appendAll(profile)) {
+    return false;
+  }
+  auto profiles = sTierUpProfiles->lock();
+  return profiles->put(moduleHash, std::move(copy));
+}
+
+JS_PUBLIC_API void JS::ClearWasmTierUpProfiles() {
+  sTierUpProfiles->lock()->clearAndCompact();
+}
+
 bool Code::finishTier2(UniqueCodeBlock tier2CodeBlock,
                        UniqueLinkData tier2LinkData,
                        const CompileAndLinkStats& tier2Stats) const {
@@ -780,8 +880,16 @@ bool Code::finishTier2(UniqueCodeBlock tier2CodeBlock,
 
 bool Code::addCodeBlock(const WriteGuard& guard, UniqueCodeBlock block,
                         UniqueLinkData maybeLinkData) const {
-  // Don't bother saving the link data if the block won't be serialized
-  if (maybeLinkData && !block->isSerializable()) {
+  // Don't bother saving the link data if the block won't be serialized. Lazy
+  // tiering serializes its baseline code, as there is no complete tier-2, but
+  // only if serialization has been requested.
+  bool isSerializable = block->isSerializable();
+  if (mode_ == CompileMode::LazyTiering) {
+    isSerializable = keepLazyTieringLinkData_ &&
+                     (block->kind == CodeBlockKind::BaselineTier ||
+                      block->kind == CodeBlockKind::OptimizedTier);
+  }
+  if (maybeLinkData && !isSerializable) {
     maybeLinkData = nullptr;
   }
 
@@ -796,7 +904,15 @@ bool Code::addCodeBlock(const WriteGuard& guard, UniqueCodeBlock block,
 SharedCodeSegment Code::createFuncCodeSegmentFromPool(
     jit::MacroAssembler& masm, const LinkData& linkData, bool allowLastDitchGC,
     uint8_t** codeStartOut, uint32_t* codeLengthOut) const {
-  uint32_t codeLength = masm.bytesNeeded();
+  CodeSource codeSource(masm, &linkData, this);
+  return createFuncCodeSegmentFromPool(codeSource, allowLastDitchGC,
+                                       codeStartOut, codeLengthOut);
+}
+
+SharedCodeSegment Code::createFuncCodeSegmentFromPool(
+    const CodeSource& codeSource, bool allowLastDitchGC,
+    uint8_t** codeStartOut, uint32_t* codeLengthOut) const {
+  uint32_t codeLength = codeSource.lengthBytes();
 
   // Allocate the code segment
   uint8_t* codeStart;
@@ -804,7 +920,6 @@ SharedCodeSegment Code::createFuncCodeSegmentFromPool(
   SharedCodeSegment segment;
   {
     auto guard = data_.writeLock();
-    CodeSource codeSource(masm, &linkData, this);
     segment =
         CodeSegment::allocate(codeSource, &guard->lazyFuncSegments,
                               allowLastDitchGC, &codeStart, &allocationLength);
@@ -1160,8 +1275,10 @@ bool JumpTables::initialize(CompileMode mode, const CodeMetadata& codeMeta,
 
 Code::Code(CompileMode mode, const CodeMetadata& codeMeta,
            const CodeTailMetadata& codeTailMeta,
-           const CodeMetadataForAsmJS* codeMetaForAsmJS)
+           const CodeMetadataForAsmJS* codeMetaForAsmJS,
+           bool keepLazyTieringLinkData)
     : mode_(mode),
+      keepLazyTieringLinkData_(keepLazyTieringLinkData),
       data_(mutexid::WasmCodeProtected),
       codeMeta_(&codeMeta),
       codeTailMeta_(&codeTailMeta),
@@ -1299,6 +1416,23 @@ const LinkData* Code::codeBlockLinkData(const CodeBlock& block) const {
   return guard->blocksLinkData[block.codeBlockIndex].get();
 }
 
+bool Code::partialTier2CodeBlocks(SerializableCodeBlockVector* blocks) const {
+  MOZ_ASSERT(mode_ == CompileMode::LazyTiering);
+  auto guard = data_.readLock();
+  for (size_t i = 0; i < guard->blocks.length(); i++) {
+    const CodeBlock& block = *guard->blocks[i];
+    if (block.kind != CodeBlockKind::OptimizedTier) {
+      continue;
+    }
+    MOZ_ASSERT(guard->blocksLinkData[i]);
+    if (!blocks->append(
+            SerializableCodeBlock{&block, guard->blocksLinkData[i].get()})) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void Code::clearLinkData() const {
   auto guard = data_.writeLock();
   for (UniqueLinkData& linkData : guard->blocksLinkData) {
@@ -45,6 +45,7 @@
 #include "js/UniquePtr.h"
 #include "js/Utility.h"
 #include "js/Vector.h"
+#include "js/WasmModule.h"
 #include "threading/ExclusiveData.h"
 #include "util/Memory.h"
 #include "vm/MutexIDs.h"
@@ -954,6 +955,11 @@ using MutableCode = RefPtr<Code>;
 using MetadataAnalysisHashMap =
     HashMap<const char*, uint32_t, mozilla::CStringHasher, SystemAllocPolicy>;
 
+// Create and destroy the registry of tier-up profiles, called by wasm::Init and
+// wasm::ShutDown.
+[[nodiscard]] bool InitTierUpProfiles();
+void ShutDownTierUpProfiles();
+
 class Code : public ShareableBase<Code> {
   struct ProtectedData {
     // A vector of all of the code blocks owned by this code. Each code block
@@ -982,6 +988,12 @@ class Code : public ShareableBase<Code> {
   // The compile mode this code is used with.
   const CompileMode mode_;
 
+  // Whether lazily tiered code keeps the link data of its baseline and partial
+  // tier-2 code blocks, so that it can be serialized. Lazily tiered code adds
+  // code blocks for as long as it lives, so this is only done when
+  // serialization has been requested.
+  const bool keepLazyTieringLinkData_;
+
   // Core data that is not thread-safe and must acquire a lock in order to
   // access.
   RWExclusiveData<ProtectedData> data_;
@@ -1084,7 +1096,8 @@ class Code : public ShareableBase<Code> {
  public:
   Code(CompileMode mode, const CodeMetadata& codeMeta,
        const CodeTailMetadata& codeTailMeta,
-       const CodeMetadataForAsmJS* codeMetaForAsmJS);
+       const CodeMetadataForAsmJS* codeMetaForAsmJS,
+       bool keepLazyTieringLinkData = false);
   ~Code();
 
   [[nodiscard]] bool initialize(FuncImportVector&& funcImports,
@@ -1105,9 +1118,20 @@ class Code : public ShareableBase<Code> {
       jit::MacroAssembler& masm, const LinkData& linkData,
       bool allowLastDitchGC, uint8_t** codeStartOut,
       uint32_t* codeLengthOut) const;
+  SharedCodeSegment createFuncCodeSegmentFromPool(
+      const CodeSource& codeSource, bool allowLastDitchGC,
+      uint8_t** codeStartOut, uint32_t* codeLengthOut) const;
 
   bool requestTierUp(uint32_t funcIndex) const;
 
+  // The key of the tier-up profiles of this code, see JS::WasmTierUpProfile.
+  HashNumber tierUpProfileKey() const;
+  // Append the functions which were requested to tier up to `profile`.
+  [[nodiscard]] bool tierUpProfile(JS::WasmTierUpProfile* profile) const;
+  // Request the tier-up of the functions of the profile registered for this
+  // code, if any.
+  void requestProfiledTierUps() const;
+
   CompileMode mode() const { return mode_; }
 
   void** tieringJumpTable() const { return jumpTables_.tiering(); }
@@ -1150,7 +1174,12 @@ class Code : public ShareableBase<Code> {
   // The 'best' complete tier of code. This may transition from baseline to ion
   // at any time.
   Tier bestCompleteTier() const;
-  bool hasSerializableCode() const { return hasCompleteTier(Tier::Serialized); }
+  bool hasSerializableCode() const {
+    if (mode_ == CompileMode::LazyTiering) {
+      return keepLazyTieringLinkData_;
+    }
+    return hasCompleteTier(Tier::Serialized);
+  }
 
   const CodeMetadata& codeMeta() const { return *codeMeta_; }
   const CodeMetadataForAsmJS* codeMetaForAsmJS() const {
@@ -1195,6 +1224,20 @@ class Code : public ShareableBase<Code> {
   const LinkData* codeBlockLinkData(const CodeBlock& block) const;
   void clearLinkData() const;
 
+  // A code block along with the link data to serialize it.
+  struct SerializableCodeBlock {
+    const CodeBlock* codeBlock;
+    const LinkData* linkData;
+  };
+  using SerializableCodeBlockVector =
+      Vector<SerializableCodeBlock, 0, SystemAllocPolicy>;
+
+  // Get the code blocks of the functions which have been compiled by partial
+  // tier-2 compilation so far, in the order they were finished. Only valid for
+  // lazy tiering.
+  [[nodiscard]] bool partialTier2CodeBlocks(
+      SerializableCodeBlockVector* blocks) const;
+
   // Code metadata lookup:
   bool lookupCallSite(void* pc, CallSite* callSite) const {
     const CodeBlock* block = blockMap_.lookup(pc);
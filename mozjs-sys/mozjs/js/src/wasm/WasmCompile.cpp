@@ -41,6 +41,7 @@
 #include "wasm/WasmFeatures.h"
 #include "wasm/WasmGenerator.h"
 #include "wasm/WasmIonCompile.h"
+#include "wasm/WasmModuleCache.h"
 #include "wasm/WasmOpIter.h"
 #include "wasm/WasmProcess.h"
 #include "wasm/WasmSignalHandlers.h"
@@ -974,6 +975,17 @@ SharedModule wasm::CompileBuffer(const CompileArgs& args,
                                  UniqueChars* error,
                                  UniqueCharsVector* warnings,
                                  JS::OptimizedEncodingListener* listener) {
+  // Reuse the module compiled from the same bytecode by any runtime, see
+  // [SMDOC] Module cache.
+  bool cacheable = IsModuleCacheable(args, listener);
+  HashNumber cacheHash = 0;
+  if (cacheable) {
+    if (SharedModule module =
+            FindCachedModule(args, bytecode.source(), &cacheHash)) {
+      return module;
+    }
+  }
+
   MutableModuleMetadata moduleMeta = js_new<ModuleMetadata>();
   if (!moduleMeta || !moduleMeta->init(args)) {
     return nullptr;
@@ -1044,7 +1056,11 @@ SharedModule wasm::CompileBuffer(const CompileArgs& args,
     MOZ_RELEASE_ASSERT(envDecoder.done());
   }
 
-  return mg.finishModule(bytecode, *moduleMeta, listener);
+  SharedModule module = mg.finishModule(bytecode, *moduleMeta, listener);
+  if (!module || !cacheable || (warnings && !warnings->empty())) {
+    return module;
+  }
+  return CacheModule(cacheHash, args, bytecode, module);
 }
 
 bool wasm::CompileCompleteTier2(const ShareableBytes* codeSection,
@@ -1216,6 +1216,9 @@ static const size_t SuspendableRedZoneSize = 0x6000;
 static constexpr size_t SuspendableStackPlusRedZoneSize =
     SuspendableStackSize + SuspendableRedZoneSize;
 
+// Limit for the amount of released stacks kept by a context for reuse.
+static const size_t SuspendableStacksPoolMaxCount = 4;
+
 // Asserted by Decoder::readVarU32.
 
 static const unsigned MaxVarU32DecodedBytes = 5;
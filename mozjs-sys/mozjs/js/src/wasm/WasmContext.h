@@ -21,6 +21,9 @@
 
 #include "mozilla/DoublyLinkedList.h"
 
+#include "js/AllocPolicy.h"
+#include "js/Vector.h"
+
 namespace js::wasm {
 
 #ifdef ENABLE_WASM_JSPI
@@ -33,12 +36,21 @@ class SuspenderContext {
   HeapPtr<SuspenderObject*> activeSuspender_;
   // Using double-linked list to avoid allocation in the JIT code.
   mozilla::DoublyLinkedList<SuspenderObjectData> suspendedStacks_;
+  // Stack memory of released suspenders, reused by new suspenders as the
+  // allocation of a stack is expensive compared to a suspend and resume.
+  Vector<void*, 0, SystemAllocPolicy> stackPool_;
 
  public:
   SuspenderContext();
   ~SuspenderContext();
   SuspenderObject* activeSuspender();
   void setActiveSuspender(SuspenderObject* obj);
+
+  // Allocate the memory of a suspendable stack, of
+  // SuspendableStackPlusRedZoneSize bytes, or return null on OOM.
+  void* allocateStackMemory();
+  void releaseStackMemory(void* stackMemory);
+
   void trace(JSTracer* trc);
   void traceRoots(JSTracer* trc);
 
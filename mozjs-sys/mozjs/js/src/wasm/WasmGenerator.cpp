@@ -1385,8 +1385,12 @@ SharedModule ModuleGenerator::finishModule(
       FuncIonPerfSpewerSpan(tier1Result.funcIonSpewers),
       FuncBaselinePerfSpewerSpan(tier1Result.funcBaselineSpewers));
 
-  MutableCode code =
-      js_new<Code>(mode(), *codeMeta_, *codeTailMeta, codeMetaForAsmJS_);
+  // Lazily tiered code only keeps what it needs to be serialized if there is a
+  // listener for its optimized encoding. Testing serialization disables lazy
+  // tiering.
+  bool keepLazyTieringLinkData = maybeCompleteTier2Listener != nullptr;
+  MutableCode code = js_new<Code>(mode(), *codeMeta_, *codeTailMeta,
+                                  codeMetaForAsmJS_, keepLazyTieringLinkData);
   if (!code || !code->initialize(std::move(funcImports_),
                                  std::move(sharedStubs_.codeBlock),
                                  std::move(sharedStubs_.linkData),
@@ -1437,6 +1441,11 @@ SharedModule ModuleGenerator::finishModule(
     }
   }
 
+  // Tier up right away the functions which were hot in previous executions.
+  if (mode() == CompileMode::LazyTiering) {
+    module->code().requestProfiledTierUps();
+  }
+
   if (compileState_ == CompileState::EagerTier1) {
     // Grab or allocate a copy of the code section bytecode
     SharedBytes codeSection;
@@ -930,7 +930,8 @@ static bool AllSegmentsArePassive(const DataSegmentVector& vec) {
 
 bool Instance::initSegments(JSContext* cx,
                             const DataSegmentVector& dataSegments,
-                            const ModuleElemSegmentVector& elemSegments) {
+                            const ModuleElemSegmentVector& elemSegments,
+                            const MemoryImageMask& memoriesFromImage) {
   MOZ_ASSERT_IF(codeMeta().memories.length() == 0,
                 AllSegmentsArePassive(dataSegments));
 
@@ -964,7 +965,9 @@ bool Instance::initSegments(JSContext* cx,
   }
 
   for (const DataSegment* seg : dataSegments) {
-    if (!seg->active()) {
+    // Memories initialized from an image already contain their segments, see
+    // [SMDOC] Memory images.
+    if (!seg->active() || memoriesFromImage[seg->memoryIndex]) {
       continue;
     }
 
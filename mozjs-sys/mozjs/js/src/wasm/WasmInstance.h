@@ -31,6 +31,7 @@
 #include "vm/SharedMem.h"
 #include "wasm/WasmExprType.h"  // for ResultType
 #include "wasm/WasmLog.h"       // for PrintCallback
+#include "wasm/WasmMemoryImage.h"
 #include "wasm/WasmModuleTypes.h"
 #include "wasm/WasmShareable.h"  // for SeenSet
 #include "wasm/WasmTypeDecls.h"
@@ -458,7 +459,8 @@ class alignas(16) Instance {
   void onMovingGrowTable(const Table* table);
 
   bool initSegments(JSContext* cx, const DataSegmentVector& dataSegments,
-                    const ModuleElemSegmentVector& elemSegments);
+                    const ModuleElemSegmentVector& elemSegments,
+                    const MemoryImageMask& memoriesFromImage);
 
   // Called to apply a single ElemSegment at a given offset, assuming
   // that all bounds validation has already been performed.
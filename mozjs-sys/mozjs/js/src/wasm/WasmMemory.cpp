@@ -19,10 +19,18 @@
 #include "wasm/WasmMemory.h"
 
 #include "mozilla/MathAlgorithms.h"
+#include "mozilla/TaggedAnonymousMemory.h"
+
+#if !defined(XP_WIN) && !defined(__wasi__)
+#  include <sys/mman.h>
+#endif
 
 #include "js/Conversions.h"
 #include "js/ErrorReport.h"
+#include "js/WasmModule.h"
+#include "threading/ExclusiveData.h"
 #include "vm/ArrayBufferObject.h"
+#include "vm/MutexIDs.h"
 #include "wasm/WasmCodegenTypes.h"
 #include "wasm/WasmProcess.h"
 
@@ -450,3 +458,113 @@ uint64_t wasm::RoundUpToNextValidBoundsCheckImmediate(uint64_t i) {
   return i;
 #endif
 }
+
+// See [SMDOC] Memory pool in WasmMemory.h. Reservations are only pooled where
+// pages can be discarded while keeping the reservation.
+
+namespace {
+
+struct PooledMemory {
+  void* base;
+  size_t mappedSize;
+};
+
+struct MemoryPool {
+  size_t maxMemories = 0;
+  // The sum of the mappedSize of `memories`.
+  uint64_t mappedBytes = 0;
+  Vector<PooledMemory, 0, SystemAllocPolicy> memories;
+};
+
+}  // namespace
+
+static ExclusiveData<MemoryPool>* sMemoryPool = nullptr;
+
+bool wasm::InitMemoryPool() {
+  MOZ_ASSERT(!sMemoryPool);
+  sMemoryPool = js_new<ExclusiveData<MemoryPool>>(mutexid::WasmMemoryPool);
+  return !!sMemoryPool;
+}
+
+static void ShrinkMemoryPool(MemoryPool& pool, size_t maxMemories) {
+  while (pool.memories.length() > maxMemories) {
+    PooledMemory memory = pool.memories.popCopy();
+    pool.mappedBytes -= memory.mappedSize;
+#if !defined(XP_WIN) && !defined(__wasi__)
+    munmap(memory.base, memory.mappedSize);
+#else
+    (void)memory;
+#endif
+  }
+}
+
+void wasm::ShutDownMemoryPool() {
+  if (!sMemoryPool) {
+    return;
+  }
+  ShrinkMemoryPool(sMemoryPool->lock().get(), 0);
+  js_delete(sMemoryPool);
+  sMemoryPool = nullptr;
+}
+
+void* wasm::TakePooledMemory(size_t mappedSize) {
+  auto pool = sMemoryPool->lock();
+  auto& memories = pool->memories;
+  for (size_t i = memories.length(); i > 0; i--) {
+    if (memories[i - 1].mappedSize == mappedSize) {
+      void* base = memories[i - 1].base;
+      memories.erase(&memories[i - 1]);
+      pool->mappedBytes -= mappedSize;
+      return base;
+    }
+  }
+  return nullptr;
+}
+
+bool wasm::PoolReleasedMemory(void* base, size_t mappedSize,
+                              size_t committedSize) {
+#if !defined(XP_WIN) && !defined(__wasi__)
+  {
+    auto pool = sMemoryPool->lock();
+    if (pool->memories.length() >= pool->maxMemories) {
+      return false;
+    }
+  }
+
+  // Replacing the committed pages discards them, along with any memory image
+  // mapped over them, and leaves them inaccessible. madvise(MADV_DONTNEED)
+  // would restore the contents of a memory image instead of zeroes.
+  void* data =
+      MozTaggedAnonymousMmap(base, committedSize, PROT_NONE,
+                             MAP_PRIVATE | MAP_ANON | MAP_FIXED, -1, 0,
+                             "wasm-reserved");
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  auto pool = sMemoryPool->lock();
+  if (pool->memories.length() >= pool->maxMemories ||
+      !pool->memories.append(PooledMemory{base, mappedSize})) {
+    return false;
+  }
+  pool->mappedBytes += mappedSize;
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t wasm::PooledMemoryBytes() {
+  return sMemoryPool->lock()->mappedBytes;
+}
+
+void wasm::ReleasePooledMemory() {
+  ShrinkMemoryPool(sMemoryPool->lock().get(), 0);
+}
+
+JS_PUBLIC_API void JS::SetWasmMemoryPoolSize(size_t maxMemories) {
+  MOZ_ASSERT(sMemoryPool, "must be called after JS_Init");
+  auto pool = sMemoryPool->lock();
+  pool->maxMemories = maxMemories;
+  ShrinkMemoryPool(pool.get(), maxMemories);
+}
@@ -212,6 +212,42 @@ static const size_t GuardSize = PageSize;
 // for a structure fields operations.
 static const size_t NullPtrGuardSize = 4096;
 
+// [SMDOC] Memory pool
+//
+// Mapping and unmapping the reservation of a memory, which can span several
+// gigabytes of address space with its guard pages, dominates the cost of
+// instantiating and releasing short-lived instances. When enabled with
+// JS::SetWasmMemoryPoolSize, released reservations are kept in a process-wide
+// pool instead, and reused by new memories whose reservation has the same
+// size.
+//
+// A reservation is returned to the pool with all its pages made inaccessible
+// and discarded, as if it was newly mapped, so that taking it from the pool
+// only commits the initial pages. Pooled reservations are not counted in
+// WasmReservedBytes(), but they still count against the limit on the address
+// space reserved for wasm memories. The pool is emptied before a new
+// reservation fails for exceeding that limit.
+
+// Create and destroy the pool, called by wasm::Init and wasm::ShutDown.
+[[nodiscard]] extern bool InitMemoryPool();
+extern void ShutDownMemoryPool();
+
+// Take a pooled reservation of `mappedSize` bytes, or return null if there is
+// none.
+extern void* TakePooledMemory(size_t mappedSize);
+
+// Offer the reservation of a released memory to the pool, discarding its first
+// `committedSize` bytes. Returns false if the reservation is not pooled, in
+// which case the caller must unmap it.
+extern bool PoolReleasedMemory(void* base, size_t mappedSize,
+                               size_t committedSize);
+
+// The number of bytes reserved by the pooled reservations.
+extern uint64_t PooledMemoryBytes();
+
+// Unmap all the pooled reservations, leaving the pool empty.
+extern void ReleasePooledMemory();
+
 // Check if a range of wasm memory is within bounds, specified as byte offset
 // and length (using 32-bit indices). Omits one check by converting from
 // uint32_t to uint64_t, at which point overflow cannot occur.
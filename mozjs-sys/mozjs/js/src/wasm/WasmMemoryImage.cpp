@@ -0,0 +1,196 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ *
+ * Copyright 2025 Mozilla Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wasm/WasmMemoryImage.h"
+
+#include "mozilla/Atomics.h"
+#include "mozilla/ScopeExit.h"
+#include "mozilla/TaggedAnonymousMemory.h"
+
+#include <algorithm>
+#include <string.h>
+
+#ifdef XP_LINUX
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#include "gc/Memory.h"
+#include "js/Utility.h"
+
+using namespace js;
+using namespace js::wasm;
+
+// memfd_create is not declared by older C libraries, so use the system call
+// directly.
+#if defined(XP_LINUX) && defined(__NR_memfd_create)
+#  define WASM_HAS_MEMORY_IMAGES
+
+#  ifndef MFD_CLOEXEC
+#    define MFD_CLOEXEC 0x0001U
+#  endif
+#  ifndef MFD_ALLOW_SEALING
+#    define MFD_ALLOW_SEALING 0x0002U
+#  endif
+#  ifndef F_ADD_SEALS
+#    define F_ADD_SEALS (1024 + 9)
+#    define F_SEAL_SHRINK 0x0002
+#    define F_SEAL_GROW 0x0004
+#    define F_SEAL_WRITE 0x0008
+#  endif
+
+static int CreateMemFd(const char* name) {
+  return int(
+      syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+}
+
+// The number of images alive in the process, see MemoryImage::MaxLiveImages.
+static mozilla::Atomic<size_t, mozilla::ReleaseAcquire> sLiveImages(0);
+#endif
+
+MemoryImage::~MemoryImage() {
+#ifdef WASM_HAS_MEMORY_IMAGES
+  close(fd_);
+  sLiveImages--;
+#endif
+}
+
+/* static */
+RefPtr<MemoryImage> MemoryImage::create(uint32_t memoryIndex,
+                                        size_t memoryLength,
+                                        const DataSegmentVector& dataSegments) {
+#ifdef WASM_HAS_MEMORY_IMAGES
+  // Find the range spanned by the data segments. A segment whose offset is
+  // not known before instantiation, or which does not fit in the memory, is
+  // written by Instance::initSegments, which must then write all of them in
+  // order.
+  size_t begin = SIZE_MAX;
+  size_t end = 0;
+  for (const DataSegment* seg : dataSegments) {
+    if (!seg->active() || seg->memoryIndex != memoryIndex) {
+      continue;
+    }
+    if (!seg->offset().isLiteral()) {
+      return nullptr;
+    }
+    LitVal offsetVal = seg->offset().literal();
+    uint64_t offset = offsetVal.type() == ValType::I32 ? offsetVal.i32()
+                                                       : offsetVal.i64();
+    size_t count = seg->bytes.length();
+    if (offset > memoryLength || memoryLength - offset < count) {
+      return nullptr;
+    }
+    if (count == 0) {
+      continue;
+    }
+    begin = std::min(begin, size_t(offset));
+    end = std::max(end, size_t(offset) + count);
+  }
+  if (begin >= end) {
+    return nullptr;
+  }
+
+  // The memory length is a multiple of the wasm page size, and thus of the
+  // system page size, so the aligned range still fits in the memory.
+  size_t pageSize = gc::SystemPageSize();
+  begin = begin & ~(pageSize - 1);
+  end = (end + pageSize - 1) & ~(pageSize - 1);
+  MOZ_ASSERT(end <= memoryLength);
+  size_t length = end - begin;
+  if (length < MinLength) {
+    return nullptr;
+  }
+
+  if (++sLiveImages > MaxLiveImages) {
+    sLiveImages--;
+    return nullptr;
+  }
+  auto releaseImage = mozilla::MakeScopeExit([&] { sLiveImages--; });
+
+  int fd = CreateMemFd("wasm-memory-image");
+  if (fd < 0) {
+    return nullptr;
+  }
+  auto closeFd = mozilla::MakeScopeExit([&] { close(fd); });
+
+  if (ftruncate(fd, off_t(length)) != 0) {
+    return nullptr;
+  }
+
+  // Write the segments in order, as later segments overwrite earlier ones.
+  void* image =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (image == MAP_FAILED) {
+    return nullptr;
+  }
+  for (const DataSegment* seg : dataSegments) {
+    if (!seg->active() || seg->memoryIndex != memoryIndex ||
+        seg->bytes.empty()) {
+      continue;
+    }
+    LitVal offsetVal = seg->offset().literal();
+    uint64_t offset = offsetVal.type() == ValType::I32 ? offsetVal.i32()
+                                                       : offsetVal.i64();
+    memcpy((uint8_t*)image + (size_t(offset) - begin), seg->bytes.begin(),
+           seg->bytes.length());
+  }
+  munmap(image, length);
+
+  // Nothing may change the image once it is mapped into memories.
+  if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) !=
+      0) {
+    return nullptr;
+  }
+
+  RefPtr<MemoryImage> memoryImage = js_new<MemoryImage>(fd, begin, length);
+  if (!memoryImage) {
+    return nullptr;
+  }
+  closeFd.release();
+  releaseImage.release();
+  return memoryImage;
+#else
+  return nullptr;
+#endif
+}
+
+bool MemoryImage::map(uint8_t* memoryBase) const {
+#ifdef WASM_HAS_MEMORY_IMAGES
+  uint8_t* addr = memoryBase + offset_;
+  void* data = mmap(addr, length_, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_FIXED, fd_, 0);
+  if (data != MAP_FAILED) {
+    MOZ_ASSERT(data == addr);
+    return true;
+  }
+
+  // A failed fixed mapping may have unmapped the range, restore zeroed pages
+  // as discarding memory does.
+  data = MozTaggedAnonymousMmap(addr, length_, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANON | MAP_FIXED, -1, 0,
+                                "wasm-reserved");
+  if (data == MAP_FAILED) {
+    MOZ_CRASH("failed to map wasm memory image; memory mappings may be broken");
+  }
+  return false;
+#else
+  MOZ_CRASH("memory images are not supported");
+#endif
+}
@@ -0,0 +1,105 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ *
+ * Copyright 2025 Mozilla Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef wasm_memory_image_h
+#define wasm_memory_image_h
+
+#include "mozilla/RefPtr.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "js/AllocPolicy.h"
+#include "js/RefCounted.h"
+#include "js/Vector.h"
+#include "wasm/WasmModuleTypes.h"
+
+namespace js {
+namespace wasm {
+
+// [SMDOC] Memory images
+//
+// A MemoryImage holds the initial contents of a memory defined by a module,
+// that is the bytes written by its active data segments, in a file which can
+// be mapped copy-on-write into every new instance of the memory. Instantiation
+// then maps the image over the pages it covers instead of copying the data
+// segments, and the pages are shared between the instances until they are
+// written to.
+//
+// An image covers the page-aligned range of the memory spanning its active
+// data segments. The image is mapped over the committed part of a new memory
+// only, so that the reserved pages and guard pages which follow it keep their
+// protection, and growing, discarding or releasing the memory work as they do
+// for anonymous memory.
+//
+// Images are only created for memories whose active data segments all have
+// constant offsets, and fit in the initial length of the memory, such that
+// instantiation cannot fail while writing them. Memories which are imported
+// are never initialized from an image. A module only creates the image of a
+// memory when it is instantiated a second time, as a module which is only
+// instantiated once gains nothing from it.
+//
+// Images are backed by a sealed memfd, thus only available on Linux. Every
+// live image holds a file descriptor, so at most MaxLiveImages of them exist
+// in the process at a time; memories fall back to copying their data segments
+// beyond that.
+class MemoryImage : public AtomicRefCounted<MemoryImage> {
+  int fd_;
+
+  // The range of the memory covered by the image, aligned to the system page
+  // size.
+  size_t offset_;
+  size_t length_;
+
+ public:
+  // Images of smaller ranges are not worth a mapping.
+  static constexpr size_t MinLength = PageSize;
+
+  // The maximum number of images, and thus of their file descriptors, which
+  // are alive in the process at a time.
+  static constexpr size_t MaxLiveImages = 128;
+
+  MemoryImage(int fd, size_t offset, size_t length)
+      : fd_(fd), offset_(offset), length_(length) {}
+  ~MemoryImage();
+
+  size_t offset() const { return offset_; }
+  size_t length() const { return length_; }
+
+  // Create the image of the memory `memoryIndex`, which is `memoryLength`
+  // bytes long when it is created, from the active data segments of a module.
+  // Returns null if the memory cannot have an image, or on failure.
+  static RefPtr<MemoryImage> create(uint32_t memoryIndex, size_t memoryLength,
+                                    const DataSegmentVector& dataSegments);
+
+  // Map the image over the new memory starting at `memoryBase`, whose
+  // committed length must cover the image. Returns false if the image could
+  // not be mapped, in which case the memory is still zeroed and the data
+  // segments have to be written to it.
+  [[nodiscard]] bool map(uint8_t* memoryBase) const;
+};
+
+using SharedMemoryImage = RefPtr<const MemoryImage>;
+
+// Whether each memory of an instance was initialized with a memory image.
+using MemoryImageMask = Vector<bool, 0, SystemAllocPolicy>;
+
+}  // namespace wasm
+}  // namespace js
+
+#endif  // wasm_memory_image_h
@@ -484,12 +484,49 @@ static bool CheckSharing(JSContext* cx, bool declaredShared, bool isShared) {
   return true;
 }
 
+SharedMemoryImage Module::memoryImage(uint32_t memoryIndex) const {
+  auto images = memoryImages_.lock();
+  if (images->empty() && !images->resize(codeMeta().memories.length())) {
+    return nullptr;
+  }
+
+  // The first instantiation copies the data segments.
+  MemoryImageState& state = images.get()[memoryIndex];
+  if (!state.instantiated) {
+    state.instantiated = true;
+    return nullptr;
+  }
+
+  if (state.image.isNothing()) {
+    const MemoryDesc& desc = codeMeta().memories[memoryIndex];
+    state.image.emplace(MemoryImage::create(memoryIndex,
+                                            desc.initialPages().byteLength(),
+                                            moduleMeta().dataSegments));
+  }
+  return *state.image;
+}
+
+bool Module::testingHasMemoryImage(uint32_t memoryIndex) const {
+  auto images = memoryImages_.lock();
+  if (memoryIndex >= images->length()) {
+    return false;
+  }
+  const MemoryImageState& state = images.get()[memoryIndex];
+  return state.image.isSome() && *state.image;
+}
+
 // asm.js module instantiation supplies its own buffer, but for wasm, create and
 // initialize the buffer if one is requested. Either way, the buffer is wrapped
 // in a WebAssembly.Memory object which is what the Instance stores.
 bool Module::instantiateMemories(
     JSContext* cx, const WasmMemoryObjectVector& memoryImports,
-    MutableHandle<WasmMemoryObjectVector> memoryObjs) const {
+    MutableHandle<WasmMemoryObjectVector> memoryObjs,
+    MemoryImageMask* memoriesFromImage) const {
+  if (!memoriesFromImage->appendN(false, codeMeta().memories.length())) {
+    ReportOutOfMemory(cx);
+    return false;
+  }
+
   for (uint32_t memoryIndex = 0; memoryIndex < codeMeta().memories.length();
        memoryIndex++) {
     const MemoryDesc& desc = codeMeta().memories[memoryIndex];
@@ -534,6 +571,14 @@ bool Module::instantiateMemories(
         return false;
       }
 
+      // Map the initial contents of the memory instead of having
+      // Instance::initSegments copy them.
+      SharedMemoryImage image = memoryImage(memoryIndex);
+      if (image &&
+          image->map(buffer->dataPointerEither().unwrap(/* mapping */))) {
+        (*memoriesFromImage)[memoryIndex] = true;
+      }
+
       RootedObject proto(cx, &cx->global()->getPrototype(JSProto_WasmMemory));
       memory = WasmMemoryObject::create(
           cx, buffer, IsHugeMemoryEnabled(desc.addressType()), proto);
@@ -898,7 +943,9 @@ bool Module::instantiate(JSContext* cx, ImportValues& imports,
   }
 
   Rooted<WasmMemoryObjectVector> memories(cx);
-  if (!instantiateMemories(cx, imports.memories, &memories)) {
+  MemoryImageMask memoriesFromImage;
+  if (!instantiateMemories(cx, imports.memories, &memories,
+                           &memoriesFromImage)) {
     return false;
   }
 
@@ -965,7 +1012,8 @@ bool Module::instantiate(JSContext* cx, ImportValues& imports,
   // start function fails).
 
   if (!instance->instance().initSegments(cx, moduleMeta().dataSegments,
-                                         moduleMeta().elemSegments)) {
+                                         moduleMeta().elemSegments,
+                                         memoriesFromImage)) {
     return false;
   }
 
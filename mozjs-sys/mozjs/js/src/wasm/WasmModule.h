@@ -25,6 +25,7 @@
 #include "wasm/WasmCode.h"
 #include "wasm/WasmException.h"
 #include "wasm/WasmJS.h"
+#include "wasm/WasmMemoryImage.h"
 #include "wasm/WasmSerialize.h"
 #include "wasm/WasmTable.h"
 
@@ -118,11 +119,27 @@ class Module : public JS::WasmModule {
 
   size_t gcMallocBytesExcludingCode_;
 
+  // Images of the initial contents of the memories defined by this module,
+  // created by the second instantiation which creates the memory, so that
+  // modules which are only instantiated once never create one. `image` is
+  // Nothing until then, and null for memories without an image. See
+  // [SMDOC] Memory images.
+
+  struct MemoryImageState {
+    bool instantiated = false;
+    Maybe<SharedMemoryImage> image;
+  };
+  using MemoryImageStateVector =
+      Vector<MemoryImageState, 0, SystemAllocPolicy>;
+  mutable ExclusiveData<MemoryImageStateVector> memoryImages_;
+
   bool instantiateFunctions(JSContext* cx,
                             const JSObjectVector& funcImports) const;
-  bool instantiateMemories(
-      JSContext* cx, const WasmMemoryObjectVector& memoryImports,
-      MutableHandle<WasmMemoryObjectVector> memoryObjs) const;
+  bool instantiateMemories(JSContext* cx,
+                           const WasmMemoryObjectVector& memoryImports,
+                           MutableHandle<WasmMemoryObjectVector> memoryObjs,
+                           MemoryImageMask* memoriesFromImage) const;
+  SharedMemoryImage memoryImage(uint32_t memoryIndex) const;
   bool instantiateTags(JSContext* cx, WasmTagObjectVector& tagObjs) const;
   bool instantiateImportedTable(JSContext* cx, const TableDesc& td,
                                 Handle<WasmTableObject*> table,
@@ -148,7 +165,8 @@ class Module : public JS::WasmModule {
       : moduleMeta_(&moduleMeta),
         code_(&code),
         loggingDeserialized_(loggingDeserialized),
-        testingTier2Active_(false) {
+        testingTier2Active_(false),
+        memoryImages_(mutexid::WasmMemoryImages) {
     initGCMallocBytesExcludingCode();
   }
   ~Module() override;
@@ -171,6 +189,10 @@ class Module : public JS::WasmModule {
                    HandleObject instanceProto,
                    MutableHandle<WasmInstanceObject*> instanceObj) const;
 
+  // Whether later instantiations map the initial contents of the given memory
+  // from an image, rather than copying the data segments into it.
+  bool testingHasMemoryImage(uint32_t memoryIndex) const;
+
   // Tier-2 compilation may be initiated after the Module is constructed at
   // most once. When tier-2 compilation completes, ModuleGenerator calls
   // finishTier2() from a helper thread, passing tier-variant data which will
@@ -214,7 +236,8 @@ class Module : public JS::WasmModule {
 
   bool extractCode(JSContext* cx, Tier tier, MutableHandleValue vp) const;
 
-  WASM_DECLARE_FRIEND_SERIALIZE(Module);
+  WASM_DECLARE_FRIEND_SERIALIZE_ARGS(
+      Module, const Code::SerializableCodeBlockVector& partialTier2Blocks);
 };
 
 using MutableModule = RefPtr<Module>;
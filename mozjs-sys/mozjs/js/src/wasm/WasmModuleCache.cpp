@@ -0,0 +1,288 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ *
+ * Copyright 2025 Mozilla Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wasm/WasmModuleCache.h"
+
+#include "mozilla/Atomics.h"
+#include "mozilla/HashFunctions.h"
+
+#include <string.h>
+
+#include "js/StreamConsumer.h"
+#include "js/WasmModule.h"
+#include "threading/ExclusiveData.h"
+#include "vm/MutexIDs.h"
+
+using namespace js;
+using namespace js::wasm;
+
+using mozilla::AddToHash;
+using mozilla::HashBytes;
+
+// See [SMDOC] Module cache in WasmModuleCache.h.
+
+namespace {
+
+struct CachedModule {
+  HashNumber hash = 0;
+  BytecodeBuffer bytecode;
+  SharedCompileArgs args;
+  SharedModule module;
+};
+
+using CachedModuleVector = Vector<CachedModule, 0, SystemAllocPolicy>;
+
+struct ModuleCache {
+  // The cached modules, the most recently used last.
+  CachedModuleVector entries;
+  // The number of modules cached so far, which tells whether a module was
+  // cached while the lock was released.
+  uint64_t numCached = 0;
+};
+
+}  // namespace
+
+static ExclusiveData<ModuleCache>* sModuleCache = nullptr;
+
+// Read without the lock, so that modules are neither hashed nor compared when
+// the cache is disabled.
+static mozilla::Atomic<size_t, mozilla::Relaxed> sModuleCacheCapacity(0);
+
+bool wasm::InitModuleCache() {
+  MOZ_ASSERT(!sModuleCache);
+  sModuleCache = js_new<ExclusiveData<ModuleCache>>(mutexid::WasmModuleCache);
+  return !!sModuleCache;
+}
+
+// Evict the least recently used modules until at most `maxModules` remain.
+// Modules are released without holding the lock, as releasing their code takes
+// other locks.
+static void ShrinkModuleCache(size_t maxModules) {
+  while (true) {
+    CachedModule evicted;
+    auto cache = sModuleCache->lock();
+    CachedModuleVector& entries = cache->entries;
+    if (entries.length() <= maxModules) {
+      return;
+    }
+    evicted = std::move(entries[0]);
+    entries.erase(entries.begin());
+  }
+}
+
+void wasm::ShutDownModuleCache() {
+  if (!sModuleCache) {
+    return;
+  }
+  sModuleCacheCapacity = 0;
+  ShrinkModuleCache(0);
+  js_delete(sModuleCache);
+  sModuleCache = nullptr;
+}
+
+bool wasm::IsModuleCacheable(const CompileArgs& args,
+                             const JS::OptimizedEncodingListener* listener) {
+  return sModuleCacheCapacity > 0 && !args.debugEnabled && !listener &&
+         !args.features.isBuiltinModule &&
+         args.features.builtinModules.hasNone();
+}
+
+static bool SameChars(const char* lhs, const char* rhs) {
+  if (!lhs || !rhs) {
+    return lhs == rhs;
+  }
+  return strcmp(lhs, rhs) == 0;
+}
+
+static bool SameCompileArgs(const CompileArgs& lhs, const CompileArgs& rhs) {
+  if (!SameChars(lhs.scriptedCaller.filename.get(),
+                 rhs.scriptedCaller.filename.get()) ||
+      lhs.scriptedCaller.filenameIsURL != rhs.scriptedCaller.filenameIsURL ||
+      lhs.scriptedCaller.line != rhs.scriptedCaller.line ||
+      !SameChars(lhs.sourceMapURL.get(), rhs.sourceMapURL.get())) {
+    return false;
+  }
+
+  if (lhs.baselineEnabled != rhs.baselineEnabled ||
+      lhs.ionEnabled != rhs.ionEnabled ||
+      lhs.debugEnabled != rhs.debugEnabled ||
+      lhs.forceTiering != rhs.forceTiering) {
+    return false;
+  }
+
+  const FeatureArgs& lhsFeatures = lhs.features;
+  const FeatureArgs& rhsFeatures = rhs.features;
+#define WASM_FEATURE(NAME, LOWER_NAME, ...)             \
+  if (lhsFeatures.LOWER_NAME != rhsFeatures.LOWER_NAME) { \
+    return false;                                         \
+  }
+  JS_FOR_WASM_FEATURES(WASM_FEATURE)
+#undef WASM_FEATURE
+
+  // Modules with builtin modules are not cached.
+  MOZ_ASSERT(!lhsFeatures.isBuiltinModule && !rhsFeatures.isBuiltinModule);
+  return lhsFeatures.sharedMemory == rhsFeatures.sharedMemory &&
+         lhsFeatures.simd == rhsFeatures.simd;
+}
+
+static bool SameSpan(const BytecodeSpan& lhs, const BytecodeSpan& rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.size() == 0 || memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+static bool SameBytecode(const BytecodeSource& lhs, const BytecodeSource& rhs) {
+  return SameSpan(lhs.envSpan(), rhs.envSpan()) &&
+         SameSpan(lhs.codeSpan(), rhs.codeSpan()) &&
+         SameSpan(lhs.tailSpan(), rhs.tailSpan());
+}
+
+static HashNumber HashBytecode(const BytecodeSource& bytecode) {
+  HashNumber hash = 0;
+  for (const BytecodeSpan& span :
+       {bytecode.envSpan(), bytecode.codeSpan(), bytecode.tailSpan()}) {
+    hash = AddToHash(hash, span.size());
+    if (span.size() != 0) {
+      hash = AddToHash(hash, HashBytes(span.data(), span.size()));
+    }
+  }
+  return hash;
+}
+
+// Take a reference to the entries whose bytecode has this hash, so that they
+// are compared without holding the lock, which all the runtimes compiling
+// modules contend for. Returns false on OOM.
+static bool FindCandidates(HashNumber hash, CachedModuleVector* candidates,
+                           uint64_t* numCached) {
+  auto cache = sModuleCache->lock();
+  *numCached = cache->numCached;
+  for (const CachedModule& entry : cache->entries) {
+    if (entry.hash == hash && !candidates->append(entry)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static SharedModule FindMatch(const CachedModuleVector& candidates,
+                              const CompileArgs& args,
+                              const BytecodeSource& bytecode) {
+  for (const CachedModule& candidate : candidates) {
+    if (SameCompileArgs(*candidate.args, args) &&
+        SameBytecode(candidate.bytecode.source(), bytecode)) {
+      return candidate.module;
+    }
+  }
+  return nullptr;
+}
+
+SharedModule wasm::FindCachedModule(const CompileArgs& args,
+                                    const BytecodeSource& bytecode,
+                                    HashNumber* hash) {
+  *hash = HashBytecode(bytecode);
+
+  // The candidates hold references to their modules, and are released after
+  // the lock, as in ShrinkModuleCache.
+  CachedModuleVector candidates;
+  uint64_t numCached;
+  if (!FindCandidates(*hash, &candidates, &numCached)) {
+    return nullptr;
+  }
+  SharedModule module = FindMatch(candidates, args, bytecode);
+  if (!module) {
+    return nullptr;
+  }
+
+  // Move the entry to the end, as the most recently used one, unless it was
+  // evicted in the meantime.
+  auto cache = sModuleCache->lock();
+  CachedModuleVector& entries = cache->entries;
+  for (CachedModule& entry : entries) {
+    if (entry.module == module) {
+      CachedModule moved = std::move(entry);
+      entries.erase(&entry);
+      MOZ_ALWAYS_TRUE(entries.append(std::move(moved)));
+      break;
+    }
+  }
+  return module;
+}
+
+SharedModule wasm::CacheModule(HashNumber hash, const CompileArgs& args,
+                               const BytecodeBufferOrSource& bytecode,
+                               const SharedModule& module) {
+  MOZ_ASSERT(module);
+
+  // Hold the bytecode, without copying it if it is already in a buffer. This
+  // happens outside the lock.
+  BytecodeBuffer buffer;
+  if (bytecode.hasBuffer()) {
+    buffer = bytecode.buffer();
+  } else if (!BytecodeBuffer::fromSource(bytecode.source(), &buffer)) {
+    return module;
+  }
+
+  while (true) {
+    // Look for the same module, cached by another thread since this one
+    // called FindCachedModule.
+    CachedModuleVector candidates;
+    uint64_t numCached;
+    if (!FindCandidates(hash, &candidates, &numCached)) {
+      return module;
+    }
+    if (SharedModule cached = FindMatch(candidates, args, bytecode.source())) {
+      return cached;
+    }
+
+    // Declared before the lock is taken, so that it is released after the
+    // lock, as in ShrinkModuleCache.
+    CachedModule evicted;
+
+    auto cache = sModuleCache->lock();
+
+    // Another module was cached while the candidates were compared, which may
+    // be this one.
+    if (cache->numCached != numCached) {
+      continue;
+    }
+
+    // The cache grows by one module at a time, and SetWasmModuleCacheCapacity
+    // trims it when its capacity is reduced, so evicting one module is enough.
+    size_t capacity = sModuleCacheCapacity;
+    if (capacity == 0) {
+      return module;
+    }
+    CachedModuleVector& entries = cache->entries;
+    if (entries.length() >= capacity) {
+      evicted = std::move(entries[0]);
+      entries.erase(entries.begin());
+    }
+
+    // The module is still usable if it could not be cached.
+    if (entries.append(CachedModule{hash, std::move(buffer),
+                                    SharedCompileArgs(&args), module})) {
+      cache->numCached++;
+    }
+    return module;
+  }
+}
+
+JS_PUBLIC_API void JS::SetWasmModuleCacheCapacity(size_t maxModules) {
+  MOZ_ASSERT(sModuleCache, "must be called after JS_Init");
+  sModuleCacheCapacity = maxModules;
+  ShrinkModuleCache(maxModules);
+}
@@ -0,0 +1,79 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ *
+ * Copyright 2025 Mozilla Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef wasm_module_cache_h
+#define wasm_module_cache_h
+
+#include "js/HashTable.h"
+#include "wasm/WasmCompileArgs.h"
+#include "wasm/WasmModule.h"
+
+namespace JS {
+class OptimizedEncodingListener;
+}
+
+namespace js {
+namespace wasm {
+
+// [SMDOC] Module cache
+//
+// The module cache lets the runtimes of a process share the modules they
+// compile from the same bytecode. A wasm::Module, its Code and its metadata do
+// not belong to any runtime, as for modules sent with postMessage, thus an
+// embedding running one runtime per worker can keep a single copy of the code
+// of a module all of its workers compile.
+//
+// Entries are keyed by the bytecode and by the CompileArgs the module was
+// compiled with, including the scripted caller which is reported in stack
+// traces. The bytecode is hashed for lookups, but compared in full, as a hash
+// collision must never hand out the code of another module. The lock of the
+// cache is only held to take references to the entries with the same hash,
+// which are then compared without it. The cache holds a reference to its
+// modules, and evicts the least recently used one when it is full. It is
+// disabled by default, see JS::SetWasmModuleCacheCapacity.
+//
+// Modules compiled for debugging, with builtin modules, with an optimized
+// encoding listener, or with warnings are not cached. Runtimes which compile
+// the same module at the same time each compile it, but the first module to be
+// cached is the one they all get.
+
+[[nodiscard]] bool InitModuleCache();
+void ShutDownModuleCache();
+
+// Whether a module compiled with these parameters may be cached.
+bool IsModuleCacheable(const CompileArgs& args,
+                       const JS::OptimizedEncodingListener* listener);
+
+// Return the module cached for this bytecode and these arguments, or null.
+// `hash` is set to the hash of the bytecode, to be given to CacheModule if
+// there is no cached module.
+SharedModule FindCachedModule(const CompileArgs& args,
+                              const BytecodeSource& bytecode,
+                              HashNumber* hash);
+
+// Cache a module compiled from this bytecode and these arguments. Returns the
+// module to use, which is a module cached by another thread in the meantime if
+// there is one, and `module` otherwise, including on OOM.
+SharedModule CacheModule(HashNumber hash, const CompileArgs& args,
+                         const BytecodeBufferOrSource& bytecode,
+                         const SharedModule& module);
+
+}  // namespace wasm
+}  // namespace js
+
+#endif  // wasm_module_cache_h
@@ -64,8 +64,8 @@ SuspenderObjectData::SuspenderObjectData(void* stackMemory)
       state_(SuspenderState::Initial),
       suspendedBy_(nullptr) {}
 
-void SuspenderObjectData::releaseStackMemory() {
-  js_free(stackMemory_);
+void SuspenderObjectData::releaseStackMemory(SuspenderContext* scx) {
+  scx->releaseStackMemory(stackMemory_);
   stackMemory_ = nullptr;
 }
 
@@ -137,6 +137,24 @@ SuspenderContext::SuspenderContext()
 SuspenderContext::~SuspenderContext() {
   MOZ_ASSERT(activeSuspender_ == nullptr);
   MOZ_ASSERT(suspendedStacks_.isEmpty());
+  for (void* stackMemory : stackPool_) {
+    js_free(stackMemory);
+  }
+}
+
+void* SuspenderContext::allocateStackMemory() {
+  if (!stackPool_.empty()) {
+    return stackPool_.popCopy();
+  }
+  return js_malloc(SuspendableStackPlusRedZoneSize);
+}
+
+void SuspenderContext::releaseStackMemory(void* stackMemory) {
+  if (stackPool_.length() < SuspendableStacksPoolMaxCount &&
+      stackPool_.append(stackMemory)) {
+    return;
+  }
+  js_free(stackMemory);
 }
 
 SuspenderObject* SuspenderContext::activeSuspender() {
@@ -239,7 +257,7 @@ class SuspenderObject : public NativeObject {
       return nullptr;
     }
 
-    void* stackMemory = js_malloc(SuspendableStackPlusRedZoneSize);
+    void* stackMemory = cx->wasm().promiseIntegration.allocateStackMemory();
     if (!stackMemory) {
       DecrementSuspendableStacksCount(cx);
       ReportOutOfMemory(cx);
@@ -248,7 +266,7 @@ class SuspenderObject : public NativeObject {
 
     SuspenderObjectData* data = js_new<SuspenderObjectData>(stackMemory);
     if (!data) {
-      js_free(stackMemory);
+      cx->wasm().promiseIntegration.releaseStackMemory(stackMemory);
       DecrementSuspendableStacksCount(cx);
       ReportOutOfMemory(cx);
       return nullptr;
@@ -350,7 +368,8 @@ void SuspenderObject::finalize(JS::GCContext* gcx, JSObject* obj) {
     MOZ_RELEASE_ASSERT(!data->stackMemory());
   } else {
     // Cleaning stack memory and removing from suspendableStacks_.
-    data->releaseStackMemory();
+    JSContext* cx = gcx->runtime()->mainContextFromOwnThread();
+    data->releaseStackMemory(&cx->wasm().promiseIntegration);
     if (SuspenderContext* scx = data->suspendedBy()) {
       scx->suspendedStacks_.remove(data);
     }
@@ -383,7 +402,7 @@ void SuspenderObject::setMoribund(JSContext* cx) {
 #  endif
   SuspenderObjectData* data = this->data();
   data->setState(SuspenderState::Moribund);
-  data->releaseStackMemory();
+  data->releaseStackMemory(&cx->wasm().promiseIntegration);
   DecrementSuspendableStacksCount(cx);
   MOZ_ASSERT(
       !cx->wasm().promiseIntegration.suspendedStacks_.ElementProbablyInList(
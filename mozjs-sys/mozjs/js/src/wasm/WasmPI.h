@@ -181,7 +181,8 @@ class SuspenderObjectData
     return suspendedReturnAddress_;
   }
 
-  void releaseStackMemory();
+  // Return the stack memory to the context's pool.
+  void releaseStackMemory(SuspenderContext* scx);
 
 #if defined(_WIN32)
   void updateTIBStackFields();
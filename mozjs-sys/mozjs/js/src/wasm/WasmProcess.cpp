@@ -28,6 +28,7 @@
 #include "wasm/WasmBuiltins.h"
 #include "wasm/WasmCode.h"
 #include "wasm/WasmInstance.h"
+#include "wasm/WasmModuleCache.h"
 #include "wasm/WasmModuleTypes.h"
 #include "wasm/WasmStaticTypeDefs.h"
 
@@ -201,6 +202,10 @@ bool wasm::Init() {
 
   sThreadSafeCodeBlockMap = map;
 
+  if (!InitMemoryPool() || !InitTierUpProfiles() || !InitModuleCache()) {
+    oomUnsafe.crash("js::wasm::Init");
+  }
+
   if (!InitTagForJSValue()) {
     oomUnsafe.crash("js::wasm::Init");
   }
@@ -216,6 +221,10 @@ void wasm::ShutDown() {
     return;
   }
 
+  // Cached modules hold canonical types and code blocks, which are released
+  // below.
+  ShutDownModuleCache();
+
   BuiltinModuleFuncs::destroy();
   StaticTypeDefs::destroy();
   PurgeCanonicalTypes();
@@ -234,5 +243,7 @@ void wasm::ShutDown() {
   }
 
   ReleaseBuiltinThunks();
+  ShutDownMemoryPool();
+  ShutDownTierUpProfiles();
   js_delete(map);
 }
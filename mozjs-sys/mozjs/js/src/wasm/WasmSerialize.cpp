@@ -1296,11 +1296,14 @@ CoderResult CodeFuncToCodeRangeMap(
   return Ok();
 }
 
+// Partial tier-2 code blocks are linked against the `maybeCode` they are
+// added to, and allocated in its pool of lazy function segments.
 CoderResult CodeCodeBlock(Coder<MODE_DECODE>& coder,
                           wasm::UniqueCodeBlock* item,
-                          const wasm::LinkData& linkData) {
+                          const wasm::LinkData& linkData, CodeBlockKind kind,
+                          const wasm::Code* maybeCode = nullptr) {
   WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::CodeBlock, 2624);
-  *item = js::MakeUnique<CodeBlock>(CodeBlock::kindFromTier(Tier::Serialized));
+  *item = js::MakeUnique<CodeBlock>(kind);
   if (!*item) {
     return Err(OutOfMemory());
   }
@@ -1315,10 +1318,16 @@ CoderResult CodeCodeBlock(Coder<MODE_DECODE>& coder,
   // Allocate a code segment using the code bytes
   uint8_t* codeStart;
   uint32_t allocationLength;
-  CodeSource codeSource(codeBytes, codeBytesLength, linkData, nullptr);
-  (*item)->segment =
-      CodeSegment::allocate(codeSource, nullptr, /* allowLastDitchGC */ true,
-                            &codeStart, &allocationLength);
+  CodeSource codeSource(codeBytes, codeBytesLength, linkData, maybeCode);
+  if (maybeCode) {
+    uint32_t codeLength;
+    (*item)->segment = maybeCode->createFuncCodeSegmentFromPool(
+        codeSource, /* allowLastDitchGC */ true, &codeStart, &codeLength);
+  } else {
+    (*item)->segment =
+        CodeSegment::allocate(codeSource, nullptr, /* allowLastDitchGC */ true,
+                              &codeStart, &allocationLength);
+  }
   if (!(*item)->segment) {
     return Err(OutOfMemory());
   }
@@ -1380,28 +1389,42 @@ CoderResult CodeSharedCode(Coder<MODE_DECODE>& coder, wasm::SharedCode* item,
   UniqueLinkData sharedStubsLinkData;
   MOZ_TRY((CodeUniquePtr<MODE_DECODE, LinkData, CodeLinkData>(
       coder, &sharedStubsLinkData)));
-  MOZ_TRY(CodeCodeBlock(coder, &sharedStubs, *sharedStubsLinkData));
+  MOZ_TRY(CodeCodeBlock(coder, &sharedStubs, *sharedStubsLinkData,
+                        CodeBlockKind::SharedStubs));
   sharedStubs->sendToProfiler(*moduleMeta.codeMeta, *moduleMeta.codeTailMeta,
                               nullptr, FuncIonPerfSpewerSpan(),
                               FuncBaselinePerfSpewerSpan());
 
-  UniqueLinkData optimizedCodeLinkData;
-  UniqueCodeBlock optimizedCode;
+  // Lazily tiered code has baseline code for every function, otherwise the
+  // code is optimized.
+  CompileMode mode;
+  MOZ_TRY(CodePod(coder, &mode));
+  MOZ_RELEASE_ASSERT(mode == CompileMode::Once ||
+                     mode == CompileMode::LazyTiering);
+  Tier tier1 =
+      mode == CompileMode::LazyTiering ? Tier::Baseline : Tier::Serialized;
+
+  UniqueLinkData tier1LinkData;
+  UniqueCodeBlock tier1Code;
   MOZ_TRY((CodeUniquePtr<MODE_DECODE, LinkData, CodeLinkData>(
-      coder, &optimizedCodeLinkData)));
-  MOZ_TRY(CodeCodeBlock(coder, &optimizedCode, *optimizedCodeLinkData));
-  optimizedCode->sendToProfiler(*moduleMeta.codeMeta, *moduleMeta.codeTailMeta,
-                                nullptr, FuncIonPerfSpewerSpan(),
-                                FuncBaselinePerfSpewerSpan());
+      coder, &tier1LinkData)));
+  MOZ_TRY(CodeCodeBlock(coder, &tier1Code, *tier1LinkData,
+                        CodeBlock::kindFromTier(tier1)));
+  tier1Code->sendToProfiler(*moduleMeta.codeMeta, *moduleMeta.codeTailMeta,
+                            nullptr, FuncIonPerfSpewerSpan(),
+                            FuncBaselinePerfSpewerSpan());
 
   // Create and initialize the code
-  MutableCode code = js_new<Code>(CompileMode::Once, *moduleMeta.codeMeta,
-                                  *moduleMeta.codeTailMeta,
-                                  /*codeMetaForAsmJS=*/nullptr);
-  if (!code || !code->initialize(
-                   std::move(funcImports), std::move(sharedStubs),
-                   std::move(sharedStubsLinkData), std::move(optimizedCode),
-                   std::move(optimizedCodeLinkData), CompileAndLinkStats())) {
+  // Deserialized lazily tiered code can be serialized again, with the
+  // functions which have tiered up since.
+  MutableCode code =
+      js_new<Code>(mode, *moduleMeta.codeMeta, *moduleMeta.codeTailMeta,
+                   /*codeMetaForAsmJS=*/nullptr,
+                   /*keepLazyTieringLinkData=*/true);
+  if (!code || !code->initialize(std::move(funcImports), std::move(sharedStubs),
+                                 std::move(sharedStubsLinkData),
+                                 std::move(tier1Code), std::move(tier1LinkData),
+                                 CompileAndLinkStats())) {
     return Err(OutOfMemory());
   }
 
@@ -1415,13 +1438,38 @@ CoderResult CodeSharedCode(Coder<MODE_DECODE>& coder, wasm::SharedCode* item,
   MOZ_TRY(CodePod(coder, &offsetOfCallRefMetricsStub));
   code->setUpdateCallRefMetricsStubOffset(offsetOfCallRefMetricsStub);
 
+  // Install the functions which were tiered up before serialization, in the
+  // order they were, so that they are linked to the same callees.
+  if (mode == CompileMode::LazyTiering) {
+    uint32_t numPartialTier2Blocks;
+    MOZ_TRY(CodePod(coder, &numPartialTier2Blocks));
+    for (uint32_t i = 0; i < numPartialTier2Blocks; i++) {
+      UniqueLinkData tier2LinkData;
+      UniqueCodeBlock tier2Code;
+      MOZ_TRY((CodeUniquePtr<MODE_DECODE, LinkData, CodeLinkData>(
+          coder, &tier2LinkData)));
+      MOZ_TRY(CodeCodeBlock(coder, &tier2Code, *tier2LinkData,
+                            CodeBlockKind::OptimizedTier, code));
+      tier2Code->sendToProfiler(*moduleMeta.codeMeta, *moduleMeta.codeTailMeta,
+                                nullptr, FuncIonPerfSpewerSpan(),
+                                FuncBaselinePerfSpewerSpan());
+      if (!code->finishTier2(std::move(tier2Code), std::move(tier2LinkData),
+                             CompileAndLinkStats())) {
+        return Err(OutOfMemory());
+      }
+    }
+  }
+
   *item = code;
   return Ok();
 }
 
+// `partialTier2Blocks` is a snapshot of the partial tier-2 code of lazily
+// tiered code, which must not change between sizing and encoding.
 template <CoderMode mode>
-CoderResult CodeSharedCode(Coder<mode>& coder,
-                           CoderArg<mode, wasm::SharedCode> item) {
+CoderResult CodeSharedCode(
+    Coder<mode>& coder, CoderArg<mode, wasm::SharedCode> item,
+    const Code::SerializableCodeBlockVector& partialTier2Blocks) {
   WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::Code, 976);
   STATIC_ASSERT_ENCODING_OR_SIZING;
   // Don't encode the CodeMetadata or CodeTailMetadata, that is handled by
@@ -1432,12 +1480,15 @@ CoderResult CodeSharedCode(Coder<mode>& coder,
       *(*item)->codeBlockLinkData(sharedStubsCodeBlock);
   MOZ_TRY(CodeLinkData(coder, &sharedStubsLinkData));
   MOZ_TRY(CodeCodeBlock(coder, &sharedStubsCodeBlock, sharedStubsLinkData));
-  const CodeBlock& optimizedCodeBlock =
-      (*item)->completeTierCodeBlock(Tier::Serialized);
-  const LinkData& optimizedLinkData =
-      *(*item)->codeBlockLinkData(optimizedCodeBlock);
-  MOZ_TRY(CodeLinkData(coder, &optimizedLinkData));
-  MOZ_TRY(CodeCodeBlock(coder, &optimizedCodeBlock, optimizedLinkData));
+
+  CompileMode compileMode = (*item)->mode();
+  MOZ_TRY(CodePod(coder, &compileMode));
+  Tier tier1 = compileMode == CompileMode::LazyTiering ? Tier::Baseline
+                                                       : Tier::Serialized;
+  const CodeBlock& tier1CodeBlock = (*item)->completeTierCodeBlock(tier1);
+  const LinkData& tier1LinkData = *(*item)->codeBlockLinkData(tier1CodeBlock);
+  MOZ_TRY(CodeLinkData(coder, &tier1LinkData));
+  MOZ_TRY(CodeCodeBlock(coder, &tier1CodeBlock, tier1LinkData));
 
   // not serialized: debugStubOffset_
 
@@ -1448,13 +1499,24 @@ CoderResult CodeSharedCode(Coder<mode>& coder,
       (*item)->updateCallRefMetricsStubOffset();
   MOZ_TRY(CodePod(coder, &offsetOfCallRefMetricsStub));
 
+  if (compileMode == CompileMode::LazyTiering) {
+    uint32_t numPartialTier2Blocks = partialTier2Blocks.length();
+    MOZ_TRY(CodePod(coder, &numPartialTier2Blocks));
+    for (const Code::SerializableCodeBlock& block : partialTier2Blocks) {
+      MOZ_TRY(CodeLinkData(coder, block.linkData));
+      MOZ_TRY(CodeCodeBlock(coder, block.codeBlock, *block.linkData));
+    }
+  } else {
+    MOZ_ASSERT(partialTier2Blocks.empty());
+  }
+
   return Ok();
 }
 
 // WasmModule.h
 
 CoderResult CodeModule(Coder<MODE_DECODE>& coder, MutableModule* item) {
-  WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::Module, 56);
+  WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::Module, 176);
   JS::BuildIdCharVector currentBuildId;
   if (!GetOptimizedEncodingBuildId(&currentBuildId)) {
     return Err(OutOfMemory());
@@ -1478,11 +1540,13 @@ CoderResult CodeModule(Coder<MODE_DECODE>& coder, MutableModule* item) {
 }
 
 template <CoderMode mode>
-CoderResult CodeModule(Coder<mode>& coder, CoderArg<mode, Module> item) {
-  WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::Module, 56);
+CoderResult CodeModule(
+    Coder<mode>& coder, CoderArg<mode, Module> item,
+    const Code::SerializableCodeBlockVector& partialTier2Blocks) {
+  WASM_VERIFY_SERIALIZATION_FOR_SIZE(wasm::Module, 176);
   STATIC_ASSERT_ENCODING_OR_SIZING;
   MOZ_RELEASE_ASSERT(!item->code().debugEnabled());
-  MOZ_RELEASE_ASSERT(item->code_->hasCompleteTier(Tier::Serialized));
+  MOZ_RELEASE_ASSERT(item->code_->hasSerializableCode());
 
   JS::BuildIdCharVector currentBuildId;
   if (!GetOptimizedEncodingBuildId(&currentBuildId)) {
@@ -1492,7 +1556,7 @@ CoderResult CodeModule(Coder<mode>& coder, CoderArg<mode, Module> item) {
   MOZ_TRY((CodeRefPtr<mode, const ModuleMetadata, &CodeModuleMetadata>(
       coder, &item->moduleMeta_)));
   MOZ_TRY(Magic(coder, Marker::Code));
-  MOZ_TRY(CodeSharedCode(coder, &item->code_));
+  MOZ_TRY(CodeSharedCode(coder, &item->code_, partialTier2Blocks));
   return Ok();
 }
 
@@ -1501,16 +1565,21 @@ CoderResult CodeModule(Coder<mode>& coder, CoderArg<mode, Module> item) {
 
 bool Module::canSerialize() const {
   // TODO(bug 1903131): JS string builtins don't support serialization
-  // TODO(bug 1913109): lazy tiering doesn't support serialization
-  return code_->mode() != CompileMode::LazyTiering &&
-         !codeMeta().isBuiltinModule() &&
+  // Lazily tiered code is only serializable if it was asked to be, see
+  // Code::keepLazyTieringLinkData_.
+  return !codeMeta().isBuiltinModule() &&
          codeMeta().features().builtinModules.hasNone() &&
-         !code_->debugEnabled();
+         !code_->debugEnabled() &&
+         (code_->mode() != CompileMode::LazyTiering ||
+          code_->hasSerializableCode());
 }
 
-static bool GetSerializedSize(const Module& module, size_t* size) {
+static bool GetSerializedSize(
+    const Module& module,
+    const Code::SerializableCodeBlockVector& partialTier2Blocks,
+    size_t* size) {
   Coder<MODE_SIZE> coder(module.codeMeta().types.get());
-  auto result = CodeModule(coder, &module);
+  auto result = CodeModule(coder, &module, partialTier2Blocks);
   if (result.isErr()) {
     return false;
   }
@@ -1520,10 +1589,18 @@ static bool GetSerializedSize(const Module& module, size_t* size) {
 
 bool Module::serialize(Bytes* bytes) const {
   MOZ_RELEASE_ASSERT(canSerialize());
-  MOZ_RELEASE_ASSERT(code_->hasCompleteTier(Tier::Serialized));
+  MOZ_RELEASE_ASSERT(code_->hasSerializableCode());
+
+  // Functions may be tiered up while we serialize, so the partial tier-2 code
+  // to serialize is chosen up front.
+  bool lazyTiering = code_->mode() == CompileMode::LazyTiering;
+  Code::SerializableCodeBlockVector partialTier2Blocks;
+  if (lazyTiering && !code_->partialTier2CodeBlocks(&partialTier2Blocks)) {
+    return false;
+  }
 
   size_t serializedSize;
-  if (!GetSerializedSize(*this, &serializedSize)) {
+  if (!GetSerializedSize(*this, partialTier2Blocks, &serializedSize)) {
     // An error is an overflow, return false
     return false;
   }
@@ -1535,7 +1612,7 @@ bool Module::serialize(Bytes* bytes) const {
 
   Coder<MODE_ENCODE> coder(codeMeta().types.get(), bytes->begin(),
                            serializedSize);
-  CoderResult result = CodeModule(coder, this);
+  CoderResult result = CodeModule(coder, this, partialTier2Blocks);
   if (result.isErr()) {
     // An error is an OOM, return false
     return false;
@@ -1543,8 +1620,11 @@ bool Module::serialize(Bytes* bytes) const {
   // Every byte is accounted for
   MOZ_RELEASE_ASSERT(coder.buffer_ == coder.end_);
 
-  // Clear out link data now, it's no longer needed.
-  code().clearLinkData();
+  // Clear out link data now, it's no longer needed. Lazily tiered code keeps
+  // it, as it may be serialized again once more functions have tiered up.
+  if (!lazyTiering) {
+    code().clearLinkData();
+  }
 
   return true;
 }
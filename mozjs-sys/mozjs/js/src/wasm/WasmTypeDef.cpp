@@ -40,6 +40,8 @@ using mozilla::CheckedInt32;
 using mozilla::CheckedUint32;
 using mozilla::IsPowerOfTwo;
 using mozilla::MallocSizeOf;
+using mozilla::Maybe;
+using mozilla::Some;
 
 // [SMDOC] Immediate type signature encoding
 //
@@ -284,6 +286,53 @@ static inline CheckedInt32 RoundUpToAlignment(CheckedInt32 address,
   return ((address + (align - 1)) / align) * align;
 }
 
+bool StructLayout::addPadding(uint32_t start, uint32_t end) {
+  MOZ_ASSERT(end - start < 16);
+
+  // Split the padding into the largest naturally aligned holes.
+  while (start < end) {
+    uint32_t log2Size = NumHoleSizes - 1;
+    while ((start & ((1 << log2Size) - 1)) != 0 ||
+           start + (1 << log2Size) > end) {
+      log2Size--;
+    }
+    if (!holes[log2Size].append(start)) {
+      return false;
+    }
+    start += 1 << log2Size;
+  }
+  return true;
+}
+
+bool StructLayout::takeHole(uint32_t fieldSize, Maybe<uint32_t>* offset) {
+  uint32_t fieldLog2Size = mozilla::FloorLog2(fieldSize);
+  for (uint32_t log2Size = fieldLog2Size; log2Size < NumHoleSizes;
+       log2Size++) {
+    HoleOffsetVector& sizeHoles = holes[log2Size];
+    if (sizeHoles.empty()) {
+      continue;
+    }
+
+    // The rest of a larger hole is given back as smaller ones.
+    for (uint32_t i = fieldLog2Size; i < log2Size; i++) {
+      if (!holes[i].reserve(holes[i].length() + 1)) {
+        return false;
+      }
+    }
+
+    // Prefer the lowest hole, which is the most likely to be inline.
+    uint32_t* lowest = std::min_element(sizeHoles.begin(), sizeHoles.end());
+    *offset = Some(*lowest);
+    sizeHoles.erase(lowest);
+
+    for (uint32_t i = fieldLog2Size; i < log2Size; i++) {
+      holes[i].infallibleAppend(**offset + (1 << i));
+    }
+    return true;
+  }
+  return true;
+}
+
 CheckedInt32 StructLayout::addField(StorageType type) {
   uint32_t fieldSize = type.size();
   uint32_t fieldAlignment = type.alignmentInStruct();
@@ -298,12 +347,32 @@ CheckedInt32 StructLayout::addField(StorageType type) {
   // Alignment of the struct is the max of the alignment of its fields.
   structAlignment = std::max(structAlignment, fieldAlignment);
 
+  // On OOM, return an invalid offset, which fails the layout as for a struct
+  // which is too large.
+  CheckedInt32 invalid = CheckedInt32(INT32_MAX) + 1;
+
+  // Fill the padding left by earlier fields, if possible. Holes are naturally
+  // aligned, so the field is too.
+  Maybe<uint32_t> holeOffset;
+  if (!takeHole(fieldSize, &holeOffset)) {
+    return invalid;
+  }
+  if (holeOffset) {
+    MOZ_ASSERT(*holeOffset % fieldAlignment == 0);
+    return CheckedInt32(*holeOffset);
+  }
+
   // Align the pointer.
   CheckedInt32 offset = RoundUpToAlignment(sizeSoFar, fieldAlignment);
   if (!offset.isValid()) {
     return offset;
   }
 
+  // Keep the padding for later fields.
+  if (!addPadding(sizeSoFar.value(), offset.value())) {
+    return invalid;
+  }
+
   // Allocate space.
   sizeSoFar = offset + fieldSize;
   if (!sizeSoFar.isValid()) {
@@ -22,6 +22,7 @@
 #include "mozilla/Assertions.h"
 #include "mozilla/CheckedInt.h"
 #include "mozilla/HashTable.h"
+#include "mozilla/Maybe.h"
 
 #include "js/RefCounted.h"
 
@@ -406,10 +407,30 @@ using StructTypeVector = Vector<StructType, 0, SystemAllocPolicy>;
 //
 // Given that, it follows from (3) that all fields fall completely within
 // either the inline or outline areas; no field crosses the boundary.
+//
+// Fields are laid out in declaration order, except that a field is placed in
+// the padding left by aligning an earlier field whenever it fits there, so
+// that structs mixing small and large fields waste little space and keep more
+// of their fields inline. The padding is kept as naturally aligned holes of 1,
+// 2, 4 or 8 bytes, and a field takes the lowest hole of its size, or splits
+// the lowest larger one. A field's offset only depends on the fields declared
+// before it, thus a subtype's layout still starts with the layout of its
+// supertype, whose fields form a prefix of its own.
 class StructLayout {
   mozilla::CheckedInt32 sizeSoFar = 0;
   uint32_t structAlignment = 1;
 
+  // The offsets of the holes of 1 << i bytes, for i in [0, NumHoleSizes).
+  // Padding is at most 15 bytes, so holes are never larger than 8 bytes.
+  static constexpr uint32_t NumHoleSizes = 4;
+  using HoleOffsetVector = Vector<uint32_t, 4, SystemAllocPolicy>;
+  HoleOffsetVector holes[NumHoleSizes];
+
+  [[nodiscard]] bool addPadding(uint32_t start, uint32_t end);
+  // Find the lowest hole for a field, if any. Returns false on OOM.
+  [[nodiscard]] bool takeHole(uint32_t fieldSize,
+                              mozilla::Maybe<uint32_t>* offset);
+
  public:
   // The field adders return the offset of the the field.
   mozilla::CheckedInt32 addField(StorageType type);
@@ -24,8 +24,10 @@
 
 #include "js/Printf.h"
 #include "js/String.h"  // JS::MaxStringLength
+#include "vm/HelperThreads.h"
 #include "vm/JSContext.h"
 #include "vm/Realm.h"
+#include "vm/Runtime.h"
 #include "wasm/WasmDump.h"
 #include "wasm/WasmInitExpr.h"
 #include "wasm/WasmOpIter.h"
@@ -4052,24 +4054,46 @@ bool wasm::DecodeModuleEnvironment(Decoder& d, CodeMetadata* codeMeta,
   return true;
 }
 
-static bool DecodeFunctionBody(Decoder& d, const CodeMetadata& codeMeta,
-                               uint32_t funcIndex) {
-  uint32_t bodySize;
-  if (!d.readVarU32(&bodySize)) {
+static bool DecodeFunctionBodySize(Decoder& d, uint32_t* bodySize) {
+  if (!d.readVarU32(bodySize)) {
     return d.fail("expected number of function body bytes");
   }
 
-  if (bodySize > MaxFunctionBytes) {
+  if (*bodySize > MaxFunctionBytes) {
     return d.fail("function body too big");
   }
 
-  if (d.bytesRemain() < bodySize) {
+  if (d.bytesRemain() < *bodySize) {
     return d.fail("function body length too big");
   }
 
+  return true;
+}
+
+static bool DecodeFunctionBody(Decoder& d, const CodeMetadata& codeMeta,
+                               uint32_t funcIndex) {
+  uint32_t bodySize;
+  if (!DecodeFunctionBodySize(d, &bodySize)) {
+    return false;
+  }
+
   return ValidateFunctionBody(codeMeta, funcIndex, bodySize, d);
 }
 
+static bool DecodeFunctionBodyCount(Decoder& d, const CodeMetadata& codeMeta,
+                                    uint32_t* numFuncDefs) {
+  if (!d.readVarU32(numFuncDefs)) {
+    return d.fail("expected function body count");
+  }
+
+  if (*numFuncDefs != codeMeta.numFuncDefs()) {
+    return d.fail(
+        "function body count does not match function signature count");
+  }
+
+  return true;
+}
+
 static bool DecodeCodeSection(Decoder& d, CodeMetadata* codeMeta) {
   if (!codeMeta->codeSectionRange) {
     if (codeMeta->numFuncDefs() != 0) {
@@ -4079,13 +4103,8 @@ static bool DecodeCodeSection(Decoder& d, CodeMetadata* codeMeta) {
   }
 
   uint32_t numFuncDefs;
-  if (!d.readVarU32(&numFuncDefs)) {
-    return d.fail("expected function body count");
-  }
-
-  if (numFuncDefs != codeMeta->numFuncDefs()) {
-    return d.fail(
-        "function body count does not match function signature count");
+  if (!DecodeFunctionBodyCount(d, *codeMeta, &numFuncDefs)) {
+    return false;
   }
 
   for (uint32_t funcDefIndex = 0; funcDefIndex < numFuncDefs; funcDefIndex++) {
@@ -4098,6 +4117,179 @@ static bool DecodeCodeSection(Decoder& d, CodeMetadata* codeMeta) {
   return d.finishSection(*codeMeta->codeSectionRange, "code");
 }
 
+// Parallel validation, see [SMDOC] Parallel validation in WasmValidate.h.
+
+// Code sections smaller than this are validated on the calling thread, as
+// dispatching tasks would cost more than it saves.
+static const size_t MinParallelValidationBytes = 1024 * 1024;
+
+// The smallest batch of function bodies validated by a task. The batches are
+// otherwise sized to give each thread a few of them, so that threads which
+// get faster batches do not stay idle.
+static const size_t MinValidationBatchBytes = 64 * 1024;
+static const size_t ValidationBatchesPerThread = 4;
+
+void ValidateTask::execute() {
+  for (const FuncValidateInput& input : inputs) {
+    // Another task already found an invalid function before this one.
+    if (input.index > state.firstFailedFuncIndex) {
+      return;
+    }
+
+    Decoder d(input.begin, codeEnd, input.offsetInModule, &error);
+    if (!ValidateFunctionBody(codeMeta, input.index, input.bodySize, d)) {
+      failedFuncIndex = input.index;
+
+      uint32_t firstFailed = state.firstFailedFuncIndex;
+      while (input.index < firstFailed &&
+             !state.firstFailedFuncIndex.compareExchange(firstFailed,
+                                                         input.index)) {
+        firstFailed = state.firstFailedFuncIndex;
+      }
+      return;
+    }
+  }
+}
+
+void ValidateTask::runHelperThreadTask(AutoLockHelperThreadState& lock) {
+  {
+    AutoUnlockHelperThreadState unlock(lock);
+    execute();
+  }
+
+  // Don't release the lock between updating our state and returning from this
+  // method.
+  state.numFinished()++;
+  state.condVar().notify_one();
+}
+
+static bool ShouldValidateInParallel(const CodeMetadata& codeMeta) {
+  return codeMeta.codeSectionRange &&
+         codeMeta.codeSectionRange->size() >= MinParallelValidationBytes &&
+         CanUseExtraThreads() && GetHelperThreadCPUCount() > 1 &&
+         GetHelperThreadCount() > 1;
+}
+
+static bool DecodeCodeSectionInParallel(Decoder& d,
+                                        const CodeMetadata& codeMeta,
+                                        UniqueChars* error) {
+  MOZ_ASSERT(codeMeta.codeSectionRange);
+
+  uint32_t numFuncDefs;
+  if (!DecodeFunctionBodyCount(d, codeMeta, &numFuncDefs)) {
+    return false;
+  }
+
+  // Find the function bodies. Serial validation checks the size of a body
+  // after validating the bodies before it, so a malformed size is only
+  // reported once these bodies are known to be valid.
+  FuncValidateInputVector inputs;
+  if (!inputs.reserve(numFuncDefs)) {
+    return false;
+  }
+  bool sizesValid = true;
+  size_t codeBytes = 0;
+  for (uint32_t funcDefIndex = 0; funcDefIndex < numFuncDefs; funcDefIndex++) {
+    uint32_t bodySize;
+    if (!DecodeFunctionBodySize(d, &bodySize)) {
+      sizesValid = false;
+      break;
+    }
+    inputs.infallibleEmplaceBack(d.currentPosition(), bodySize,
+                                 codeMeta.numFuncImports + funcDefIndex,
+                                 d.currentOffset());
+    MOZ_ALWAYS_TRUE(d.readBytes(bodySize));
+    codeBytes += bodySize;
+  }
+
+  // Split the bodies into batches of consecutive functions.
+  size_t batchBytes =
+      std::max(MinValidationBatchBytes,
+               codeBytes / (ValidationBatchesPerThread *
+                            GetMaxWasmCompilationThreads()));
+  Vector<Span<const FuncValidateInput>, 0, SystemAllocPolicy> batches;
+  size_t batchStart = 0;
+  size_t batchSize = 0;
+  for (size_t i = 0; i < inputs.length(); i++) {
+    batchSize += inputs[i].bodySize;
+    if (batchSize >= batchBytes || i + 1 == inputs.length()) {
+      if (!batches.append(Span<const FuncValidateInput>(
+              inputs.begin() + batchStart, i + 1 - batchStart))) {
+        return false;
+      }
+      batchStart = i + 1;
+      batchSize = 0;
+    }
+  }
+
+  ValidateTaskState taskState;
+  Vector<ValidateTask, 0, SystemAllocPolicy> tasks;
+  if (!tasks.reserve(batches.length())) {
+    return false;
+  }
+  for (Span<const FuncValidateInput> batch : batches) {
+    tasks.infallibleEmplaceBack(codeMeta, taskState, batch, d.end());
+  }
+
+  // Submit all the batches but the first one, which this thread validates
+  // while the helper threads start. The batches which could not be submitted
+  // are validated by this thread too.
+  size_t numSubmitted = 0;
+  for (size_t i = 1; i < tasks.length(); i++) {
+    if (!StartOffThreadWasmValidate(&tasks[i])) {
+      break;
+    }
+    numSubmitted++;
+  }
+  for (size_t i = 0; i < tasks.length(); i++) {
+    if (i == 0 || i > numSubmitted) {
+      tasks[i].execute();
+    }
+  }
+
+  {
+    AutoLockHelperThreadState lock;
+
+    // Validate the batches which no helper thread has started yet.
+    uint32_t outstanding = numSubmitted;
+    while (ValidateTask* task = TakePendingWasmValidateTask(taskState, lock)) {
+      outstanding--;
+      AutoUnlockHelperThreadState unlock(lock);
+      task->execute();
+    }
+
+    while (taskState.numFinished() < outstanding) {
+      taskState.condVar().wait(lock); /* finished */
+    }
+  }
+
+  // The batches are in function order, and a task stops at its first invalid
+  // function, so the first failure of the first failed task is the first
+  // invalid function of the module.
+  for (ValidateTask& task : tasks) {
+    if (task.failedFuncIndex != UINT32_MAX) {
+      *error = std::move(task.error);
+      return false;
+    }
+  }
+
+  if (!sizesValid) {
+    return false;
+  }
+
+  return d.finishSection(*codeMeta.codeSectionRange, "code");
+}
+
+static bool ValidateCodeSection(Decoder& d, CodeMetadata* codeMeta,
+                                ParallelValidation parallel,
+                                UniqueChars* error) {
+  if (parallel == ParallelValidation::Allowed &&
+      ShouldValidateInParallel(*codeMeta)) {
+    return DecodeCodeSectionInParallel(d, *codeMeta, error);
+  }
+  return DecodeCodeSection(d, codeMeta);
+}
+
 static bool DecodeDataSection(Decoder& d, CodeMetadata* codeMeta,
                               ModuleMetadata* moduleMeta) {
   MaybeBytecodeRange range;
@@ -4354,7 +4546,8 @@ bool wasm::DecodeModuleTail(Decoder& d, CodeMetadata* codeMeta,
 // Validate algorithm.
 
 bool wasm::Validate(JSContext* cx, const BytecodeSource& bytecode,
-                    const FeatureOptions& options, UniqueChars* error) {
+                    const FeatureOptions& options, UniqueChars* error,
+                    ParallelValidation parallel) {
   FeatureArgs features = FeatureArgs::build(cx, options);
   SharedCompileArgs compileArgs = CompileArgs::buildForValidation(features);
   if (!compileArgs) {
@@ -4384,7 +4577,7 @@ bool wasm::Validate(JSContext* cx, const BytecodeSource& bytecode,
     MOZ_RELEASE_ASSERT(envDecoder.done());
 
     Decoder codeDecoder(bytecode.codeSpan(), bytecode.codeRange().start, error);
-    if (!DecodeCodeSection(codeDecoder, codeMeta)) {
+    if (!ValidateCodeSection(codeDecoder, codeMeta, parallel, error)) {
       return false;
     }
     // Our pre-parse that split the module should ensure that after we've
@@ -4398,7 +4591,7 @@ bool wasm::Validate(JSContext* cx, const BytecodeSource& bytecode,
     // Decoding the module tail should consume all remaining bytes.
     MOZ_RELEASE_ASSERT(tailDecoder.done());
   } else {
-    if (!DecodeCodeSection(envDecoder, codeMeta)) {
+    if (!ValidateCodeSection(envDecoder, codeMeta, parallel, error)) {
       return false;
     }
     if (!DecodeModuleTail(envDecoder, codeMeta, moduleMeta)) {
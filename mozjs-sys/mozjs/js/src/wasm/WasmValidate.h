@@ -19,11 +19,16 @@
 #ifndef wasm_validate_h
 #define wasm_validate_h
 
+#include "mozilla/Atomics.h"
+#include "mozilla/Span.h"
+
 #include <type_traits>
 
 #include "js/Utility.h"
 #include "js/WasmFeatures.h"
-
+#include "threading/ConditionVariable.h"
+#include "threading/ProtectedData.h"
+#include "vm/HelperThreadTask.h"
 #include "wasm/WasmBinary.h"
 #include "wasm/WasmCompile.h"
 #include "wasm/WasmCompileArgs.h"
@@ -168,9 +173,106 @@ using ValidatingOpIter = OpIter<ValidatingPolicy>;
 // successfully. If Validate returns false:
 //  - if *error is null, the caller should report out-of-memory
 //  - otherwise, there was a legitimate error described by *error
+//
+// The function bodies of large modules are validated on helper threads, see
+// [SMDOC] Parallel validation, unless |parallel| is Disabled. Both report the
+// same result and error.
+
+enum class ParallelValidation : bool { Disabled, Allowed };
+
+[[nodiscard]] bool Validate(
+    JSContext* cx, const BytecodeSource& bytecode,
+    const FeatureOptions& options, UniqueChars* error,
+    ParallelValidation parallel = ParallelValidation::Allowed);
+
+// [SMDOC] Parallel validation
+//
+// Validate checks the function bodies of large modules on helper threads. A
+// function body only depends on the CodeMetadata decoded from the module
+// environment, notably on its types, which the ValidateTasks share without
+// copying it. The code section is split into batches of consecutive function
+// bodies of about the same bytecode size, each validated by a ValidateTask.
+// The calling thread validates the first batch, then the batches which no
+// helper thread has started, and then waits for the remaining tasks.
+//
+// A task stops at the first function of its batch which fails validation, and
+// records its index and error. Tasks skip the functions following the first
+// failure found so far by any task. The error which is reported is the one of
+// the failing function with the lowest index, which is the error serial
+// validation reports.
+//
+// Compilation does not use these tasks, as the compilers validate function
+// bodies while compiling them.
+
+// A function body to be validated by a ValidateTask.
+struct FuncValidateInput {
+  const uint8_t* begin;
+  uint32_t bodySize;
+  uint32_t index;
+  size_t offsetInModule;
+
+  FuncValidateInput(const uint8_t* begin, uint32_t bodySize, uint32_t index,
+                    size_t offsetInModule)
+      : begin(begin),
+        bodySize(bodySize),
+        index(index),
+        offsetInModule(offsetInModule) {}
+};
+
+using FuncValidateInputVector =
+    Vector<FuncValidateInput, 0, SystemAllocPolicy>;
+
+// The state shared by the ValidateTasks of a module, and the thread waiting
+// for them.
+struct ValidateTaskState {
+  // The lowest index of a function which failed validation so far, or
+  // UINT32_MAX.
+  mozilla::Atomic<uint32_t, mozilla::Relaxed> firstFailedFuncIndex;
+
+  HelperThreadLockData<uint32_t> numFinished_;
+  HelperThreadLockData<ConditionVariable> condVar_;
 
-[[nodiscard]] bool Validate(JSContext* cx, const BytecodeSource& bytecode,
-                            const FeatureOptions& options, UniqueChars* error);
+  ValidateTaskState() : firstFailedFuncIndex(UINT32_MAX), numFinished_(0) {}
+
+  uint32_t& numFinished() { return numFinished_.ref(); }
+  ConditionVariable& condVar() { return condVar_.ref(); }
+};
+
+// A ValidateTask validates a batch of function bodies, on a helper thread or
+// on the thread validating the module.
+struct ValidateTask : public HelperThreadTask {
+  const CodeMetadata& codeMeta;
+  ValidateTaskState& state;
+  mozilla::Span<const FuncValidateInput> inputs;
+
+  // The end of the code section, which bounds decoding as it does for serial
+  // validation.
+  const uint8_t* codeEnd;
+
+  // The index of the function which failed validation, or UINT32_MAX if all
+  // the functions of the batch which were not skipped are valid. The error is
+  // null if validation failed on out-of-memory.
+  uint32_t failedFuncIndex;
+  UniqueChars error;
+
+  ValidateTask(const CodeMetadata& codeMeta, ValidateTaskState& state,
+               mozilla::Span<const FuncValidateInput> inputs,
+               const uint8_t* codeEnd)
+      : codeMeta(codeMeta),
+        state(state),
+        inputs(inputs),
+        codeEnd(codeEnd),
+        failedFuncIndex(UINT32_MAX) {}
+
+  void execute();
+
+  void runHelperThreadTask(AutoLockHelperThreadState& locked) override;
+  ThreadType threadType() override {
+    return ThreadType::THREAD_TYPE_WASM_VALIDATE;
+  }
+
+  const char* getName() override { return "WasmValidateTask"; }
+};
 
 struct NopOpDumper {
   void dumpOpBegin(OpBytes op) {}
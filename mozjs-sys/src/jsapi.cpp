@@ -40,6 +40,7 @@
 #include "js/Utility.h"
 #include "js/Warnings.h"
 #include "js/WasmModule.h"
+#include "js/experimental/ICHealth.h"
 #include "js/experimental/JSStencil.h"
 #include "js/experimental/JitInfo.h"
 #include "js/experimental/TypedData.h"